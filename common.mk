@@ -89,6 +89,11 @@ ifeq ($(logger),1)
     CFLAGS_BASE += -DOOI_DEBUG
 endif
 
+# replace the native USB backend with trace replay
+ifeq ($(usb_replay),1)
+    CFLAGS_BASE += -DUSB_REPLAY_BACKEND
+endif
+
 # osx install name
 ifdef install_name
     LFLAGS_LIB += -install_name $(install_name)
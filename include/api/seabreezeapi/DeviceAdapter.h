@@ -68,6 +68,12 @@
 #include "api/seabreezeapi/FPGARegisterFeatureAdapter.h"
 #include <vector>
 
+namespace seabreeze {
+    namespace oceanBinaryProtocol {
+        class OBPQueryBatch;
+    }
+}
+
 namespace seabreeze {
     namespace api {
 
@@ -91,6 +97,18 @@ namespace seabreeze {
             /*  endpointType. A 0 is returned if the endpoint requested is not in use. */
             unsigned char getDeviceEndpoint(int *errorCode, usbEndpointType anEndpointType);
 
+            /* Get or clear the transfer counters kept for a USB endpoint */
+            int getUSBEndpointMetrics(int *errorCode, unsigned char endpoint,
+                    unsigned long long *counters, int countersLength,
+                    unsigned long long *histogram, int histogramLength);
+            void resetUSBEndpointMetrics(int *errorCode);
+
+            /* Run several OBP queries as one batch */
+            int obpQueryBatch(int *errorCode, int count,
+                    const unsigned int *messageTypes,
+                    const unsigned char *payloads, const int *payloadLengths,
+                    unsigned char *replies, int repliesLength, int *replyLengths);
+
             /* Get one or more raw USB access features */
             int getNumberOfRawUSBBusAccessFeatures();
             int getRawUSBBusAccessFeatures(long *buffer, int maxFeatures);
@@ -116,15 +134,24 @@ namespace seabreeze {
             double spectrometerGetMaximumIntensity(long spectrometerFeatureID, int *errorCode);
             int spectrometerGetUnformattedSpectrumLength(long spectrometerFeatureID, int *errorCode);
             int spectrometerGetUnformattedSpectrum(long spectrometerFeatureID,int *errorCode, unsigned char *buffer, int bufferLength);
+            int spectrometerBorrowUnformattedSpectrum(long spectrometerFeatureID, int *errorCode, const unsigned char **buffer);
+            void spectrometerReleaseUnformattedSpectrum(long spectrometerFeatureID, int *errorCode);
+            void spectrometerSubmitUnformattedSpectrum(long spectrometerFeatureID, int *errorCode);
+            int spectrometerIsUnformattedSpectrumReady(long spectrometerFeatureID, int *errorCode);
+            int spectrometerCompleteUnformattedSpectrum(long spectrometerFeatureID, int *errorCode, unsigned char *buffer, int bufferLength);
             int spectrometerGetFastBufferSpectrum(long spectrometerFeatureID, int *errorCode, unsigned char *buffer, int bufferLength, unsigned int numberOfSamplesToRetrieve);
             void spectrometerFastBufferSpectrumRequest(long spectrometerFeatureID, int *errorCode, unsigned int numberOfSamplesToRetrieve);
             int spectrometerFastBufferSpectrumResponse(long spectrometerFeatureID, int *errorCode, unsigned char *buffer, int bufferLength, unsigned int numberOfSamplesToRetrieve);
             int spectrometerGetFormattedSpectrumLength(long spectrometerFeatureID, int *errorCode);
             int spectrometerGetFormattedSpectrum(long spectrometerFeatureID, int *errorCode,double *buffer, int bufferLength);
+            int spectrometerGetFormattedSpectrumWithStatistics(long spectrometerFeatureID, int *errorCode, double *buffer, int bufferLength, sbapi_spectrum_statistics *statistics);
+            int spectrometerGetSpectrumAs(long spectrometerFeatureID, int *errorCode, int format, void *buffer, int bufferLength);
             int spectrometerGetWavelengths(long spectrometerFeatureID, int *errorCode,double *wavelengths, int length);
             int spectrometerGetElectricDarkPixelCount(long spectrometerFeatureID, int *errorCode);
             int spectrometerGetElectricDarkPixelIndices(long spectrometerFeatureID, int *errorCode, int *indices, int length);
             void spectrometerSetUSBTimeout(long spectrometerFeatureID, int *errorCode, unsigned int timeout);
+            void spectrometerSetUSBReadQueueDepth(long spectrometerFeatureID, int *errorCode, unsigned int depth, bool zeroCopy);
+            sbapi_acquisition_handle spectrometerOpenAcquisition(long spectrometerFeatureID, int *errorCode);
 
             /* Get one or more pixel binning features */
             int getNumberOfPixelBinningFeatures();
@@ -367,6 +394,7 @@ namespace seabreeze {
         protected:
             unsigned long instanceID;
             seabreeze::Device *device;
+            seabreeze::oceanBinaryProtocol::OBPQueryBatch *queryBatch;
             std::vector<RawUSBBusAccessFeatureAdapter *> rawUSBBusAccessFeatures;
             std::vector<SerialNumberFeatureAdapter *> serialNumberFeatures;
             std::vector<SpectrometerFeatureAdapter *> spectrometerFeatures;
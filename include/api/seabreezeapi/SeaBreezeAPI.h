@@ -39,6 +39,36 @@
 #include "api/DllDecl.h"
 #include "api/USBEndpointTypes.h"
 
+/* Opaque handle to a spectrometer feature with the protocol implementation
+ * and bus transfer helpers its acquisitions go through already looked up.
+ * See sbapi_spectrometer_open_acquisition().
+ */
+typedef struct sbapi_acquisition *sbapi_acquisition_handle;
+
+/* Figures worked out while a formatted spectrum is decoded.  See
+ * sbapi_spectrometer_get_formatted_spectrum_with_statistics().
+ */
+typedef struct sbapi_spectrum_statistics {
+    double minimum;
+    double maximum;
+    double sum;
+    int maximum_index;      /* First pixel holding the maximum */
+    int saturated_pixels;   /* Pixels at the maximum intensity or above */
+} sbapi_spectrum_statistics;
+
+/* One spectrum in the buffer filled by a fast buffer read.  See
+ * sbapi_fast_buffer_get_spectrum().
+ */
+typedef struct sbapi_fast_buffer_spectrum {
+    unsigned int spectrum_count;        /* Counts up with each spectrum taken */
+    unsigned long long tick_count;      /* Microseconds since power up */
+    unsigned int integration_time;      /* Microseconds */
+    int trigger_mode;
+    const unsigned char *metadata;      /* The 64-byte block, in the buffer */
+    const unsigned short *pixels;       /* In the buffer, little-endian */
+    unsigned int checksum;
+} sbapi_fast_buffer_spectrum;
+
 #ifdef __cplusplus
 
 /*!
@@ -86,6 +116,30 @@ public:
      */
     virtual int addRS232DeviceLocation(char *deviceTypeName, char *deviceBusPath, unsigned int baud) = 0;
 
+    /**
+     * Use enableDeviceEvents() to have devices tracked as they are attached
+     * and detached instead of calling probeDevices() repeatedly.  The
+     * changes are applied and reported by pollDeviceEvents().
+     */
+    virtual int enableDeviceEvents(int *errorCode) = 0;
+    virtual void disableDeviceEvents(int *errorCode) = 0;
+    virtual int pollDeviceEvents(int *errorCode, long *ids, int *events, unsigned int maxEvents) = 0;
+
+    /**
+     * Use getUSBPollDescriptors() to watch for USB activity from an event
+     * loop, and handleUSBEvents() to complete transfers once there is some.
+     */
+    virtual int getUSBPollDescriptors(int *errorCode, int *fds, short *events, unsigned int maxDescriptors) = 0;
+    virtual void handleUSBEvents(int *errorCode) = 0;
+
+    /**
+     * The flight recorder keeps the latest transfers on every bus so they
+     * can be written out after something has gone wrong.
+     */
+    virtual void setFlightRecorderEnabled(int *errorCode, bool enable) = 0;
+    virtual int dumpFlightRecorder(int *errorCode, const char *path) = 0;
+    virtual void setFlightRecorderDumpFile(int *errorCode, const char *path) = 0;
+
     /**
      * This provides the number of devices that have either been probed or
      * manually specified.  Devices are not opened automatically, but this can
@@ -121,6 +175,18 @@ public:
     /* Get the usb endpoint address for a specified type of endpoint */
     virtual unsigned char getDeviceEndpoint(long id, int *error_code, usbEndpointType endpointType) = 0;
 
+    /* Get or clear the transfer counters kept for each USB endpoint */
+    virtual int getUSBEndpointMetrics(long id, int *errorCode, unsigned char endpoint,
+            unsigned long long *counters, int countersLength,
+            unsigned long long *histogram, int histogramLength) = 0;
+    virtual void resetUSBEndpointMetrics(long id, int *errorCode) = 0;
+
+    /* Run several OBP queries against one device in a single round trip */
+    virtual int obpQueryBatch(long id, int *errorCode, int count,
+            const unsigned int *messageTypes,
+            const unsigned char *payloads, const int *payloadLengths,
+            unsigned char *replies, int repliesLength, int *replyLengths) = 0;
+
     /* Get raw usb access capabilities */
     virtual int getNumberOfRawUSBBusAccessFeatures(long deviceID, int *errorCode) = 0;
     virtual int getRawUSBBusAccessFeatures(long deviceID, int *errorCode, long *buffer, unsigned int maxLength) = 0;
@@ -143,6 +209,11 @@ public:
     virtual double spectrometerGetMaximumIntensity(long deviceID, long spectrometerFeatureID, int *errorCode) = 0;
     virtual int spectrometerGetUnformattedSpectrumLength(long deviceID, long spectrometerFeatureID, int *errorCode) = 0;
     virtual int spectrometerGetUnformattedSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned char *buffer, int bufferLength) = 0;
+    virtual int spectrometerBorrowUnformattedSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode, const unsigned char **buffer) = 0;
+    virtual void spectrometerReleaseUnformattedSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode) = 0;
+    virtual void spectrometerSubmitUnformattedSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode) = 0;
+    virtual int spectrometerIsUnformattedSpectrumReady(long deviceID, long spectrometerFeatureID, int *errorCode) = 0;
+    virtual int spectrometerCompleteUnformattedSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned char *buffer, int bufferLength) = 0;
     virtual int spectrometerGetFastBufferSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned char *dataBuffer, int dataMaxLength, unsigned int numberOfSampleToRetrieve) = 0; // currently 15 max
     virtual void spectrometerFastBufferSpectrumRequest(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned int numberOfSampleToRetrieve) = 0; // currently 15 max
     virtual int spectrometerFastBufferSpectrumResponse(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned char *dataBuffer, int dataMaxLength, unsigned int numberOfSampleToRetrieve) = 0; // currently 15 max
@@ -152,6 +223,15 @@ public:
     virtual int spectrometerGetElectricDarkPixelCount(long deviceID, long spectrometerFeatureID, int *errorCode) = 0;
     virtual int spectrometerGetElectricDarkPixelIndices(long deviceID, long spectrometerFeatureID, int *errorCode, int *indices, int length) = 0;
     virtual void spectrometerSetUSBTimeout(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned int timeout) = 0;
+    virtual void spectrometerSetUSBReadQueueDepth(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned int depth, bool zeroCopy) = 0;
+    virtual sbapi_acquisition_handle spectrometerOpenAcquisition(long deviceID, long spectrometerFeatureID, int *errorCode) = 0;
+    virtual void spectrometerCloseAcquisition(sbapi_acquisition_handle handle) = 0;
+    virtual int spectrometerGetFormattedSpectrum(sbapi_acquisition_handle handle, int *errorCode, double *buffer, int bufferLength) = 0;
+    virtual int spectrometerGetUnformattedSpectrum(sbapi_acquisition_handle handle, int *errorCode, unsigned char *buffer, int bufferLength) = 0;
+    virtual int spectrometerGetFormattedSpectrumWithStatistics(long deviceID, long spectrometerFeatureID, int *errorCode, double *buffer, int bufferLength, sbapi_spectrum_statistics *statistics) = 0;
+    virtual int spectrometerGetFormattedSpectrumWithStatistics(sbapi_acquisition_handle handle, int *errorCode, double *buffer, int bufferLength, sbapi_spectrum_statistics *statistics) = 0;
+    virtual int spectrometerGetSpectrumAs(long deviceID, long spectrometerFeatureID, int *errorCode, int format, void *buffer, int bufferLength) = 0;
+    virtual int spectrometerGetSpectrumAs(sbapi_acquisition_handle handle, int *errorCode, int format, void *buffer, int bufferLength) = 0;
 
     /* Pixel binning capabilities */
     virtual int getNumberOfPixelBinningFeatures(long id, int *errorCode) = 0;
@@ -474,6 +554,134 @@ extern "C" {
     DLL_DECL int
     sbapi_probe_devices();
 
+    /**
+     * This starts tracking devices as they are attached and detached, which
+     * avoids having to call sbapi_probe_devices() periodically.  Devices
+     * that are already attached are probed once as part of this call.
+     * Afterwards, sbapi_poll_device_events() must be called to apply and
+     * collect the changes; it never blocks.  This is only available with
+     * libusb (Linux).
+     *
+     * @param error_code (Output) A pointer to an integer that can be used
+     *      for storing error codes.  This will be ERROR_NOT_IMPLEMENTED if
+     *      the platform cannot report attach/detach events.
+     *
+     * @return the total number of devices found, or -1 on error.
+     */
+    DLL_DECL int
+    sbapi_enable_device_events(int *error_code);
+
+    /**
+     * This stops tracking devices as they are attached and detached.  Any
+     * events that have not been collected are discarded.
+     *
+     * @param error_code (Output) A pointer to an integer that can be used
+     *      for storing error codes.
+     */
+    DLL_DECL void
+    sbapi_disable_device_events(int *error_code);
+
+    /**
+     * This applies any attach/detach events since the previous call and
+     * reports them.  Attached devices get a new device ID that can be used
+     * with sbapi_open_device() right away.  Detached devices are removed
+     * from the set returned by sbapi_get_device_ids(); their IDs become
+     * invalid once this returns.  This should be called from the same
+     * thread that would otherwise call sbapi_probe_devices().
+     *
+     * @param error_code (Output) A pointer to an integer that can be used
+     *      for storing error codes.
+     * @param ids (Output) A buffer that receives the device ID of each event
+     * @param events (Output) A buffer that receives DEVICE_EVENT_ARRIVED or
+     *      DEVICE_EVENT_DEPARTED for the corresponding ID
+     * @param max_events (Input) The number of entries in both buffers.  Any
+     *      further events are kept for the next call.
+     *
+     * @return the number of events stored, or -1 if device events are not
+     *      enabled.
+     */
+    DLL_DECL int
+    sbapi_poll_device_events(int *error_code, long *ids, int *events,
+            unsigned int max_events);
+
+    /**
+     * This provides the file descriptors that become ready when there is USB
+     * activity on any open device, so that spectrometers can be driven from
+     * an existing poll(), epoll or select() loop instead of one blocking
+     * thread per device.  Whenever one of them is ready,
+     * sbapi_handle_usb_events() must be called.  The set can change as
+     * devices are opened and closed, so it should be fetched again after
+     * either.  This is only available with libusb (Linux).
+     *
+     * @param error_code (Output) A pointer to an integer that can be used
+     *      for storing error codes.  This will be ERROR_NOT_IMPLEMENTED if
+     *      the platform cannot provide file descriptors.
+     * @param fds (Output) A buffer that receives the file descriptors
+     * @param events (Output) A buffer that receives the poll() events
+     *      (POLLIN, POLLOUT) to watch for on the corresponding descriptor
+     * @param max_descriptors (Input) The number of entries in both buffers
+     *
+     * @return the total number of descriptors, which may be more than
+     *      max_descriptors, or -1 on error.
+     */
+    DLL_DECL int
+    sbapi_get_usb_poll_descriptors(int *error_code, int *fds, short *events,
+            unsigned int max_descriptors);
+
+    /**
+     * This completes whatever USB transfers are ready without blocking.  It
+     * should be called whenever a descriptor from
+     * sbapi_get_usb_poll_descriptors() is ready, after which
+     * sbapi_spectrometer_is_unformatted_spectrum_ready() reflects any
+     * spectra that have arrived.
+     *
+     * @param error_code (Output) A pointer to an integer that can be used
+     *      for storing error codes.
+     */
+    DLL_DECL void
+    sbapi_handle_usb_events(int *error_code);
+
+    /**
+     * This turns the flight recorder on or off.  The flight recorder keeps
+     * the time, endpoint, length and first few bytes of the latest 1024
+     * transfers made over USB, TCP/IP and RS232 in memory.  It is on by
+     * default and costs little enough to leave on.
+     *
+     * @param error_code (Output) A pointer to an integer that can be used
+     *      for storing error codes.
+     * @param enable (Input) Zero to stop recording, anything else to record
+     */
+    DLL_DECL void
+    sbapi_enable_flight_recorder(int *error_code, unsigned char enable);
+
+    /**
+     * This writes what the flight recorder holds to a file, oldest transfer
+     * first.  The layout is described in native/system/FlightRecorder.h.
+     *
+     * @param error_code (Output) A pointer to an integer that can be used
+     *      for storing error codes.
+     * @param path (Input) The file to write; it is replaced if it exists.
+     *
+     * @return the number of transfers written, or -1 on error.
+     */
+    DLL_DECL int
+    sbapi_dump_flight_recorder(int *error_code, const char *path);
+
+    /**
+     * This has the flight recorder written to the given file every time a
+     * malformed message is received from a device, such as a spectrum that
+     * has lost its sync byte.  Each dump replaces the previous one.  So
+     * that a device that keeps failing does not have the file rewritten on
+     * every acquisition, after one dump further errors are not dumped for
+     * ten seconds.
+     *
+     * @param error_code (Output) A pointer to an integer that can be used
+     *      for storing error codes.
+     * @param path (Input) The file to write, or NULL to stop dumping.
+     */
+    DLL_DECL void
+    sbapi_set_flight_recorder_dump_file(int *error_code, const char *path);
+
     /**
      * This returns the total number of devices that are known either because
      * they have been specified with sbapi_add_RS232_device_location or
@@ -655,6 +863,82 @@ extern "C" {
     DLL_DECL unsigned char
     sbapi_get_device_usb_endpoint_secondary_in2(long id, int *error_code);
 
+    /**
+     * This function returns the counters kept for every transfer made on one
+     * USB endpoint of an open device, so that throughput and stalls can be
+     * watched in production without verbose logging.  They start at zero
+     * when the device is opened.
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.  This will be ERROR_FEATURE_NOT_FOUND if the
+     *      device was not opened over USB.
+     * @param endpoint (Input) The endpoint address, including the 0x80 bit
+     *      for IN endpoints.
+     * @param counters (Output) A buffer that receives, in order, the number
+     *      of bytes moved, transfers that moved data, transfers that moved
+     *      less than was asked for, timeouts, and other errors.  These are
+     *      64-bit so that the byte count does not wrap at high data rates.
+     * @param counters_length (Input) The number of entries in counters; at
+     *      most five are filled in.
+     * @param histogram (Output) A buffer that receives the latency
+     *      histogram.  Entry 0 counts transfers that took under a
+     *      microsecond and entry i those that took from 2^(i-1) up to 2^i
+     *      microseconds; the last entry also counts anything slower.
+     * @param histogram_length (Input) The number of entries in histogram
+     *
+     * @return the number of histogram entries available, or -1 on error.
+     */
+    DLL_DECL int
+    sbapi_get_usb_endpoint_metrics(long deviceID, int *error_code,
+            unsigned char endpoint, unsigned long long *counters, int counters_length,
+            unsigned long long *histogram, int histogram_length);
+
+    /**
+     * This function sets the counters for every USB endpoint of an open
+     * device back to zero.
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     */
+    DLL_DECL void
+    sbapi_reset_usb_endpoint_metrics(long deviceID, int *error_code);
+
+    /**
+     * This function sends several Ocean Binary Protocol queries to a device
+     * back-to-back and then reads all of the replies, so that polling a
+     * number of small values costs about one round trip instead of one per
+     * value.  Each query is given by its OBP message type and an optional
+     * payload, as listed in the device's OBP documentation.
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.  This will be ERROR_FEATURE_NOT_FOUND if the
+     *      device was not opened on a bus that carries OBP.
+     * @param count (Input) The number of queries
+     * @param message_types (Input) The OBP message type of each query
+     * @param payloads (Input) The payloads of all of the queries, one after
+     *      another.  This may be NULL if none of the queries has a payload.
+     * @param payload_lengths (Input) The length of each query's payload, or
+     *      NULL if none of the queries has a payload.
+     * @param replies (Output) A buffer that receives the data from each
+     *      reply, one after another.  Replies that do not fit are cut short.
+     * @param replies_length (Input) The size of the replies buffer in bytes
+     * @param reply_lengths (Output) The number of bytes stored in replies for
+     *      each query, or -1 where the device refused the query.
+     *
+     * @return the number of bytes stored in replies, or -1 on error.
+     */
+    DLL_DECL int
+    sbapi_obp_query_batch(long deviceID, int *error_code, int count,
+            const unsigned int *message_types,
+            const unsigned char *payloads, const int *payload_lengths,
+            unsigned char *replies, int replies_length, int *reply_lengths);
+
 
     /**
      * This function returns the total number of raw usb bus access feature
@@ -983,6 +1267,111 @@ extern "C" {
             long featureID, int *error_code,
             unsigned char *buffer, int buffer_length);
 
+    /**
+     * This acquires a spectrum like sbapi_spectrometer_get_unformatted_spectrum()
+     * but, instead of copying it into a caller's buffer, returns a pointer to
+     * wherever it was received.  When a zero-copy read queue has been set up
+     * with sbapi_spectrometer_set_usb_zero_copy_read_queue() this is the
+     * buffer the USB controller wrote the spectrum into.  Only devices that
+     * use the OOI protocol are read without a copy; for OBP devices the
+     * spectrum is unwrapped from its message into a held copy.  The data remains
+     * valid until sbapi_spectrometer_release_unformatted_spectrum() is called
+     * or another spectrum is borrowed, and must not be modified.
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param featureID (Input) The ID of a particular instance of a spectrometer
+     *      feature.  Valid IDs can be found with the sbapi_get_spectrometer_features()
+     *      function.
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param buffer (Output) Set to point at the spectral data
+     *
+     * @return the number of bytes available at the returned pointer
+     */
+    DLL_DECL int
+    sbapi_spectrometer_borrow_unformatted_spectrum(long deviceID,
+            long featureID, int *error_code, const unsigned char **buffer);
+
+    /**
+     * This hands back a spectrum obtained with
+     * sbapi_spectrometer_borrow_unformatted_spectrum() so that its buffer
+     * can be used for another read.
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param featureID (Input) The ID of a particular instance of a spectrometer
+     *      feature.  Valid IDs can be found with the sbapi_get_spectrometer_features()
+     *      function.
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     */
+    DLL_DECL void
+    sbapi_spectrometer_release_unformatted_spectrum(long deviceID,
+            long featureID, int *error_code);
+
+    /**
+     * This requests a spectrum like sbapi_spectrometer_get_unformatted_spectrum()
+     * but returns as soon as the request has been sent, with the read for the
+     * spectrum already queued on the bus.  Once
+     * sbapi_spectrometer_is_unformatted_spectrum_ready() reports it,
+     * sbapi_spectrometer_complete_unformatted_spectrum() collects the spectrum
+     * without blocking.  A read queue of depth one is set up on the spectrum
+     * endpoint if there is none.  This is only available with libusb (Linux).
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param featureID (Input) The ID of a particular instance of a spectrometer
+     *      feature.  Valid IDs can be found with the sbapi_get_spectrometer_features()
+     *      function.
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     */
+    DLL_DECL void
+    sbapi_spectrometer_submit_unformatted_spectrum(long deviceID,
+            long featureID, int *error_code);
+
+    /**
+     * This reports whether a spectrum requested with
+     * sbapi_spectrometer_submit_unformatted_spectrum() has arrived.  It
+     * never blocks, and only changes after sbapi_handle_usb_events().
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param featureID (Input) The ID of a particular instance of a spectrometer
+     *      feature.  Valid IDs can be found with the sbapi_get_spectrometer_features()
+     *      function.
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     *
+     * @return 1 if the spectrum can be collected, otherwise 0
+     */
+    DLL_DECL int
+    sbapi_spectrometer_is_unformatted_spectrum_ready(long deviceID,
+            long featureID, int *error_code);
+
+    /**
+     * This copies out a spectrum requested with
+     * sbapi_spectrometer_submit_unformatted_spectrum().  No request is sent.
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param featureID (Input) The ID of a particular instance of a spectrometer
+     *      feature.  Valid IDs can be found with the sbapi_get_spectrometer_features()
+     *      function.
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param buffer (Output) A buffer (with memory already allocated) to hold
+     *      the spectral data
+     * @param buffer_length (Input) The length of the buffer in bytes
+     *
+     * @return the number of bytes read into the buffer
+     */
+    DLL_DECL int
+    sbapi_spectrometer_complete_unformatted_spectrum(long deviceID,
+            long featureID, int *error_code,
+            unsigned char *buffer, int buffer_length);
+
     /**
     * This acquires the number of fast buffer spectra specified and returns the actual number of spectra retrieved,
     *  placing the spectra and meta data into the specified buffer
@@ -1044,6 +1433,47 @@ extern "C" {
                                                 long spectrometerFeatureID, int *error_code,
                                                 unsigned char *buffer, int buffer_length, unsigned int numberOfSamplesToRetrieve);
 
+    /**
+     * This finds how many whole spectra are held in a buffer filled by
+     * sbapi_spectrometer_get_fast_buffer_spectrum() or
+     * sbapi_spectrometer_fast_buffer_spectrum_response().
+     *
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param buffer (Input) The buffer that was filled
+     * @param buffer_length (Input) The number of bytes that were read into it
+     * @param pixels (Input) The number of pixels in each spectrum, as given by
+     *      sbapi_spectrometer_get_formatted_spectrum_length()
+     *
+     * @return the number of spectra in the buffer
+     */
+    DLL_DECL int
+    sbapi_fast_buffer_get_number_of_spectra(int *error_code,
+            const unsigned char *buffer, int buffer_length, int pixels);
+
+    /**
+     * This reads the metadata of one spectrum in a buffer filled by a fast
+     * buffer read, and finds its pixels.  Nothing is copied: the pointers
+     * in the result are into the buffer, so are only good while it is.
+     * The pixels are 16-bit values in the device's little-endian order,
+     * and the buffer must be 2-byte aligned to read them in place.
+     *
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param buffer (Input) The buffer that was filled
+     * @param buffer_length (Input) The number of bytes that were read into it
+     * @param pixels (Input) The number of pixels in each spectrum
+     * @param index (Input) Which spectrum to look at, counting from 0
+     * @param spectrum (Output) Filled in with the spectrum's metadata fields
+     *      and pointers to its metadata block and pixels
+     *
+     * @return 0 on success, or -1 if index is past the last spectrum
+     */
+    DLL_DECL int
+    sbapi_fast_buffer_get_spectrum(int *error_code,
+            const unsigned char *buffer, int buffer_length, int pixels,
+            int index, sbapi_fast_buffer_spectrum *spectrum);
+
 
     /**
      * This computes the wavelengths for the spectrometer and fills in the
@@ -1114,6 +1544,218 @@ extern "C" {
     sbapi_spectrometer_get_electric_dark_pixel_indices(long deviceID,
             long featureID, int *error_code, int *indices, int length);
 
+    /**
+     * This sets how many USB reads are kept queued on the endpoint(s) that
+     * spectra are read from, so that the spectrometer never has to wait for
+     * the host to ask for the next one.  This mostly benefits high-rate
+     * acquisition and is currently only available with libusb (Linux).
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param featureID (Input) The ID of a particular instance of a spectrometer
+     *      feature.  Valid IDs can be found with the sbapi_get_spectrometer_features()
+     *      function.
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param depth (Input) The number of reads to keep queued (up to 32), or
+     *      zero to return to one blocking read at a time.
+     */
+    DLL_DECL void
+    sbapi_spectrometer_set_usb_read_queue_depth(long deviceID,
+            long featureID, int *error_code, unsigned int depth);
+
+    /**
+     * This is sbapi_spectrometer_set_usb_read_queue_depth() with the queued
+     * buffers allocated from memory the kernel can transfer into directly
+     * (usbfs zero-copy, falling back to ordinary memory where the kernel does
+     * not support it).  Spectra read with
+     * sbapi_spectrometer_borrow_unformatted_spectrum() are then handed out
+     * from those buffers without being copied.
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param featureID (Input) The ID of a particular instance of a spectrometer
+     *      feature.  Valid IDs can be found with the sbapi_get_spectrometer_features()
+     *      function.
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param depth (Input) The number of reads to keep queued (up to 32), or
+     *      zero to return to one blocking read at a time.
+     */
+    DLL_DECL void
+    sbapi_spectrometer_set_usb_zero_copy_read_queue(long deviceID,
+            long featureID, int *error_code, unsigned int depth);
+
+    /**
+     * This looks up, once, everything that acquiring from a spectrometer
+     * feature goes through: the device, the feature, the protocol
+     * implementation and the bus transfer helpers.  The handle it returns
+     * can then be passed to sbapi_spectrometer_get_formatted_spectrum_by_handle()
+     * and sbapi_spectrometer_get_unformatted_spectrum_by_handle(), which
+     * acquire exactly like sbapi_spectrometer_get_formatted_spectrum() and
+     * sbapi_spectrometer_get_unformatted_spectrum() without repeating
+     * those lookups on every call.  Closing the device invalidates the
+     * handle: calls made with it then fail with ERROR_NO_DEVICE.  Either
+     * way it must still be released with sbapi_spectrometer_close_acquisition().
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param featureID (Input) The ID of a particular instance of a spectrometer
+     *      feature.  Valid IDs can be found with the sbapi_get_spectrometer_features()
+     *      function.
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     *
+     * @return a handle for the acquisition calls, or NULL on error
+     */
+    DLL_DECL sbapi_acquisition_handle
+    sbapi_spectrometer_open_acquisition(long deviceID, long featureID,
+            int *error_code);
+
+    /**
+     * This releases a handle obtained from sbapi_spectrometer_open_acquisition().
+     *
+     * @param handle (Input) The handle to release.  NULL is ignored.
+     */
+    DLL_DECL void
+    sbapi_spectrometer_close_acquisition(sbapi_acquisition_handle handle);
+
+    /**
+     * This is sbapi_spectrometer_get_formatted_spectrum() for a handle
+     * obtained from sbapi_spectrometer_open_acquisition().
+     *
+     * @param handle (Input) The acquisition handle
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param buffer (Output) A buffer (with memory already allocated) to
+     *      hold the spectral data
+     * @param buffer_length (Input) The length of the buffer
+     *
+     * @return the number of doubles read into the buffer
+     */
+    DLL_DECL int
+    sbapi_spectrometer_get_formatted_spectrum_by_handle(
+            sbapi_acquisition_handle handle, int *error_code,
+            double *buffer, int buffer_length);
+
+    /**
+     * This is sbapi_spectrometer_get_unformatted_spectrum() for a handle
+     * obtained from sbapi_spectrometer_open_acquisition().
+     *
+     * @param handle (Input) The acquisition handle
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param buffer (Output) A buffer (with memory already allocated) to
+     *      hold the spectral data
+     * @param buffer_length (Input) The length of the buffer
+     *
+     * @return the number of bytes read into the buffer
+     */
+    DLL_DECL int
+    sbapi_spectrometer_get_unformatted_spectrum_by_handle(
+            sbapi_acquisition_handle handle, int *error_code,
+            unsigned char *buffer, int buffer_length);
+
+    /**
+     * This acquires a spectrum like sbapi_spectrometer_get_formatted_spectrum()
+     * and also fills in its minimum, maximum, sum, the index of its maximum
+     * and the number of saturated pixels.  These are worked out while the
+     * spectrum is decoded, so they cost much less than a second pass over
+     * the buffer.  A pixel is saturated if it reaches the value returned by
+     * sbapi_spectrometer_get_maximum_intensity().  The statistics cover the
+     * whole spectrum even if the buffer is too short to hold all of it.
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param featureID (Input) The ID of a particular instance of a
+     *      spectrometer feature.  Valid IDs can be found with the
+     *      sbapi_get_spectrometer_features() function.
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.  This is set to ERROR_SPECTROMETER_SATURATED
+     *      if any pixel was saturated, in which case the spectrum and
+     *      statistics are still returned.
+     * @param buffer (Output) A buffer (with memory already allocated) to
+     *      hold the spectral data
+     * @param buffer_length (Input) The length of the buffer
+     * @param statistics (Output) Where to store the statistics
+     *
+     * @return the number of doubles read into the buffer
+     */
+    DLL_DECL int
+    sbapi_spectrometer_get_formatted_spectrum_with_statistics(long deviceID,
+            long featureID, int *error_code, double *buffer, int buffer_length,
+            sbapi_spectrum_statistics *statistics);
+
+    /**
+     * This is sbapi_spectrometer_get_formatted_spectrum_with_statistics()
+     * for a handle obtained from sbapi_spectrometer_open_acquisition().
+     *
+     * @param handle (Input) The acquisition handle
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param buffer (Output) A buffer (with memory already allocated) to
+     *      hold the spectral data
+     * @param buffer_length (Input) The length of the buffer
+     * @param statistics (Output) Where to store the statistics
+     *
+     * @return the number of doubles read into the buffer
+     */
+    DLL_DECL int
+    sbapi_spectrometer_get_formatted_spectrum_by_handle_with_statistics(
+            sbapi_acquisition_handle handle, int *error_code,
+            double *buffer, int buffer_length,
+            sbapi_spectrum_statistics *statistics);
+
+    /**
+     * This acquires a formatted spectrum like
+     * sbapi_spectrometer_get_formatted_spectrum(), but returns its pixels
+     * as 16 or 32-bit unsigned integers or as single precision floats
+     * instead of doubles.  Pixels are converted once, from the type the
+     * device sends them as, so this takes a half or a quarter of the
+     * memory bandwidth.  Spectrometers that send 32-bit pixels have them
+     * clamped to 65535 in SPECTRUM_FORMAT_UINT16, and those whose
+     * formatted spectra are scaled have them rounded to the nearest count
+     * in the integer formats.
+     *
+     * @param deviceID (Input) The index of a device previously opened with
+     *      sbapi_open_device().
+     * @param featureID (Input) The ID of a particular instance of a
+     *      spectrometer feature.  Valid IDs can be found with the
+     *      sbapi_get_spectrometer_features() function.
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param format (Input) SPECTRUM_FORMAT_UINT16, SPECTRUM_FORMAT_UINT32
+     *      or SPECTRUM_FORMAT_FLOAT32
+     * @param buffer (Output) A buffer (with memory already allocated) of
+     *      unsigned shorts, unsigned ints or floats according to format
+     * @param buffer_length (Input) The length of the buffer in pixels
+     *
+     * @return the number of pixels read into the buffer
+     */
+    DLL_DECL int
+    sbapi_spectrometer_get_spectrum_as(long deviceID, long featureID,
+            int *error_code, int format, void *buffer, int buffer_length);
+
+    /**
+     * This is sbapi_spectrometer_get_spectrum_as() for a handle obtained
+     * from sbapi_spectrometer_open_acquisition().
+     *
+     * @param handle (Input) The acquisition handle
+     * @param error_code (Output) pointer to an integer that can be used for
+     *      storing error codes.
+     * @param format (Input) SPECTRUM_FORMAT_UINT16, SPECTRUM_FORMAT_UINT32
+     *      or SPECTRUM_FORMAT_FLOAT32
+     * @param buffer (Output) A buffer (with memory already allocated) to
+     *      hold the spectral data
+     * @param buffer_length (Input) The length of the buffer in pixels
+     *
+     * @return the number of pixels read into the buffer
+     */
+    DLL_DECL int
+    sbapi_spectrometer_get_spectrum_by_handle_as(
+            sbapi_acquisition_handle handle, int *error_code, int format,
+            void *buffer, int buffer_length);
+
     /**
      * This function returns the total number of pixel binning instances available
      * in the indicated device.
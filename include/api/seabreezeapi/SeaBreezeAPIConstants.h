@@ -54,4 +54,13 @@
 #define ERROR_VALUE_NOT_EXPECTED        11
 #define ERROR_INVALID_TRIGGER_MODE        12
 
+/* Pixel types for sbapi_spectrometer_get_spectrum_as() */
+#define SPECTRUM_FORMAT_UINT16          1
+#define SPECTRUM_FORMAT_UINT32          2
+#define SPECTRUM_FORMAT_FLOAT32         3
+
+/* Device events reported by sbapi_poll_device_events() */
+#define DEVICE_EVENT_ARRIVED            1
+#define DEVICE_EVENT_DEPARTED           2
+
 #endif /* SEABREEZEAPICONSTANTS_H */
@@ -40,6 +40,8 @@
 
 #include "api/seabreezeapi/SeaBreezeAPI.h"
 #include "api/seabreezeapi/DeviceAdapter.h"
+#include <deque>
+#include <map>
 
 class SeaBreezeAPI_Impl : SeaBreezeAPI {
 public:
@@ -50,6 +52,16 @@ public:
     virtual int addRS232DeviceLocation(char *deviceTypeName, char *deviceBusPath,
         unsigned int baud);
 
+    virtual int enableDeviceEvents(int *errorCode);
+    virtual void disableDeviceEvents(int *errorCode);
+    virtual int pollDeviceEvents(int *errorCode, long *ids, int *events, unsigned int maxEvents);
+
+    virtual int getUSBPollDescriptors(int *errorCode, int *fds, short *events, unsigned int maxDescriptors);
+    virtual void handleUSBEvents(int *errorCode);
+    virtual void setFlightRecorderEnabled(int *errorCode, bool enable);
+    virtual int dumpFlightRecorder(int *errorCode, const char *path);
+    virtual void setFlightRecorderDumpFile(int *errorCode, const char *path);
+
     virtual int getNumberOfDeviceIDs();
     virtual int getDeviceIDs(long *ids, unsigned long maxLength);
     virtual int openDevice(long id, int *errorCode);
@@ -59,6 +71,15 @@ public:
 
     virtual unsigned char getDeviceEndpoint(long id, int *error_code, usbEndpointType endpointType);
 
+    virtual int getUSBEndpointMetrics(long id, int *errorCode, unsigned char endpoint,
+            unsigned long long *counters, int countersLength,
+            unsigned long long *histogram, int histogramLength);
+    virtual void resetUSBEndpointMetrics(long id, int *errorCode);
+    virtual int obpQueryBatch(long id, int *errorCode, int count,
+            const unsigned int *messageTypes,
+            const unsigned char *payloads, const int *payloadLengths,
+            unsigned char *replies, int repliesLength, int *replyLengths);
+
     /* Get raw usb access capabilities */
     virtual int getNumberOfRawUSBBusAccessFeatures(long deviceID, int *errorCode);
     virtual int getRawUSBBusAccessFeatures(long deviceID, int *errorCode, long *buffer, unsigned int maxLength);
@@ -81,6 +102,11 @@ public:
     virtual double spectrometerGetMaximumIntensity(long deviceID, long spectrometerFeatureID, int *errorCode);
     virtual int spectrometerGetUnformattedSpectrumLength(long deviceID, long spectrometerFeatureID, int *errorCode);
     virtual int spectrometerGetUnformattedSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned char *buffer, int bufferLength);
+    virtual int spectrometerBorrowUnformattedSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode, const unsigned char **buffer);
+    virtual void spectrometerReleaseUnformattedSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode);
+    virtual void spectrometerSubmitUnformattedSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode);
+    virtual int spectrometerIsUnformattedSpectrumReady(long deviceID, long spectrometerFeatureID, int *errorCode);
+    virtual int spectrometerCompleteUnformattedSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned char *buffer, int bufferLength);
     virtual int spectrometerGetFastBufferSpectrum(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned char *buffer, int bufferLength, unsigned int numberOfSamplesToRetrieve);
     virtual void spectrometerFastBufferSpectrumRequest(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned int numberOfSamplesToRetrieve);
     virtual int spectrometerFastBufferSpectrumResponse(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned char *buffer, int bufferLength, unsigned int numberOfSamplesToRetrieve);
@@ -90,6 +116,15 @@ public:
     virtual int spectrometerGetElectricDarkPixelCount(long deviceID, long spectrometerFeatureID, int *errorCode);
     virtual int spectrometerGetElectricDarkPixelIndices(long deviceID, long spectrometerFeatureID, int *errorCode, int *indices, int length);
     virtual void spectrometerSetUSBTimeout(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned int timeout);
+    virtual void spectrometerSetUSBReadQueueDepth(long deviceID, long spectrometerFeatureID, int *errorCode, unsigned int depth, bool zeroCopy);
+    virtual sbapi_acquisition_handle spectrometerOpenAcquisition(long deviceID, long spectrometerFeatureID, int *errorCode);
+    virtual void spectrometerCloseAcquisition(sbapi_acquisition_handle handle);
+    virtual int spectrometerGetFormattedSpectrum(sbapi_acquisition_handle handle, int *errorCode, double *buffer, int bufferLength);
+    virtual int spectrometerGetUnformattedSpectrum(sbapi_acquisition_handle handle, int *errorCode, unsigned char *buffer, int bufferLength);
+    virtual int spectrometerGetFormattedSpectrumWithStatistics(long deviceID, long spectrometerFeatureID, int *errorCode, double *buffer, int bufferLength, sbapi_spectrum_statistics *statistics);
+    virtual int spectrometerGetFormattedSpectrumWithStatistics(sbapi_acquisition_handle handle, int *errorCode, double *buffer, int bufferLength, sbapi_spectrum_statistics *statistics);
+    virtual int spectrometerGetSpectrumAs(long deviceID, long spectrometerFeatureID, int *errorCode, int format, void *buffer, int bufferLength);
+    virtual int spectrometerGetSpectrumAs(sbapi_acquisition_handle handle, int *errorCode, int format, void *buffer, int bufferLength);
 
     /* Pixel binning capabilities */
     virtual int getNumberOfPixelBinningFeatures(long id, int *errorCode);
@@ -351,6 +386,13 @@ private:
     std::vector<seabreeze::api::DeviceAdapter *> probedDevices;
     std::vector<seabreeze::api::DeviceAdapter *> specifiedDevices;
 
+    /* Device events: USB (VID << 16 | PID) to DeviceFactory type index,
+     * and events that have not been collected yet.
+     */
+    bool deviceEventsEnabled;
+    std::map<unsigned long, int> usbDeviceTypes;
+    std::deque<std::pair<long, int> > pendingDeviceEvents;
+
 friend class SeaBreezeAPI;
 
 };
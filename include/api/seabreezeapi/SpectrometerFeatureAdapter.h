@@ -34,6 +34,7 @@
 #define SEABREEZE_SPECTROMETER_FEATURE_ADAPTER_H
 
 #include "api/seabreezeapi/FeatureAdapterTemplate.h"
+#include "api/seabreezeapi/SeaBreezeAPI.h"
 #include "common/buses/Bus.h"
 #include "common/protocols/Protocol.h"
 #include "vendors/OceanOptics/features/spectrometer/OOISpectrometerFeatureInterface.h"
@@ -51,6 +52,11 @@ namespace seabreeze {
 
             /* Spectrometer commands */
             int getUnformattedSpectrum(int *errorCode,unsigned char *buffer, int bufferLength);
+            int borrowUnformattedSpectrum(int *errorCode, const unsigned char **buffer);
+            void releaseUnformattedSpectrum(int *errorCode);
+            void submitUnformattedSpectrum(int *errorCode);
+            int isUnformattedSpectrumReady(int *errorCode);
+            int completeUnformattedSpectrum(int *errorCode, unsigned char *buffer, int bufferLength);
             int getFastBufferSpectrum(int *errorCode, unsigned char *buffer, int bufferLength, unsigned int numberOfSamplesToRetrieve);
             void fastBufferSpectrumRequest(int *errorCode, unsigned int numberOfSamplesToRetrieve);
             int fastBufferSpectrumResponse(int *errorCode, unsigned char *buffer, int bufferLength, unsigned int numberOfSamplesToRetrieve);
@@ -72,9 +78,58 @@ namespace seabreeze {
             long getMaximumIntegrationTimeMicros(int *errorCode);
             double getMaximumIntensity(int *errorCode);
             void setTimeout(int *errorCode, unsigned int timeout);
+            void setReadQueueDepth(int *errorCode, unsigned int depth, bool zeroCopy);
+
+            /* Acquisitions through a handle, with the protocol and bus
+             * helpers looked up when the handle was opened
+             */
+            sbapi_acquisition_handle openAcquisition(int *errorCode);
+            void closeAcquisition(sbapi_acquisition_handle handle);
+            /* Called when the device is closed.  Open handles stay
+             * allocated until the caller closes them, but no longer refer
+             * to this adapter or to the bus.
+             */
+            void invalidateAcquisitions();
+            int getFormattedSpectrum(sbapi_acquisition_handle handle,
+                    int *errorCode, double *buffer, int bufferLength);
+            int getUnformattedSpectrum(sbapi_acquisition_handle handle,
+                    int *errorCode, unsigned char *buffer, int bufferLength);
+
+            /* Also report statistics gathered while decoding, setting
+             * ERROR_SPECTROMETER_SATURATED if any pixel was saturated
+             */
+            int getFormattedSpectrumWithStatistics(int *errorCode,
+                    double *buffer, int bufferLength,
+                    sbapi_spectrum_statistics *statistics);
+            int getFormattedSpectrumWithStatistics(sbapi_acquisition_handle handle,
+                    int *errorCode, double *buffer, int bufferLength,
+                    sbapi_spectrum_statistics *statistics);
+
+            /* Spectra as SPECTRUM_FORMAT_* pixels rather than doubles */
+            int getSpectrumAs(int *errorCode, int format, void *buffer,
+                    int bufferLength);
+            int getSpectrumAs(sbapi_acquisition_handle handle, int *errorCode,
+                    int format, void *buffer, int bufferLength);
+
+        private:
+            std::vector<sbapi_acquisition_handle> acquisitions;
+
+            static bool toPixelFormat(int format, PixelFormat *out);
+            int copyFormattedSpectrum(DoubleVector *spectrum, int *errorCode,
+                    double *buffer, int bufferLength,
+                    const SpectrumStatistics &decoded,
+                    sbapi_spectrum_statistics *statistics);
         };
 
     }
 }
 
+/* What an sbapi_acquisition_handle refers to.  Both pointers are NULL once
+ * the device the handle was opened on has been closed.
+ */
+struct sbapi_acquisition {
+    seabreeze::api::SpectrometerFeatureAdapter *adapter;
+    seabreeze::SpectrometerAcquisition *acquisition;
+};
+
 #endif
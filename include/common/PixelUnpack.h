@@ -0,0 +1,146 @@
+/***************************************************//**
+ * @file    PixelUnpack.h
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * PixelUnpack turns the little-endian 16-bit pixels that
+ * spectrometers send into host values.  Each routine has
+ * a plain C++ version and, where the processor has them,
+ * SSE2, AVX2 or NEON versions; the fastest one the
+ * processor running the library supports is chosen the
+ * first time any of them is used.
+ *
+ * None of them require src or dst to be aligned.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#ifndef SEABREEZE_PIXELUNPACK_H
+#define SEABREEZE_PIXELUNPACK_H
+
+#include "common/SeaBreeze.h"
+
+namespace seabreeze {
+
+    /* Figures gathered while a spectrum is decoded.  A pixel is counted as
+     * saturated if it reaches the saturation level given.
+     */
+    struct SpectrumStatistics {
+        double minimum;
+        double maximum;
+        double sum;
+        unsigned int maximumIndex;      /* First pixel holding the maximum */
+        unsigned int saturatedPixels;
+    };
+
+    class PixelUnpack {
+    public:
+        /* Copies count pixels from src, two bytes each, into dst */
+        static void unpackLE16(const byte *src, unsigned short *dst,
+                unsigned int count);
+
+        /* As unpackLE16(), but with the bits set in flip inverted.  Some
+         * detectors report a signed or offset value that is brought back
+         * into range this way, e.g. by flipping bit 15.
+         */
+        static void unpackLE16Flip(const byte *src, unsigned short *dst,
+                unsigned int count, unsigned short flip);
+
+        /* As unpackLE16(), widening each pixel as it is stored */
+        static void unpackLE16ToU32(const byte *src, unsigned int *dst,
+                unsigned int count);
+        static void unpackLE16ToDouble(const byte *src, double *dst,
+                unsigned int count);
+
+        /* As unpackLE16Flip(), widening to doubles */
+        static void unpackLE16FlipToDouble(const byte *src, double *dst,
+                unsigned int count, unsigned short flip);
+
+        /* Widens pixels that have already been unpacked */
+        static void widenToDouble(const unsigned short *src, double *dst,
+                unsigned int count);
+
+        /* As unpackLE16ToDouble() and widenToDouble(), but also filling in
+         * statistics in the same pass over the pixels.
+         */
+        static void unpackLE16ToDoubleWithStatistics(const byte *src,
+                double *dst, unsigned int count, double saturationLevel,
+                SpectrumStatistics *statistics);
+        static void widenToDoubleWithStatistics(const unsigned short *src,
+                double *dst, unsigned int count, double saturationLevel,
+                SpectrumStatistics *statistics);
+
+        /* Single precision versions of unpackLE16ToDouble() and
+         * widenToDouble(), which are exact for 16-bit pixels.
+         */
+        static void unpackLE16ToFloat(const byte *src, float *dst,
+                unsigned int count);
+        static void widenToFloat(const unsigned short *src, float *dst,
+                unsigned int count);
+        static void widenToU32(const unsigned short *src, unsigned int *dst,
+                unsigned int count);
+
+        /* Converts spectra that were not decoded as 16-bit pixels.  Values
+         * that do not fit in an integer type are clamped to its range, and
+         * doubles are rounded to the nearest integer.
+         */
+        static void convert(const unsigned int *src, unsigned short *dst,
+                unsigned int count);
+        static void convert(const unsigned int *src, float *dst,
+                unsigned int count);
+        static void convert(const double *src, unsigned short *dst,
+                unsigned int count);
+        static void convert(const double *src, unsigned int *dst,
+                unsigned int count);
+        static void convert(const double *src, float *dst,
+                unsigned int count);
+
+        /* Fills in statistics for a spectrum that is already in doubles */
+        static void computeStatistics(const double *values, unsigned int count,
+                double saturationLevel, SpectrumStatistics *statistics);
+
+        /* Corrects counts for detector gain by scaling each one by
+         * maxIntensity / saturationLevel, never going above maxIntensity.
+         * The first form works in place, the second widens as it goes.
+         */
+        static void applyGain(double *values, unsigned int count,
+                double maxIntensity, double saturationLevel);
+        static void applyGain(const unsigned short *src, double *dst,
+                unsigned int count, double maxIntensity, double saturationLevel);
+
+        /* The instruction set in use: "scalar", "sse2", "avx2" or "neon" */
+        static const char *getKernelName();
+
+        /* Uses the named instruction set from now on, so that tests can
+         * compare each one with "scalar".  Returns false, changing nothing,
+         * if it was not built in or this processor does not have it.  NULL
+         * goes back to the fastest one.  Not safe while other threads are
+         * unpacking.
+         */
+        static bool selectKernel(const char *name);
+    };
+
+}
+
+#endif /* SEABREEZE_PIXELUNPACK_H */
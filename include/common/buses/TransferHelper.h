@@ -43,6 +43,14 @@
 
 namespace seabreeze {
 
+    /* Whatever a protocol keeps for a helper from one exchange to the next.
+     * The helper does not look inside it.
+     */
+    class TransferHelperState {
+    public:
+        virtual ~TransferHelperState();
+    };
+
     class TransferHelper {
     public:
         TransferHelper();
@@ -51,6 +59,59 @@ namespace seabreeze {
             throw (BusTransferException) = 0;
         virtual int send(const std::vector<byte> &buffer, unsigned int length) const
             throw (BusTransferException) = 0;
+
+        /* Receive without handing over a copy: on return *data points at the
+         * received bytes, which belong to the helper and stay valid until
+         * releaseBorrowed().  Helpers that cannot lend out their own buffers
+         * receive into an internal one instead.
+         */
+        virtual int receiveBorrowed(const byte **data, unsigned int length)
+            throw (BusTransferException);
+        virtual void releaseBorrowed();
+
+        /* Receive into buffer starting at offset, so that a message read in
+         * more than one piece ends up in one place.  The buffer must already
+         * hold at least offset + length bytes.
+         */
+        virtual int receiveAt(std::vector<byte> &buffer, unsigned int offset,
+                unsigned int length) throw (BusTransferException);
+
+        /* The longest receive() that returns with whatever the device has
+         * sent so far rather than waiting for the full length, or zero if
+         * receive() always waits.  Protocols use this to take in a short
+         * reply with a single read.
+         */
+        virtual unsigned int getSingleReadLength();
+
+        /* Start a receive without waiting for it, so that it can complete
+         * while an event loop does other work.  Once isReceiveReady() is
+         * true, receive() returns without blocking.  Only buses that can
+         * watch for completion support this.
+         */
+        virtual void submitReceive(unsigned int length)
+            throw (BusTransferException);
+        virtual bool isReceiveReady() throw (BusTransferException);
+
+        /* Bound how long a receive waits, in milliseconds (zero is the
+         * bus's default), storing the bound it replaces in *previous so
+         * that it can be put back.  Returns false, changing nothing, on
+         * buses where receives cannot be bounded.
+         */
+        virtual bool setReceiveTimeout(unsigned int milliseconds,
+                unsigned int *previous);
+
+        /* State attached by the protocol that talks over this helper.  The
+         * helper takes ownership, deleting any state it already held, and
+         * deletes it in turn when the bus is closed and its helpers go.
+         */
+        TransferHelperState *getProtocolState();
+        void setProtocolState(TransferHelperState *state);
+
+    protected:
+        std::vector<byte> borrowBuffer;
+
+    private:
+        TransferHelperState *protocolState;
     };
 
 }
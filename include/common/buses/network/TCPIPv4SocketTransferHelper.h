@@ -43,6 +43,8 @@ namespace seabreeze {
             throw (BusTransferException);
         virtual int send(const std::vector<byte> &buffer, unsigned int length) const
             throw (BusTransferException);
+        virtual int receiveAt(std::vector<byte> &buffer, unsigned int offset,
+                unsigned int length) throw (BusTransferException);
         
     protected:
         Socket *socket;
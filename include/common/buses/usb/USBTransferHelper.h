@@ -54,15 +54,52 @@ namespace seabreeze {
             throw (BusTransferException);
         virtual int send(const std::vector<byte> &buffer, unsigned int length) const
             throw (BusTransferException);
+        virtual int receiveAt(std::vector<byte> &buffer, unsigned int offset,
+                unsigned int length) throw (BusTransferException);
+
+        // A read of up to one packet ends with the first packet, short or not
+        virtual unsigned int getSingleReadLength();
 
         // Set timeout
         virtual void setTimeout(unsigned int time);
+        virtual bool setReceiveTimeout(unsigned int milliseconds,
+                unsigned int *previous);
+
+        // Set how many reads are kept queued on the receive endpoint, and
+        // whether their buffers may be lent out by receiveBorrowed()
+        virtual void setReadQueueDepth(unsigned int depth, bool zeroCopy)
+            throw (BusTransferException);
+
+        virtual int receiveBorrowed(const byte **data, unsigned int length)
+            throw (BusTransferException);
+        virtual void releaseBorrowed();
+
+        virtual void submitReceive(unsigned int length)
+            throw (BusTransferException);
+        virtual bool isReceiveReady() throw (BusTransferException);
 
     protected:
+        int sendAt(const std::vector<byte> &buffer, unsigned int offset,
+                unsigned int length) const throw (BusTransferException);
+
+        // Helpers that pad or split transfers stage them in scratch, which
+        // is kept from one transfer to the next.  scratchAt() grows the
+        // given buffer as needed and returns the offset of a
+        // cache-line-aligned stretch of at least length bytes.  Sends and
+        // receives have their own buffers, so staging a padded request
+        // cannot overwrite a reply that is still lent out.
+        unsigned int scratchAt(std::vector<byte> &scratch,
+                unsigned int length) const;
+        mutable std::vector<byte> sendScratch;
+        std::vector<byte> receiveScratch;
+
         USB *usb;
         int sendEndpoint;
         int receiveEndpoint;
         unsigned int timeout;
+        bool zeroCopy;
+        bool borrowing;
+        int maxPacketSize;
     };
 
 }
@@ -0,0 +1,76 @@
+/***************************************************//**
+ * @file    ReplyCache.h
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * A ReplyCache remembers the replies a device gave to
+ * queries whose answers cannot change while it is open,
+ * such as its serial number or calibration coefficients,
+ * so that asking again does not have to go out on the bus.
+ * Replies are keyed by message type and request data.
+ * Which queries may be cached, and which commands make the
+ * cached replies stale, is up to the protocol using it.
+ *
+ * Each TransferHelper has one, so the cache lasts as long
+ * as the bus connection to the device.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#ifndef SEABREEZE_REPLYCACHE_H
+#define SEABREEZE_REPLYCACHE_H
+
+#include "common/SeaBreeze.h"
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace seabreeze {
+
+    class ReplyCache {
+    public:
+        ReplyCache();
+        ~ReplyCache();
+
+        /* Looks for a reply to the given request.  If there is one, *reply
+         * points at it until the next call to store() or clear(), and its
+         * length is returned.  Otherwise this returns -1.
+         */
+        int lookup(unsigned int messageType, const std::vector<byte> &request,
+                const byte **reply) const;
+
+        void store(unsigned int messageType, const std::vector<byte> &request,
+                const byte *reply, unsigned int length);
+
+        /* Forgets every reply */
+        void clear();
+
+    private:
+        typedef std::pair<unsigned int, std::vector<byte> > Key;
+        std::map<Key, std::vector<byte> > replies;
+    };
+
+}
+
+#endif /* SEABREEZE_REPLYCACHE_H */
@@ -75,6 +75,28 @@ namespace seabreeze {
         virtual ~Transfer();
         virtual Data *transfer(TransferHelper *helper) throw (ProtocolException);
 
+        /* Receives without copying into this object's buffer or a new Data
+         * object.  On return *data points at the received bytes, which stay
+         * valid until helper->releaseBorrowed() is called.  This only makes
+         * sense for FROM_DEVICE transfers whose payload is used as it
+         * arrives; subclasses that decode what they receive in transfer()
+         * do not do so here.
+         */
+        virtual int transferBorrowed(TransferHelper *helper, const byte **data)
+            throw (ProtocolException);
+
+        /* Receives a spectrum and decodes it straight into the caller's
+         * spectrum array, storing no more than length pixels, and returns
+         * the number stored.  Exchanges that can only hand their spectra
+         * back as Data from transfer() return -1 without transferring
+         * anything, which is what this does by default.
+         */
+        virtual int transferSpectrum(TransferHelper *helper, double *spectrum,
+            unsigned int length) throw (ProtocolException);
+
+        /* The number of bytes this transfer sends or receives */
+        unsigned int getLength() const;
+
         static const direction_t TO_DEVICE;
         static const direction_t FROM_DEVICE;
 
@@ -91,6 +113,14 @@ namespace seabreeze {
         Transfer();
         void checkBufferSize();
 
+        /* Moves the data across the bus through this object's own buffer
+         * without making a Data copy of it, and returns the number of bytes
+         * moved.  Derived exchanges that decode what they receive straight
+         * out of the buffer should use this rather than transfer(), which
+         * has to hand a copy back to its caller.
+         */
+        int transferInPlace(TransferHelper *helper) throw (ProtocolException);
+
         unsigned int length;
         std::vector<byte> *buffer;
         direction_t direction;
@@ -0,0 +1,127 @@
+/***************************************************//**
+ * @file    FlightRecorder.h
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * The FlightRecorder keeps the most recent bus transfers
+ * in a fixed-size ring in memory so that the traffic
+ * leading up to a problem can be examined afterwards.
+ * Recording a transfer only costs a timestamp and a short
+ * copy, so it is left on all the time; the ring is only
+ * written out when asked to, or when a malformed message
+ * is detected if a dump file has been set.
+ *
+ * A dump is a FlightRecorderHeader followed by its
+ * recordCount FlightRecords, oldest first, all in host
+ * byte order.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#ifndef SEABREEZE_FLIGHTRECORDER_H
+#define SEABREEZE_FLIGHTRECORDER_H
+
+#include <stdint.h>
+#include <string>
+
+#define FLIGHT_RECORDER_RECORDS     1024    /* Must be a power of two */
+#define FLIGHT_RECORDER_DATA_BYTES    40    /* Leading bytes kept per transfer */
+#define FLIGHT_RECORDER_VERSION        1
+
+/* Protocol errors tend to come in runs, so after an automatic dump further
+ * errors are not dumped again for this long.
+ */
+#define FLIGHT_RECORDER_DUMP_INTERVAL_MICROS    10000000
+
+/* Values for FlightRecord::bus */
+#define FLIGHT_RECORDER_BUS_USB        1
+#define FLIGHT_RECORDER_BUS_TCPIP      2
+#define FLIGHT_RECORDER_BUS_RS232      3
+
+/* As for USB, bit 7 of FlightRecord::endpoint is set for transfers into the
+ * host.  TCP/IP and RS232 only use that bit.
+ */
+#define FLIGHT_RECORDER_IN          0x80
+#define FLIGHT_RECORDER_OUT         0x00
+
+struct FlightRecorderHeader {
+    char magic[8];                  /* "SBFLIGHT" */
+    uint32_t version;               /* FLIGHT_RECORDER_VERSION */
+    uint32_t recordSize;            /* sizeof(struct FlightRecord) */
+    uint32_t recordCount;           /* Records that follow */
+    uint32_t reserved;
+};
+
+struct FlightRecord {
+    uint64_t timestampMicros;       /* System::getMonotonicMicroseconds() */
+    uint32_t sequence;              /* Counts up from 1 across all buses */
+    uint8_t bus;                    /* FLIGHT_RECORDER_BUS_* */
+    uint8_t endpoint;
+    uint16_t reserved;
+    int32_t requested;              /* Bytes asked for */
+    int32_t result;                 /* Bytes moved, or negative on failure */
+    uint8_t data[FLIGHT_RECORDER_DATA_BYTES];
+};
+
+namespace seabreeze {
+
+    class FlightRecorder {
+    public:
+        /* Notes one transfer.  The timestamp should be taken when the
+         * transfer finished; the overload without one takes it now.
+         */
+        static void record(int bus, int endpoint, const void *data,
+                int requested, int result, unsigned long timestampMicros);
+        static void record(int bus, int endpoint, const void *data,
+                int requested, int result);
+
+        static void setEnabled(bool enable);
+        static bool isEnabled();
+
+        /* Writes the ring out to the given file, replacing it.  Returns the
+         * number of records written or -1 if the file could not be written.
+         */
+        static int dump(const char *path);
+
+        /* Sets a file to dump to when a protocol error is detected, or
+         * stops doing so if path is NULL.  The first error after this is
+         * always dumped; later ones at most once per
+         * FLIGHT_RECORDER_DUMP_INTERVAL_MICROS.
+         */
+        static void setProtocolErrorDumpFile(const char *path);
+        static void protocolError();
+
+    private:
+        static struct FlightRecord records[FLIGHT_RECORDER_RECORDS];
+        static volatile long nextSequence;
+        static bool enabled;
+        static std::string protocolErrorDumpFile;
+        static volatile long protocolErrorDumpFileLock;
+        static bool protocolErrorDumped;
+        static unsigned long lastProtocolErrorDumpMicros;
+    };
+
+}
+
+#endif /* SEABREEZE_FLIGHTRECORDER_H */
@@ -41,6 +41,10 @@ extern "C" {
 
 void sleepMilliseconds(unsigned int msecs);
 int systemInitialize();
+/* Microseconds from an arbitrary fixed point; only differences are useful,
+ * and those stay correct across the wrap of the counter.
+ */
+unsigned long monotonicMicroseconds();
 void systemShutdown();
 
 /* End of C prototypes */
@@ -10,6 +10,11 @@
  * and equivalent functionality should be brought back
  * in for Windows and MacOSX.
  *
+ * On Linux these functions may be called from several
+ * threads at once.  Transfers on one open device only
+ * ever wait on that device, so one thread per device
+ * can stream while another probes for new devices.
+ *
  * LICENSE:
  *
  * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
@@ -49,10 +54,15 @@ extern "C" {
 #define CLOSE_ERROR             -1
 #define WRITE_FAILED            -1
 #define READ_FAILED             -1
+#define WRITE_TIMED_OUT         -2
+#define READ_TIMED_OUT          -2
 #define ABORT_OK                 0
 #define ABORT_FAILED            -1
 #define RESET_OK                 0
 #define RESET_FAILED            -1
+#define USB_DEVICE_ARRIVED       1
+#define USB_DEVICE_LEFT          2
+#define USB_READ_QUEUE_ZERO_COPY 0x01
 
 struct USBConfigurationDescriptor {
     unsigned char bLength;
@@ -103,6 +113,25 @@ struct USBEndpointDescriptor {
     unsigned char bInterval;
 };
 
+struct USBReadRequest {
+    unsigned char endpoint;
+    char *data;
+    int numberOfBytes;
+    int bytesRead;              /* Filled in; READ_FAILED or READ_TIMED_OUT on failure */
+};
+
+struct USBHotplugEvent {
+    unsigned long deviceID;
+    unsigned short vendorID;
+    unsigned short productID;
+    int event;                  /* USB_DEVICE_ARRIVED or USB_DEVICE_LEFT */
+};
+
+struct USBPollDescriptor {
+    int fd;
+    short events;               /* POLLIN and/or POLLOUT as for poll() */
+};
+
 //------------------------------------------------------------------------------
 // This function attempts to discover all devices with the given product
 // and vendor IDs.  Descriptors for each found device will be placed in the
@@ -121,6 +150,51 @@ int
 USBProbeDevices(int vendorID, int productID, unsigned long *output,
         int max_devices);
 
+//------------------------------------------------------------------------------
+// These functions bracket a series of USBProbeDevices() calls so that the bus
+// is only enumerated once for all of them.  USBBeginProbe() takes a snapshot
+// of the devices present and indexes it by vendor and product ID; each
+// USBProbeDevices() call until the matching USBEndProbe() looks its devices
+// up in that index instead of enumerating again.  Calls may be nested.
+//
+// RETURN VALUE:
+// USBBeginProbe() returns 0 on success or -1 if the bus could not be
+// enumerated, in which case USBEndProbe() must not be called.
+//------------------------------------------------------------------------------
+int
+USBBeginProbe(void);
+void
+USBEndProbe(void);
+
+//------------------------------------------------------------------------------
+// These functions maintain the set of known devices incrementally from hotplug
+// notifications instead of requiring a full USBProbeDevices() pass.
+// USBEnableHotplug() starts watching for devices with the given vendor and
+// product IDs and may be called once for each type of interest; devices that
+// are already attached are not reported and should be found by probing.
+// USBPollHotplugEvents() never blocks: it processes whatever notifications
+// have arrived, adds newly attached devices to the set that USBOpen() accepts,
+// forgets detached ones, and reports both.  A handle that is still open on a
+// detached device must still be released with USBClose().
+//
+// PARAMETERS:
+// vendorID:   The vendor ID to watch for
+// productID:  The product ID to watch for
+// events:     A buffer to receive up to max_events notifications
+//
+// RETURN VALUE:
+// USBEnableHotplug() returns 0 on success or -1 if hotplug notification is
+// not available.  USBPollHotplugEvents() returns the number of events stored,
+// or -1 if hotplug has never been enabled.  Events beyond max_events are kept
+// for the next call.
+//------------------------------------------------------------------------------
+int
+USBEnableHotplug(int vendorID, int productID);
+void
+USBDisableHotplug(void);
+int
+USBPollHotplugEvents(struct USBHotplugEvent *events, int max_events);
+
 //------------------------------------------------------------------------------
 // This function attempts to open a device with the given product and vendor
 // ID's at the specified index.
@@ -171,6 +245,8 @@ USBClose(void *handle);
 // Returns an integer which will be equal to either:
 //  - The number of bytes written to the endpoint if the write was successful
 //  - WRITE_FAILED if the data was not written to the device
+//  - WRITE_TIMED_OUT if the device did not accept the data in time (not
+//    distinguished from WRITE_FAILED on every platform)
 //------------------------------------------------------------------------------
 int
 USBWrite(void *handle, unsigned char endpoint, char * data, int numberOfBytes);
@@ -191,12 +267,155 @@ USBWrite_timeout(void *handle, unsigned char endpoint, char * data, int numberOf
 // Returns an integer which will be equal to either:
 //  - The number of bytes read from the endpoint if the read was successful
 //  - READ_FAILED if the data was not successfully read from the device
+//  - READ_TIMED_OUT if no data arrived in time (not distinguished from
+//    READ_FAILED on every platform)
 //------------------------------------------------------------------------------
 int
 USBRead(void *handle, unsigned char endpoint, char * data, int numberOfBytes);
 int
 USBRead_timeout(void *handle, unsigned char endpoint, char * data, int numberOfBytes, unsigned int timeout);
 
+//------------------------------------------------------------------------------
+// This function reads from several endpoints at once, for devices that split
+// one message across more than one endpoint.  All of the reads are put on the
+// bus before waiting for any of them, and each one lands directly in its own
+// destination, so the parts can simply point into one buffer.  Endpoints that
+// have a read queue (see USBSetReadQueueDepth()) are already being read ahead
+// and are served from their queue in turn.
+//
+// PARAMETERS:
+// handle: The device handle obtained via the open() function.
+// requests: The reads to make; bytesRead is filled in for each of them.
+// count: The number of requests.
+// timeout: How long to wait in milliseconds, or zero for the default.
+//
+// RETURN VALUE:
+// Returns the total number of bytes read, or READ_FAILED if any of the reads
+// failed (check bytesRead to see which, and whether it timed out).
+//------------------------------------------------------------------------------
+int
+USBReadConcurrent(void *handle, struct USBReadRequest *requests, int count,
+        unsigned int timeout);
+
+//------------------------------------------------------------------------------
+// This function sets how many bulk transfers are kept queued on the given IN
+// endpoint so that the device never has to wait for the host to issue the
+// next read.  The transfers are sized after the first read made on the
+// endpoint once the queue is enabled, so this is best suited to endpoints
+// that carry fixed-size messages such as spectra.  All later reads from the
+// endpoint are served from the queue in the order the data arrived.  Any data
+// held by a previous queue on the endpoint is discarded.  A read's timeout,
+// zero meaning no limit as for any read, covers the whole read however many
+// transfers it spans, and if it runs out or a transfer fails after some data
+// has been delivered that data is returned rather than the error.
+//
+// PARAMETERS:
+// handle: The device handle obtained via the open() function.
+// endpoint: The IN endpoint on the device to queue transfers on.
+// depth: The number of transfers to keep in flight, or zero to go back to
+//        blocking reads.
+//
+// RETURN VALUE:
+// Returns 0 on success or -1 if the queue could not be set up (including on
+// platforms where this is not supported).
+//------------------------------------------------------------------------------
+int
+USBSetReadQueueDepth(void *handle, unsigned char endpoint, int depth);
+
+//------------------------------------------------------------------------------
+// This is USBSetReadQueueDepth() with options.  USB_READ_QUEUE_ZERO_COPY
+// allocates the queued buffers from memory the kernel can transfer into
+// directly (usbfs zero-copy, where available) and allows completed buffers
+// to be borrowed with USBReadQueueAcquire() instead of copied out.
+//
+// PARAMETERS:
+// handle: The device handle obtained via the open() function.
+// endpoint: The IN endpoint on the device to queue transfers on.
+// depth: The number of transfers to keep in flight, or zero to go back to
+//        blocking reads.
+// flags: Zero or USB_READ_QUEUE_ZERO_COPY.
+//
+// RETURN VALUE:
+// Returns 0 on success or -1 if the queue could not be set up.
+//------------------------------------------------------------------------------
+int
+USBSetReadQueue(void *handle, unsigned char endpoint, int depth, int flags);
+
+//------------------------------------------------------------------------------
+// These functions lend out the next completed transfer on an endpoint that
+// has a USB_READ_QUEUE_ZERO_COPY queue, without copying it.  The data stays
+// valid until USBReadQueueRelease() is called for the endpoint, and only one
+// buffer per endpoint can be borrowed at a time.  The whole transfer is lent
+// out, so numberOfBytes only matters for sizing the queue on first use.
+//
+// PARAMETERS:
+// handle: The device handle obtained via the open() function.
+// endpoint: The IN endpoint on the device to read from.
+// numberOfBytes: The expected message size.
+// data: Set to point at the received data.
+// timeout: How long to wait in milliseconds, or zero for the default.
+//
+// RETURN VALUE:
+// USBReadQueueAcquire() returns the number of bytes available at *data,
+// READ_TIMED_OUT or READ_FAILED.  USBReadQueueRelease() returns 0 on success or -1 if nothing
+// was borrowed.
+//------------------------------------------------------------------------------
+int
+USBReadQueueAcquire(void *handle, unsigned char endpoint, int numberOfBytes,
+        unsigned char **data, unsigned int timeout);
+int
+USBReadQueueRelease(void *handle, unsigned char endpoint);
+
+//------------------------------------------------------------------------------
+// These functions let a read queue be driven from an external event loop
+// instead of a blocking read.  USBReadQueueSubmit() makes sure transfers
+// are in flight on the endpoint, setting up a queue of depth one if there
+// is none.  Once USBReadQueueReady() reports that the oldest transfer has
+// completed, USBRead() on the endpoint returns its data without waiting.
+//
+// PARAMETERS:
+// handle: The device handle obtained via the open() function.
+// endpoint: The IN endpoint on the device to read from.
+// numberOfBytes: The expected message size, used to size the queue.
+//
+// RETURN VALUE:
+// USBReadQueueSubmit() returns 0 on success or -1 on error.
+// USBReadQueueReady() returns 1 if data is ready, 0 if the transfer is still
+// pending, or -1 if nothing has been submitted on the endpoint.
+//------------------------------------------------------------------------------
+int
+USBReadQueueSubmit(void *handle, unsigned char endpoint, int numberOfBytes);
+int
+USBReadQueueReady(void *handle, unsigned char endpoint);
+
+//------------------------------------------------------------------------------
+// This function provides the file descriptors that become ready when any
+// open device has USB activity, for use with poll(), epoll or select().
+// Whenever one of them is ready, USBHandleEvents() must be called to let the
+// transfers complete.  The set can change as devices are opened and closed,
+// so it should be fetched again after either.
+//
+// PARAMETERS:
+// descriptors: A buffer that receives the file descriptors.
+// max_descriptors: The number of entries in the buffer.
+//
+// RETURN VALUE:
+// Returns the total number of descriptors, which may exceed max_descriptors,
+// or -1 if this is not supported on the platform.
+//------------------------------------------------------------------------------
+int
+USBGetPollDescriptors(struct USBPollDescriptor *descriptors, int max_descriptors);
+
+//------------------------------------------------------------------------------
+// This function completes any USB transfers that are ready, without
+// blocking.
+//
+// RETURN VALUE:
+// Returns 0 on success or -1 on error.
+//------------------------------------------------------------------------------
+int
+USBHandleEvents(void);
+
 //------------------------------------------------------------------------------
 // This function attempts to clear any stall on the given endpoint.
 //
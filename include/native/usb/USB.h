@@ -34,6 +34,24 @@
 #include "native/usb/NativeUSB.h"
 #include <string>
 
+/* Latency bucket i counts transfers that took less than 2^i microseconds
+ * but at least 2^(i-1); the last bucket also takes everything slower.
+ */
+#define USB_LATENCY_BUCKETS 32
+#define USB_METRICS_ENDPOINTS 32    /* 16 endpoint numbers, IN and OUT */
+
+/* The counters are 64 bits wide everywhere, since a fast spectrometer can
+ * move 4 GiB in a few minutes.
+ */
+struct USBEndpointMetrics {
+    unsigned long long bytes;           /* Total bytes moved */
+    unsigned long long transfers;       /* Transfers that moved any data */
+    unsigned long long shortTransfers;  /* Transfers that moved less than asked */
+    unsigned long long timeouts;
+    unsigned long long errors;          /* Failures other than timeouts */
+    unsigned long long latencyHistogram[USB_LATENCY_BUCKETS];
+};
+
 namespace seabreeze {
 
     /* Empty declaration of USBDiscovery to deal with cross-includes */
@@ -47,16 +65,46 @@ namespace seabreeze {
         bool close();
         int write(int endpoint, void *data, unsigned int length_bytes, unsigned int timeout=0);
         int read(int endpoint, void *data, unsigned int length_bytes, unsigned int timeout=0);
+        /* Issue several reads at once, each into its own destination */
+        int readConcurrent(struct USBReadRequest *requests, int count, unsigned int timeout=0);
         void clearStall(int endpoint);
+        /* Keep up to depth reads queued on the given IN endpoint; zero
+         * restores plain blocking reads.  With zeroCopy the buffers come
+         * from memory the kernel can transfer into directly and can be
+         * borrowed with acquireReadBuffer().
+         */
+        int setReadQueueDepth(int endpoint, int depth, bool zeroCopy=false);
+        /* Borrow the next received buffer on a zero-copy queue instead of
+         * copying it out; it stays valid until releaseReadBuffer().
+         */
+        int acquireReadBuffer(int endpoint, unsigned int length_bytes,
+                unsigned char **data, unsigned int timeout=0);
+        int releaseReadBuffer(int endpoint);
+        /* Get reads in flight on the given IN endpoint without waiting for
+         * them; once isReadReady() returns 1, read() will not block.  The
+         * transfers only complete while USBDiscovery::handleEvents() runs.
+         */
+        int submitQueuedRead(int endpoint, unsigned int length_bytes);
+        int isReadReady(int endpoint);
 
         static void setVerbose(bool v);
 
+        /* Counters for every transfer made on the given endpoint address
+         * since the device was opened or the counters were last reset.
+         */
+        int getEndpointMetrics(int endpoint, struct USBEndpointMetrics *metrics);
+        void resetEndpointMetrics();
+
         int getDeviceDescriptor(struct USBDeviceDescriptor *desc);
         int getInterfaceDescriptor(struct USBInterfaceDescriptor *desc);
         /* Get the endpoint descriptor where index is the endpoint index. */
         int getEndpointDescriptor(int index, struct USBEndpointDescriptor *epDesc);
         std::string *getStringDescriptor(int index);
         int getMaxPacketSize();
+        /* wMaxPacketSize of the endpoint with the given address, or -1 if
+         * the interface does not have it.
+         */
+        int getEndpointMaxPacketSize(int endpoint);
 
         bool isOpened();
 
@@ -73,10 +121,14 @@ namespace seabreeze {
         void describeTransfer(const char *label, int length, void* data, int endpoint, bool hexdump);
         USB(unsigned long deviceID);
 
+        void recordTransfer(int endpoint, const void *data, unsigned int length_bytes,
+                int result, unsigned long startMicros);
+
         void *descriptor;
         bool opened;
         static bool verbose;
         unsigned long deviceID;
+        struct USBEndpointMetrics metrics[USB_METRICS_ENDPOINTS];
     };
 
 }
@@ -52,6 +52,32 @@ namespace seabreeze {
          */
         std::vector<unsigned long> *probeDevices(int vendorID, int productID);
 
+        /**
+         * Brackets a series of probeDevices() calls (e.g. one for every
+         * known device type) so that the bus is only enumerated once for
+         * all of them.  Every successful beginProbe() must be matched by
+         * a call to endProbe().
+         */
+        static bool beginProbe();
+        static void endProbe();
+
+        /**
+         * Watches for devices with the given VID and PID being attached or
+         * detached.  Notifications are collected with pollHotplugEvents(),
+         * which never blocks and returns the number of events stored.
+         */
+        static bool enableHotplug(int vendorID, int productID);
+        static void disableHotplug();
+        static int pollHotplugEvents(struct USBHotplugEvent *events, int maxEvents);
+
+        /**
+         * Provides the file descriptors to watch for USB activity on any
+         * open device, and completes whatever transfers are ready once one
+         * of them is.  handleEvents() never blocks.
+         */
+        static int getPollDescriptors(struct USBPollDescriptor *descriptors, int maxDescriptors);
+        static bool handleEvents();
+
         /**
          * Given an identifier from probeDevices(), create a USB interface to
          * the device that can be used to open/write/read/close the device.
@@ -0,0 +1,183 @@
+/***************************************************//**
+ * @file    NativeUSBReplay.h
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * This provides a USB backend that plays back a trace of
+ * recorded USB traffic instead of talking to hardware,
+ * and the hooks a real backend uses to record such a
+ * trace.  It allows the full driver stack to be exercised
+ * and benchmarked without a spectrometer attached.
+ *
+ * When built with USB_REPLAY_BACKEND defined, the replay
+ * code implements NativeUSB.h itself and replaces the
+ * native backend entirely.  Otherwise its entry points
+ * carry a ReplayUSB prefix and the native backend hands
+ * every call over to them while USBReplayActive() is true.
+ *
+ * Trace files are plain text, one record per line, with
+ * numbers in C notation and payloads as hex digits, or
+ * '.' for an empty payload:
+ *
+ *   device <id> <vid> <pid>
+ *   devdesc <id> <14 device descriptor fields>
+ *   ifdesc <id> <9 interface descriptor fields>
+ *   epdesc <id> <index> <6 endpoint descriptor fields>
+ *   string <id> <index> <hex>
+ *   write <id> <endpoint> <hex>
+ *   read <id> <endpoint> <hex>   (or '-' for a failed read)
+ *   loop
+ *
+ * Reads are handed out per device and endpoint in the order
+ * they were recorded.  Once the reads on an endpoint run out,
+ * replay continues from the first of its reads after the
+ * 'loop' record, so a trace of one acquisition cycle can be
+ * replayed indefinitely.  Writes are accepted without being
+ * checked.  Lines starting with '#' are ignored.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#ifndef NATIVEUSBREPLAY_H
+#define NATIVEUSBREPLAY_H
+
+#include "native/usb/NativeUSB.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* cplusplus */
+
+/* Environment variables naming the trace to replay or the file to record */
+#define USB_REPLAY_ENV           "SEABREEZE_USB_REPLAY"
+#define USB_CAPTURE_ENV          "SEABREEZE_USB_CAPTURE"
+
+//------------------------------------------------------------------------------
+// These report whether a trace is being replayed or recorded, as selected by
+// the environment variables above when the library is first used.
+//------------------------------------------------------------------------------
+int
+USBReplayActive(void);
+int
+USBCaptureActive(void);
+
+//------------------------------------------------------------------------------
+// These append records to the capture file.  A real backend calls them as
+// devices are found and as descriptors and data pass through it.  A
+// negative length records a failed read.
+//------------------------------------------------------------------------------
+void
+USBCaptureDevice(unsigned long deviceID, unsigned short vendorID,
+        unsigned short productID);
+void
+USBCaptureDeviceDescriptor(unsigned long deviceID,
+        const struct USBDeviceDescriptor *desc);
+void
+USBCaptureInterfaceDescriptor(unsigned long deviceID,
+        const struct USBInterfaceDescriptor *desc);
+void
+USBCaptureEndpointDescriptor(unsigned long deviceID, int endpoint_index,
+        const struct USBEndpointDescriptor *desc);
+void
+USBCaptureStringDescriptor(unsigned long deviceID, unsigned int string_index,
+        const char *buffer, int length);
+void
+USBCaptureWrite(unsigned long deviceID, unsigned char endpoint,
+        const char *data, int length);
+void
+USBCaptureRead(unsigned long deviceID, unsigned char endpoint,
+        const char *data, int length);
+
+#ifndef USB_REPLAY_BACKEND
+
+//------------------------------------------------------------------------------
+// The replay implementation of each NativeUSB.h function, for a native
+// backend to hand over to.  See NativeUSB.h for their descriptions.
+//------------------------------------------------------------------------------
+int
+ReplayUSBProbeDevices(int vendorID, int productID, unsigned long *output,
+        int max_devices);
+int
+ReplayUSBBeginProbe(void);
+void
+ReplayUSBEndProbe(void);
+int
+ReplayUSBEnableHotplug(int vendorID, int productID);
+void
+ReplayUSBDisableHotplug(void);
+int
+ReplayUSBPollHotplugEvents(struct USBHotplugEvent *events, int max_events);
+void *
+ReplayUSBOpen(unsigned long deviceID, int *errorCode);
+int
+ReplayUSBClose(void *handle);
+int
+ReplayUSBWrite(void *handle, unsigned char endpoint, char * data, int numberOfBytes);
+int
+ReplayUSBWrite_timeout(void *handle, unsigned char endpoint, char * data,
+        int numberOfBytes, unsigned int timeout);
+int
+ReplayUSBRead(void *handle, unsigned char endpoint, char * data, int numberOfBytes);
+int
+ReplayUSBRead_timeout(void *handle, unsigned char endpoint, char * data,
+        int numberOfBytes, unsigned int timeout);
+int
+ReplayUSBReadConcurrent(void *handle, struct USBReadRequest *requests, int count,
+        unsigned int timeout);
+int
+ReplayUSBSetReadQueueDepth(void *handle, unsigned char endpoint, int depth);
+int
+ReplayUSBSetReadQueue(void *handle, unsigned char endpoint, int depth, int flags);
+int
+ReplayUSBReadQueueAcquire(void *handle, unsigned char endpoint, int numberOfBytes,
+        unsigned char **data, unsigned int timeout);
+int
+ReplayUSBReadQueueRelease(void *handle, unsigned char endpoint);
+int
+ReplayUSBReadQueueSubmit(void *handle, unsigned char endpoint, int numberOfBytes);
+int
+ReplayUSBReadQueueReady(void *handle, unsigned char endpoint);
+int
+ReplayUSBGetPollDescriptors(struct USBPollDescriptor *descriptors, int max_descriptors);
+int
+ReplayUSBHandleEvents(void);
+void
+ReplayUSBClearStall(void *handle, unsigned char endpoint);
+int
+ReplayUSBGetDeviceDescriptor(void *handle, struct USBDeviceDescriptor *desc);
+int
+ReplayUSBGetInterfaceDescriptor(void *handle, struct USBInterfaceDescriptor *desc);
+int
+ReplayUSBGetEndpointDescriptor(void *handle, int endpoint_index,
+        struct USBEndpointDescriptor *desc);
+int
+ReplayUSBGetStringDescriptor(void *handle, unsigned int string_index,
+        char *buffer, int maxLength);
+
+#endif /* USB_REPLAY_BACKEND */
+
+#ifdef __cplusplus
+}
+#endif /* _cplusplus */
+
+#endif /* NATIVEUSBREPLAY_H */
@@ -49,11 +49,21 @@ namespace seabreeze {
         /* Inherited */
         virtual int receive(std::vector<byte> &buffer, unsigned int length)
             throw (BusTransferException);
+        virtual int receiveAt(std::vector<byte> &buffer, unsigned int offset,
+                unsigned int length) throw (BusTransferException);
+        virtual unsigned int getSingleReadLength();
+        virtual void setReadQueueDepth(unsigned int depth, bool zeroCopy)
+            throw (BusTransferException);
+        virtual int receiveBorrowed(const byte **data, unsigned int length)
+            throw (BusTransferException);
+        virtual void releaseBorrowed();
+        virtual void submitReceive(unsigned int length)
+            throw (BusTransferException);
+        virtual bool isReceiveReady() throw (BusTransferException);
 
     private:
         int secondaryHighSpeedEP;
-        std::vector<byte> primaryReadBuffer;
-        std::vector<byte> secondaryReadBuffer;
+        bool primarySubmitted;
     };
 
 }
@@ -42,6 +42,7 @@
 #include "vendors/OceanOptics/features/spectrometer/OOISpectrometerFeatureInterface.h"
 #include "vendors/OceanOptics/features/introspection/IntrospectionFeature.h"
 #include "vendors/OceanOptics/features/fast_buffer/FlameXFastBufferFeature.h"
+#include "common/buses/usb/USBTransferHelper.h"
 
 
 
@@ -60,6 +61,42 @@ namespace seabreeze {
         virtual ByteVector *getUnformattedSpectrum(const Protocol &protocol,
                 const Bus &bus) throw (FeatureException);
 
+        /* Look up what acquisitions go through once, then acquire with it */
+        virtual SpectrometerAcquisition *resolveAcquisition(const Protocol &protocol,
+                const Bus &bus) throw (FeatureException);
+
+        virtual DoubleVector *getFormattedSpectrum(
+                const SpectrometerAcquisition &acquisition) throw (FeatureException);
+
+        virtual ByteVector *getUnformattedSpectrum(
+                const SpectrometerAcquisition &acquisition) throw (FeatureException);
+
+        /* Formatted spectra along with their statistics */
+        virtual DoubleVector *getFormattedSpectrum(const Protocol &protocol,
+                const Bus &bus, SpectrumStatistics *statistics) throw (FeatureException);
+
+        virtual DoubleVector *getFormattedSpectrum(
+                const SpectrometerAcquisition &acquisition,
+                SpectrumStatistics *statistics) throw (FeatureException);
+
+        /* Formatted spectra decoded into the caller's buffer */
+        virtual unsigned int getFormattedSpectrum(const Protocol &protocol,
+                const Bus &bus, double *buffer, unsigned int bufferLength)
+                throw (FeatureException);
+
+        virtual unsigned int getFormattedSpectrum(
+                const SpectrometerAcquisition &acquisition, double *buffer,
+                unsigned int bufferLength) throw (FeatureException);
+
+        /* Formatted spectra in the caller's choice of pixel type */
+        virtual unsigned int getFormattedSpectrumAs(const Protocol &protocol,
+                const Bus &bus, PixelFormat format, void *buffer,
+                unsigned int bufferLength) throw (FeatureException);
+
+        virtual unsigned int getFormattedSpectrumAs(
+                const SpectrometerAcquisition &acquisition, PixelFormat format,
+                void *buffer, unsigned int bufferLength) throw (FeatureException);
+
         virtual ByteVector *getFastBufferSpectrum(const Protocol &protocol,
             const Bus &bus, unsigned int numberOfSamplesToRetrieve) throw (FeatureException);
 
@@ -80,6 +117,20 @@ namespace seabreeze {
         virtual ByteVector *readFastBufferSpectrum(const Protocol &protocol,
             const Bus &bus, unsigned int numberOfSamplesToReceive) throw (FeatureException);
 
+        /* Request and read out the raw spectrum data stream without copying it */
+        virtual int borrowUnformattedSpectrum(const Protocol &protocol,
+            const Bus &bus, const byte **data) throw (FeatureException);
+
+        virtual void releaseUnformattedSpectrum(const Protocol &protocol,
+            const Bus &bus) throw (FeatureException);
+
+        /* Request the raw spectrum data stream without waiting for it */
+        virtual void submitUnformattedSpectrum(const Protocol &protocol,
+            const Bus &bus) throw (FeatureException);
+
+        virtual bool isUnformattedSpectrumReady(const Protocol &protocol,
+            const Bus &bus) throw (FeatureException);
+
         /* Set the integration time of the spectrometer */
         virtual void setIntegrationTimeMicros(const Protocol &protocol,
                 const Bus &bus, unsigned long time_usec)
@@ -115,12 +166,21 @@ namespace seabreeze {
         virtual int getMaximumIntensity() const;
 
         virtual void setTimeout(const Bus &bus, unsigned int timeout) throw (FeatureException);
+        virtual void setReadQueueDepth(const Bus &bus, unsigned int depth,
+                bool zeroCopy) throw (FeatureException);
 
         /* Overriding from Feature */
         virtual FeatureFamily getFeatureFamily();
 
     protected:
 
+        /* Fills in an acquisition that the caller owns */
+        void resolveAcquisition(const Protocol &protocol, const Bus &bus,
+                SpectrometerAcquisition *acquisition) throw (FeatureException);
+
+        /* Looks up the USB helper that spectra are read through */
+        USBTransferHelper *getSpectrumUSBHelper(const Bus &bus) throw (FeatureException);
+
         /* introspection feature */
         IntrospectionFeature *myIntrospection;
         FlameXFastBufferFeature *myFastBuffer;
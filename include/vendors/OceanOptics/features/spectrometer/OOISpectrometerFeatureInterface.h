@@ -33,6 +33,7 @@
 #include <vector>
 #include "common/ByteVector.h"
 #include "common/DoubleVector.h"
+#include "common/PixelUnpack.h"
 #include "common/protocols/Protocol.h"
 #include "common/buses/Bus.h"
 #include "common/exceptions/FeatureException.h"
@@ -41,6 +42,15 @@
 
 namespace seabreeze {
 
+    class SpectrometerAcquisition;
+
+    /* Pixel types that formatted spectra can be returned as */
+    enum PixelFormat {
+        PIXEL_UINT16,
+        PIXEL_UINT32,
+        PIXEL_FLOAT32
+    };
+
     class OOISpectrometerFeatureInterface {
     public:
         virtual ~OOISpectrometerFeatureInterface() = 0;
@@ -53,6 +63,57 @@ namespace seabreeze {
         virtual ByteVector *getUnformattedSpectrum(const Protocol &protocol,
                 const Bus &bus) throw (FeatureException) = 0;
 
+        /* Find the protocol implementation and transfer helpers that
+         * acquisitions over the given protocol and bus go through.  The
+         * result belongs to the caller; passing it to the two calls after
+         * this one skips those lookups, which are otherwise made on every
+         * acquisition.
+         */
+        virtual SpectrometerAcquisition *resolveAcquisition(const Protocol &protocol,
+                const Bus &bus) throw (FeatureException) = 0;
+
+        virtual DoubleVector *getFormattedSpectrum(
+                const SpectrometerAcquisition &acquisition) throw (FeatureException) = 0;
+
+        virtual ByteVector *getUnformattedSpectrum(
+                const SpectrometerAcquisition &acquisition) throw (FeatureException) = 0;
+
+        /* As getFormattedSpectrum(), also working out the figures in
+         * statistics while the spectrum is decoded.  Pixels that reach
+         * getMaximumIntensity() are counted as saturated.
+         */
+        virtual DoubleVector *getFormattedSpectrum(const Protocol &protocol,
+                const Bus &bus, SpectrumStatistics *statistics) throw (FeatureException) = 0;
+
+        virtual DoubleVector *getFormattedSpectrum(
+                const SpectrometerAcquisition &acquisition,
+                SpectrumStatistics *statistics) throw (FeatureException) = 0;
+
+        /* As getFormattedSpectrum(), but storing up to bufferLength pixels
+         * in the caller's buffer, into which the spectrum is decoded where
+         * the protocol allows.  Returns the number of pixels stored.
+         */
+        virtual unsigned int getFormattedSpectrum(const Protocol &protocol,
+                const Bus &bus, double *buffer, unsigned int bufferLength)
+                throw (FeatureException) = 0;
+
+        virtual unsigned int getFormattedSpectrum(
+                const SpectrometerAcquisition &acquisition, double *buffer,
+                unsigned int bufferLength) throw (FeatureException) = 0;
+
+        /* As getFormattedSpectrum(), but storing up to bufferLength pixels
+         * as format in buffer instead of returning doubles.  Integer
+         * formats clamp pixels that do not fit.  Returns the number of
+         * pixels stored.
+         */
+        virtual unsigned int getFormattedSpectrumAs(const Protocol &protocol,
+                const Bus &bus, PixelFormat format, void *buffer,
+                unsigned int bufferLength) throw (FeatureException) = 0;
+
+        virtual unsigned int getFormattedSpectrumAs(
+                const SpectrometerAcquisition &acquisition, PixelFormat format,
+                void *buffer, unsigned int bufferLength) throw (FeatureException) = 0;
+
         virtual ByteVector *getFastBufferSpectrum(const Protocol &protocol,
             const Bus &bus, unsigned int numberOfSamplesToRetrieve) throw (FeatureException) = 0;
 
@@ -74,6 +135,25 @@ namespace seabreeze {
         virtual ByteVector *readFastBufferSpectrum(const Protocol &protocol,
             const Bus &bus, unsigned int numberOfSamplesToRetrieve) throw (FeatureException) = 0;
 
+        /* Request and read out the raw spectrum data stream without copying
+         * it.  *data stays valid until releaseUnformattedSpectrum().
+         */
+        virtual int borrowUnformattedSpectrum(const Protocol &protocol,
+            const Bus &bus, const byte **data) throw (FeatureException) = 0;
+
+        virtual void releaseUnformattedSpectrum(const Protocol &protocol,
+            const Bus &bus) throw (FeatureException) = 0;
+
+        /* Request the raw spectrum data stream without waiting for it.  Once
+         * isUnformattedSpectrumReady() is true, readUnformattedSpectrum()
+         * returns it without blocking.
+         */
+        virtual void submitUnformattedSpectrum(const Protocol &protocol,
+            const Bus &bus) throw (FeatureException) = 0;
+
+        virtual bool isUnformattedSpectrumReady(const Protocol &protocol,
+            const Bus &bus) throw (FeatureException) = 0;
+
         /* Set the integration time of the spectrometer */
         virtual void setIntegrationTimeMicros(const Protocol &protocol,
                 const Bus &bus, unsigned long time_usec)
@@ -109,6 +189,8 @@ namespace seabreeze {
         virtual int getMaximumIntensity() const = 0;
 
         virtual void setTimeout(const Bus &bus, unsigned int timeout) throw (FeatureException) = 0;
+        virtual void setReadQueueDepth(const Bus &bus, unsigned int depth,
+                bool zeroCopy) throw (FeatureException) = 0;
 
     };
 
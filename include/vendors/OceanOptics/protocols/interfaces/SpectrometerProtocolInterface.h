@@ -38,6 +38,7 @@
 #include "common/SeaBreeze.h"
 #include "common/ByteVector.h"
 #include "common/DoubleVector.h"
+#include "common/PixelUnpack.h"
 #include "common/buses/Bus.h"
 #include "common/exceptions/ProtocolException.h"
 #include "common/protocols/ProtocolHelper.h"
@@ -45,6 +46,22 @@
 
 namespace seabreeze {
 
+    class SpectrometerProtocolInterface;
+
+    /* Everything that acquiring a spectrum through one spectrometer protocol
+     * on one bus goes through, found once by resolveAcquisition() so that
+     * repeated acquisitions do not have to look it up each time.  It stays
+     * valid for as long as the bus stays open.
+     */
+    class SpectrometerAcquisition {
+    public:
+        SpectrometerProtocolInterface *protocol;
+        TransferHelper *requestFormattedHelper;
+        TransferHelper *readFormattedHelper;
+        TransferHelper *requestUnformattedHelper;
+        TransferHelper *readUnformattedHelper;
+    };
+
     class SpectrometerProtocolInterface : public ProtocolHelper {
     public:
         SpectrometerProtocolInterface(Protocol *protocol);
@@ -57,6 +74,54 @@ namespace seabreeze {
         virtual ByteVector *readFastBufferSpectrum(const Bus &bus, unsigned int numberOfSamplesToRetrieve) throw (ProtocolException) = 0;
         virtual void setIntegrationTimeMicros(const Bus &bus, unsigned long time_usec) throw (ProtocolException) = 0;
         virtual void setTriggerMode(const Bus &bus,SpectrometerTriggerMode &mode) throw (ProtocolException) = 0;
+
+        /* Looks up the transfer helpers that the calls below take, which
+         * the calls above look up on the bus every time.
+         */
+        virtual void resolveAcquisition(const Bus &bus,
+                SpectrometerAcquisition *acquisition) throw (ProtocolException) = 0;
+        virtual void requestFormattedSpectrum(TransferHelper *helper) throw (ProtocolException) = 0;
+        virtual DoubleVector *readFormattedSpectrum(TransferHelper *helper) throw (ProtocolException) = 0;
+
+        /* As above, also filling in statistics on the spectrum as it is
+         * decoded.  Pixels at or above saturationLevel count as saturated.
+         */
+        virtual DoubleVector *readFormattedSpectrum(TransferHelper *helper,
+                double saturationLevel, SpectrumStatistics *statistics) throw (ProtocolException) = 0;
+
+        /* Reads a formatted spectrum as the exchange decoded it, without
+         * widening it to doubles.  This is a UShortVector or U32Vector of
+         * counts, or a DoubleVector for exchanges that scale the pixels.
+         * The result belongs to the caller.
+         */
+        virtual Data *readNativeSpectrum(TransferHelper *helper) throw (ProtocolException) = 0;
+
+        /* Reads a formatted spectrum into the caller's array, storing at
+         * most length pixels, and returns the number stored.  Exchanges
+         * that support it decode straight into the array; otherwise the
+         * spectrum is copied there from readFormattedSpectrum().
+         */
+        virtual unsigned int readFormattedSpectrum(TransferHelper *helper,
+                double *spectrum, unsigned int length) throw (ProtocolException) = 0;
+        virtual void requestUnformattedSpectrum(TransferHelper *helper) throw (ProtocolException) = 0;
+        virtual ByteVector *readUnformattedSpectrum(TransferHelper *helper) throw (ProtocolException) = 0;
+
+        /* Reads an unformatted spectrum and hands it out without the caller
+         * owning a copy.  On return *data points at the spectrum, which
+         * stays valid until releaseUnformattedSpectrum() is called.  Only
+         * the OOI protocol lends out the buffer the spectrum was received
+         * into; OBP holds on to a copy from readUnformattedSpectrum().
+         */
+        virtual int borrowUnformattedSpectrum(const Bus &bus, const byte **data) throw (ProtocolException) = 0;
+        virtual void releaseUnformattedSpectrum(const Bus &bus) throw (ProtocolException) = 0;
+
+        /* Requests an unformatted spectrum with the read for it already in
+         * flight, so that completion can be watched for instead of waited on.
+         * Once isUnformattedSpectrumReady() is true, readUnformattedSpectrum()
+         * does not block.
+         */
+        virtual void submitUnformattedSpectrum(const Bus &bus) throw (ProtocolException) = 0;
+        virtual bool isUnformattedSpectrumReady(const Bus &bus) throw (ProtocolException) = 0;
     };
 
 }
@@ -32,6 +32,7 @@
 
 #include <vector>
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPTransaction.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPPipeline.h"
 
 namespace seabreeze {
     namespace oceanBinaryProtocol {
@@ -43,6 +44,13 @@ namespace seabreeze {
             using OBPTransaction::sendCommandToDevice;
             virtual bool sendCommandToDevice(TransferHelper *helper) throw (ProtocolException);
 
+            /* Sends this command through the pipeline without waiting for the
+             * acknowledgment, returning the token to collect it with.
+             * OBPPipeline::collect() returns -1 if the command was refused.
+             */
+            virtual unsigned int submitCommand(OBPPipeline &pipeline)
+                    throw (ProtocolException);
+
         protected:
             int messageType;
             std::vector<byte> payload;
@@ -0,0 +1,117 @@
+/***************************************************//**
+ * @file    OBPFastBufferSpectra.h
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * A fast buffer read hands back a run of spectra, each a
+ * 64-byte metadata block, then the pixels, then a 4-byte
+ * checksum.  OBPFastBufferSpectra lays a view over such a
+ * payload where it is, so that the spectra in it can be
+ * walked through and their metadata read without copying
+ * anything.  The payload must outlive the view and any
+ * OBPFastBufferSpectrum taken from it.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#ifndef OBPFASTBUFFERSPECTRA_H
+#define OBPFASTBUFFERSPECTRA_H
+
+#include "common/SeaBreeze.h"
+
+#define OBP_FAST_BUFFER_METADATA_LENGTH     64
+#define OBP_FAST_BUFFER_CHECKSUM_LENGTH      4
+
+/* Offsets of the fields in the metadata block, all little-endian */
+#define OBP_FAST_BUFFER_SPECTRUM_COUNT_OFFSET       0   /* 4 bytes */
+#define OBP_FAST_BUFFER_TICK_COUNT_OFFSET           4   /* 8 bytes */
+#define OBP_FAST_BUFFER_INTEGRATION_TIME_OFFSET    12   /* 4 bytes */
+#define OBP_FAST_BUFFER_TRIGGER_MODE_OFFSET        18   /* 1 byte */
+
+namespace seabreeze {
+  namespace oceanBinaryProtocol {
+
+    struct OBPFastBufferSpectrum {
+        unsigned int spectrumCount;         /* Counts up with each spectrum taken */
+        unsigned long long tickCount;       /* Microseconds since power up */
+        unsigned int integrationTimeMicros;
+        byte triggerMode;
+        const byte *metadata;               /* The raw block, for other fields */
+        const byte *pixels;                 /* Little-endian pixel values */
+        unsigned int checksum;
+    };
+
+    class OBPFastBufferSpectra {
+    public:
+        class const_iterator {
+        public:
+            const_iterator() : view(0), index(0) { }
+            const OBPFastBufferSpectrum &operator*() const { parse(); return this->spectrum; }
+            const OBPFastBufferSpectrum *operator->() const { parse(); return &(this->spectrum); }
+            const_iterator &operator++() { this->index++; return *this; }
+            const_iterator operator++(int) { const_iterator old(*this); this->index++; return old; }
+            bool operator==(const const_iterator &that) const { return this->index == that.index; }
+            bool operator!=(const const_iterator &that) const { return this->index != that.index; }
+
+        private:
+            friend class OBPFastBufferSpectra;
+            const_iterator(const OBPFastBufferSpectra *v, unsigned int i) : view(v), index(i) { }
+            void parse() const { this->view->getSpectrum(this->index, &(this->spectrum)); }
+
+            const OBPFastBufferSpectra *view;
+            unsigned int index;
+            mutable OBPFastBufferSpectrum spectrum;
+        };
+
+        /* Any bytes after the last whole spectrum in the payload are left
+         * out, so size() is how many spectra can safely be looked at.
+         */
+        OBPFastBufferSpectra(const byte *payload, unsigned int length,
+                unsigned int numberOfPixels, unsigned int bytesPerPixel);
+        ~OBPFastBufferSpectra();
+
+        unsigned int size() const;
+        unsigned int getNumberOfPixels() const;
+        unsigned int getBytesPerPixel() const;
+
+        /* index must be less than size() */
+        void getSpectrum(unsigned int index, OBPFastBufferSpectrum *spectrum) const;
+
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        static unsigned int getRecordLength(unsigned int numberOfPixels,
+                unsigned int bytesPerPixel);
+
+    private:
+        const byte *payload;
+        unsigned int count;
+        unsigned int numberOfPixels;
+        unsigned int bytesPerPixel;
+        unsigned int recordLength;
+    };
+  }
+}
+
+#endif /* OBPFASTBUFFERSPECTRA_H */
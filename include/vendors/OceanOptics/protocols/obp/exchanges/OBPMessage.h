@@ -43,8 +43,31 @@
 #include "common/SeaBreeze.h"
 #include "common/exceptions/IllegalArgumentException.h"
 
+#define OBP_MESSAGE_HEADER_LENGTH       44
+#define OBP_MESSAGE_OVERHEAD_LENGTH     64  /* Header, checksum and footer */
+#define OBP_MESSAGE_TRAILER_LENGTH      20  /* Checksum and footer */
+
+#define OBP_MESSAGE_FLAGS_RESPONSE      (1 << 0)
+#define OBP_MESSAGE_FLAGS_ACK           (1 << 1)
+#define OBP_MESSAGE_FLAGS_ACK_REQUESTED (1 << 2)
+#define OBP_MESSAGE_FLAGS_NACK          (1 << 3)
+#define OBP_MESSAGE_FLAGS_EXCEPTION     (1 << 4)
+
 namespace seabreeze {
   namespace oceanBinaryProtocol {
+
+    /* The fixed fields at the start of every OBP message */
+    struct OBPHeader {
+        unsigned short protocolVersion;
+        unsigned short flags;
+        unsigned short errorNumber;
+        unsigned int messageType;
+        unsigned int regarding;
+        byte checksumType;
+        byte immediateDataLength;
+        unsigned int bytesRemaining;
+    };
+
     class OBPMessage {
     public:
         OBPMessage();
@@ -53,6 +76,34 @@ namespace seabreeze {
         static OBPMessage *parseHeaderFromByteStream(std::vector<byte> *stream) throw (IllegalArgumentException);
         static OBPMessage *parseByteStream(std::vector<byte> *stream) throw (IllegalArgumentException);
 
+        /* These work on buffers that the caller keeps, and so allocate
+         * nothing.  writeByteStream() formats a complete message into stream,
+         * growing it only if it is too small, and returns the message length.
+         * parseHeader() reads the first OBP_MESSAGE_HEADER_LENGTH bytes of a
+         * message.  findData() checks the footer of a complete message of the
+         * given length and points *data at its immediate data or payload,
+         * returning the number of bytes there.  checkTrailer() does the
+         * same footer check on the OBP_MESSAGE_TRAILER_LENGTH bytes that
+         * follow a payload, for messages whose payload was read apart from
+         * the header.  patchData() replaces the
+         * data in a message that writeByteStream() formatted with data of
+         * the same length; nothing else in the message depends on the data
+         * since no checksum is sent.
+         */
+        static unsigned int writeByteStream(std::vector<byte> &stream,
+                unsigned int messageType, unsigned short flags,
+                unsigned int regarding, const byte *data,
+                unsigned int dataLength);
+        static void patchData(byte *stream, const byte *data,
+                unsigned int dataLength);
+        static void parseHeader(const byte *stream, OBPHeader *header)
+                throw (IllegalArgumentException);
+        static unsigned int findData(const byte *stream, unsigned int length,
+                const OBPHeader &header, const byte **data)
+                throw (IllegalArgumentException);
+        static void checkTrailer(const byte *trailer)
+                throw (IllegalArgumentException);
+
         std::vector<byte> *toByteStream();
         std::vector<byte> *getData();
         unsigned int getBytesRemaining();
@@ -0,0 +1,134 @@
+/***************************************************//**
+ * @file    OBPPipeline.h
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * An OBPPipeline lets one caller have several OBP requests
+ * outstanding on a device at once instead of waiting for
+ * each reply before sending the next request.  It is the
+ * transport behind OBPQueryBatch and is meant for that kind
+ * of batch, where a single owner submits a group of
+ * requests and then collects all of their replies.
+ *
+ * Each request carries a token in the "regarding" field of
+ * its header, which the device copies into its reply, so a
+ * reply can be matched to its request whatever order the
+ * replies come in.  Where a device leaves the field zero,
+ * replies are matched to the oldest outstanding request of
+ * the same message type instead.  Replies that arrive ahead
+ * of the one being collected are held in the pipeline until
+ * their own collect() call.
+ *
+ * This is not a shared transport.  Routing replies to other
+ * threads or exchanges that are waiting on the same device
+ * is not implemented: OBPTransaction::queryDevice(), the
+ * fast buffer exchanges and everything else still work in
+ * lockstep on the TransferHelper and do not go through a
+ * pipeline.  While requests are outstanding, nothing else
+ * may use the helper, or replies will be taken by the wrong
+ * reader.  A pipeline is not itself thread-safe; the caller
+ * must already hold the device for the whole batch.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#ifndef OBPPIPELINE_H
+#define OBPPIPELINE_H
+
+#include <vector>
+#include "common/buses/TransferHelper.h"
+#include "common/exceptions/ProtocolException.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPMessage.h"
+
+#define OBP_PIPELINE_DEPTH  8   /* Default limit on requests in flight */
+#define OBP_PIPELINE_DRAIN_TIMEOUT_MILLIS   100
+
+namespace seabreeze {
+    namespace oceanBinaryProtocol {
+        class OBPPipeline {
+        public:
+            OBPPipeline(TransferHelper *helper,
+                    unsigned int maximumInFlight = OBP_PIPELINE_DEPTH);
+            ~OBPPipeline();
+
+            /* Sends a request and returns at once with a nonzero token to
+             * collect its reply with.  If the pipeline is full this throws
+             * rather than waiting, since only collect() frees a place.
+             */
+            unsigned int submit(unsigned int messageType, unsigned short flags,
+                    const std::vector<byte> &data) throw (ProtocolException);
+
+            /* Waits for the reply to the given request, holding on to any
+             * other replies that arrive first until they are collected in
+             * turn.  On return
+             * *reply points at the reply's data, which stays valid until the
+             * next call to submit().  Returns the number of bytes of data, or
+             * -1 if the device refused the request.
+             */
+            int collect(unsigned int token, const byte **reply)
+                    throw (ProtocolException);
+
+            unsigned int getNumberInFlight() const;
+
+            /* Gives up on every request in flight.  Replies still owed are
+             * read and thrown away, waiting at most timeoutMillis for each,
+             * so that they are not taken for replies to later requests.
+             * Where the bus cannot bound a receive nothing is read.  Returns
+             * the number of replies that were thrown away.
+             */
+            unsigned int drain(unsigned int timeoutMillis) throw();
+
+        private:
+            struct Request {
+                unsigned int token;
+                unsigned int messageType;
+                unsigned long order;
+                bool inFlight;
+                bool arrived;
+                bool refused;
+                std::vector<byte> message;
+                unsigned int dataOffset;
+                unsigned int dataLength;
+            };
+
+            void receiveReply() throw (ProtocolException);
+            Request *findRequest(unsigned int token);
+            Request *matchReply(const OBPHeader &header);
+
+            TransferHelper *helper;
+            std::vector<Request> requests;
+            std::vector<byte> frame;
+            std::vector<byte> scratch;
+            unsigned int nextToken;
+            unsigned long nextOrder;
+            unsigned int inFlight;
+
+            /* Not copyable */
+            OBPPipeline(const OBPPipeline &that);
+            OBPPipeline &operator=(const OBPPipeline &that);
+        };
+    }
+}
+
+#endif /* OBPPIPELINE_H */
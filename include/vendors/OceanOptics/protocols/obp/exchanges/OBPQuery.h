@@ -31,6 +31,7 @@
 #define OBPQUERY_H
 
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPTransaction.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPPipeline.h"
 #include <vector>
 
 namespace seabreeze {
@@ -43,9 +44,23 @@ namespace seabreeze {
             using OBPTransaction::queryDevice;
             virtual std::vector<byte> *queryDevice(TransferHelper *helper) throw (ProtocolException) ;
 
+            /* See OBPTransaction::queryDeviceInPlace() */
+            using OBPTransaction::queryDeviceInPlace;
+            virtual int queryDeviceInPlace(TransferHelper *helper,
+                    const byte **reply) throw (ProtocolException);
+
+            /* Sends this query through the pipeline without waiting for the
+             * reply, returning the token to collect it with.
+             */
+            virtual unsigned int submitQuery(OBPPipeline &pipeline)
+                    throw (ProtocolException);
+
         protected:
             int messageType;
             std::vector<byte> payload;
+
+            /* Takes copies of queries as they stand when added */
+            friend class OBPQueryBatch;
         };
     }
 }
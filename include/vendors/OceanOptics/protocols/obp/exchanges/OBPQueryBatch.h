@@ -0,0 +1,118 @@
+/***************************************************//**
+ * @file    OBPQueryBatch.h
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * An OBPQueryBatch runs a list of OBP queries against one
+ * device as a single operation.  The requests are written
+ * back-to-back through an OBPPipeline and the replies are
+ * drained in order, so the batch costs about one round trip
+ * on the bus rather than one per query.  This suits polling
+ * a handful of small values such as temperatures, GPIO
+ * vectors or buffer counts.
+ *
+ * The queries are kept in the batch, and so is the
+ * pipeline along with its buffers, so the same batch can be
+ * run repeatedly without allocating.  Nothing else may use
+ * the device from the first request of a run to its last
+ * reply, since the pipeline does not route replies to other
+ * exchanges.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#ifndef OBPQUERYBATCH_H
+#define OBPQUERYBATCH_H
+
+#include <vector>
+#include "common/buses/TransferHelper.h"
+#include "common/exceptions/ProtocolException.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPTransaction.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPQuery.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPPipeline.h"
+
+namespace seabreeze {
+    namespace oceanBinaryProtocol {
+        class OBPQueryBatch : public OBPTransaction {
+        public:
+            OBPQueryBatch(unsigned int maximumInFlight = OBP_PIPELINE_DEPTH);
+            virtual ~OBPQueryBatch();
+
+            /* Adds a query to the end of the batch and returns its index.
+             * The query's message type and payload are copied, so the same
+             * exchange can be changed and added again, as for reading a set
+             * of indexed coefficients.
+             */
+            unsigned int add(const OBPQuery &query);
+
+            /* Adds a query for a message type with the given payload */
+            unsigned int add(unsigned int messageType,
+                    const std::vector<byte> &payload);
+
+            /* Removes all of the queries */
+            void clear();
+
+            unsigned int getNumberOfQueries() const;
+
+            /* Sends every query and waits for all of the replies.  Queries
+             * already answered in the helper's OBPTransport are not sent.  The
+             * helper must stay the same between runs for the pipeline's
+             * buffers to be reused.  If this throws, replies still owed
+             * for queries that were already sent are drained first (see
+             * OBPPipeline::drain()) so that the next exchange on the
+             * helper does not read one of them as its own.
+             */
+            void run(TransferHelper *helper) throw (ProtocolException);
+
+            /* The data from the reply to the query with the given index in
+             * the last run.  This is empty if the device refused the query.
+             */
+            const std::vector<byte> &getReply(unsigned int index) const;
+
+            /* Whether the device refused the query with the given index */
+            bool wasRefused(unsigned int index) const;
+
+        private:
+            struct Entry {
+                unsigned int messageType;
+                std::vector<byte> payload;
+                unsigned int token;
+                bool refused;
+                std::vector<byte> reply;
+            };
+
+            std::vector<Entry> entries;
+            unsigned int numberOfEntries;
+            unsigned int maximumInFlight;
+            OBPPipeline *pipeline;
+            TransferHelper *pipelineHelper;
+
+            /* Not copyable */
+            OBPQueryBatch(const OBPQueryBatch &that);
+            OBPQueryBatch &operator=(const OBPQueryBatch &that);
+        };
+    }
+}
+
+#endif /* OBPQUERYBATCH_H */
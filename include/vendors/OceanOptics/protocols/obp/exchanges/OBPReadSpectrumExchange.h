@@ -41,6 +41,8 @@ namespace seabreeze {
 
         /* Inherited */
         virtual Data *transfer(TransferHelper *helper) throw (ProtocolException);
+        virtual int transferSpectrum(TransferHelper *helper, double *spectrum,
+            unsigned int length) throw (ProtocolException);
     };
   }
 }
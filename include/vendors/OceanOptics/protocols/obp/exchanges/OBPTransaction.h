@@ -55,6 +55,17 @@ namespace seabreeze {
 
             virtual const std::vector<ProtocolHint *> &getHints();
 
+            /* Whether the reply to a query of the given type cannot change
+             * while the device is open, so it may be kept in the ReplyCache
+             * of the helper's OBPTransport.
+             */
+            static bool isCacheable(unsigned int messageType);
+
+            /* Whether a command of the given type may change the reply to a
+             * cacheable query, so the cache must be cleared.
+             */
+            static bool invalidatesCache(unsigned int messageType);
+
         protected:
             /* This creates a message of the given type and payload and sends it
              * to the device.  The reply is formatted into a byte vector.  Any
@@ -64,6 +75,18 @@ namespace seabreeze {
                     unsigned int messageType,
                     std::vector<byte> &data) throw (ProtocolException);
 
+            /* As queryDevice(), but the request and reply are formatted in
+             * the buffers of the helper's OBPTransport rather than newly
+             * allocated ones.  On return *reply points at the reply's data
+             * in the transport's reply buffer, which stays valid until the
+             * next exchange on that helper.  Returns the number of bytes of data, or -1 where
+             * queryDevice() would return NULL.
+             */
+            virtual int queryDeviceInPlace(TransferHelper *helper,
+                    unsigned int messageType,
+                    const std::vector<byte> &data,
+                    const byte **reply) throw (ProtocolException);
+
             /* This creates a message of the given type and payload and sends it
              * to the device.  No response (other than an acknowledgment) is
              * expected.  This will return true if the command was acknowledged
@@ -77,6 +100,18 @@ namespace seabreeze {
                     std::vector<byte> &data) throw (ProtocolException);
 
             std::vector<ProtocolHint *> *hints;
+
+        private:
+            void sendRequest(TransferHelper *helper, unsigned int messageType,
+                    unsigned short flags, const std::vector<byte> &data)
+                    throw (ProtocolException);
+            /* Returns false if what arrived was not an OBP header.  The
+             * reply lands in the transport's reply buffer, and as much of it
+             * as the bus lets one read take may arrive with the header;
+             * received says how much that was.
+             */
+            bool receiveReplyHeader(TransferHelper *helper, OBPHeader *header,
+                    unsigned int *received) throw (BusException);
         };
     }
 }
@@ -0,0 +1,112 @@
+/***************************************************//**
+ * @file    OBPTransport.h
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * An OBPTransport holds what the OBP exchanges keep for
+ * one TransferHelper from one exchange to the next: the
+ * buffers requests and replies are formatted in, a note of
+ * which request the request buffer holds, the replies that
+ * may be answered without asking the device again, and how
+ * long a read to start each reply with.  It is attached to
+ * the helper the first time an exchange asks for it and
+ * goes away with the helper when the bus is closed, so a
+ * device that is opened again starts with nothing cached.
+ *
+ * Only one exchange at a time may use a transport.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#ifndef OBPTRANSPORT_H
+#define OBPTRANSPORT_H
+
+#include <vector>
+#include "common/buses/TransferHelper.h"
+#include "common/protocols/ReplyCache.h"
+
+namespace seabreeze {
+    namespace oceanBinaryProtocol {
+
+        /* What the request buffer currently holds, so that an exchange
+         * sending the same kind of message again only has to patch its
+         * data.  A length of zero means it holds nothing that can be reused.
+         */
+        struct RequestFrame {
+            unsigned int length;
+            unsigned int messageType;
+            unsigned int flags;
+            unsigned int dataLength;
+        };
+
+        class OBPTransport : public TransferHelperState {
+        public:
+            virtual ~OBPTransport();
+
+            /* The transport for the given helper, attaching a new one to it
+             * if it has none yet.
+             */
+            static OBPTransport *getTransport(TransferHelper *helper);
+
+            std::vector<byte> &getRequestBuffer();
+            std::vector<byte> &getReplyBuffer();
+
+            /* Describes the request buffer.  Anything that formats a request
+             * there must keep this up to date, or set its length to zero.
+             */
+            RequestFrame &getRequestFrame();
+
+            /* Replies to queries whose answers cannot change while the device
+             * is open (see OBPTransaction::isCacheable()).  Anything that
+             * sends a command which could change one of them must clear this.
+             * Traffic written directly to the bus, such as through raw USB
+             * access, is not seen here.
+             */
+            ReplyCache &getReplyCache();
+
+            /* How many bytes to ask for when reading the start of a reply:
+             * the 64-byte block holding its header, or more where the bus
+             * hands back whatever has arrived from a single read, so that a
+             * short reply comes in whole with its header.
+             */
+            unsigned int getHeaderReadLength();
+
+        private:
+            OBPTransport(TransferHelper *helper);
+
+            TransferHelper *helper;
+            std::vector<byte> requestBuffer;
+            std::vector<byte> replyBuffer;
+            RequestFrame requestFrame;
+            ReplyCache replyCache;
+            unsigned int headerReadLength;
+
+            /* Not copyable */
+            OBPTransport(const OBPTransport &that);
+            OBPTransport &operator=(const OBPTransport &that);
+        };
+    }
+}
+
+#endif /* OBPTRANSPORT_H */
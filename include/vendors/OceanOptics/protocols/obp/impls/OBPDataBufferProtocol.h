@@ -36,6 +36,10 @@
 
 namespace seabreeze {
     namespace oceanBinaryProtocol {
+        class OBPGetDataBufferElementCountExchange;
+        class OBPGetDataBufferCapacityExchange;
+        class OBPGetDataBufferMaximumCapacityExchange;
+
         class OBPDataBufferProtocol : public DataBufferProtocolInterface {
         public:
             OBPDataBufferProtocol();
@@ -68,6 +72,13 @@ namespace seabreeze {
                     const unsigned long capacity)
                     throw (ProtocolException);
 
+        private:
+            /* The element count is polled while a buffer fills; the
+             * queries are kept rather than rebuilt for every call.
+             */
+            OBPGetDataBufferElementCountExchange *getDataBufferElementCountExchange;
+            OBPGetDataBufferCapacityExchange *getDataBufferCapacityExchange;
+            OBPGetDataBufferMaximumCapacityExchange *getDataBufferMaximumCapacityExchange;
         };
     } /* end namespace oceanBinaryProtocol */
 } /* end namespace seabreeze */
@@ -36,6 +36,9 @@
 
 namespace seabreeze {
     namespace oceanBinaryProtocol {
+        class OBPGetFastBufferingEnableExchange;
+        class OBPGetConsecutiveSampleCountExchange;
+
         class OBPFastBufferProtocol : public FastBufferProtocolInterface {
         public:
             OBPFastBufferProtocol();
@@ -58,6 +61,11 @@ namespace seabreeze {
                 unsigned char bufferIndex,
                 const unsigned int consecutiveSampleCount)
                 throw (ProtocolException);
+
+        private:
+            /* Reused across calls so the getters do not allocate */
+            OBPGetFastBufferingEnableExchange *getFastBufferingEnableExchange;
+            OBPGetConsecutiveSampleCountExchange *getConsecutiveSampleCountExchange;
         };
     } /* end namespace oceanBinaryProtocol */
 } /* end namespace seabreeze */
@@ -36,6 +36,20 @@
 
 namespace seabreeze {
   namespace oceanBinaryProtocol {
+    class OBPGetGPIONumberOfPinsExchange;
+    class OBPGetGPIOOutputEnableVectorExchange;
+    class OBPSetGPIOOutputEnableVectorExchange;
+    class OBPGetGPIOValueVectorExchange;
+    class OBPSetGPIOValueVectorExchange;
+    class OBPGetGPIOExtensionNumberOfPinsExchange;
+    class OBPGetGPIOExtensionAvailableModesExchange;
+    class OBPGetGPIOExtensionCurrentModeExchange;
+    class OBPSetGPIOExtensionModeExchange;
+    class OBPGetGPIOExtensionOutputVectorExchange;
+    class OBPSetGPIOExtensionOutputVectorExchange;
+    class OBPGetGPIOExtensionValueExchange;
+    class OBPSetGPIOExtensionValueExchange;
+
     class OBPGPIOProtocol : public GPIOProtocolInterface {
     public:
         OBPGPIOProtocol();
@@ -69,6 +83,24 @@ namespace seabreeze {
             throw (ProtocolException);
         virtual void setEGPIO_Value(const Bus &bus, unsigned char pinNumber, float value)
             throw (ProtocolException);
+
+    private:
+        /* One exchange per message, created with the protocol so that
+         * reading or toggling pins in a loop does not rebuild them.
+         */
+        OBPGetGPIONumberOfPinsExchange *getGPIONumberOfPinsExchange;
+        OBPGetGPIOOutputEnableVectorExchange *getGPIOOutputEnableVectorExchange;
+        OBPSetGPIOOutputEnableVectorExchange *setGPIOOutputEnableVectorExchange;
+        OBPGetGPIOValueVectorExchange *getGPIOValueVectorExchange;
+        OBPSetGPIOValueVectorExchange *setGPIOValueVectorExchange;
+        OBPGetGPIOExtensionNumberOfPinsExchange *getGPIOExtensionNumberOfPinsExchange;
+        OBPGetGPIOExtensionAvailableModesExchange *getGPIOExtensionAvailableModesExchange;
+        OBPGetGPIOExtensionCurrentModeExchange *getGPIOExtensionCurrentModeExchange;
+        OBPSetGPIOExtensionModeExchange *setGPIOExtensionModeExchange;
+        OBPGetGPIOExtensionOutputVectorExchange *getGPIOExtensionOutputVectorExchange;
+        OBPSetGPIOExtensionOutputVectorExchange *setGPIOExtensionOutputVectorExchange;
+        OBPGetGPIOExtensionValueExchange *getGPIOExtensionValueExchange;
+        OBPSetGPIOExtensionValueExchange *setGPIOExtensionValueExchange;
     };
   }
 }
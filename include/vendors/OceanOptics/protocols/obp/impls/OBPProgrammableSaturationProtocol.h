@@ -36,6 +36,8 @@
 
 namespace seabreeze {
     namespace oceanBinaryProtocol {
+        class OBPGetSaturationExchange;
+
         class OBPProgrammableSaturationProtocol
                 : public ProgrammableSaturationProtocolInterface {
         public:
@@ -45,6 +47,10 @@ namespace seabreeze {
             /* Inherited from ProgrammableSaturationProtocolInterface */
             virtual unsigned int getSaturation(const Bus &bus)
                 throw (ProtocolException);
+
+        private:
+            /* Built once; callers tend to re-read saturation per scan */
+            OBPGetSaturationExchange *getSaturationExchange;
         };
     } /* end namespace oceanBinaryProtocol */
 } /* end namespace seabreeze */
@@ -75,6 +75,21 @@ namespace seabreeze {
         virtual ByteVector *readFastBufferSpectrum(const Bus &bus, unsigned int numberOfSamplesToRetrieve) throw (ProtocolException);
         virtual void setIntegrationTimeMicros(const Bus &bus, unsigned long time_usec) throw (ProtocolException);
         virtual void setTriggerMode(const Bus &bus, SpectrometerTriggerMode &mode) throw (ProtocolException);
+        virtual void resolveAcquisition(const Bus &bus,
+                SpectrometerAcquisition *acquisition) throw (ProtocolException);
+        virtual void requestFormattedSpectrum(TransferHelper *helper) throw (ProtocolException);
+        virtual DoubleVector *readFormattedSpectrum(TransferHelper *helper) throw (ProtocolException);
+        virtual DoubleVector *readFormattedSpectrum(TransferHelper *helper,
+                double saturationLevel, SpectrumStatistics *statistics) throw (ProtocolException);
+        virtual Data *readNativeSpectrum(TransferHelper *helper) throw (ProtocolException);
+        virtual unsigned int readFormattedSpectrum(TransferHelper *helper,
+                double *spectrum, unsigned int length) throw (ProtocolException);
+        virtual void requestUnformattedSpectrum(TransferHelper *helper) throw (ProtocolException);
+        virtual ByteVector *readUnformattedSpectrum(TransferHelper *helper) throw (ProtocolException);
+        virtual int borrowUnformattedSpectrum(const Bus &bus, const byte **data) throw (ProtocolException);
+        virtual void releaseUnformattedSpectrum(const Bus &bus) throw (ProtocolException);
+        virtual void submitUnformattedSpectrum(const Bus &bus) throw (ProtocolException);
+        virtual bool isUnformattedSpectrumReady(const Bus &bus) throw (ProtocolException);
 
     private:
         OBPIntegrationTimeExchange *integrationTimeExchange;
@@ -89,6 +104,11 @@ namespace seabreeze {
         Transfer *requestFastBufferSpectrumExchange;
         Transfer *readFastBufferSpectrumExchange;
         OBPTriggerModeExchange *triggerModeExchange;
+
+        /* OBP spectra come wrapped in a message, so a borrowed spectrum is
+         * a copy kept here until it is released.
+         */
+        ByteVector *borrowedSpectrum;
     };
   }
 }
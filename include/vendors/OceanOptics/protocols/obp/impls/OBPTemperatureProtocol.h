@@ -37,6 +37,10 @@
 
 namespace seabreeze {
   namespace oceanBinaryProtocol {
+    class OBPGetTemperatureExchange;
+    class OBPGetAllTemperaturesExchange;
+    class OBPGetTemperatureCountExchange;
+
     class OBPTemperatureProtocol : public TemperatureProtocolInterface {
     public:
         OBPTemperatureProtocol();
@@ -48,6 +52,14 @@ namespace seabreeze {
                 throw (ProtocolException);               
         virtual std::vector<double> *readAllTemperatures(const Bus &bus)
                 throw (ProtocolException);
+
+    private:
+        /* Temperatures are polled, so the exchanges are built once and
+         * reused rather than rebuilt (with their hints) on every read.
+         */
+        OBPGetTemperatureExchange *temperatureExchange;
+        OBPGetAllTemperaturesExchange *allTemperaturesExchange;
+        OBPGetTemperatureCountExchange *temperatureCountExchange;
     };
   }
 }
@@ -44,6 +44,8 @@ namespace seabreeze {
 
         /* Inherited */
         virtual Data *transfer(TransferHelper *helper) throw (ProtocolException);
+        virtual int transferSpectrum(TransferHelper *helper, double *spectrum,
+            unsigned int length) throw (ProtocolException);
 
     protected:
         /* This is necessary so that the saturation level which is determined
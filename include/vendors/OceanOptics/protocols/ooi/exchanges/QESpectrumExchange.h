@@ -43,6 +43,12 @@ namespace seabreeze {
 
         /* Inherited */
         virtual Data *transfer(TransferHelper *helper) throw (ProtocolException);
+        virtual int transferSpectrum(TransferHelper *helper, double *spectrum,
+            unsigned int length) throw (ProtocolException);
+
+    protected:
+        /* Moves a spectrum into this->buffer and checks its synch byte */
+        void receiveSpectrum(TransferHelper *helper) throw (ProtocolException);
     };
   }
 }
@@ -54,6 +54,7 @@
 
 #define SPECTRA_PER_TRIGGER 50000
 #define NUMBER_SPECTRA_TO_RETRIEVE 15 // current max available from the OceanFX
+#define OCEANFX_PIXELS 2136
 #define FAST_BUFFER_ENABLED 1
 #define DISPLAY_PERIOD 5
 #define OCEANFX_TRIGGER_MODE 0x00
@@ -281,7 +282,7 @@ void ocean_fx_standard_speed_test(long deviceID, long data_buffer_feature_id, lo
     static struct ocean_fx_raw_spectrum_with_meta_data
     {
         uint8_t meta_data[64];
-        uint16_t pixel_values[2136];
+        uint16_t pixel_values[OCEANFX_PIXELS];
         uint32_t checksum;
     } spectral_data[NUMBER_SPECTRA_TO_RETRIEVE];
 
@@ -322,7 +323,7 @@ void ocean_fx_standard_speed_test(long deviceID, long data_buffer_feature_id, lo
                 }
 
                 bytesReturned = sbapi_spectrometer_get_fast_buffer_spectrum(deviceID, spectrometer_feature_id, &error, (unsigned char *)spectral_data, sizeof(spectral_data), NUMBER_SPECTRA_TO_RETRIEVE);
-                spectra_retrieved += (bytesReturned / (sizeof(spectral_data[0])));
+                spectra_retrieved += sbapi_fast_buffer_get_number_of_spectra(&error, (unsigned char *)spectral_data, bytesReturned, OCEANFX_PIXELS);
                 loopCount++;
             }
 
@@ -359,7 +360,7 @@ void ocean_fx_split_speed_test(long deviceID, long data_buffer_feature_id, long
     static struct ocean_fx_raw_spectrum_with_meta_data
     {
         uint8_t meta_data[64];
-        uint16_t pixel_values[2136];
+        uint16_t pixel_values[OCEANFX_PIXELS];
         uint32_t checksum;
     } spectral_data[NUMBER_SPECTRA_TO_RETRIEVE];
 
@@ -406,7 +407,7 @@ void ocean_fx_split_speed_test(long deviceID, long data_buffer_feature_id, long
                 //bytesReturned = sbapi_spectrometer_get_fast_buffer_spectrum(deviceID, spectrometer_feature_id, &error, (unsigned char *)spectral_data, sizeof(spectral_data), NUMBER_SPECTRA_TO_RETRIEVE);
                 bytesReturned = sbapi_spectrometer_fast_buffer_spectrum_response(deviceID, spectrometer_feature_id, &error, (unsigned char *)spectral_data, sizeof(spectral_data), NUMBER_SPECTRA_TO_RETRIEVE);
 
-                spectra_retrieved += (bytesReturned / (sizeof(spectral_data[0])));
+                spectra_retrieved += sbapi_fast_buffer_get_number_of_spectra(&error, (unsigned char *)spectral_data, bytesReturned, OCEANFX_PIXELS);
                 loopCount++;
             }
             bytesReturned = sbapi_spectrometer_fast_buffer_spectrum_response(deviceID, spectrometer_feature_id, &error, (unsigned char *)spectral_data, sizeof(spectral_data), NUMBER_SPECTRA_TO_RETRIEVE);
@@ -34,6 +34,8 @@
 #include "api/seabreezeapi/DeviceAdapter.h"  // references device.h
 #include "api/seabreezeapi/FeatureFamilies.h"
 #include "api/seabreezeapi/SeaBreezeAPIConstants.h"
+#include "common/buses/usb/USBInterface.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPQueryBatch.h"
 #include <string>
 #include <string.h>
 
@@ -63,6 +65,7 @@ vector<T *> *__sbapi_getFeatures(Device *dev) {
 DeviceAdapter::DeviceAdapter(Device *dev, unsigned long id) {
     this->device = dev;
     this->instanceID = id;
+    this->queryBatch = NULL;
 
     if(NULL == this->device) {
         std::string error("Null device is not allowed.");
@@ -111,6 +114,7 @@ DeviceAdapter::~DeviceAdapter() {
     __delete_feature_adapters<FirmwareVersionFeatureAdapter>(firmwareVersionFeatures);
     __delete_feature_adapters<FPGARegisterFeatureAdapter>(fpgaRegisterFeatures);
 
+    delete this->queryBatch;
     delete this->device;
 }
 
@@ -327,6 +331,18 @@ int DeviceAdapter::open(int *errorCode) {
 }
 
 void DeviceAdapter::close() {
+    vector<SpectrometerFeatureAdapter *>::iterator iter;
+
+    /* The batch's pipeline belongs to the bus that is being closed */
+    delete this->queryBatch;
+    this->queryBatch = NULL;
+
+    /* So do the helpers that acquisition handles resolved */
+    for(iter = this->spectrometerFeatures.begin();
+            iter != this->spectrometerFeatures.end(); iter++) {
+        (*iter)->invalidateAcquisitions();
+    }
+
     this->device->close();
 }
 
@@ -397,6 +413,134 @@ unsigned char DeviceAdapter::getDeviceEndpoint(int *errorCode, usbEndpointType e
     return this->device->getEndpoint(errorCode, endpointType);
 }
 
+/* Finds the USB descriptor behind the bus the device was opened on, if any */
+static USB *__getOpenedUSB(Device *device) {
+    USBInterface *usb = dynamic_cast<USBInterface *>(device->getOpenedBus());
+    if(NULL == usb) {
+        return NULL;
+    }
+    return usb->getUSBDescriptor();
+}
+
+int DeviceAdapter::getUSBEndpointMetrics(int *errorCode, unsigned char endpoint,
+        unsigned long long *counters, int countersLength,
+        unsigned long long *histogram, int histogramLength) {
+    struct USBEndpointMetrics metrics;
+    unsigned long long values[5];
+    int i;
+
+    USB *usb = __getOpenedUSB(this->device);
+    if(NULL == usb || usb->getEndpointMetrics(endpoint, &metrics) < 0) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return -1;
+    }
+
+    if((NULL == counters && countersLength > 0)
+            || (NULL == histogram && histogramLength > 0)) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return -1;
+    }
+
+    values[0] = metrics.bytes;
+    values[1] = metrics.transfers;
+    values[2] = metrics.shortTransfers;
+    values[3] = metrics.timeouts;
+    values[4] = metrics.errors;
+    for(i = 0; i < countersLength && i < 5; i++) {
+        counters[i] = values[i];
+    }
+    for(i = 0; i < histogramLength && i < USB_LATENCY_BUCKETS; i++) {
+        histogram[i] = metrics.latencyHistogram[i];
+    }
+
+    SET_ERROR_CODE(ERROR_SUCCESS);
+    return USB_LATENCY_BUCKETS;
+}
+
+void DeviceAdapter::resetUSBEndpointMetrics(int *errorCode) {
+    USB *usb = __getOpenedUSB(this->device);
+    if(NULL == usb) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return;
+    }
+
+    usb->resetEndpointMetrics();
+    SET_ERROR_CODE(ERROR_SUCCESS);
+}
+
+int DeviceAdapter::obpQueryBatch(int *errorCode, int count,
+        const unsigned int *messageTypes,
+        const unsigned char *payloads, const int *payloadLengths,
+        unsigned char *replies, int repliesLength, int *replyLengths) {
+    vector<byte> payload;
+    TransferHelper *helper;
+    Bus *bus;
+    int payloadOffset = 0;
+    int replyOffset = 0;
+    int length;
+    int i;
+
+    if(count < 0 || (count > 0 && (NULL == messageTypes || NULL == replyLengths))
+            || (NULL == replies && repliesLength > 0)) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return -1;
+    }
+
+    if(NULL == this->queryBatch) {
+        this->queryBatch = new oceanBinaryProtocol::OBPQueryBatch();
+    }
+
+    /* Only buses that carry OBP have a helper for its hints */
+    bus = this->device->getOpenedBus();
+    helper = (NULL == bus) ? NULL : bus->getHelper(this->queryBatch->getHints());
+    if(NULL == helper) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return -1;
+    }
+
+    this->queryBatch->clear();
+    for(i = 0; i < count; i++) {
+        length = (NULL == payloadLengths) ? 0 : payloadLengths[i];
+        if(length < 0 || (length > 0 && NULL == payloads)) {
+            SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+            return -1;
+        }
+        payload.assign(payloads + payloadOffset, payloads + payloadOffset + length);
+        payloadOffset += length;
+        this->queryBatch->add(messageTypes[i], payload);
+    }
+
+    try {
+        this->queryBatch->run(helper);
+    } catch (ProtocolException &pe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return -1;
+    }
+
+    /* The replies are packed one after another, and any that do not fit
+     * are cut short.
+     */
+    for(i = 0; i < count; i++) {
+        if(true == this->queryBatch->wasRefused(i)) {
+            replyLengths[i] = -1;
+            continue;
+        }
+        const vector<byte> &reply = this->queryBatch->getReply(i);
+        length = (int)reply.size();
+        if(length > repliesLength - replyOffset) {
+            length = repliesLength - replyOffset;
+        }
+        if(length > 0) {
+            memcpy(replies + replyOffset, &(reply[0]), length);
+        }
+        replyOffset += length;
+        replyLengths[i] = length;
+    }
+
+    SET_ERROR_CODE(ERROR_SUCCESS);
+    return replyOffset;
+}
+
 /* Raw USB Access  feature wrappers */
 int DeviceAdapter::getNumberOfRawUSBBusAccessFeatures() {
     return (int) this->rawUSBBusAccessFeatures.size();
@@ -564,6 +708,61 @@ int DeviceAdapter::spectrometerGetUnformattedSpectrum(long featureID,
     return feature->getUnformattedSpectrum(errorCode, buffer, bufferLength);
 }
 
+int DeviceAdapter::spectrometerBorrowUnformattedSpectrum(long featureID,
+        int *errorCode, const unsigned char **buffer) {
+    SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
+    if(NULL == feature) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return 0;
+    }
+
+    return feature->borrowUnformattedSpectrum(errorCode, buffer);
+}
+
+void DeviceAdapter::spectrometerReleaseUnformattedSpectrum(long featureID,
+        int *errorCode) {
+    SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
+    if(NULL == feature) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return;
+    }
+
+    feature->releaseUnformattedSpectrum(errorCode);
+}
+
+void DeviceAdapter::spectrometerSubmitUnformattedSpectrum(long featureID,
+        int *errorCode) {
+    SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
+    if(NULL == feature) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return;
+    }
+
+    feature->submitUnformattedSpectrum(errorCode);
+}
+
+int DeviceAdapter::spectrometerIsUnformattedSpectrumReady(long featureID,
+        int *errorCode) {
+    SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
+    if(NULL == feature) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return 0;
+    }
+
+    return feature->isUnformattedSpectrumReady(errorCode);
+}
+
+int DeviceAdapter::spectrometerCompleteUnformattedSpectrum(long featureID,
+        int *errorCode, unsigned char *buffer, int bufferLength) {
+    SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
+    if(NULL == feature) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return 0;
+    }
+
+    return feature->completeUnformattedSpectrum(errorCode, buffer, bufferLength);
+}
+
 int DeviceAdapter::spectrometerGetFastBufferSpectrum(long featureID,
     int *errorCode, unsigned char *buffer, int bufferLength, unsigned int numberOfSamplesToRetrieve) {
     SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
@@ -619,6 +818,30 @@ int DeviceAdapter::spectrometerGetFormattedSpectrum(long featureID, int *errorCo
     return feature->getFormattedSpectrum(errorCode, buffer, bufferLength);
 }
 
+int DeviceAdapter::spectrometerGetFormattedSpectrumWithStatistics(long featureID,
+        int *errorCode, double *buffer, int bufferLength,
+        sbapi_spectrum_statistics *statistics) {
+    SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
+    if(NULL == feature) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return 0;
+    }
+
+    return feature->getFormattedSpectrumWithStatistics(errorCode, buffer,
+            bufferLength, statistics);
+}
+
+int DeviceAdapter::spectrometerGetSpectrumAs(long featureID, int *errorCode,
+        int format, void *buffer, int bufferLength) {
+    SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
+    if(NULL == feature) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return 0;
+    }
+
+    return feature->getSpectrumAs(errorCode, format, buffer, bufferLength);
+}
+
 int DeviceAdapter::spectrometerGetWavelengths(long featureID, int *errorCode,
         double *wavelengths, int length) {
     SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
@@ -660,6 +883,24 @@ void DeviceAdapter::spectrometerSetUSBTimeout(long featureID, int *errorCode, un
     feature->setTimeout(errorCode, timeout);
 }
 
+void DeviceAdapter::spectrometerSetUSBReadQueueDepth(long featureID, int *errorCode, unsigned int depth, bool zeroCopy) {
+    SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
+    if(NULL == feature) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return;
+    }
+    feature->setReadQueueDepth(errorCode, depth, zeroCopy);
+}
+
+sbapi_acquisition_handle DeviceAdapter::spectrometerOpenAcquisition(long featureID, int *errorCode) {
+    SpectrometerFeatureAdapter *feature = getSpectrometerFeatureByID(featureID);
+    if(NULL == feature) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return NULL;
+    }
+    return feature->openAcquisition(errorCode);
+}
+
 
 /* Pixel binning feature wrappers */
 int DeviceAdapter::getNumberOfPixelBinningFeatures() {
@@ -43,6 +43,7 @@
 #include "api/seabreezeapi/SeaBreezeAPI_Impl.h"
 #include "api/seabreezeapi/SeaBreezeAPIConstants.h"
 #include "api/DeviceFactory.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPFastBufferSpectra.h"
 
 #include <ctype.h>
 #include <vector>
@@ -51,6 +52,7 @@
 
 using namespace seabreeze;
 using namespace seabreeze::api;
+using namespace seabreeze::oceanBinaryProtocol;
 using namespace std;
 
 // MZ: added "Error" to all error strings to simplify test output analysis
@@ -138,6 +140,64 @@ sbapi_probe_devices() {
     return wrapper->probeDevices();
 }
 
+int
+sbapi_enable_device_events(int *error_code) {
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->enableDeviceEvents(error_code);
+}
+
+void
+sbapi_disable_device_events(int *error_code) {
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    wrapper->disableDeviceEvents(error_code);
+}
+
+int
+sbapi_poll_device_events(int *error_code, long *ids, int *events,
+            unsigned int max_events) {
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->pollDeviceEvents(error_code, ids, events, max_events);
+}
+
+int
+sbapi_get_usb_poll_descriptors(int *error_code, int *fds, short *events,
+            unsigned int max_descriptors) {
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->getUSBPollDescriptors(error_code, fds, events, max_descriptors);
+}
+
+void
+sbapi_handle_usb_events(int *error_code) {
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    wrapper->handleUSBEvents(error_code);
+}
+
+void
+sbapi_enable_flight_recorder(int *error_code, unsigned char enable) {
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    wrapper->setFlightRecorderEnabled(error_code, 0 != enable);
+}
+
+int
+sbapi_dump_flight_recorder(int *error_code, const char *path) {
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->dumpFlightRecorder(error_code, path);
+}
+
+void
+sbapi_set_flight_recorder_dump_file(int *error_code, const char *path) {
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    wrapper->setFlightRecorderDumpFile(error_code, path);
+}
+
 int
 sbapi_get_number_of_device_ids() {
     SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
@@ -252,6 +312,37 @@ sbapi_get_device_usb_endpoint_secondary_in2(long deviceID, int *error_code)
     return wrapper->getDeviceEndpoint(deviceID, error_code, ept);
 }
 
+int
+sbapi_get_usb_endpoint_metrics(long deviceID, int *error_code,
+        unsigned char endpoint, unsigned long long *counters, int counters_length,
+        unsigned long long *histogram, int histogram_length)
+{
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->getUSBEndpointMetrics(deviceID, error_code, endpoint,
+            counters, counters_length, histogram, histogram_length);
+}
+
+void
+sbapi_reset_usb_endpoint_metrics(long deviceID, int *error_code)
+{
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    wrapper->resetUSBEndpointMetrics(deviceID, error_code);
+}
+
+int
+sbapi_obp_query_batch(long deviceID, int *error_code, int count,
+        const unsigned int *message_types,
+        const unsigned char *payloads, const int *payload_lengths,
+        unsigned char *replies, int replies_length, int *reply_lengths)
+{
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->obpQueryBatch(deviceID, error_code, count, message_types,
+            payloads, payload_lengths, replies, replies_length, reply_lengths);
+}
+
 
 /**************************************************************************************/
 //  C language wrapper for raw usb access
@@ -413,6 +504,49 @@ int sbapi_spectrometer_fast_buffer_spectrum_response(long deviceID,
                                                       spectrometerFeatureID, error_code, buffer, buffer_length, numberOfSamplesToRetrieve);
 }
 
+int
+sbapi_fast_buffer_get_number_of_spectra(int *errorCode,
+        const unsigned char *buffer, int buffer_length, int pixels) {
+    if(NULL == buffer || buffer_length < 0 || pixels < 0) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return 0;
+    }
+
+    OBPFastBufferSpectra spectra(buffer, buffer_length, pixels, sizeof(unsigned short));
+    SET_ERROR_CODE(ERROR_SUCCESS);
+    return spectra.size();
+}
+
+int
+sbapi_fast_buffer_get_spectrum(int *errorCode,
+        const unsigned char *buffer, int buffer_length, int pixels,
+        int index, sbapi_fast_buffer_spectrum *spectrum) {
+    OBPFastBufferSpectrum record;
+
+    if(NULL == buffer || buffer_length < 0 || pixels < 0 || NULL == spectrum) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return -1;
+    }
+
+    OBPFastBufferSpectra spectra(buffer, buffer_length, pixels, sizeof(unsigned short));
+    if(index < 0 || (unsigned int)index >= spectra.size()) {
+        SET_ERROR_CODE(ERROR_INPUT_OUT_OF_BOUNDS);
+        return -1;
+    }
+
+    spectra.getSpectrum(index, &record);
+    spectrum->spectrum_count = record.spectrumCount;
+    spectrum->tick_count = record.tickCount;
+    spectrum->integration_time = record.integrationTimeMicros;
+    spectrum->trigger_mode = record.triggerMode;
+    spectrum->metadata = record.metadata;
+    spectrum->pixels = (const unsigned short *)record.pixels;
+    spectrum->checksum = record.checksum;
+
+    SET_ERROR_CODE(ERROR_SUCCESS);
+    return 0;
+}
+
 int
 sbapi_spectrometer_get_unformatted_spectrum(long deviceID,
         long spectrometerFeatureID, int *error_code,
@@ -424,6 +558,58 @@ sbapi_spectrometer_get_unformatted_spectrum(long deviceID,
             spectrometerFeatureID, error_code, buffer, buffer_length);
 }
 
+int
+sbapi_spectrometer_borrow_unformatted_spectrum(long deviceID,
+        long spectrometerFeatureID, int *error_code,
+        const unsigned char **buffer) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->spectrometerBorrowUnformattedSpectrum(deviceID,
+            spectrometerFeatureID, error_code, buffer);
+}
+
+void
+sbapi_spectrometer_release_unformatted_spectrum(long deviceID,
+        long spectrometerFeatureID, int *error_code) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    wrapper->spectrometerReleaseUnformattedSpectrum(deviceID,
+            spectrometerFeatureID, error_code);
+}
+
+void
+sbapi_spectrometer_submit_unformatted_spectrum(long deviceID,
+        long spectrometerFeatureID, int *error_code) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    wrapper->spectrometerSubmitUnformattedSpectrum(deviceID,
+            spectrometerFeatureID, error_code);
+}
+
+int
+sbapi_spectrometer_is_unformatted_spectrum_ready(long deviceID,
+        long spectrometerFeatureID, int *error_code) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->spectrometerIsUnformattedSpectrumReady(deviceID,
+            spectrometerFeatureID, error_code);
+}
+
+int
+sbapi_spectrometer_complete_unformatted_spectrum(long deviceID,
+        long spectrometerFeatureID, int *error_code,
+        unsigned char *buffer, int buffer_length) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->spectrometerCompleteUnformattedSpectrum(deviceID,
+            spectrometerFeatureID, error_code, buffer, buffer_length);
+}
+
 int
 sbapi_spectrometer_get_formatted_spectrum(long deviceID,
         long spectrometerFeatureID, int *error_code,
@@ -486,6 +672,111 @@ sbapi_spectrometer_get_electric_dark_pixel_indices(long deviceID,
             error_code, indices, length);
 }
 
+void
+sbapi_spectrometer_set_usb_read_queue_depth(long deviceID,
+        long spectrometerFeatureID, int *error_code, unsigned int depth) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    wrapper->spectrometerSetUSBReadQueueDepth(deviceID, spectrometerFeatureID,
+            error_code, depth, false);
+}
+
+void
+sbapi_spectrometer_set_usb_zero_copy_read_queue(long deviceID,
+        long spectrometerFeatureID, int *error_code, unsigned int depth) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    wrapper->spectrometerSetUSBReadQueueDepth(deviceID, spectrometerFeatureID,
+            error_code, depth, true);
+}
+
+sbapi_acquisition_handle
+sbapi_spectrometer_open_acquisition(long deviceID,
+        long spectrometerFeatureID, int *error_code) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->spectrometerOpenAcquisition(deviceID,
+            spectrometerFeatureID, error_code);
+}
+
+void
+sbapi_spectrometer_close_acquisition(sbapi_acquisition_handle handle) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    wrapper->spectrometerCloseAcquisition(handle);
+}
+
+int
+sbapi_spectrometer_get_formatted_spectrum_by_handle(
+        sbapi_acquisition_handle handle, int *error_code,
+        double *buffer, int buffer_length) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->spectrometerGetFormattedSpectrum(handle, error_code,
+            buffer, buffer_length);
+}
+
+int
+sbapi_spectrometer_get_unformatted_spectrum_by_handle(
+        sbapi_acquisition_handle handle, int *error_code,
+        unsigned char *buffer, int buffer_length) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->spectrometerGetUnformattedSpectrum(handle, error_code,
+            buffer, buffer_length);
+}
+
+int
+sbapi_spectrometer_get_formatted_spectrum_with_statistics(long deviceID,
+        long spectrometerFeatureID, int *error_code,
+        double *buffer, int buffer_length,
+        sbapi_spectrum_statistics *statistics) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->spectrometerGetFormattedSpectrumWithStatistics(deviceID,
+            spectrometerFeatureID, error_code, buffer, buffer_length, statistics);
+}
+
+int
+sbapi_spectrometer_get_formatted_spectrum_by_handle_with_statistics(
+        sbapi_acquisition_handle handle, int *error_code,
+        double *buffer, int buffer_length,
+        sbapi_spectrum_statistics *statistics) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->spectrometerGetFormattedSpectrumWithStatistics(handle,
+            error_code, buffer, buffer_length, statistics);
+}
+
+int
+sbapi_spectrometer_get_spectrum_as(long deviceID, long spectrometerFeatureID,
+        int *error_code, int format, void *buffer, int buffer_length) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->spectrometerGetSpectrumAs(deviceID, spectrometerFeatureID,
+            error_code, format, buffer, buffer_length);
+}
+
+int
+sbapi_spectrometer_get_spectrum_by_handle_as(
+        sbapi_acquisition_handle handle, int *error_code, int format,
+        void *buffer, int buffer_length) {
+
+    SeaBreezeAPI *wrapper = SeaBreezeAPI::getInstance();
+
+    return wrapper->spectrometerGetSpectrumAs(handle, error_code, format,
+            buffer, buffer_length);
+}
+
 /**************************************************************************************/
 //  C language wrapper for pixel binning features
 /**************************************************************************************/
@@ -46,6 +46,10 @@
 #include "common/buses/rs232/RS232DeviceLocator.h"
 #include "common/buses/DeviceLocationProberInterface.h"
 #include "native/system/System.h"
+#include "native/system/FlightRecorder.h"
+#include "native/usb/USBDiscovery.h"
+#include "common/buses/usb/USBDeviceLocator.h"
+#include "vendors/OceanOptics/buses/usb/OOIUSBInterface.h"
 
 #include <ctype.h>
 #include <vector>
@@ -58,13 +62,20 @@ using namespace std;
 
 static int __deviceID = 1;
 
+#define MAX_DEVICE_EVENTS_PER_POLL 32
+
 SeaBreezeAPI_Impl::SeaBreezeAPI_Impl() {
+    this->deviceEventsEnabled = false;
     System::initialize();
 }
 
 SeaBreezeAPI_Impl::~SeaBreezeAPI_Impl() {
     vector<DeviceAdapter *>::iterator dIter;
 
+    if(true == this->deviceEventsEnabled) {
+        USBDiscovery::disableHotplug();
+    }
+
     for(dIter = this->specifiedDevices.begin(); dIter != this->specifiedDevices.end(); dIter++) {
         delete *dIter;
     }
@@ -91,9 +102,16 @@ int SeaBreezeAPI_Impl::probeDevices() {
     vector<DeviceAdapter *>::iterator validIter;
     int i;
     vector<DeviceAdapter *> validDevices;
+    bool usbProbeStarted;
 
     DeviceFactory* deviceFactory = DeviceFactory::getInstance();
 
+    /* Enumerate the USB bus once up front so that each device type below
+     * only has to look up its own VID/PID rather than walk the bus again.
+     * If this fails, each type just falls back to enumerating on its own.
+     */
+    usbProbeStarted = USBDiscovery::beginProbe();
+
     for(i = 0; i < deviceFactory->getNumberOfDeviceTypes(); i++) {
         /* Try to create a device by its type index.  This does not require
          * knowing what type of device is actually being created.  This instance
@@ -142,6 +160,9 @@ int SeaBreezeAPI_Impl::probeDevices() {
                          * effectively marks the new instance as being valid.
                          */
                         Device *newdev = deviceFactory->create(i);
+                        if(NULL == newdev) {
+                            continue;
+                        }
                         newdev->setLocation(**locIter);
                         /* Note that this pre-increments the device ID to
                          * mitigate any race conditions
@@ -151,6 +172,7 @@ int SeaBreezeAPI_Impl::probeDevices() {
                             this->probedDevices.push_back(da);
                             validDevices.push_back(da);
                         } catch (IllegalArgumentException &iae) {
+                            delete newdev;
                             continue;
                         }
                     }
@@ -167,6 +189,10 @@ int SeaBreezeAPI_Impl::probeDevices() {
         delete dev;
     }
 
+    if(true == usbProbeStarted) {
+        USBDiscovery::endProbe();
+    }
+
     /* Now go through the set of all probed devices and ensure that each of
      * them is still around.
      */
@@ -198,6 +224,205 @@ int SeaBreezeAPI_Impl::probeDevices() {
     return (int) probedDevices.size();
 }
 
+int SeaBreezeAPI_Impl::enableDeviceEvents(int *errorCode) {
+    DeviceFactory* deviceFactory = DeviceFactory::getInstance();
+    Device *dev;
+    int i;
+
+    if(true == this->deviceEventsEnabled) {
+        SET_ERROR_CODE(ERROR_SUCCESS);
+        return (int) probedDevices.size();
+    }
+
+    /* Learn which type of device each USB VID/PID corresponds to, and
+     * watch for each of them.
+     */
+    this->usbDeviceTypes.clear();
+    for(i = 0; i < deviceFactory->getNumberOfDeviceTypes(); i++) {
+        dev = deviceFactory->create(i);
+
+        vector<Bus *>::iterator iter;
+        vector<Bus *> buses = dev->getBuses();
+
+        for(iter = buses.begin(); iter != buses.end(); iter++) {
+            OOIUSBInterface *usb = dynamic_cast<OOIUSBInterface *>(*iter);
+            if(NULL == usb) {
+                continue;
+            }
+            unsigned long key = ((unsigned long)usb->getVendorID() << 16)
+                    | (unsigned long)usb->getProductID();
+            if(this->usbDeviceTypes.end() != this->usbDeviceTypes.find(key)) {
+                /* Another type claimed this VID/PID first (as in probing) */
+                continue;
+            }
+            if(false == USBDiscovery::enableHotplug(usb->getVendorID(), usb->getProductID())) {
+                delete dev;
+                USBDiscovery::disableHotplug();
+                this->usbDeviceTypes.clear();
+                SET_ERROR_CODE(ERROR_NOT_IMPLEMENTED);
+                return -1;
+            }
+            this->usbDeviceTypes[key] = i;
+        }
+
+        delete dev;
+    }
+
+    this->deviceEventsEnabled = true;
+
+    /* Anything attached from here on will be reported as an event, so one
+     * probe now catches up with what is already there.
+     */
+    SET_ERROR_CODE(ERROR_SUCCESS);
+    return probeDevices();
+}
+
+void SeaBreezeAPI_Impl::disableDeviceEvents(int *errorCode) {
+    if(true == this->deviceEventsEnabled) {
+        USBDiscovery::disableHotplug();
+        this->deviceEventsEnabled = false;
+    }
+    this->usbDeviceTypes.clear();
+    this->pendingDeviceEvents.clear();
+    SET_ERROR_CODE(ERROR_SUCCESS);
+}
+
+int SeaBreezeAPI_Impl::pollDeviceEvents(int *errorCode, long *ids, int *events,
+        unsigned int maxEvents) {
+    struct USBHotplugEvent usbEvents[MAX_DEVICE_EVENTS_PER_POLL];
+    vector<DeviceAdapter *>::iterator devIter;
+    map<unsigned long, int>::iterator typeIter;
+    unsigned int copied;
+    int count;
+    int i;
+
+    if(false == this->deviceEventsEnabled) {
+        SET_ERROR_CODE(ERROR_NOT_IMPLEMENTED);
+        return -1;
+    }
+
+    if(NULL == ids || NULL == events) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return -1;
+    }
+
+    do {
+        count = USBDiscovery::pollHotplugEvents(usbEvents, MAX_DEVICE_EVENTS_PER_POLL);
+        for(i = 0; i < count; i++) {
+            USBDeviceLocator location(usbEvents[i].deviceID);
+
+            if(USB_DEVICE_ARRIVED == usbEvents[i].event) {
+                typeIter = this->usbDeviceTypes.find(
+                        ((unsigned long)usbEvents[i].vendorID << 16) | usbEvents[i].productID);
+                if(this->usbDeviceTypes.end() == typeIter) {
+                    continue;
+                }
+                Device *newdev = DeviceFactory::getInstance()->create(typeIter->second);
+                if(NULL == newdev) {
+                    continue;
+                }
+                newdev->setLocation(location);
+                try {
+                    /* Note that this pre-increments the device ID to
+                     * mitigate any race conditions
+                     */
+                    DeviceAdapter *da = new DeviceAdapter(newdev, ++__deviceID);
+                    this->probedDevices.push_back(da);
+                    this->pendingDeviceEvents.push_back(
+                            pair<long, int>(da->getID(), DEVICE_EVENT_ARRIVED));
+                } catch (IllegalArgumentException &iae) {
+                    delete newdev;
+                    continue;
+                }
+            } else {
+                for(    devIter = this->probedDevices.begin();
+                        devIter != this->probedDevices.end();
+                        devIter++) {
+                    if(true == location.equals(*((*devIter)->getLocation()))) {
+                        this->pendingDeviceEvents.push_back(
+                                pair<long, int>((*devIter)->getID(), DEVICE_EVENT_DEPARTED));
+                        delete *devIter;
+                        this->probedDevices.erase(devIter);
+                        break;
+                    }
+                }
+            }
+        }
+    } while(MAX_DEVICE_EVENTS_PER_POLL == count);
+
+    for(copied = 0; copied < maxEvents && false == this->pendingDeviceEvents.empty(); copied++) {
+        ids[copied] = this->pendingDeviceEvents.front().first;
+        events[copied] = this->pendingDeviceEvents.front().second;
+        this->pendingDeviceEvents.pop_front();
+    }
+
+    SET_ERROR_CODE(ERROR_SUCCESS);
+    return (int) copied;
+}
+
+int SeaBreezeAPI_Impl::getUSBPollDescriptors(int *errorCode, int *fds,
+        short *events, unsigned int maxDescriptors) {
+    int count;
+    unsigned int i;
+
+    if(NULL == fds || NULL == events) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return -1;
+    }
+
+    vector<struct USBPollDescriptor> descriptors(maxDescriptors);
+    count = USBDiscovery::getPollDescriptors(
+            descriptors.empty() ? NULL : &(descriptors[0]), (int) maxDescriptors);
+    if(count < 0) {
+        SET_ERROR_CODE(ERROR_NOT_IMPLEMENTED);
+        return -1;
+    }
+
+    for(i = 0; i < (unsigned int) count && i < maxDescriptors; i++) {
+        fds[i] = descriptors[i].fd;
+        events[i] = descriptors[i].events;
+    }
+
+    SET_ERROR_CODE(ERROR_SUCCESS);
+    return count;
+}
+
+void SeaBreezeAPI_Impl::handleUSBEvents(int *errorCode) {
+    if(false == USBDiscovery::handleEvents()) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return;
+    }
+    SET_ERROR_CODE(ERROR_SUCCESS);
+}
+
+void SeaBreezeAPI_Impl::setFlightRecorderEnabled(int *errorCode, bool enable) {
+    FlightRecorder::setEnabled(enable);
+    SET_ERROR_CODE(ERROR_SUCCESS);
+}
+
+int SeaBreezeAPI_Impl::dumpFlightRecorder(int *errorCode, const char *path) {
+    int count;
+
+    if(NULL == path) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return -1;
+    }
+
+    count = FlightRecorder::dump(path);
+    if(count < 0) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return -1;
+    }
+
+    SET_ERROR_CODE(ERROR_SUCCESS);
+    return count;
+}
+
+void SeaBreezeAPI_Impl::setFlightRecorderDumpFile(int *errorCode, const char *path) {
+    FlightRecorder::setProtocolErrorDumpFile(path);
+    SET_ERROR_CODE(ERROR_SUCCESS);
+}
+
 int SeaBreezeAPI_Impl::addTCPIPv4DeviceLocation(char *deviceTypeName, char *ipAddr,
         int port) {
     string address(ipAddr);
@@ -350,6 +575,49 @@ unsigned char SeaBreezeAPI_Impl::getDeviceEndpoint(long id, int *errorCode, usbE
     return adapter->getDeviceEndpoint(errorCode, endpoint);
 }
 
+int SeaBreezeAPI_Impl::getUSBEndpointMetrics(long id, int *errorCode,
+        unsigned char endpoint, unsigned long long *counters, int countersLength,
+        unsigned long long *histogram, int histogramLength)
+{
+    DeviceAdapter *adapter = getDeviceByID(id);
+    if(NULL == adapter)
+    {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return -1;
+    }
+
+    return adapter->getUSBEndpointMetrics(errorCode, endpoint, counters,
+            countersLength, histogram, histogramLength);
+}
+
+void SeaBreezeAPI_Impl::resetUSBEndpointMetrics(long id, int *errorCode)
+{
+    DeviceAdapter *adapter = getDeviceByID(id);
+    if(NULL == adapter)
+    {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return;
+    }
+
+    adapter->resetUSBEndpointMetrics(errorCode);
+}
+
+int SeaBreezeAPI_Impl::obpQueryBatch(long id, int *errorCode, int count,
+        const unsigned int *messageTypes,
+        const unsigned char *payloads, const int *payloadLengths,
+        unsigned char *replies, int repliesLength, int *replyLengths)
+{
+    DeviceAdapter *adapter = getDeviceByID(id);
+    if(NULL == adapter)
+    {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return -1;
+    }
+
+    return adapter->obpQueryBatch(errorCode, count, messageTypes, payloads,
+            payloadLengths, replies, repliesLength, replyLengths);
+}
+
 /**************************************************************************************/
 //  raw USB access Features for the SeaBreeze API class
 /**************************************************************************************/
@@ -588,6 +856,63 @@ int SeaBreezeAPI_Impl::spectrometerGetUnformattedSpectrum(long deviceID,
             buffer, bufferLength);
 }
 
+int SeaBreezeAPI_Impl::spectrometerBorrowUnformattedSpectrum(long deviceID,
+        long featureID, int *errorCode, const unsigned char **buffer) {
+    DeviceAdapter *adapter = getDeviceByID(deviceID);
+    if(NULL == adapter) {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return 0;
+    }
+
+    return adapter->spectrometerBorrowUnformattedSpectrum(featureID, errorCode,
+            buffer);
+}
+
+void SeaBreezeAPI_Impl::spectrometerReleaseUnformattedSpectrum(long deviceID,
+        long featureID, int *errorCode) {
+    DeviceAdapter *adapter = getDeviceByID(deviceID);
+    if(NULL == adapter) {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return;
+    }
+
+    adapter->spectrometerReleaseUnformattedSpectrum(featureID, errorCode);
+}
+
+void SeaBreezeAPI_Impl::spectrometerSubmitUnformattedSpectrum(long deviceID,
+        long featureID, int *errorCode) {
+    DeviceAdapter *adapter = getDeviceByID(deviceID);
+    if(NULL == adapter) {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return;
+    }
+
+    adapter->spectrometerSubmitUnformattedSpectrum(featureID, errorCode);
+}
+
+int SeaBreezeAPI_Impl::spectrometerIsUnformattedSpectrumReady(long deviceID,
+        long featureID, int *errorCode) {
+    DeviceAdapter *adapter = getDeviceByID(deviceID);
+    if(NULL == adapter) {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return 0;
+    }
+
+    return adapter->spectrometerIsUnformattedSpectrumReady(featureID, errorCode);
+}
+
+int SeaBreezeAPI_Impl::spectrometerCompleteUnformattedSpectrum(long deviceID,
+        long featureID, int *errorCode, unsigned char *buffer, int bufferLength) {
+    DeviceAdapter *adapter = getDeviceByID(deviceID);
+    if(NULL == adapter) {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return 0;
+    }
+
+    return adapter->spectrometerCompleteUnformattedSpectrum(featureID, errorCode,
+            buffer, bufferLength);
+}
+
 int SeaBreezeAPI_Impl::spectrometerGetFormattedSpectrum(long deviceID,
         long featureID, int *errorCode, double *buffer, int bufferLength) {
     DeviceAdapter *adapter = getDeviceByID(deviceID);
@@ -666,6 +991,124 @@ void SeaBreezeAPI_Impl::spectrometerSetUSBTimeout(long deviceID,
     adapter->spectrometerSetUSBTimeout(featureID, errorCode, timeout);
 }
 
+void SeaBreezeAPI_Impl::spectrometerSetUSBReadQueueDepth(long deviceID,
+        long featureID, int *errorCode, unsigned int depth, bool zeroCopy) {
+    DeviceAdapter *adapter = getDeviceByID(deviceID);
+    if(NULL == adapter) {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return;
+    }
+    adapter->spectrometerSetUSBReadQueueDepth(featureID, errorCode, depth, zeroCopy);
+}
+
+sbapi_acquisition_handle SeaBreezeAPI_Impl::spectrometerOpenAcquisition(long deviceID,
+        long featureID, int *errorCode) {
+    DeviceAdapter *adapter = getDeviceByID(deviceID);
+    if(NULL == adapter) {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return NULL;
+    }
+
+    return adapter->spectrometerOpenAcquisition(featureID, errorCode);
+}
+
+void SeaBreezeAPI_Impl::spectrometerCloseAcquisition(sbapi_acquisition_handle handle) {
+    if(NULL == handle) {
+        return;
+    }
+
+    if(NULL == handle->adapter) {
+        /* Already invalidated by closing its device */
+        delete handle;
+    } else {
+        handle->adapter->closeAcquisition(handle);
+    }
+}
+
+/* A handle whose device has been closed is still allocated, but its adapter
+ * is gone; it stays unusable until it is closed.
+ */
+static bool __acquisition_is_open(sbapi_acquisition_handle handle, int *errorCode) {
+    if(NULL == handle) {
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return false;
+    }
+
+    if(NULL == handle->adapter) {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return false;
+    }
+
+    return true;
+}
+
+/* The handle leads straight to the feature adapter, so none of the device
+ * and feature lookups that the ID-based calls make are needed here.
+ */
+int SeaBreezeAPI_Impl::spectrometerGetFormattedSpectrum(sbapi_acquisition_handle handle,
+        int *errorCode, double *buffer, int bufferLength) {
+    if(false == __acquisition_is_open(handle, errorCode)) {
+        return 0;
+    }
+
+    return handle->adapter->getFormattedSpectrum(handle, errorCode, buffer, bufferLength);
+}
+
+int SeaBreezeAPI_Impl::spectrometerGetFormattedSpectrumWithStatistics(long deviceID,
+        long featureID, int *errorCode, double *buffer, int bufferLength,
+        sbapi_spectrum_statistics *statistics) {
+    DeviceAdapter *adapter = getDeviceByID(deviceID);
+    if(NULL == adapter) {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return 0;
+    }
+
+    return adapter->spectrometerGetFormattedSpectrumWithStatistics(featureID,
+            errorCode, buffer, bufferLength, statistics);
+}
+
+int SeaBreezeAPI_Impl::spectrometerGetFormattedSpectrumWithStatistics(
+        sbapi_acquisition_handle handle, int *errorCode, double *buffer,
+        int bufferLength, sbapi_spectrum_statistics *statistics) {
+    if(false == __acquisition_is_open(handle, errorCode)) {
+        return 0;
+    }
+
+    return handle->adapter->getFormattedSpectrumWithStatistics(handle, errorCode,
+            buffer, bufferLength, statistics);
+}
+
+int SeaBreezeAPI_Impl::spectrometerGetSpectrumAs(long deviceID, long featureID,
+        int *errorCode, int format, void *buffer, int bufferLength) {
+    DeviceAdapter *adapter = getDeviceByID(deviceID);
+    if(NULL == adapter) {
+        SET_ERROR_CODE(ERROR_NO_DEVICE);
+        return 0;
+    }
+
+    return adapter->spectrometerGetSpectrumAs(featureID, errorCode, format,
+            buffer, bufferLength);
+}
+
+int SeaBreezeAPI_Impl::spectrometerGetSpectrumAs(sbapi_acquisition_handle handle,
+        int *errorCode, int format, void *buffer, int bufferLength) {
+    if(false == __acquisition_is_open(handle, errorCode)) {
+        return 0;
+    }
+
+    return handle->adapter->getSpectrumAs(handle, errorCode, format, buffer,
+            bufferLength);
+}
+
+int SeaBreezeAPI_Impl::spectrometerGetUnformattedSpectrum(sbapi_acquisition_handle handle,
+        int *errorCode, unsigned char *buffer, int bufferLength) {
+    if(false == __acquisition_is_open(handle, errorCode)) {
+        return 0;
+    }
+
+    return handle->adapter->getUnformattedSpectrum(handle, errorCode, buffer, bufferLength);
+}
+
 /**************************************************************************************/
 //  Pixel binning features for the SeaBreeze API class
 /**************************************************************************************/
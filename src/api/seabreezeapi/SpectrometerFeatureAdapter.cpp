@@ -36,6 +36,7 @@
 #include "api/seabreezeapi/SeaBreezeAPIConstants.h"
 #include "api/seabreezeapi/SpectrometerFeatureAdapter.h"
 #include "common/exceptions/IllegalArgumentException.h"
+#include "vendors/OceanOptics/protocols/interfaces/SpectrometerProtocolInterface.h"
 
 using namespace seabreeze;
 using namespace seabreeze::api;
@@ -51,8 +52,10 @@ SpectrometerFeatureAdapter::SpectrometerFeatureAdapter(
 
 SpectrometerFeatureAdapter::~SpectrometerFeatureAdapter() {
     /* This is just a wrapper around pointers to instances.  This is not
-     * responsible for destroying anything.
+     * responsible for destroying anything except what acquisition handles
+     * still hold.
      */
+    invalidateAcquisitions();
 }
 
 #ifdef _WINDOWS
@@ -87,6 +90,88 @@ int SpectrometerFeatureAdapter::getUnformattedSpectrum(int *errorCode,
     return bytesCopied;
 }
 
+int SpectrometerFeatureAdapter::borrowUnformattedSpectrum(int *errorCode,
+                    const unsigned char **buffer) {
+    int length;
+
+    if(NULL == buffer) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return 0;
+    }
+
+    try {
+        /* The spectrum stays wherever it was received; no copy is made */
+        length = this->feature->borrowUnformattedSpectrum(*this->protocol,
+            *this->bus, buffer);
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        *buffer = NULL;
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return 0;
+    }
+
+    return length;
+}
+
+void SpectrometerFeatureAdapter::releaseUnformattedSpectrum(int *errorCode) {
+    try {
+        this->feature->releaseUnformattedSpectrum(*this->protocol, *this->bus);
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+    }
+}
+
+void SpectrometerFeatureAdapter::submitUnformattedSpectrum(int *errorCode) {
+    try {
+        this->feature->submitUnformattedSpectrum(*this->protocol, *this->bus);
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+    }
+}
+
+int SpectrometerFeatureAdapter::isUnformattedSpectrumReady(int *errorCode) {
+    bool ready;
+
+    try {
+        ready = this->feature->isUnformattedSpectrumReady(*this->protocol, *this->bus);
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return 0;
+    }
+
+    return (true == ready) ? 1 : 0;
+}
+
+int SpectrometerFeatureAdapter::completeUnformattedSpectrum(int *errorCode,
+                    unsigned char *buffer, int bufferLength) {
+    ByteVector *spectrum;
+    int bytesCopied = 0;
+
+    if(NULL == buffer) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return 0;
+    }
+
+    try {
+        /* The request went out with submitUnformattedSpectrum() */
+        spectrum = this->feature->readUnformattedSpectrum(*this->protocol,
+            *this->bus);
+        vector<byte>& specdata = spectrum->getByteVector();
+        bytesCopied = ((int)specdata.size() < bufferLength) ? (int)specdata.size() : bufferLength;
+        memcpy(buffer, specdata.data(), bytesCopied * sizeof (unsigned char));
+        delete spectrum;
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return 0;
+    }
+
+    return bytesCopied;
+}
+
 int SpectrometerFeatureAdapter::getFastBufferSpectrum(int *errorCode,
     unsigned char *buffer, int bufferLength, unsigned int numberOfSamplesToRetrieve) {
     ByteVector *spectrum;
@@ -164,23 +249,17 @@ int SpectrometerFeatureAdapter::fastBufferSpectrumResponse(int *errorCode,
 
 int SpectrometerFeatureAdapter::getFormattedSpectrum(int *errorCode,
                     double* buffer, int bufferLength) {
-    DoubleVector *spectrum;
     int doublesCopied = 0;
 
-    if(NULL == buffer) {
+    if(NULL == buffer || bufferLength < 0) {
         SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
         return 0;
     }
 
     try {
-        spectrum = this->feature->getFormattedSpectrum(*this->protocol, *this->bus);
-        // Get reference
-        vector<double>& specdata = spectrum->getDoubleVector();
-        // Copy data
-        doublesCopied = ((int)specdata.size() < bufferLength) ? (int)specdata.size() : bufferLength;
-        // NOTE: this may be dangerous, but it's fast...
-        memcpy(buffer, specdata.data(), doublesCopied * sizeof(double));
-        delete spectrum;
+        /* The spectrum is decoded straight into the caller's buffer */
+        doublesCopied = (int)this->feature->getFormattedSpectrum(*this->protocol,
+            *this->bus, buffer, (unsigned int)bufferLength);
         SET_ERROR_CODE(ERROR_SUCCESS);
     } catch (FeatureException &fe) {
         // the get spectrum calls should have an argument for the error string so that fe.what can be used
@@ -453,3 +532,253 @@ void SpectrometerFeatureAdapter::setTimeout(int *errorCode, unsigned int timeout
         SET_ERROR_CODE(ERROR_NOT_IMPLEMENTED);
     }
 }
+
+void SpectrometerFeatureAdapter::setReadQueueDepth(int *errorCode, unsigned int depth, bool zeroCopy) {
+    try {
+        this->feature->setReadQueueDepth(*this->bus, depth, zeroCopy);
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_NOT_IMPLEMENTED);
+    }
+}
+
+sbapi_acquisition_handle SpectrometerFeatureAdapter::openAcquisition(int *errorCode) {
+    sbapi_acquisition_handle handle;
+
+    handle = new struct sbapi_acquisition;
+    handle->adapter = this;
+
+    try {
+        handle->acquisition = this->feature->resolveAcquisition(*this->protocol,
+            *this->bus);
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        delete handle;
+        SET_ERROR_CODE(ERROR_FEATURE_NOT_FOUND);
+        return NULL;
+    }
+
+    this->acquisitions.push_back(handle);
+
+    return handle;
+}
+
+void SpectrometerFeatureAdapter::closeAcquisition(sbapi_acquisition_handle handle) {
+    vector<sbapi_acquisition_handle>::iterator iter;
+
+    for(iter = this->acquisitions.begin(); iter != this->acquisitions.end(); iter++) {
+        if(*iter == handle) {
+            this->acquisitions.erase(iter);
+            break;
+        }
+    }
+
+    delete handle->acquisition;
+    delete handle;
+}
+
+void SpectrometerFeatureAdapter::invalidateAcquisitions() {
+    vector<sbapi_acquisition_handle>::iterator iter;
+
+    /* The resolved helpers belong to the bus, which is going away */
+    for(iter = this->acquisitions.begin(); iter != this->acquisitions.end(); iter++) {
+        delete (*iter)->acquisition;
+        (*iter)->acquisition = NULL;
+        (*iter)->adapter = NULL;
+    }
+    this->acquisitions.clear();
+}
+
+int SpectrometerFeatureAdapter::getFormattedSpectrum(sbapi_acquisition_handle handle,
+                    int *errorCode, double *buffer, int bufferLength) {
+    int doublesCopied = 0;
+
+    if(NULL == buffer || bufferLength < 0) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return 0;
+    }
+
+    try {
+        doublesCopied = (int)this->feature->getFormattedSpectrum(*handle->acquisition,
+            buffer, (unsigned int)bufferLength);
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return 0;
+    }
+
+    return doublesCopied;
+}
+
+int SpectrometerFeatureAdapter::getUnformattedSpectrum(sbapi_acquisition_handle handle,
+                    int *errorCode, unsigned char *buffer, int bufferLength) {
+    ByteVector *spectrum;
+    int bytesCopied = 0;
+
+    if(NULL == buffer || bufferLength < 0) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return 0;
+    }
+
+    try {
+        spectrum = this->feature->getUnformattedSpectrum(*handle->acquisition);
+        vector<byte> &specdata = spectrum->getByteVector();
+        bytesCopied = ((int)specdata.size() < bufferLength) ? (int)specdata.size() : bufferLength;
+        if(bytesCopied > 0) {
+            memcpy(buffer, &(specdata[0]), bytesCopied * sizeof(unsigned char));
+        }
+        delete spectrum;
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return 0;
+    }
+
+    return bytesCopied;
+}
+
+int SpectrometerFeatureAdapter::getFormattedSpectrumWithStatistics(int *errorCode,
+                    double *buffer, int bufferLength,
+                    sbapi_spectrum_statistics *statistics) {
+    SpectrumStatistics decoded;
+    DoubleVector *spectrum;
+
+    if(NULL == buffer || NULL == statistics) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return 0;
+    }
+
+    try {
+        spectrum = this->feature->getFormattedSpectrum(*this->protocol,
+            *this->bus, &decoded);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return 0;
+    }
+
+    return copyFormattedSpectrum(spectrum, errorCode, buffer, bufferLength,
+        decoded, statistics);
+}
+
+int SpectrometerFeatureAdapter::getFormattedSpectrumWithStatistics(
+                    sbapi_acquisition_handle handle, int *errorCode,
+                    double *buffer, int bufferLength,
+                    sbapi_spectrum_statistics *statistics) {
+    SpectrumStatistics decoded;
+    DoubleVector *spectrum;
+
+    if(NULL == buffer || NULL == statistics) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return 0;
+    }
+
+    try {
+        spectrum = this->feature->getFormattedSpectrum(*handle->acquisition,
+            &decoded);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return 0;
+    }
+
+    return copyFormattedSpectrum(spectrum, errorCode, buffer, bufferLength,
+        decoded, statistics);
+}
+
+bool SpectrometerFeatureAdapter::toPixelFormat(int format, PixelFormat *out) {
+    switch(format) {
+    case SPECTRUM_FORMAT_UINT16:
+        *out = PIXEL_UINT16;
+        return true;
+    case SPECTRUM_FORMAT_UINT32:
+        *out = PIXEL_UINT32;
+        return true;
+    case SPECTRUM_FORMAT_FLOAT32:
+        *out = PIXEL_FLOAT32;
+        return true;
+    }
+    return false;
+}
+
+int SpectrometerFeatureAdapter::getSpectrumAs(int *errorCode, int format,
+                    void *buffer, int bufferLength) {
+    PixelFormat pixelFormat;
+    int pixelsCopied;
+
+    if(NULL == buffer || bufferLength < 0) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return 0;
+    }
+
+    if(false == toPixelFormat(format, &pixelFormat)) {
+        SET_ERROR_CODE(ERROR_INPUT_OUT_OF_BOUNDS);
+        return 0;
+    }
+
+    try {
+        pixelsCopied = (int)this->feature->getFormattedSpectrumAs(*this->protocol,
+            *this->bus, pixelFormat, buffer, (unsigned int)bufferLength);
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return 0;
+    }
+
+    return pixelsCopied;
+}
+
+int SpectrometerFeatureAdapter::getSpectrumAs(sbapi_acquisition_handle handle,
+                    int *errorCode, int format, void *buffer, int bufferLength) {
+    PixelFormat pixelFormat;
+    int pixelsCopied;
+
+    if(NULL == buffer || bufferLength < 0) {
+        SET_ERROR_CODE(ERROR_BAD_USER_BUFFER);
+        return 0;
+    }
+
+    if(false == toPixelFormat(format, &pixelFormat)) {
+        SET_ERROR_CODE(ERROR_INPUT_OUT_OF_BOUNDS);
+        return 0;
+    }
+
+    try {
+        pixelsCopied = (int)this->feature->getFormattedSpectrumAs(*handle->acquisition,
+            pixelFormat, buffer, (unsigned int)bufferLength);
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    } catch (FeatureException &fe) {
+        SET_ERROR_CODE(ERROR_TRANSFER_ERROR);
+        return 0;
+    }
+
+    return pixelsCopied;
+}
+
+/* Hands a spectrum and its statistics back to the caller and frees it.  A
+ * saturated spectrum is still returned; the error code only says so.
+ */
+int SpectrometerFeatureAdapter::copyFormattedSpectrum(DoubleVector *spectrum,
+                    int *errorCode, double *buffer, int bufferLength,
+                    const SpectrumStatistics &decoded,
+                    sbapi_spectrum_statistics *statistics) {
+    vector<double> &specdata = spectrum->getDoubleVector();
+    int doublesCopied = ((int)specdata.size() < bufferLength) ? (int)specdata.size() : bufferLength;
+
+    if(doublesCopied > 0) {
+        memcpy(buffer, &(specdata[0]), doublesCopied * sizeof(double));
+    }
+    delete spectrum;
+
+    statistics->minimum = decoded.minimum;
+    statistics->maximum = decoded.maximum;
+    statistics->sum = decoded.sum;
+    statistics->maximum_index = (int)decoded.maximumIndex;
+    statistics->saturated_pixels = (int)decoded.saturatedPixels;
+
+    if(decoded.saturatedPixels > 0) {
+        SET_ERROR_CODE(ERROR_SPECTROMETER_SATURATED);
+    } else {
+        SET_ERROR_CODE(ERROR_SUCCESS);
+    }
+
+    return doublesCopied;
+}
@@ -0,0 +1,818 @@
+/***************************************************//**
+ * @file    PixelUnpack.cpp
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * Scalar, SSE2, AVX2 and NEON versions of the pixel
+ * unpacking routines, and the choice between them.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#include "common/globals.h"
+#include "common/PixelUnpack.h"
+#include <string.h>
+
+/* The SIMD versions all load pixels straight into 16-bit lanes, so they are
+ * only built for processors that are little-endian like the data.
+ */
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PIXEL_UNPACK_X86
+#define PIXEL_UNPACK_LITTLE_ENDIAN
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#if _MSC_VER >= 1700
+#define PIXEL_UNPACK_AVX2
+#include <immintrin.h>
+#endif
+#define SSE2_TARGET
+#define AVX2_TARGET
+#elif defined(__GNUC__) && (defined(__clang__) || __GNUC__ > 4 \
+        || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define PIXEL_UNPACK_AVX2
+#include <cpuid.h>
+#include <immintrin.h>
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#include <cpuid.h>
+#define SSE2_TARGET
+#endif
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#define PIXEL_UNPACK_NEON
+#define PIXEL_UNPACK_LITTLE_ENDIAN
+#include <arm_neon.h>
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PIXEL_UNPACK_LITTLE_ENDIAN
+#endif
+
+using namespace seabreeze;
+
+typedef void (*FlipKernel)(const byte *, unsigned short *, unsigned int, unsigned short);
+typedef void (*U32Kernel)(const byte *, unsigned int *, unsigned int);
+typedef void (*DoubleKernel)(const byte *, double *, unsigned int);
+typedef void (*FloatKernel)(const byte *, float *, unsigned int);
+typedef void (*FlipDoubleKernel)(const byte *, double *, unsigned int, unsigned short);
+typedef void (*StatisticsKernel)(const byte *, double *, unsigned int,
+        unsigned int, SpectrumStatistics *);
+
+struct PixelUnpackKernels {
+    const char *name;
+    FlipKernel flip;
+    U32Kernel toU32;
+    DoubleKernel toDouble;
+    StatisticsKernel toDoubleWithStatistics;
+    FloatKernel toFloat;
+    FlipDoubleKernel flipToDouble;
+};
+
+/* Scalar versions, which also finish off whatever the others leave over */
+
+static void unpackLE16FlipScalar(const byte *src, unsigned short *dst,
+        unsigned int count, unsigned short flip) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = (unsigned short)((src[i * 2] | (src[i * 2 + 1] << 8)) ^ flip);
+    }
+}
+
+static void unpackLE16ToU32Scalar(const byte *src, unsigned int *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = src[i * 2] | (src[i * 2 + 1] << 8);
+    }
+}
+
+static void unpackLE16ToDoubleScalar(const byte *src, double *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = (double)(src[i * 2] | (src[i * 2 + 1] << 8));
+    }
+}
+
+static void unpackLE16FlipToDoubleScalar(const byte *src, double *dst,
+        unsigned int count, unsigned short flip) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = (double)((src[i * 2] | (src[i * 2 + 1] << 8)) ^ flip);
+    }
+}
+
+static void unpackLE16ToFloatScalar(const byte *src, float *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = (float)(src[i * 2] | (src[i * 2 + 1] << 8));
+    }
+}
+
+/* The statistics kernels take the saturation level as a whole number of
+ * counts from 0 to 65536, where 65536 means no pixel can reach it.  They
+ * start from the statistics they are given so that one can finish what
+ * another started, with start being the index of src[0] in the spectrum.
+ */
+static void statisticsScalar(const byte *src, double *dst, unsigned int count,
+        unsigned int start, unsigned int threshold, SpectrumStatistics *s) {
+    unsigned int i;
+    unsigned int pixel;
+
+    for(i = 0; i < count; i++) {
+        pixel = src[i * 2] | (src[i * 2 + 1] << 8);
+        dst[i] = (double)pixel;
+        s->sum += dst[i];
+        if(dst[i] < s->minimum) {
+            s->minimum = dst[i];
+        }
+        if(dst[i] > s->maximum) {
+            s->maximum = dst[i];
+            s->maximumIndex = start + i;
+        }
+        if(pixel >= threshold) {
+            s->saturatedPixels++;
+        }
+    }
+}
+
+static void unpackLE16ToDoubleWithStatisticsScalar(const byte *src, double *dst,
+        unsigned int count, unsigned int threshold, SpectrumStatistics *s) {
+    statisticsScalar(src, dst, count, 0, threshold, s);
+}
+
+static const struct PixelUnpackKernels scalarKernels = {
+    "scalar", unpackLE16FlipScalar, unpackLE16ToU32Scalar, unpackLE16ToDoubleScalar,
+    unpackLE16ToDoubleWithStatisticsScalar, unpackLE16ToFloatScalar,
+    unpackLE16FlipToDoubleScalar
+};
+
+#ifdef PIXEL_UNPACK_X86
+
+SSE2_TARGET static void unpackLE16FlipSSE2(const byte *src, unsigned short *dst,
+        unsigned int count, unsigned short flip) {
+    __m128i mask = _mm_set1_epi16((short)flip);
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(v, mask));
+    }
+    unpackLE16FlipScalar(src + i * 2, dst + i, count - i, flip);
+}
+
+SSE2_TARGET static void unpackLE16ToU32SSE2(const byte *src, unsigned int *dst,
+        unsigned int count) {
+    __m128i zero = _mm_setzero_si128();
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi16(v, zero));
+        _mm_storeu_si128((__m128i *)(dst + i + 4), _mm_unpackhi_epi16(v, zero));
+    }
+    unpackLE16ToU32Scalar(src + i * 2, dst + i, count - i);
+}
+
+SSE2_TARGET static void unpackLE16ToDoubleSSE2(const byte *src, double *dst,
+        unsigned int count) {
+    __m128i zero = _mm_setzero_si128();
+    unsigned int i;
+
+    /* Widened to 32 bits the pixels are all positive, so the signed
+     * conversion is exact.
+     */
+    for(i = 0; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+        __m128i lo = _mm_unpacklo_epi16(v, zero);
+        __m128i hi = _mm_unpackhi_epi16(v, zero);
+        _mm_storeu_pd(dst + i, _mm_cvtepi32_pd(lo));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtepi32_pd(_mm_srli_si128(lo, 8)));
+        _mm_storeu_pd(dst + i + 4, _mm_cvtepi32_pd(hi));
+        _mm_storeu_pd(dst + i + 6, _mm_cvtepi32_pd(_mm_srli_si128(hi, 8)));
+    }
+    unpackLE16ToDoubleScalar(src + i * 2, dst + i, count - i);
+}
+
+SSE2_TARGET static void unpackLE16FlipToDoubleSSE2(const byte *src, double *dst,
+        unsigned int count, unsigned short flip) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i mask = _mm_set1_epi16((short)flip);
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + i * 2)), mask);
+        __m128i lo = _mm_unpacklo_epi16(v, zero);
+        __m128i hi = _mm_unpackhi_epi16(v, zero);
+        _mm_storeu_pd(dst + i, _mm_cvtepi32_pd(lo));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtepi32_pd(_mm_srli_si128(lo, 8)));
+        _mm_storeu_pd(dst + i + 4, _mm_cvtepi32_pd(hi));
+        _mm_storeu_pd(dst + i + 6, _mm_cvtepi32_pd(_mm_srli_si128(hi, 8)));
+    }
+    unpackLE16FlipToDoubleScalar(src + i * 2, dst + i, count - i, flip);
+}
+
+SSE2_TARGET static void unpackLE16ToFloatSSE2(const byte *src, float *dst,
+        unsigned int count) {
+    __m128i zero = _mm_setzero_si128();
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+        _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)));
+        _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)));
+    }
+    unpackLE16ToFloatScalar(src + i * 2, dst + i, count - i);
+}
+
+/* Adds the lanes of the running sums into the statistics */
+SSE2_TARGET static void flushStatisticsSSE2(__m128i *sum32, __m128i *saturated16,
+        SpectrumStatistics *s) {
+    unsigned int sums[4];
+    unsigned short counts[8];
+    unsigned int i;
+
+    _mm_storeu_si128((__m128i *)sums, *sum32);
+    _mm_storeu_si128((__m128i *)counts, *saturated16);
+    for(i = 0; i < 4; i++) {
+        s->sum += sums[i];
+    }
+    for(i = 0; i < 8; i++) {
+        s->saturatedPixels += counts[i];
+    }
+    *sum32 = _mm_setzero_si128();
+    *saturated16 = _mm_setzero_si128();
+}
+
+SSE2_TARGET static void unpackLE16ToDoubleWithStatisticsSSE2(const byte *src,
+        double *dst, unsigned int count, unsigned int threshold,
+        SpectrumStatistics *s) {
+    /* SSE2 only compares signed 16-bit values, so pixels are compared with
+     * their top bit flipped, which keeps them in the same order.
+     */
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    const __m128i limit = _mm_set1_epi16((short)((threshold - 1) ^ 0x8000));
+    __m128i minimum = _mm_set1_epi16((short)0x7FFF);
+    __m128i maximum = _mm_set1_epi16((short)0x8000);
+    __m128i sum32 = zero;
+    __m128i saturated16 = zero;
+    unsigned short minima[8];
+    unsigned int maximumPixel = 0;
+    unsigned int blocks = 0;
+    unsigned int i;
+    unsigned int j;
+
+    if(0 == threshold) {
+        /* Every pixel is saturated, which the comparison cannot express */
+        statisticsScalar(src, dst, count, 0, threshold, s);
+        return;
+    }
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 2));
+        __m128i lo = _mm_unpacklo_epi16(v, zero);
+        __m128i hi = _mm_unpackhi_epi16(v, zero);
+        __m128i biased = _mm_xor_si128(v, bias);
+
+        _mm_storeu_pd(dst + i, _mm_cvtepi32_pd(lo));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtepi32_pd(_mm_srli_si128(lo, 8)));
+        _mm_storeu_pd(dst + i + 4, _mm_cvtepi32_pd(hi));
+        _mm_storeu_pd(dst + i + 6, _mm_cvtepi32_pd(_mm_srli_si128(hi, 8)));
+
+        sum32 = _mm_add_epi32(sum32, _mm_add_epi32(lo, hi));
+        minimum = _mm_min_epi16(minimum, biased);
+        saturated16 = _mm_sub_epi16(saturated16, _mm_cmpgt_epi16(biased, limit));
+
+        /* A new maximum is rare once the peak has gone by, so the block is
+         * only searched for the first pixel holding it when there is one.
+         */
+        if(0 != _mm_movemask_epi8(_mm_cmpgt_epi16(biased, maximum))) {
+            for(j = 0; j < 8; j++) {
+                unsigned int pixel = src[(i + j) * 2] | (src[(i + j) * 2 + 1] << 8);
+                if(pixel > maximumPixel) {
+                    maximumPixel = pixel;
+                    s->maximumIndex = i + j;
+                }
+            }
+            maximum = _mm_set1_epi16((short)(maximumPixel ^ 0x8000));
+        }
+
+        /* Flushed well before a 32-bit sum lane or 16-bit count can wrap */
+        if(16384 == ++blocks) {
+            flushStatisticsSSE2(&sum32, &saturated16, s);
+            blocks = 0;
+        }
+    }
+    flushStatisticsSSE2(&sum32, &saturated16, s);
+
+    if(i > 0) {
+        _mm_storeu_si128((__m128i *)minima, minimum);
+        for(j = 0; j < 8; j++) {
+            if((double)(minima[j] ^ 0x8000) < s->minimum) {
+                s->minimum = (double)(minima[j] ^ 0x8000);
+            }
+        }
+        if((double)maximumPixel > s->maximum) {
+            s->maximum = (double)maximumPixel;
+        }
+    }
+
+    statisticsScalar(src + i * 2, dst + i, count - i, i, threshold, s);
+}
+
+static const struct PixelUnpackKernels sse2Kernels = {
+    "sse2", unpackLE16FlipSSE2, unpackLE16ToU32SSE2, unpackLE16ToDoubleSSE2,
+    unpackLE16ToDoubleWithStatisticsSSE2, unpackLE16ToFloatSSE2,
+    unpackLE16FlipToDoubleSSE2
+};
+
+#ifdef PIXEL_UNPACK_AVX2
+
+AVX2_TARGET static void unpackLE16FlipAVX2(const byte *src, unsigned short *dst,
+        unsigned int count, unsigned short flip) {
+    __m256i mask = _mm256_set1_epi16((short)flip);
+    unsigned int i;
+
+    for(i = 0; i + 16 <= count; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i * 2));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(v, mask));
+    }
+    unpackLE16FlipScalar(src + i * 2, dst + i, count - i, flip);
+}
+
+AVX2_TARGET static void unpackLE16ToU32AVX2(const byte *src, unsigned int *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i + 16 <= count; i += 16) {
+        __m128i lo = _mm_loadu_si128((const __m128i *)(src + i * 2));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(src + i * 2 + 16));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_cvtepu16_epi32(lo));
+        _mm256_storeu_si256((__m256i *)(dst + i + 8), _mm256_cvtepu16_epi32(hi));
+    }
+    unpackLE16ToU32Scalar(src + i * 2, dst + i, count - i);
+}
+
+AVX2_TARGET static void unpackLE16ToDoubleAVX2(const byte *src, double *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_cvtepu16_epi32(
+            _mm_loadu_si128((const __m128i *)(src + i * 2)));
+        _mm256_storeu_pd(dst + i, _mm256_cvtepi32_pd(_mm256_castsi256_si128(v)));
+        _mm256_storeu_pd(dst + i + 4, _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)));
+    }
+    unpackLE16ToDoubleScalar(src + i * 2, dst + i, count - i);
+}
+
+AVX2_TARGET static void unpackLE16FlipToDoubleAVX2(const byte *src, double *dst,
+        unsigned int count, unsigned short flip) {
+    __m128i mask = _mm_set1_epi16((short)flip);
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_cvtepu16_epi32(_mm_xor_si128(
+            _mm_loadu_si128((const __m128i *)(src + i * 2)), mask));
+        _mm256_storeu_pd(dst + i, _mm256_cvtepi32_pd(_mm256_castsi256_si128(v)));
+        _mm256_storeu_pd(dst + i + 4, _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)));
+    }
+    unpackLE16FlipToDoubleScalar(src + i * 2, dst + i, count - i, flip);
+}
+
+AVX2_TARGET static void unpackLE16ToFloatAVX2(const byte *src, float *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_cvtepu16_epi32(
+            _mm_loadu_si128((const __m128i *)(src + i * 2)));
+        _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(v));
+    }
+    unpackLE16ToFloatScalar(src + i * 2, dst + i, count - i);
+}
+
+/* The statistics pass is bound by its compares rather than by the width of
+ * the loads, so AVX2 processors use the SSE2 version.
+ */
+static const struct PixelUnpackKernels avx2Kernels = {
+    "avx2", unpackLE16FlipAVX2, unpackLE16ToU32AVX2, unpackLE16ToDoubleAVX2,
+    unpackLE16ToDoubleWithStatisticsSSE2, unpackLE16ToFloatAVX2,
+    unpackLE16FlipToDoubleAVX2
+};
+
+#endif /* PIXEL_UNPACK_AVX2 */
+
+static void __cpuid_registers(unsigned int leaf, unsigned int regs[4]) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuidex(info, (int)leaf, 0);
+    regs[0] = info[0]; regs[1] = info[1]; regs[2] = info[2]; regs[3] = info[3];
+#else
+    if(__get_cpuid_max(0, NULL) < leaf) {
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+        return;
+    }
+    __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static const struct PixelUnpackKernels *__select_kernels() {
+    unsigned int regs[4];
+
+    __cpuid_registers(1, regs);
+    if(0 == (regs[3] & (1 << 26))) {
+        return &scalarKernels;
+    }
+
+#ifdef PIXEL_UNPACK_AVX2
+    /* AVX2 also needs the operating system to save the YMM registers */
+    if(0 != (regs[2] & (1 << 27)) && 0 != (regs[2] & (1 << 28))) {
+        unsigned long long xcr0;
+#ifdef _MSC_VER
+        xcr0 = _xgetbv(0);
+#else
+        unsigned int eax, edx;
+        __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        xcr0 = ((unsigned long long)edx << 32) | eax;
+#endif
+        __cpuid_registers(7, regs);
+        if(6 == (xcr0 & 6) && 0 != (regs[1] & (1 << 5))) {
+            return &avx2Kernels;
+        }
+    }
+#endif
+
+    return &sse2Kernels;
+}
+
+#elif defined(PIXEL_UNPACK_NEON)
+
+static void unpackLE16FlipNEON(const byte *src, unsigned short *dst,
+        unsigned int count, unsigned short flip) {
+    uint16x8_t mask = vdupq_n_u16(flip);
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(src + i * 2));
+        vst1q_u16(dst + i, veorq_u16(v, mask));
+    }
+    unpackLE16FlipScalar(src + i * 2, dst + i, count - i, flip);
+}
+
+static void unpackLE16ToU32NEON(const byte *src, unsigned int *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(src + i * 2));
+        vst1q_u32(dst + i, vmovl_u16(vget_low_u16(v)));
+        vst1q_u32(dst + i + 4, vmovl_u16(vget_high_u16(v)));
+    }
+    unpackLE16ToU32Scalar(src + i * 2, dst + i, count - i);
+}
+
+static void unpackLE16ToFloatNEON(const byte *src, float *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(src + i * 2));
+        vst1q_f32(dst + i, vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))));
+        vst1q_f32(dst + i + 4, vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))));
+    }
+    unpackLE16ToFloatScalar(src + i * 2, dst + i, count - i);
+}
+
+#ifdef __aarch64__
+static void unpackLE16ToDoubleNEON(const byte *src, double *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i + 8 <= count; i += 8) {
+        uint16x8_t v = vreinterpretq_u16_u8(vld1q_u8(src + i * 2));
+        uint32x4_t lo = vmovl_u16(vget_low_u16(v));
+        uint32x4_t hi = vmovl_u16(vget_high_u16(v));
+        vst1q_f64(dst + i, vcvtq_f64_u64(vmovl_u32(vget_low_u32(lo))));
+        vst1q_f64(dst + i + 2, vcvtq_f64_u64(vmovl_u32(vget_high_u32(lo))));
+        vst1q_f64(dst + i + 4, vcvtq_f64_u64(vmovl_u32(vget_low_u32(hi))));
+        vst1q_f64(dst + i + 6, vcvtq_f64_u64(vmovl_u32(vget_high_u32(hi))));
+    }
+    unpackLE16ToDoubleScalar(src + i * 2, dst + i, count - i);
+}
+#else
+/* 32-bit NEON has no double precision lanes */
+#define unpackLE16ToDoubleNEON unpackLE16ToDoubleScalar
+#endif
+
+static const struct PixelUnpackKernels neonKernels = {
+    "neon", unpackLE16FlipNEON, unpackLE16ToU32NEON, unpackLE16ToDoubleNEON,
+    unpackLE16ToDoubleWithStatisticsScalar, unpackLE16ToFloatNEON,
+    unpackLE16FlipToDoubleScalar
+};
+
+/* NEON is part of every processor the library is built with it for */
+static const struct PixelUnpackKernels *__select_kernels() {
+    return &neonKernels;
+}
+
+#else
+
+static const struct PixelUnpackKernels *__select_kernels() {
+    return &scalarKernels;
+}
+
+#endif
+
+/* Choosing twice is harmless, so threads that race here need no lock */
+static const struct PixelUnpackKernels *__kernels = NULL;
+
+static inline const struct PixelUnpackKernels *__get_kernels() {
+    if(NULL == __kernels) {
+        __kernels = __select_kernels();
+    }
+    return __kernels;
+}
+
+void PixelUnpack::unpackLE16(const byte *src, unsigned short *dst,
+        unsigned int count) {
+#ifdef PIXEL_UNPACK_LITTLE_ENDIAN
+    /* The pixels are already laid out as the host keeps them */
+    memcpy(dst, src, count * sizeof(unsigned short));
+#else
+    unpackLE16FlipScalar(src, dst, count, 0);
+#endif
+}
+
+void PixelUnpack::unpackLE16Flip(const byte *src, unsigned short *dst,
+        unsigned int count, unsigned short flip) {
+    __get_kernels()->flip(src, dst, count, flip);
+}
+
+void PixelUnpack::unpackLE16ToU32(const byte *src, unsigned int *dst,
+        unsigned int count) {
+    __get_kernels()->toU32(src, dst, count);
+}
+
+void PixelUnpack::unpackLE16ToDouble(const byte *src, double *dst,
+        unsigned int count) {
+    __get_kernels()->toDouble(src, dst, count);
+}
+
+void PixelUnpack::unpackLE16FlipToDouble(const byte *src, double *dst,
+        unsigned int count, unsigned short flip) {
+    __get_kernels()->flipToDouble(src, dst, count, flip);
+}
+
+void PixelUnpack::widenToDouble(const unsigned short *src, double *dst,
+        unsigned int count) {
+#ifdef PIXEL_UNPACK_LITTLE_ENDIAN
+    /* In memory these are the same as the little-endian bytes */
+    __get_kernels()->toDouble((const byte *)src, dst, count);
+#else
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = src[i];
+    }
+#endif
+}
+
+void PixelUnpack::unpackLE16ToFloat(const byte *src, float *dst,
+        unsigned int count) {
+    __get_kernels()->toFloat(src, dst, count);
+}
+
+void PixelUnpack::widenToFloat(const unsigned short *src, float *dst,
+        unsigned int count) {
+#ifdef PIXEL_UNPACK_LITTLE_ENDIAN
+    __get_kernels()->toFloat((const byte *)src, dst, count);
+#else
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = src[i];
+    }
+#endif
+}
+
+void PixelUnpack::widenToU32(const unsigned short *src, unsigned int *dst,
+        unsigned int count) {
+#ifdef PIXEL_UNPACK_LITTLE_ENDIAN
+    __get_kernels()->toU32((const byte *)src, dst, count);
+#else
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = src[i];
+    }
+#endif
+}
+
+void PixelUnpack::convert(const unsigned int *src, unsigned short *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = (src[i] > 0xFFFF) ? 0xFFFF : (unsigned short)src[i];
+    }
+}
+
+void PixelUnpack::convert(const unsigned int *src, float *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = (float)src[i];
+    }
+}
+
+void PixelUnpack::convert(const double *src, unsigned short *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        if(!(src[i] > 0.0)) {
+            dst[i] = 0;         /* Also catches NaN */
+        } else if(src[i] >= 65535.0) {
+            dst[i] = 0xFFFF;
+        } else {
+            dst[i] = (unsigned short)(src[i] + 0.5);
+        }
+    }
+}
+
+void PixelUnpack::convert(const double *src, unsigned int *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        if(!(src[i] > 0.0)) {
+            dst[i] = 0;
+        } else if(src[i] >= 4294967295.0) {
+            dst[i] = 0xFFFFFFFF;
+        } else {
+            dst[i] = (unsigned int)(src[i] + 0.5);
+        }
+    }
+}
+
+void PixelUnpack::convert(const double *src, float *dst,
+        unsigned int count) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        dst[i] = (float)src[i];
+    }
+}
+
+/* Starts statistics off so that any pixel replaces the minimum and maximum,
+ * and returns the saturation level as the kernels take it.
+ */
+static unsigned int __start_statistics(double saturationLevel,
+        SpectrumStatistics *statistics) {
+    statistics->minimum = 65536.0;
+    statistics->maximum = -1.0;
+    statistics->sum = 0.0;
+    statistics->maximumIndex = 0;
+    statistics->saturatedPixels = 0;
+
+    if(saturationLevel <= 0.0) {
+        return 0;
+    } else if(saturationLevel > 65535.0) {
+        return 65536;
+    }
+    return (unsigned int)saturationLevel
+        + (((double)(unsigned int)saturationLevel < saturationLevel) ? 1 : 0);
+}
+
+/* An empty spectrum has no minimum or maximum to report */
+static void __finish_statistics(unsigned int count, SpectrumStatistics *statistics) {
+    if(0 == count) {
+        statistics->minimum = 0.0;
+        statistics->maximum = 0.0;
+    }
+}
+
+void PixelUnpack::unpackLE16ToDoubleWithStatistics(const byte *src, double *dst,
+        unsigned int count, double saturationLevel, SpectrumStatistics *statistics) {
+    unsigned int threshold = __start_statistics(saturationLevel, statistics);
+
+    __get_kernels()->toDoubleWithStatistics(src, dst, count, threshold, statistics);
+    __finish_statistics(count, statistics);
+}
+
+void PixelUnpack::widenToDoubleWithStatistics(const unsigned short *src,
+        double *dst, unsigned int count, double saturationLevel,
+        SpectrumStatistics *statistics) {
+#ifdef PIXEL_UNPACK_LITTLE_ENDIAN
+    unpackLE16ToDoubleWithStatistics((const byte *)src, dst, count,
+        saturationLevel, statistics);
+#else
+    widenToDouble(src, dst, count);
+    computeStatistics(dst, count, saturationLevel, statistics);
+#endif
+}
+
+void PixelUnpack::computeStatistics(const double *values, unsigned int count,
+        double saturationLevel, SpectrumStatistics *statistics) {
+    unsigned int i;
+
+    statistics->minimum = (count > 0) ? values[0] : 0.0;
+    statistics->maximum = (count > 0) ? values[0] : 0.0;
+    statistics->sum = 0.0;
+    statistics->maximumIndex = 0;
+    statistics->saturatedPixels = 0;
+
+    for(i = 0; i < count; i++) {
+        statistics->sum += values[i];
+        if(values[i] < statistics->minimum) {
+            statistics->minimum = values[i];
+        }
+        if(values[i] > statistics->maximum) {
+            statistics->maximum = values[i];
+            statistics->maximumIndex = i;
+        }
+        if(values[i] >= saturationLevel) {
+            statistics->saturatedPixels++;
+        }
+    }
+}
+
+/* The product is taken before the division, as it always has been, so that
+ * corrected spectra do not change in the last bit.
+ */
+void PixelUnpack::applyGain(double *values, unsigned int count,
+        double maxIntensity, double saturationLevel) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        double temp = values[i] * maxIntensity / saturationLevel;
+        values[i] = (temp > maxIntensity) ? maxIntensity : temp;
+    }
+}
+
+void PixelUnpack::applyGain(const unsigned short *src, double *dst,
+        unsigned int count, double maxIntensity, double saturationLevel) {
+    unsigned int i;
+
+    for(i = 0; i < count; i++) {
+        double temp = src[i] * maxIntensity / saturationLevel;
+        dst[i] = (temp > maxIntensity) ? maxIntensity : temp;
+    }
+}
+
+const char *PixelUnpack::getKernelName() {
+    return __get_kernels()->name;
+}
+
+bool PixelUnpack::selectKernel(const char *name) {
+    const struct PixelUnpackKernels *best = __select_kernels();
+    const struct PixelUnpackKernels *chosen = NULL;
+
+    if(NULL == name) {
+        chosen = best;
+    } else if(0 == strcmp(name, scalarKernels.name)) {
+        chosen = &scalarKernels;
+    } else if(0 == strcmp(name, best->name)) {
+        chosen = best;
+#ifdef PIXEL_UNPACK_X86
+    } else if(0 == strcmp(name, sse2Kernels.name) && best != &scalarKernels) {
+        /* Every processor with AVX2 also has SSE2 */
+        chosen = &sse2Kernels;
+#endif
+    }
+
+    if(NULL == chosen) {
+        return false;
+    }
+    __kernels = chosen;
+    return true;
+}
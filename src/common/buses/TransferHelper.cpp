@@ -29,13 +29,88 @@
 
 #include "common/globals.h"
 #include "common/buses/TransferHelper.h"
+#include <string.h>
 
 using namespace seabreeze;
 
-TransferHelper::TransferHelper() {
+TransferHelperState::~TransferHelperState() {
+
+}
 
+TransferHelper::TransferHelper() {
+    this->protocolState = NULL;
 }
 
 TransferHelper::~TransferHelper() {
+    delete this->protocolState;
+}
+
+int TransferHelper::receiveBorrowed(const byte **data, unsigned int length)
+        throw (BusTransferException) {
+    int retval;
+
+    if(this->borrowBuffer.size() < length) {
+        this->borrowBuffer.resize(length);
+    }
+
+    retval = receive(this->borrowBuffer, length);
+    *data = &(this->borrowBuffer[0]);
+
+    return retval;
+}
+
+void TransferHelper::releaseBorrowed() {
+    /* Nothing to do; the internal buffer is reused on the next receive */
+}
+
+int TransferHelper::receiveAt(std::vector<byte> &buffer, unsigned int offset,
+        unsigned int length) throw (BusTransferException) {
+    int retval;
+
+    if(0 == offset) {
+        return receive(buffer, length);
+    }
+
+    /* Helpers that can only fill a buffer from the start read into the
+     * internal one and the bytes are moved into place afterwards.
+     */
+    if(this->borrowBuffer.size() < length) {
+        this->borrowBuffer.resize(length);
+    }
+
+    retval = receive(this->borrowBuffer, length);
+    if(retval > 0) {
+        memcpy(&(buffer[offset]), &(this->borrowBuffer[0]), retval);
+    }
+
+    return retval;
+}
+
+unsigned int TransferHelper::getSingleReadLength() {
+    return 0;
+}
+
+void TransferHelper::submitReceive(unsigned int length)
+        throw (BusTransferException) {
+    throw BusTransferException("Asynchronous receive is not supported on this bus.");
+}
+
+bool TransferHelper::isReceiveReady() throw (BusTransferException) {
+    throw BusTransferException("Asynchronous receive is not supported on this bus.");
+}
+
+bool TransferHelper::setReceiveTimeout(unsigned int milliseconds,
+        unsigned int *previous) {
+    return false;
+}
+
+TransferHelperState *TransferHelper::getProtocolState() {
+    return this->protocolState;
+}
 
+void TransferHelper::setProtocolState(TransferHelperState *state) {
+    if(state != this->protocolState) {
+        delete this->protocolState;
+        this->protocolState = state;
+    }
 }
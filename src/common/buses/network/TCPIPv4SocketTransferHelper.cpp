@@ -28,6 +28,7 @@
  *******************************************************/
 
 #include "common/buses/network/TCPIPv4SocketTransferHelper.h"
+#include "native/system/FlightRecorder.h"
 
 using namespace seabreeze;
 using namespace std;
@@ -44,8 +45,13 @@ TCPIPv4SocketTransferHelper::~TCPIPv4SocketTransferHelper() {
 
 int TCPIPv4SocketTransferHelper::receive(vector<byte> &buffer,
         unsigned int length) throw (BusTransferException) {
+    return receiveAt(buffer, 0, length);
+}
+
+int TCPIPv4SocketTransferHelper::receiveAt(vector<byte> &buffer,
+        unsigned int offset, unsigned int length) throw (BusTransferException) {
     
-    unsigned char *rawBuffer = (unsigned char *)&buffer[0];
+    unsigned char *rawBuffer = (unsigned char *)&buffer[offset];
     unsigned int bytesRead = 0;
     
     /* TODO: There should be a couple alternatives for this.  One should
@@ -57,6 +63,8 @@ int TCPIPv4SocketTransferHelper::receive(vector<byte> &buffer,
         while(bytesRead < length) {
             int result = this->socket->read(&rawBuffer[bytesRead],
                     length - bytesRead);
+            FlightRecorder::record(FLIGHT_RECORDER_BUS_TCPIP, FLIGHT_RECORDER_IN,
+                    &rawBuffer[bytesRead], length - bytesRead, result);
             if(result > 0) {
                 bytesRead += result;
             } else {
@@ -67,6 +75,8 @@ int TCPIPv4SocketTransferHelper::receive(vector<byte> &buffer,
             }
         }
     } catch (BusTransferException &bte) {
+        FlightRecorder::record(FLIGHT_RECORDER_BUS_TCPIP, FLIGHT_RECORDER_IN,
+                NULL, length - bytesRead, -1);
         if(0 == bytesRead) {
             throw bte;
         }
@@ -85,6 +95,8 @@ int TCPIPv4SocketTransferHelper::send(const vector<byte> &buffer,
          * by the caller.
          */
         int result = this->socket->write(&rawBuffer[written], length - written);
+        FlightRecorder::record(FLIGHT_RECORDER_BUS_TCPIP, FLIGHT_RECORDER_OUT,
+                &rawBuffer[written], length - written, result);
         if(result > 0) {
             written += result;
         } else {
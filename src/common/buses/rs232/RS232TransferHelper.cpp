@@ -45,11 +45,16 @@ RS232TransferHelper::~RS232TransferHelper() {
 
 int RS232TransferHelper::receive(vector<byte> &buffer, unsigned int length)
         throw (BusTransferException) {
+    return receiveAt(buffer, 0, length);
+}
+
+int RS232TransferHelper::receiveAt(vector<byte> &buffer, unsigned int offset,
+        unsigned int length) throw (BusTransferException) {
     int retval = 0;
     unsigned int bytesRead = 0;
 
     while(bytesRead < length) {
-        retval = this->rs232->read((void *)&(buffer[bytesRead]), length - bytesRead);
+        retval = this->rs232->read((void *)&(buffer[offset + bytesRead]), length - bytesRead);
         if(retval < 0) {
             string error("Failed to read any data from RS232.");
             throw BusTransferException(error);
@@ -29,21 +29,31 @@
 
 #include "common/globals.h"
 #include "common/buses/usb/USBTransferHelper.h"
+#include <stdint.h>
 #include <string>
 
 using namespace seabreeze;
 using namespace std;
 
+#define SCRATCH_ALIGNMENT 64
+
 USBTransferHelper::USBTransferHelper(USB *usbDescriptor, int sendEndpoint,
         int receiveEndpoint) : TransferHelper() {
     this->usb = usbDescriptor;
     this->sendEndpoint = sendEndpoint;
     this->receiveEndpoint = receiveEndpoint;
     this->timeout = 0; // NOTE: zero timeout means using the standard USB timeout or no timeout at all (depending on implementation)
+    this->zeroCopy = false;
+    this->borrowing = false;
+    this->maxPacketSize = -1;
 }
 
 USBTransferHelper::USBTransferHelper(USB *usbDescriptor) : TransferHelper() {
     this->usb = usbDescriptor;
+    this->timeout = 0;
+    this->zeroCopy = false;
+    this->borrowing = false;
+    this->maxPacketSize = -1;
 }
 
 USBTransferHelper::~USBTransferHelper() {
@@ -52,9 +62,14 @@ USBTransferHelper::~USBTransferHelper() {
 
 int USBTransferHelper::receive(vector<byte> &buffer, unsigned int length)
         throw (BusTransferException) {
+    return USBTransferHelper::receiveAt(buffer, 0, length);
+}
+
+int USBTransferHelper::receiveAt(vector<byte> &buffer, unsigned int offset,
+        unsigned int length) throw (BusTransferException) {
     int retval = 0;
 
-    retval = this->usb->read(this->receiveEndpoint, (void *)&(buffer[0]), length, this->timeout);
+    retval = this->usb->read(this->receiveEndpoint, (void *)&(buffer[offset]), length, this->timeout);
 
     if((0 == retval && length > 0) || (retval < 0)) {
         string error("Failed to read any data from USB.");
@@ -66,9 +81,14 @@ int USBTransferHelper::receive(vector<byte> &buffer, unsigned int length)
 
 int USBTransferHelper::send(const vector<byte> &buffer, unsigned int length) const
         throw (BusTransferException) {
+    return USBTransferHelper::sendAt(buffer, 0, length);
+}
+
+int USBTransferHelper::sendAt(const vector<byte> &buffer, unsigned int offset,
+        unsigned int length) const throw (BusTransferException) {
     int retval = 0;
 
-    retval = this->usb->write(this->sendEndpoint, (void *)&(buffer[0]), length, this->timeout);
+    retval = this->usb->write(this->sendEndpoint, (void *)&(buffer[offset]), length, this->timeout);
 
     if((0 == retval && length > 0) || (retval < 0)) {
         string error("Failed to write any data to USB.");
@@ -78,7 +98,118 @@ int USBTransferHelper::send(const vector<byte> &buffer, unsigned int length) con
     return retval;
 }
 
+unsigned int USBTransferHelper::scratchAt(vector<byte> &scratch,
+        unsigned int length) const {
+    uintptr_t address;
+
+    if(scratch.size() < length + SCRATCH_ALIGNMENT) {
+        scratch.resize(length + SCRATCH_ALIGNMENT);
+    }
+
+    address = (uintptr_t)&(scratch[0]);
+    return (unsigned int)((SCRATCH_ALIGNMENT - (address % SCRATCH_ALIGNMENT)) % SCRATCH_ALIGNMENT);
+}
+
+unsigned int USBTransferHelper::getSingleReadLength() {
+    if(this->maxPacketSize < 0) {
+        /* Only look this up once; it means walking the descriptors.
+         * Endpoints on one interface can differ (e.g. a 512-byte bulk
+         * endpoint next to a 64-byte one), so size reads by the
+         * endpoint they actually come from.
+         */
+        this->maxPacketSize = this->usb->getEndpointMaxPacketSize(this->receiveEndpoint);
+        if(this->maxPacketSize < 0) {
+            /* Endpoint not in the descriptors; fall back to the largest */
+            this->maxPacketSize = this->usb->getMaxPacketSize();
+        }
+        if(this->maxPacketSize < 0) {
+            return 0;
+        }
+    }
+
+    return (unsigned int)this->maxPacketSize;
+}
 
 void USBTransferHelper::setTimeout(unsigned int time) {
     this->timeout = time;
 }
+
+bool USBTransferHelper::setReceiveTimeout(unsigned int milliseconds,
+        unsigned int *previous) {
+    /* Sends and receives share one timeout here */
+    *previous = this->timeout;
+    this->timeout = milliseconds;
+    return true;
+}
+
+void USBTransferHelper::setReadQueueDepth(unsigned int depth, bool zeroCopy)
+        throw (BusTransferException) {
+
+    /* Anything still borrowed goes away with the old queue */
+    this->borrowing = false;
+    this->zeroCopy = false;
+
+    if(this->usb->setReadQueueDepth(this->receiveEndpoint, (int)depth, zeroCopy) < 0) {
+        string error("Failed to set up queued reads on USB endpoint.");
+        throw BusTransferException(error);
+    }
+
+    this->zeroCopy = zeroCopy && depth > 0;
+}
+
+int USBTransferHelper::receiveBorrowed(const byte **data, unsigned int length)
+        throw (BusTransferException) {
+    unsigned char *buffer = NULL;
+    int retval;
+
+    if(false == this->zeroCopy) {
+        return TransferHelper::receiveBorrowed(data, length);
+    }
+
+    if(true == this->borrowing) {
+        releaseBorrowed();
+    }
+
+    retval = this->usb->acquireReadBuffer(this->receiveEndpoint, length, &buffer, this->timeout);
+    if(0 == retval && length > 0) {
+        /* An empty buffer was still lent out */
+        this->usb->releaseReadBuffer(this->receiveEndpoint);
+    }
+    if((0 == retval && length > 0) || (retval < 0)) {
+        string error("Failed to read any data from USB.");
+        throw BusTransferException(error);
+    }
+
+    this->borrowing = true;
+    *data = buffer;
+
+    return retval;
+}
+
+void USBTransferHelper::submitReceive(unsigned int length)
+        throw (BusTransferException) {
+
+    if(this->usb->submitQueuedRead(this->receiveEndpoint, length) < 0) {
+        string error("Failed to queue a read on USB endpoint.");
+        throw BusTransferException(error);
+    }
+}
+
+bool USBTransferHelper::isReceiveReady() throw (BusTransferException) {
+    int retval;
+
+    retval = this->usb->isReadReady(this->receiveEndpoint);
+    if(retval < 0) {
+        string error("No read has been queued on USB endpoint.");
+        throw BusTransferException(error);
+    }
+
+    return (retval > 0);
+}
+
+void USBTransferHelper::releaseBorrowed() {
+    if(true == this->borrowing) {
+        this->usb->releaseReadBuffer(this->receiveEndpoint);
+        this->borrowing = false;
+    }
+}
@@ -29,9 +29,13 @@
 
 #include "common/globals.h"
 #include "common/exceptions/ProtocolFormatException.h"
+#include "native/system/FlightRecorder.h"
 
 using namespace seabreeze;
 
 ProtocolFormatException::ProtocolFormatException(const std::string &msg) : ProtocolException(msg) {
-
+    /* A malformed message usually means a transfer was lost or cut short
+     * somewhere before it, so keep the traffic that led up to it.
+     */
+    FlightRecorder::protocolError();
 }
@@ -0,0 +1,72 @@
+/***************************************************//**
+ * @file    ReplyCache.cpp
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * A ReplyCache remembers the replies a device gave to
+ * queries whose answers do not change while it is open.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#include "common/globals.h"
+#include "common/protocols/ReplyCache.h"
+#include <stddef.h>
+
+using namespace seabreeze;
+using namespace std;
+
+ReplyCache::ReplyCache() {
+
+}
+
+ReplyCache::~ReplyCache() {
+
+}
+
+int ReplyCache::lookup(unsigned int messageType, const vector<byte> &request,
+        const byte **reply) const {
+    map<Key, vector<byte> >::const_iterator iter;
+
+    if(true == this->replies.empty()) {
+        return -1;
+    }
+
+    iter = this->replies.find(Key(messageType, request));
+    if(this->replies.end() == iter) {
+        return -1;
+    }
+
+    *reply = (true == iter->second.empty()) ? NULL : &(iter->second[0]);
+    return (int)iter->second.size();
+}
+
+void ReplyCache::store(unsigned int messageType, const vector<byte> &request,
+        const byte *reply, unsigned int length) {
+    this->replies[Key(messageType, request)].assign(reply, reply + length);
+}
+
+void ReplyCache::clear() {
+    this->replies.clear();
+}
@@ -30,6 +30,7 @@
 #include "common/globals.h"
 #include "native/rs232/RS232.h"
 #include "native/rs232/NativeRS232.h"
+#include "native/system/FlightRecorder.h"
 #include "common/exceptions/IllegalArgumentException.h"
 #include <stdlib.h>
 #include <stdio.h>  /* For debugging, feel free to replace with iostream */
@@ -143,6 +144,8 @@ int RS232::write(void *data, unsigned int length_bytes) {
     }
 
     flag = RS232Write(this->descriptor, (char *)data, (int)length_bytes);
+    FlightRecorder::record(FLIGHT_RECORDER_BUS_RS232, FLIGHT_RECORDER_OUT,
+            data, (int)length_bytes, flag);
 
     if(flag < 0) {
         /* FIXME: throw an exception here */
@@ -176,6 +179,8 @@ int RS232::read(void *data, unsigned int length_bytes) {
     }
 
     flag = RS232Read(this->descriptor, (char *)data, (int)length_bytes);
+    FlightRecorder::record(FLIGHT_RECORDER_BUS_RS232, FLIGHT_RECORDER_IN,
+            data, (int)length_bytes, flag);
 
     if(flag < 0) {
         /* FIXME: throw an exception here */
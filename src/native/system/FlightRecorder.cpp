@@ -0,0 +1,219 @@
+/***************************************************//**
+ * @file    FlightRecorder.cpp
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * The FlightRecorder keeps the most recent bus transfers
+ * in a fixed-size ring in memory so that the traffic
+ * leading up to a problem can be examined afterwards.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#include "common/globals.h"
+#include "native/system/FlightRecorder.h"
+#include "native/system/System.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WINDOWS
+#include <windows.h>
+#define ATOMIC_INCREMENT(x) InterlockedIncrement(&(x))
+#define MEMORY_BARRIER()    MemoryBarrier()
+#define SPIN_LOCK(x)        while(0 != InterlockedExchange(&(x), 1)) { }
+#define SPIN_UNLOCK(x)      InterlockedExchange(&(x), 0)
+#else
+#define ATOMIC_INCREMENT(x) __sync_add_and_fetch(&(x), 1)
+#define MEMORY_BARRIER()    __sync_synchronize()
+#define SPIN_LOCK(x)        while(0 != __sync_lock_test_and_set(&(x), 1)) { }
+#define SPIN_UNLOCK(x)      __sync_lock_release(&(x))
+#endif
+
+/* Each slot works as a seqlock: its sequence is zero while the record is
+ * being written and is only set, after a barrier, once the record is
+ * complete.  A reader takes the sequence before copying and checks it is
+ * unchanged afterwards, so a record rewritten during the copy is dropped.
+ */
+#define SLOT_SEQUENCE(r)    (*(volatile uint32_t *)&((r)->sequence))
+
+using namespace seabreeze;
+using namespace std;
+
+struct FlightRecord FlightRecorder::records[FLIGHT_RECORDER_RECORDS];
+volatile long FlightRecorder::nextSequence = 0;
+bool FlightRecorder::enabled = true;
+string FlightRecorder::protocolErrorDumpFile;
+volatile long FlightRecorder::protocolErrorDumpFileLock = 0;
+bool FlightRecorder::protocolErrorDumped = false;
+unsigned long FlightRecorder::lastProtocolErrorDumpMicros = 0;
+
+void FlightRecorder::record(int bus, int endpoint, const void *data,
+        int requested, int result, unsigned long timestampMicros) {
+    struct FlightRecord *r;
+    unsigned long sequence;
+    int length;
+
+    if(false == enabled) {
+        return;
+    }
+
+    /* Each caller gets a slot of its own, so threads recording transfers on
+     * different devices never have to wait for each other.
+     */
+    sequence = (unsigned long)ATOMIC_INCREMENT(nextSequence);
+    r = &(records[(sequence - 1) & (FLIGHT_RECORDER_RECORDS - 1)]);
+
+    /* A zero sequence makes dump() skip the slot while it is rewritten */
+    SLOT_SEQUENCE(r) = 0;
+    MEMORY_BARRIER();
+    r->timestampMicros = timestampMicros;
+    r->bus = (uint8_t)bus;
+    r->endpoint = (uint8_t)endpoint;
+    r->reserved = 0;
+    r->requested = requested;
+    r->result = result;
+
+    length = (result < FLIGHT_RECORDER_DATA_BYTES) ? result : FLIGHT_RECORDER_DATA_BYTES;
+    if(NULL == data || length < 0) {
+        length = 0;
+    } else {
+        memcpy(r->data, data, length);
+    }
+    memset(r->data + length, 0, FLIGHT_RECORDER_DATA_BYTES - length);
+
+    MEMORY_BARRIER();
+    SLOT_SEQUENCE(r) = (uint32_t)sequence;
+}
+
+void FlightRecorder::record(int bus, int endpoint, const void *data,
+        int requested, int result) {
+    if(true == enabled) {
+        record(bus, endpoint, data, requested, result,
+                System::getMonotonicMicroseconds());
+    }
+}
+
+void FlightRecorder::setEnabled(bool enable) {
+    enabled = enable;
+}
+
+bool FlightRecorder::isEnabled() {
+    return enabled;
+}
+
+int FlightRecorder::dump(const char *path) {
+    struct FlightRecorderHeader header;
+    struct FlightRecord *copy;
+    unsigned long last;
+    unsigned long sequence;
+    unsigned long slot;
+    uint32_t before;
+    int count = 0;
+    FILE *file;
+
+    if(NULL == path) {
+        return -1;
+    }
+
+    /* Recording carries on meanwhile, so work from a copy.  Only the slots
+     * holding the sequence numbers expected of them both before and after
+     * they were copied are kept, which leaves out any that were rewritten.
+     */
+    copy = new struct FlightRecord[FLIGHT_RECORDER_RECORDS];
+    last = (unsigned long)nextSequence;
+    sequence = (last > FLIGHT_RECORDER_RECORDS) ? last - FLIGHT_RECORDER_RECORDS + 1 : 1;
+    for(; sequence <= last; sequence++) {
+        slot = (sequence - 1) & (FLIGHT_RECORDER_RECORDS - 1);
+        before = SLOT_SEQUENCE(&(records[slot]));
+        MEMORY_BARRIER();
+        if(before != (uint32_t)sequence) {
+            continue;
+        }
+        memcpy(&(copy[count]), &(records[slot]), sizeof(struct FlightRecord));
+        MEMORY_BARRIER();
+        if(SLOT_SEQUENCE(&(records[slot])) == before) {
+            count++;
+        }
+    }
+
+    file = fopen(path, "wb");
+    if(NULL == file) {
+        delete [] copy;
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "SBFLIGHT", sizeof(header.magic));
+    header.version = FLIGHT_RECORDER_VERSION;
+    header.recordSize = sizeof(struct FlightRecord);
+    header.recordCount = count;
+
+    if(1 != fwrite(&header, sizeof(header), 1, file)
+            || (count > 0 && (size_t)count != fwrite(copy, sizeof(struct FlightRecord), count, file))) {
+        count = -1;
+    }
+    if(0 != fclose(file)) {
+        count = -1;
+    }
+
+    delete [] copy;
+    return count;
+}
+
+void FlightRecorder::setProtocolErrorDumpFile(const char *path) {
+    SPIN_LOCK(protocolErrorDumpFileLock);
+    if(NULL == path) {
+        protocolErrorDumpFile.clear();
+    } else {
+        protocolErrorDumpFile = path;
+    }
+    protocolErrorDumped = false;
+    SPIN_UNLOCK(protocolErrorDumpFileLock);
+}
+
+void FlightRecorder::protocolError() {
+    unsigned long now;
+    string path;
+
+    /* This is called every time a malformed message is seen, so a device
+     * that keeps losing sync would otherwise have the file rewritten on
+     * every acquisition.  The first dump of a run of errors is the one
+     * that shows how it started.  The dump itself is done outside the lock.
+     */
+    SPIN_LOCK(protocolErrorDumpFileLock);
+    now = System::getMonotonicMicroseconds();
+    if(false == protocolErrorDumped
+            || now - lastProtocolErrorDumpMicros >= FLIGHT_RECORDER_DUMP_INTERVAL_MICROS) {
+        path = protocolErrorDumpFile;
+        if(false == path.empty()) {
+            protocolErrorDumped = true;
+            lastProtocolErrorDumpMicros = now;
+        }
+    }
+    SPIN_UNLOCK(protocolErrorDumpFileLock);
+
+    if(false == path.empty()) {
+        dump(path.c_str());
+    }
+}
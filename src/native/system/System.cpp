@@ -53,6 +53,11 @@ void System::sleepMilliseconds(unsigned int millis) {
     ::sleepMilliseconds(millis);
 }
 
+unsigned long System::getMonotonicMicroseconds() {
+    /* Delegate to the native C clock */
+    return ::monotonicMicroseconds();
+}
+
 bool System::initialize() {
     /* Delegate to the native C startup function. */
     int result = ::systemInitialize();
@@ -36,7 +36,7 @@
 #define _POSIX_C_SOURCE 199309  /* Needed for Linux to define POSIX level */
 
 #include "common/globals.h"
-#include <time.h>               /* For definition of nanosleep() */
+#include <time.h>               /* For nanosleep() and clock_gettime() */
 #include "native/system/NativeSystem.h"
 
 /* Function definitions */
@@ -61,6 +61,16 @@ void sleepMilliseconds(unsigned int msecs) {
     nanosleep(&ts, NULL);
 }
 
+unsigned long monotonicMicroseconds() {
+    struct timespec ts;
+
+    /* CLOCK_MONOTONIC is not affected by changes to the wall clock, so
+     * intervals measured with it are always sane.
+     */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL + (unsigned long)(ts.tv_nsec / 1000);
+}
+
 int systemInitialize() {
     /* There are no system-wide services that need to be warmed up. */
     return 0;
@@ -32,7 +32,7 @@
 
 #include "common/globals.h"
 #include <winsock2.h>              /* Must include winsock2.h before windows.h */
-#include <windows.h>               /* For definition of Sleep() */
+#include <windows.h>               /* For Sleep() and QueryPerformanceCounter() */
 #include "native/system/NativeSystem.h"
 
 /* Function definitions */
@@ -44,6 +44,19 @@ void sleepMilliseconds(unsigned int msecs) {
     Sleep(msecs);
 }
 
+unsigned long monotonicMicroseconds() {
+    static LARGE_INTEGER frequency = { { 0, 0 } };
+    LARGE_INTEGER counter;
+
+    /* The performance counter frequency is fixed at boot */
+    if(0 == frequency.QuadPart) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (unsigned long)((counter.QuadPart / frequency.QuadPart) * 1000000
+            + ((counter.QuadPart % frequency.QuadPart) * 1000000) / frequency.QuadPart);
+}
+
 int systemInitialize() {
     /* Need to start up WinSock to be able to use network functionality. */
     WSADATA wsaData;
@@ -30,18 +30,34 @@
 #include "common/globals.h"
 #include "native/usb/USB.h"
 #include "native/usb/NativeUSB.h"
+#include "native/system/System.h"
+#include "native/system/FlightRecorder.h"
 #include <stdio.h>  /* For debugging, feel free to replace with iostream */
 #include <string.h> /* for memset() */
 
+/* Any thread using the device may be updating its metrics */
+#ifdef _WINDOWS
+#include <windows.h>
+#define ATOMIC_ADD(x, n) InterlockedExchangeAdd64((volatile LONGLONG *)&(x), (LONGLONG)(n))
+#else
+#define ATOMIC_ADD(x, n) __sync_fetch_and_add(&(x), (n))
+#endif
+
 using namespace seabreeze;
 using namespace std;
 
 bool seabreeze::USB::verbose = false;
 
+/* IN and OUT endpoints with the same number are counted separately */
+static int __metrics_index(int endpoint) {
+    return (endpoint & 0x0F) + ((0 != (endpoint & 0x80)) ? 16 : 0);
+}
+
 USB::USB(unsigned long id) {
     this->opened = false;
     this->descriptor = NULL;
     this->deviceID = id;
+    resetEndpointMetrics();
 }
 
 USB::~USB() {
@@ -63,6 +79,7 @@ bool USB::open() {
 
     if(0 == error) {
         this->opened = true;
+        resetEndpointMetrics();
         if(true == this->verbose) {
             fprintf(stderr, "Opened device with ID %ld\n", deviceID);
         }
@@ -103,6 +120,7 @@ bool USB::close() {
 int USB::write(int endpoint, void *data, unsigned int length_bytes, unsigned int timeout) {
 
     int flag = 0;
+    unsigned long start;
 
     if(true == this->verbose) {
         // set 'true' for hexdump of output bytes BEFORE actual USB transfer
@@ -117,11 +135,13 @@ int USB::write(int endpoint, void *data, unsigned int length_bytes, unsigned int
         return -1;
     }
 
+    start = System::getMonotonicMicroseconds();
     if(timeout) {
         flag = USBWrite_timeout(this->descriptor, (unsigned char)endpoint, (char *)data, (int)length_bytes, timeout);
     } else {
         flag = USBWrite(this->descriptor, (unsigned char)endpoint, (char *)data, (int)length_bytes);
     }
+    recordTransfer(endpoint, data, length_bytes, flag, start);
 
     if(flag < 0) {
         /* FIXME: throw an exception here */
@@ -141,6 +161,7 @@ int USB::write(int endpoint, void *data, unsigned int length_bytes, unsigned int
 
 int USB::read(int endpoint, void *data, unsigned int length_bytes, unsigned int timeout) {
     int flag = 0;
+    unsigned long start;
 
     if(true == this->verbose) {
         this->describeTransfer("<<", length_bytes, data, endpoint, false);
@@ -154,11 +175,13 @@ int USB::read(int endpoint, void *data, unsigned int length_bytes, unsigned int
         return -1;
     }
 
+    start = System::getMonotonicMicroseconds();
     if(timeout) {
         flag = USBRead_timeout(this->descriptor, (unsigned char)endpoint, (char *)data, (int)length_bytes, timeout);
     } else {
         flag = USBRead(this->descriptor, (unsigned char)endpoint, (char *)data, (int)length_bytes);
     }
+    recordTransfer(endpoint, data, length_bytes, flag, start);
     if(flag < 0) {
         /* FIXME: throw an exception here */
         if(true == this->verbose) {
@@ -175,6 +198,49 @@ int USB::read(int endpoint, void *data, unsigned int length_bytes, unsigned int
     return flag;
 }
 
+int USB::readConcurrent(struct USBReadRequest *requests, int count, unsigned int timeout) {
+    int flag = 0;
+    int i;
+    unsigned long start;
+
+    if(NULL == this->descriptor || false == this->opened) {
+        /* FIXME: throw an exception for device not ready or opened */
+        if(true == this->verbose) {
+            fprintf(stderr, "ERROR: tried to read a USB device that is not opened.\n");
+        }
+        return -1;
+    }
+
+    for(i = 0; i < count; i++) {
+        requests[i].bytesRead = READ_FAILED;
+    }
+
+    start = System::getMonotonicMicroseconds();
+    flag = USBReadConcurrent(this->descriptor, requests, count, timeout);
+    /* The reads overlap, so each is charged with the time for all of them */
+    for(i = 0; i < count; i++) {
+        recordTransfer(requests[i].endpoint, requests[i].data,
+                requests[i].numberOfBytes, requests[i].bytesRead, start);
+    }
+
+    if(true == this->verbose) {
+        for(i = 0; i < count; i++) {
+            if(requests[i].bytesRead < 0) {
+                fprintf(stderr, "Warning: got error %d while trying to read %d bytes over USB endpoint %d\n",
+                        requests[i].bytesRead, requests[i].numberOfBytes, requests[i].endpoint);
+            } else {
+                this->usbHexDump(requests[i].data, requests[i].bytesRead, requests[i].endpoint);
+            }
+        }
+    }
+
+    if(flag < 0) {
+        return -1;
+    }
+
+    return flag;
+}
+
 void USB::clearStall(int endpoint) {
 
     if(NULL == this->descriptor || false == this->opened) {
@@ -188,10 +254,135 @@ void USB::clearStall(int endpoint) {
     USBClearStall(this->descriptor, (unsigned char)endpoint);
 }
 
+int USB::setReadQueueDepth(int endpoint, int depth, bool zeroCopy) {
+    int flag;
+
+    if(NULL == this->descriptor || false == this->opened) {
+        /* FIXME: throw an exception for device not ready or opened */
+        if(true == this->verbose) {
+            fprintf(stderr, "ERROR: tried to access a USB device that is not opened.\n");
+        }
+        return -1;
+    }
+
+    flag = USBSetReadQueue(this->descriptor, (unsigned char)endpoint, depth,
+            (true == zeroCopy) ? USB_READ_QUEUE_ZERO_COPY : 0);
+    if(flag < 0 && true == this->verbose) {
+        fprintf(stderr, "Warning: could not queue %d reads on USB endpoint %d\n",
+                depth, endpoint);
+    }
+
+    return flag;
+}
+
+int USB::acquireReadBuffer(int endpoint, unsigned int length_bytes,
+        unsigned char **data, unsigned int timeout) {
+    int flag;
+    unsigned long start;
+
+    if(NULL == this->descriptor || false == this->opened) {
+        /* FIXME: throw an exception for device not ready or opened */
+        if(true == this->verbose) {
+            fprintf(stderr, "ERROR: tried to read a USB device that is not opened.\n");
+        }
+        return -1;
+    }
+
+    start = System::getMonotonicMicroseconds();
+    flag = USBReadQueueAcquire(this->descriptor, (unsigned char)endpoint,
+            (int)length_bytes, data, timeout);
+    recordTransfer(endpoint, (flag > 0) ? *data : NULL, length_bytes, flag, start);
+    if(flag < 0) {
+        if(true == this->verbose) {
+            fprintf(stderr, "Warning: got error %d while trying to borrow %d bytes from USB endpoint %d\n",
+                    flag, length_bytes, endpoint);
+        }
+        return -1;
+    }
+
+    if(true == this->verbose) {
+        this->usbHexDump(*data, flag, endpoint);
+    }
+
+    return flag;
+}
+
+int USB::releaseReadBuffer(int endpoint) {
+
+    if(NULL == this->descriptor || false == this->opened) {
+        return -1;
+    }
+
+    return USBReadQueueRelease(this->descriptor, (unsigned char)endpoint);
+}
+
+int USB::submitQueuedRead(int endpoint, unsigned int length_bytes) {
+
+    if(NULL == this->descriptor || false == this->opened) {
+        return -1;
+    }
+
+    return USBReadQueueSubmit(this->descriptor, (unsigned char)endpoint, (int)length_bytes);
+}
+
+int USB::isReadReady(int endpoint) {
+
+    if(NULL == this->descriptor || false == this->opened) {
+        return -1;
+    }
+
+    return USBReadQueueReady(this->descriptor, (unsigned char)endpoint);
+}
+
 void USB::setVerbose(bool v) {
     verbose = v;
 }
 
+int USB::getEndpointMetrics(int endpoint, struct USBEndpointMetrics *m) {
+
+    if(NULL == m) {
+        return -1;
+    }
+
+    memcpy(m, &(this->metrics[__metrics_index(endpoint)]), sizeof(struct USBEndpointMetrics));
+    return 0;
+}
+
+void USB::resetEndpointMetrics() {
+    memset(this->metrics, 0, sizeof(this->metrics));
+}
+
+void USB::recordTransfer(int endpoint, const void *data, unsigned int length_bytes,
+        int result, unsigned long startMicros) {
+    struct USBEndpointMetrics *m = &(this->metrics[__metrics_index(endpoint)]);
+    unsigned long now = System::getMonotonicMicroseconds();
+    unsigned long elapsed = now - startMicros;
+    int bucket = 0;
+
+    FlightRecorder::record(FLIGHT_RECORDER_BUS_USB, endpoint, data,
+            (int)length_bytes, result, now);
+
+    /* Find the position of the highest set bit, i.e. log2 of the latency */
+    while(elapsed > 0 && bucket < USB_LATENCY_BUCKETS - 1) {
+        elapsed >>= 1;
+        bucket++;
+    }
+    ATOMIC_ADD(m->latencyHistogram[bucket], 1);
+
+    /* WRITE_TIMED_OUT is the same code */
+    if(READ_TIMED_OUT == result) {
+        ATOMIC_ADD(m->timeouts, 1);
+    } else if(result < 0) {
+        ATOMIC_ADD(m->errors, 1);
+    } else {
+        ATOMIC_ADD(m->transfers, 1);
+        ATOMIC_ADD(m->bytes, (unsigned long long)result);
+        if((unsigned int)result < length_bytes) {
+            ATOMIC_ADD(m->shortTransfers, 1);
+        }
+    }
+}
+
 int USB::getDeviceDescriptor(struct USBDeviceDescriptor *desc) {
 
     if(NULL == this->descriptor || false == this->opened) {
@@ -305,6 +496,39 @@ int USB::getMaxPacketSize() {
     return retval;
 }
 
+int USB::getEndpointMaxPacketSize(int endpoint) {
+
+    struct USBInterfaceDescriptor intfDesc;
+    struct USBEndpointDescriptor epDesc;
+    int i;
+
+    if(NULL == this->descriptor || false == this->opened) {
+        if(true == this->verbose) {
+            fprintf(stderr, "ERROR: tried to read a USB device that is not opened.\n");
+        }
+        return -1;
+    }
+
+    memset(&intfDesc, (int)0, sizeof(struct USBInterfaceDescriptor));
+    memset(&epDesc, (int)0, sizeof(struct USBEndpointDescriptor));
+
+    if(getInterfaceDescriptor(&intfDesc) < 0) {
+        return -1;
+    }
+
+    for(i = 0; i < intfDesc.bNumEndpoints; i++) {
+        if(getEndpointDescriptor(i, &epDesc) < 0) {
+            return -1;
+        }
+
+        if(epDesc.bEndpointAddress == (endpoint & 0xFF)) {
+            return epDesc.wMaxPacketSize;
+        }
+    }
+
+    return -1;
+}
+
 /* Debugging methods */
 void USB::usbHexDump(void *x, int length, int endpoint) {
     /* FIXME: put in a system-independent timestamp here with usec resolution */
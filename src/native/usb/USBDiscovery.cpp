@@ -72,6 +72,34 @@ vector<unsigned long> *USBDiscovery::probeDevices(int vendorID, int productID) {
     return retval;
 }
 
+bool USBDiscovery::beginProbe() {
+    return (0 == USBBeginProbe());
+}
+
+void USBDiscovery::endProbe() {
+    USBEndProbe();
+}
+
+bool USBDiscovery::enableHotplug(int vendorID, int productID) {
+    return (0 == USBEnableHotplug(vendorID, productID));
+}
+
+void USBDiscovery::disableHotplug() {
+    USBDisableHotplug();
+}
+
+int USBDiscovery::pollHotplugEvents(struct USBHotplugEvent *events, int maxEvents) {
+    return USBPollHotplugEvents(events, maxEvents);
+}
+
+int USBDiscovery::getPollDescriptors(struct USBPollDescriptor *descriptors, int maxDescriptors) {
+    return USBGetPollDescriptors(descriptors, maxDescriptors);
+}
+
+bool USBDiscovery::handleEvents() {
+    return (0 == USBHandleEvents());
+}
+
 USB *USBDiscovery::createUSBInterface(unsigned long deviceID) {
     /* Create a USB instance with the given deviceID.  This constructor for
      * USB is protected, so this class uses a friend relationship to get
@@ -37,12 +37,20 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>  // for perror()
+#include <time.h>   // for clock_gettime()
+#include <pthread.h>
 #include "native/usb/NativeUSB.h"
+#include "native/usb/replay/NativeUSBReplay.h"
 #include "api/seabreezeapi/SeaBreezeAPIConstants.h"
 
 /* Definitions and macros */
 #define MAX_USB_DEVICES             127
+#define DEVICE_SLOT_BITS              7 /* Low bits of a device ID hold its table slot */
 #define DEFAULT_TIMEOUT         1000000 /* milliseconds (c.a 16.5 min) */
+#define MAX_ENDPOINTS                16 /* Endpoint numbers are 4 bits wide */
+#define MAX_QUEUED_TRANSFERS         32 /* Upper bound on the read queue depth */
+#define MAX_HOTPLUG_CALLBACKS        64 /* One per VID/PID being watched */
+#define MAX_PENDING_HOTPLUG_EVENTS  128
 /* Tell gcc not to warn about a particular
  * variable being unused.  This is useful for function
  * parameters that are required by an interface prototype, but not
@@ -52,13 +60,71 @@
  */
 #define UNUSED(x)  UNUSED_ ## x __attribute__((unused))
 
+/* While a trace is being replayed, every call is handed over to the replay
+ * backend and libusb is never touched.
+ */
+#define REPLAY_DISPATCH(call)   if(0 != USBReplayActive()) { return Replay##call; }
+#define REPLAY_DISPATCH_VOID(call) if(0 != USBReplayActive()) { Replay##call; return; }
+
 /* struct definitions */
+typedef struct {
+    struct libusb_transfer *transfer;
+    int submitted;                /* Queued with libusb or holding unread data */
+    int completed;                /* Set by the completion callback */
+    int offset;                   /* Bytes of a completed transfer already read */
+} __queued_transfer_t;
+
+typedef struct {
+    unsigned char endpoint;
+    int depth;                    /* Number of transfers kept in flight */
+    int transferSize;             /* Zero until the first read arms the queue */
+    int head;                     /* Index of the oldest transfer in the ring */
+    int flags;                    /* USB_READ_QUEUE_* options */
+    int devMem;                   /* Still getting buffers from usbfs */
+    int devMemCount;
+    unsigned char *devMemBuffers[MAX_QUEUED_TRANSFERS + 1]; /* Those that came from usbfs */
+    unsigned char *spare;         /* Swapped in while a buffer is lent out */
+    unsigned char *borrowed;      /* Buffer lent out by USBReadQueueAcquire() */
+    pthread_mutex_t readLock;     /* Held by the one reader allowed in at a time */
+    int users;                    /* Readers in or waiting for readLock */
+    int retired;                  /* Replaced while in use; the last user frees it */
+    __queued_transfer_t transfers[MAX_QUEUED_TRANSFERS];
+} __read_queue_t;
+
+/* A borrowed buffer whose queue has been torn down, kept until the caller
+ * is known to be done with it.
+ */
+typedef struct {
+    unsigned char *buffer;
+    int length;
+    int devMem;
+} __orphaned_buffer_t;
+
 typedef struct {
     long deviceID;  /* Unique ID for device.  Assigned by this driver */
     int interface;  /* Interface number, needed to release it on close */
     libusb_device_handle *dev;
+    pthread_mutex_t lock;   /* Guards readQueues and the queues themselves */
+    __read_queue_t *readQueues[MAX_ENDPOINTS]; /* Indexed by IN endpoint number */
+    __orphaned_buffer_t orphaned[MAX_ENDPOINTS]; /* Likewise */
 } __usb_interface_t;
 
+typedef struct {
+    unsigned short vendorID;
+    unsigned short productID;
+    libusb_device *device;        /* Owned by __probe_device_list */
+} __probe_entry_t;
+
+typedef struct {
+    int outstanding;              /* Transfers not yet called back */
+    int completed;                /* Set once outstanding reaches zero */
+} __concurrent_read_t;
+
+typedef struct {
+    libusb_device *device;        /* Referenced until the event is consumed */
+    int event;                    /* USB_DEVICE_ARRIVED or USB_DEVICE_LEFT */
+} __hotplug_event_t;
+
 typedef struct {
     long deviceID;                /* Unique ID for device.  Assigned by this driver. */
     __usb_interface_t *handle;    /* Pointer to USB interface instance */
@@ -76,10 +142,43 @@ static int __enumerated_device_count = 0;   /* To keep linear searches short */
 static long __last_assigned_deviceID = 0;   /* To keep device IDs unique */
 
 /**
- * Global USB context (should be initialized before any call is done)
+ * The device table, the probe snapshot, the hotplug registrations and the
+ * libusb context are only touched with this held.  It is taken by probing,
+ * opening and closing, never by transfers: an open handle has a lock of its
+ * own, so threads streaming from different devices do not contend and a
+ * re-probe does not stall them.  When both are needed, this one is taken
+ * first.
+ */
+static pthread_mutex_t __device_table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Global USB context (should be initialized before any call is done).  It is
+ * made once and kept for the life of the process: the device table and any
+ * queued hotplug events hold libusb devices from it whether or not a device
+ * is open, so there is no point at which it could safely be torn down.
  */
 static libusb_context *__libusb_ctx = NULL;
-static int __libusb_ctx_usage = 0;
+
+/**
+ * Snapshot of the bus taken by USBBeginProbe(), sorted by VID/PID so that
+ * each device type can find its devices without enumerating again.
+ */
+static libusb_device **__probe_device_list = NULL;
+static __probe_entry_t *__probe_index = NULL;
+static int __probe_index_count = 0;
+static int __probe_depth = 0;               /* Nesting of begin/end calls */
+
+/**
+ * Hotplug notifications.  libusb may deliver these on whichever thread is
+ * handling events (including one blocked in a transfer), so the callback
+ * only queues them; the device table is updated by USBPollHotplugEvents().
+ */
+static libusb_hotplug_callback_handle __hotplug_handles[MAX_HOTPLUG_CALLBACKS];
+static int __hotplug_handle_count = 0;
+static __hotplug_event_t __hotplug_events[MAX_PENDING_HOTPLUG_EVENTS];
+static int __hotplug_event_head = 0;
+static int __hotplug_event_count = 0;
+static pthread_mutex_t __hotplug_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /* Function prototypes */
 static __device_instance_t *__lookup_device_instance_by_ID(long deviceID);
@@ -88,17 +187,62 @@ static __device_instance_t *__add_device_instance(libusb_device *device, int ven
 static void __purge_unmarked_device_instances(int vendorID, int productID);
 static void __close_and_dealloc_usb_interface(__usb_interface_t *usb);
 static int __probe_devices();
-
-/* This function will iterate over the known devices and attempt to match
- * the given ID.  It might be more efficient for the sake of this search
- * to store the device instances in a linked list so that no invalid elements
- * need to be searched through, but that just has the effect of shifting the
- * time burden to when a device must be removed from the list.  This lookup
- * is most likely to be called when the calling code is trying to open a device,
- * at which point they more or less expect to have to wait a little while.
- * Not that searching over this array will take very long...
+static int __init_libusb_context(void);
+static int __compare_probe_entries(const void *a, const void *b);
+static int __probe_index_lower_bound(int vendorID, int productID);
+static int LIBUSB_CALL __hotplug_callback(libusb_context *ctx, libusb_device *device,
+        libusb_hotplug_event event, void *user_data);
+static __device_instance_t *__lookup_device_instance_by_device(libusb_device *device);
+static void __remove_device_instance(__device_instance_t *instance);
+static void LIBUSB_CALL __read_queue_callback(struct libusb_transfer *transfer);
+static int __read_queue_arm(__usb_interface_t *usb, __read_queue_t *queue, int length);
+static void __read_queue_refill(__read_queue_t *queue);
+static long long __read_queue_deadline(unsigned int timeout);
+static int __read_queue_wait(__usb_interface_t *usb, __queued_transfer_t *queued,
+        long long deadline);
+static int __read_queue_enter(__usb_interface_t *usb, __read_queue_t *queue);
+static void __read_queue_leave(__usb_interface_t *usb, __read_queue_t *queue);
+static void __read_queue_retire(__read_queue_t *queue);
+static int __read_queue_read(__usb_interface_t *usb, __read_queue_t *queue,
+        char *data, int numberOfBytes, unsigned int timeout);
+static void __read_queue_destroy(__usb_interface_t *usb, __read_queue_t *queue);
+static void LIBUSB_CALL __concurrent_read_callback(struct libusb_transfer *transfer);
+static unsigned char *__read_queue_alloc(__usb_interface_t *usb, __read_queue_t *queue, int length);
+static void __read_queue_free(__usb_interface_t *usb, __read_queue_t *queue, unsigned char *buffer);
+static void __free_orphaned_buffer(__usb_interface_t *usb, int index);
+static int __begin_probe(void);
+static void __end_probe(void);
+static int __probe_matching_devices(int vendorID, int productID,
+        unsigned long *output, int max_devices);
+static void *__open_device(unsigned long deviceID, int *errorCode);
+static int __set_read_queue(__usb_interface_t *usb, unsigned char endpoint,
+        int depth, int flags);
+
+/* Every device ID carries the index of its slot in the table in its low
+ * bits (see __add_device_instance()), so the lookup goes straight to the
+ * slot.  The rest of the ID only has to be compared to reject an ID whose
+ * device is gone and whose slot has since been reused.
  */
 static __device_instance_t *__lookup_device_instance_by_ID(long deviceID) {
+    __device_instance_t *instance;
+    long slot;
+
+    if(deviceID < 0) {
+        return NULL;
+    }
+    slot = deviceID & ((1L << DEVICE_SLOT_BITS) - 1);
+    if(slot >= MAX_USB_DEVICES) {
+        return NULL;
+    }
+
+    instance = &(__enumerated_devices[slot]);
+    if(0 == instance->valid || instance->deviceID != deviceID) {
+        return NULL;
+    }
+    return instance;
+}
+
+static __device_instance_t *__lookup_device_instance_by_location(libusb_device *device) {
     int i;
     int valid;
     /* The __enumerated_device_count is used to end the search once it is
@@ -106,7 +250,8 @@ static __device_instance_t *__lookup_device_instance_by_ID(long deviceID) {
      */
     for(i = 0, valid = 0; i < MAX_USB_DEVICES && valid < __enumerated_device_count; i++) {
         if(0 != __enumerated_devices[i].valid) {
-            if(__enumerated_devices[i].deviceID == deviceID) {
+            if(libusb_get_bus_number(__enumerated_devices[i].device) == libusb_get_bus_number(device) &&
+               libusb_get_port_number(__enumerated_devices[i].device) == libusb_get_port_number(device)) {
                 return &(__enumerated_devices[i]);
             }
             valid++;
@@ -115,16 +260,13 @@ static __device_instance_t *__lookup_device_instance_by_ID(long deviceID) {
     return NULL;
 }
 
-static __device_instance_t *__lookup_device_instance_by_location(libusb_device *device) {
+static __device_instance_t *__lookup_device_instance_by_device(libusb_device *device) {
     int i;
     int valid;
-    /* The __enumerated_device_count is used to end the search once it is
-     * known that there are no more devices to be found.
-     */
+
     for(i = 0, valid = 0; i < MAX_USB_DEVICES && valid < __enumerated_device_count; i++) {
         if(0 != __enumerated_devices[i].valid) {
-            if(libusb_get_bus_number(__enumerated_devices[i].device) == libusb_get_bus_number(device) &&
-               libusb_get_port_number(__enumerated_devices[i].device) == libusb_get_port_number(device)) {
+            if(__enumerated_devices[i].device == device) {
                 return &(__enumerated_devices[i]);
             }
             valid++;
@@ -144,7 +286,8 @@ static __device_instance_t *__add_device_instance(libusb_device* device, int ven
             /* Increse reference count on device */
             libusb_ref_device(device);
             __enumerated_devices[i].device = device;
-            __enumerated_devices[i].deviceID = __last_assigned_deviceID++;
+            __enumerated_devices[i].deviceID =
+                    (__last_assigned_deviceID++ << DEVICE_SLOT_BITS) | i;
             __enumerated_devices[i].vendorID = vendorID;
             __enumerated_devices[i].productID = productID;
             __enumerated_device_count++;
@@ -177,11 +320,10 @@ static void __purge_unmarked_device_instances(int vendorID, int productID) {
         if(0 == device->mark
                 && (vendorID == device->vendorID)
                 && (productID == device->productID)) {
-            /* Not marked, so it needs to be purged */
-            if(NULL != device->handle) {
-                /* Clean up the device since it seems to have been disconnected */
-                __close_and_dealloc_usb_interface(device->handle);
-            }
+            /* Not marked, so it needs to be purged.  An open handle is left
+             * to its owner, which may be using it on another thread right
+             * now; it is released by USBClose() as for an unplugged device.
+             */
             /* Unreference device */
             libusb_unref_device(device->device);
             /* Wipe the structure completely */
@@ -193,107 +335,796 @@ static void __purge_unmarked_device_instances(int vendorID, int productID) {
             new_count++;
         }
     }
-    __enumerated_device_count = new_count;
-}
+    __enumerated_device_count = new_count;
+}
+
+
+/* Forgets a device that has been unplugged.  An open handle is left alone
+ * because the caller still owns it and must release it with USBClose(),
+ * which copes with the device no longer being in the table.
+ */
+static void __remove_device_instance(__device_instance_t *instance) {
+    libusb_unref_device(instance->device);
+    memset(instance, (int)0, sizeof(__device_instance_t));
+    __enumerated_device_count--;
+}
+
+/* This will attempt to free up all resources associated with an open
+ * USB descriptor.  This also deallocates the provided pointer.
+ */
+static void __close_and_dealloc_usb_interface(__usb_interface_t *usb) {
+    int i;
+
+    if(NULL == usb) {
+        return;
+    }
+
+    /* Any transfers still queued must be cancelled and reaped before the
+     * handle they were submitted on goes away.
+     */
+    for(i = 0; i < MAX_ENDPOINTS; i++) {
+        if(NULL != usb->readQueues[i]) {
+            __read_queue_destroy(usb, usb->readQueues[i]);
+            usb->readQueues[i] = NULL;
+        }
+        /* Anything still borrowed cannot outlive the handle */
+        __free_orphaned_buffer(usb, i);
+    }
+
+    if(NULL != usb->dev) {
+        /* MZ: This call to usb_reset() resolves a reported issue in which Linux apps 
+         * would run correctly once, then require spectrometer to be un/replugged to 
+         * run a second time.
+         */
+        libusb_reset_device(usb->dev);
+        /* Release interface */
+        libusb_release_interface(usb->dev, usb->interface);
+        /* Close device */
+        libusb_close(usb->dev);
+    }
+
+    pthread_mutex_destroy(&(usb->lock));
+    free(usb);
+}
+
+/* Asynchronous read queues.  A blocking libusb_bulk_transfer() leaves the
+ * endpoint without any pending request while the host is busy handling the
+ * previous one, so the device has to wait for the next IN token before it
+ * can continue.  A read queue keeps a ring of bulk transfers submitted on an
+ * IN endpoint so that there is always somewhere for the data to go.  The
+ * transfers are sized after the first read that is made once the queue has
+ * been enabled (normally one spectrum) and are handed back to readers in
+ * submission order.  A reader that asks for less than a transfer holds gets
+ * the rest on its next read; a reader that asks for more keeps consuming
+ * transfers until it is satisfied or a short transfer ends the message.
+ */
+static void LIBUSB_CALL __read_queue_callback(struct libusb_transfer *transfer) {
+    __queued_transfer_t *queued = (__queued_transfer_t *)transfer->user_data;
+
+    queued->completed = 1;
+}
+
+static int __read_queue_arm(__usb_interface_t *usb, __read_queue_t *queue, int length) {
+    __queued_transfer_t *queued;
+    unsigned char *buffer;
+    int packetSize;
+    int i;
+
+    /* Round up to whole packets so that a message longer than one transfer
+     * never overflows in the middle of a packet.
+     */
+    packetSize = libusb_get_max_packet_size(libusb_get_device(usb->dev), queue->endpoint);
+    if(packetSize > 0) {
+        length = ((length + packetSize - 1) / packetSize) * packetSize;
+    }
+    if(length <= 0) {
+        return -1;
+    }
+    queue->transferSize = length;
+
+    if(0 != (queue->flags & USB_READ_QUEUE_ZERO_COPY)) {
+        queue->devMem = 1;
+        queue->spare = __read_queue_alloc(usb, queue, length);
+        if(NULL == queue->spare) {
+            queue->transferSize = 0;
+            return -1;
+        }
+    }
+
+    for(i = 0; i < queue->depth; i++) {
+        queued = &(queue->transfers[i]);
+        queued->transfer = libusb_alloc_transfer(0);
+        buffer = __read_queue_alloc(usb, queue, length);
+        if(NULL == queued->transfer || NULL == buffer) {
+            __read_queue_free(usb, queue, buffer);
+            /* Unwind whatever has been allocated so far */
+            for(; i >= 0; i--) {
+                queued = &(queue->transfers[i]);
+                if(NULL != queued->transfer) {
+                    __read_queue_free(usb, queue, queued->transfer->buffer);
+                    libusb_free_transfer(queued->transfer);
+                    queued->transfer = NULL;
+                }
+            }
+            __read_queue_free(usb, queue, queue->spare);
+            queue->spare = NULL;
+            queue->transferSize = 0;
+            return -1;
+        }
+        libusb_fill_bulk_transfer(queued->transfer, usb->dev, queue->endpoint,
+                buffer, length, __read_queue_callback, queued, 0);
+        queued->submitted = 0;
+        queued->completed = 0;
+        queued->offset = 0;
+    }
+
+    queue->head = 0;
+    __read_queue_refill(queue);
+    return 0;
+}
+
+/* Submits every idle transfer in ring order, starting after the last one
+ * that is still outstanding.  Stopping at the first failure keeps the
+ * outstanding transfers contiguous from the head, which is what guarantees
+ * that data is handed out in the order it arrived.
+ */
+static void __read_queue_refill(__read_queue_t *queue) {
+    __queued_transfer_t *queued;
+    int i;
+
+    if(0 != queue->retired) {
+        return;
+    }
+
+    for(i = 0; i < queue->depth; i++) {
+        queued = &(queue->transfers[(queue->head + i) % queue->depth]);
+        if(0 != queued->submitted) {
+            continue;
+        }
+        queued->completed = 0;
+        queued->offset = 0;
+        if(libusb_submit_transfer(queued->transfer) < 0) {
+            break;
+        }
+        queued->submitted = 1;
+    }
+}
+
+/* Turns a read timeout into a deadline on the monotonic clock, in
+ * milliseconds.  As with a transfer that is not queued, zero means the
+ * read is not limited, which here is DEFAULT_TIMEOUT.
+ */
+static long long __read_queue_deadline(unsigned int timeout) {
+    struct timespec now;
+
+    if(0 == timeout) {
+        timeout = DEFAULT_TIMEOUT;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000 + timeout;
+}
+
+/* Waits until the deadline for a transfer to complete.  The handle's lock
+ * is dropped while libusb handles events, so that polling and submitting
+ * on the device from an event loop, or reading other endpoints, does not
+ * have to wait for data to arrive here.  Readers of the same queue are
+ * kept out by its readLock.
+ */
+static int __read_queue_wait(__usb_interface_t *usb, __queued_transfer_t *queued,
+        long long deadline) {
+    struct timespec now;
+    struct timeval tv;
+    long long remaining;
+    int flag;
+
+    while(0 == queued->completed) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        remaining = deadline - ((long long)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+        if(remaining <= 0) {
+            return READ_TIMED_OUT;
+        }
+        tv.tv_sec = remaining / 1000;
+        tv.tv_usec = (remaining % 1000) * 1000;
+        pthread_mutex_unlock(&(usb->lock));
+        flag = libusb_handle_events_timeout_completed(__libusb_ctx, &tv,
+                &(queued->completed));
+        pthread_mutex_lock(&(usb->lock));
+        if(flag < 0 && 0 == queued->completed) {
+            return READ_FAILED;
+        }
+    }
+    return 0;
+}
+
+/* Lets a reader into a queue.  This is called, and returns, with the
+ * handle's lock held, and fails if the queue was replaced in the meantime.
+ * Every call must be matched by __read_queue_leave().
+ */
+static int __read_queue_enter(__usb_interface_t *usb, __read_queue_t *queue) {
+    queue->users++;
+    /* readLock is always taken before the handle's lock */
+    pthread_mutex_unlock(&(usb->lock));
+    pthread_mutex_lock(&(queue->readLock));
+    pthread_mutex_lock(&(usb->lock));
+    return (0 != queue->retired) ? -1 : 0;
+}
+
+static void __read_queue_leave(__usb_interface_t *usb, __read_queue_t *queue) {
+    queue->users--;
+    pthread_mutex_unlock(&(queue->readLock));
+    if(0 != queue->retired && 0 == queue->users) {
+        __read_queue_destroy(usb, queue);
+    }
+}
+
+/* Takes a queue out of use while a reader may still be waiting on it.  Its
+ * transfers are cancelled so that the wait ends promptly.
+ */
+static void __read_queue_retire(__read_queue_t *queue) {
+    __queued_transfer_t *queued;
+    int i;
+
+    queue->retired = 1;
+    for(i = 0; i < queue->depth; i++) {
+        queued = &(queue->transfers[i]);
+        if(NULL != queued->transfer && 0 != queued->submitted && 0 == queued->completed) {
+            libusb_cancel_transfer(queued->transfer);
+        }
+    }
+}
+
+static int __read_queue_read(__usb_interface_t *usb, __read_queue_t *queue,
+        char *data, int numberOfBytes, unsigned int timeout) {
+    __queued_transfer_t *queued;
+    struct libusb_transfer *transfer;
+    long long deadline;
+    int bytesRead = 0;
+    int available;
+    int count;
+    int shortTransfer;
+    int flag;
+
+    if(0 == queue->transferSize && __read_queue_arm(usb, queue, numberOfBytes) < 0) {
+        return READ_FAILED;
+    }
+
+    /* The timeout covers the whole read, however many transfers it takes */
+    deadline = __read_queue_deadline(timeout);
+
+    /* Data already taken off the queue is never thrown away: if a later
+     * transfer fails or times out, what arrived so far is returned and the
+     * error is left for the next read to report.
+     */
+    while(bytesRead < numberOfBytes) {
+        __read_queue_refill(queue);
+        queued = &(queue->transfers[queue->head]);
+        if(0 == queued->submitted) {
+            /* Could not even get the oldest transfer queued */
+            return (bytesRead > 0) ? bytesRead : READ_FAILED;
+        }
+        flag = __read_queue_wait(usb, queued, deadline);
+        if(flag < 0) {
+            /* The transfer stays queued, so late data is not lost */
+            return (bytesRead > 0) ? bytesRead : flag;
+        }
+
+        transfer = queued->transfer;
+        if(LIBUSB_TRANSFER_COMPLETED != transfer->status) {
+            /* Drop the failed transfer; it is requeued on the next read */
+            queued->submitted = 0;
+            queue->head = (queue->head + 1) % queue->depth;
+            return (bytesRead > 0) ? bytesRead : READ_FAILED;
+        }
+
+        available = transfer->actual_length - queued->offset;
+        count = (available < numberOfBytes - bytesRead) ? available : numberOfBytes - bytesRead;
+        memcpy(data + bytesRead, transfer->buffer + queued->offset, count);
+        bytesRead += count;
+        queued->offset += count;
+
+        if(queued->offset >= transfer->actual_length) {
+            shortTransfer = (transfer->actual_length < transfer->length);
+            queued->submitted = 0;
+            queue->head = (queue->head + 1) % queue->depth;
+            if(0 != shortTransfer) {
+                /* A short transfer marks the end of what the device sent */
+                break;
+            }
+        }
+    }
+    __read_queue_refill(queue);
+
+    if(0 == bytesRead && 0 != numberOfBytes) {
+        return READ_FAILED;
+    }
+    return bytesRead;
+}
+
+static void __read_queue_destroy(__usb_interface_t *usb, __read_queue_t *queue) {
+    __queued_transfer_t *queued;
+    int i;
+
+    for(i = 0; i < queue->depth; i++) {
+        queued = &(queue->transfers[i]);
+        if(0 != queued->submitted && 0 == queued->completed) {
+            libusb_cancel_transfer(queued->transfer);
+        }
+    }
+    for(i = 0; i < queue->depth; i++) {
+        queued = &(queue->transfers[i]);
+        while(0 != queued->submitted && 0 == queued->completed) {
+            if(libusb_handle_events_completed(__libusb_ctx, &(queued->completed)) < 0) {
+                break;
+            }
+        }
+        if(NULL != queued->transfer) {
+            __read_queue_free(usb, queue, queued->transfer->buffer);
+            libusb_free_transfer(queued->transfer);
+        }
+    }
+    __read_queue_free(usb, queue, queue->spare);
+    pthread_mutex_destroy(&(queue->readLock));
+
+    if(NULL != queue->borrowed) {
+        /* The caller may still be reading this one, so it is left alone
+         * until the next borrow or release on the endpoint.
+         */
+        int index = queue->endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK;
+        __free_orphaned_buffer(usb, index);
+        usb->orphaned[index].buffer = queue->borrowed;
+        usb->orphaned[index].length = queue->transferSize;
+        usb->orphaned[index].devMem = (queue->devMemCount > 0);
+    }
+    free(queue);
+}
+
+/* With USB_READ_QUEUE_ZERO_COPY the buffers are mapped from usbfs with
+ * libusb_dev_mem_alloc() so that the controller writes straight into memory
+ * the caller can see, rather than the kernel bouncing the data through its
+ * own buffers and copying it out.  usbfs memory is limited, so once the
+ * kernel refuses a buffer the rest are ordinary ones.  Buffers change hands
+ * between transfers, the spare and the caller, so the queue remembers which
+ * ones came from usbfs in order to free each the right way.
+ */
+static unsigned char *__read_queue_alloc(__usb_interface_t *usb, __read_queue_t *queue, int length) {
+    unsigned char *buffer;
+
+    if(0 != queue->devMem) {
+        buffer = libusb_dev_mem_alloc(usb->dev, length);
+        if(NULL != buffer) {
+            queue->devMemBuffers[queue->devMemCount++] = buffer;
+            return buffer;
+        }
+        queue->devMem = 0;
+    }
+    return (unsigned char *)malloc(length);
+}
+
+static void __read_queue_free(__usb_interface_t *usb, __read_queue_t *queue, unsigned char *buffer) {
+    int i;
+
+    if(NULL == buffer) {
+        return;
+    }
+    for(i = 0; i < queue->devMemCount; i++) {
+        if(buffer == queue->devMemBuffers[i]) {
+            queue->devMemBuffers[i] = queue->devMemBuffers[--queue->devMemCount];
+            libusb_dev_mem_free(usb->dev, buffer, queue->transferSize);
+            return;
+        }
+    }
+    free(buffer);
+}
+
+static void __free_orphaned_buffer(__usb_interface_t *usb, int index) {
+    __orphaned_buffer_t *orphan = &(usb->orphaned[index]);
+
+    if(NULL == orphan->buffer) {
+        return;
+    }
+    if(0 != orphan->devMem) {
+        libusb_dev_mem_free(usb->dev, orphan->buffer, orphan->length);
+    } else {
+        free(orphan->buffer);
+    }
+    orphan->buffer = NULL;
+}
+
+/* Lends out the buffer of the oldest completed transfer instead of copying
+ * it.  The transfer is given the spare buffer in exchange and resubmitted
+ * at once, so the device keeps streaming while the caller holds the data.
+ * There is only one spare, so only one buffer can be out at a time.
+ */
+static int __read_queue_acquire(__usb_interface_t *usb, __read_queue_t *queue,
+        int numberOfBytes, unsigned char **data, unsigned int timeout) {
+    __queued_transfer_t *queued;
+    struct libusb_transfer *transfer;
+    int available;
+    int flag;
+
+    if(0 == queue->transferSize && __read_queue_arm(usb, queue, numberOfBytes) < 0) {
+        return READ_FAILED;
+    }
+    if(NULL == queue->spare) {
+        return READ_FAILED;
+    }
+
+    __read_queue_refill(queue);
+    queued = &(queue->transfers[queue->head]);
+    if(0 == queued->submitted) {
+        return READ_FAILED;
+    }
+    flag = __read_queue_wait(usb, queued, __read_queue_deadline(timeout));
+    if(flag < 0) {
+        return flag;
+    }
+
+    transfer = queued->transfer;
+    queued->submitted = 0;
+    queue->head = (queue->head + 1) % queue->depth;
+    if(LIBUSB_TRANSFER_COMPLETED != transfer->status) {
+        __read_queue_refill(queue);
+        return READ_FAILED;
+    }
+
+    available = transfer->actual_length - queued->offset;
+    queue->borrowed = transfer->buffer;
+    *data = transfer->buffer + queued->offset;
+    transfer->buffer = queue->spare;
+    queue->spare = NULL;
+    __read_queue_refill(queue);
+
+    return available;
+}
+
+
+/* Check if libusb_init() has been called since it must be called before
+ * anything else happens.  This is only checked on the probe entry points
+ * since nothing else can be done before a device has been probed.
+ */
+static int __init_libusb_context(void) {
+    int r;
+
+    if(NULL == __libusb_ctx) {
+        r = libusb_init(&__libusb_ctx);
+        if(r < 0) { // Init failed
+            fprintf(stderr, "libusb_init() failed (Error: %s)", libusb_strerror(r));
+            __libusb_ctx = NULL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int __compare_probe_entries(const void *a, const void *b) {
+    const __probe_entry_t *left = (const __probe_entry_t *)a;
+    const __probe_entry_t *right = (const __probe_entry_t *)b;
+
+    if(left->vendorID != right->vendorID) {
+        return (left->vendorID < right->vendorID) ? -1 : 1;
+    }
+    if(left->productID != right->productID) {
+        return (left->productID < right->productID) ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Returns the index of the first snapshot entry that is not ordered before
+ * the given VID/PID, which is where any matching entries start.
+ */
+static int __probe_index_lower_bound(int vendorID, int productID) {
+    __probe_entry_t key;
+    int low = 0;
+    int high = __probe_index_count;
+    int middle;
+
+    key.vendorID = (unsigned short)vendorID;
+    key.productID = (unsigned short)productID;
+    key.device = NULL;
+
+    while(low < high) {
+        middle = low + (high - low) / 2;
+        if(__compare_probe_entries(&(__probe_index[middle]), &key) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static int LIBUSB_CALL __hotplug_callback(libusb_context *UNUSED(ctx), libusb_device *device,
+        libusb_hotplug_event event, void *UNUSED(user_data)) {
+    int tail;
+
+    pthread_mutex_lock(&__hotplug_lock);
+    if(__hotplug_event_count < MAX_PENDING_HOTPLUG_EVENTS) {
+        tail = (__hotplug_event_head + __hotplug_event_count) % MAX_PENDING_HOTPLUG_EVENTS;
+        __hotplug_events[tail].device = libusb_ref_device(device);
+        __hotplug_events[tail].event = (LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED == event)
+                ? USB_DEVICE_ARRIVED : USB_DEVICE_LEFT;
+        __hotplug_event_count++;
+    }
+    /* Otherwise the event is dropped; a full probe will still catch up */
+    pthread_mutex_unlock(&__hotplug_lock);
+
+    /* Stay registered */
+    return 0;
+}
+
+int
+USBEnableHotplug(int vendorID, int productID) {
+    REPLAY_DISPATCH(USBEnableHotplug(vendorID, productID))
+
+    int r;
+
+    pthread_mutex_lock(&__device_table_lock);
+    if(__init_libusb_context() < 0) {
+        pthread_mutex_unlock(&__device_table_lock);
+        return -1;
+    }
+
+    if(0 == libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)
+            || __hotplug_handle_count >= MAX_HOTPLUG_CALLBACKS) {
+        pthread_mutex_unlock(&__device_table_lock);
+        return -1;
+    }
+
+    /* Devices that are already present are found by probing, so there is
+     * no need to have them enumerated through the callback.
+     */
+    r = libusb_hotplug_register_callback(__libusb_ctx,
+            LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+            LIBUSB_HOTPLUG_NO_FLAGS, vendorID, productID, LIBUSB_HOTPLUG_MATCH_ANY,
+            __hotplug_callback, NULL, &(__hotplug_handles[__hotplug_handle_count]));
+    if(r < 0) {
+        fprintf(stderr, "libusb_hotplug_register_callback() failed (Error: %s)", libusb_strerror(r));
+        pthread_mutex_unlock(&__device_table_lock);
+        return -1;
+    }
+    __hotplug_handle_count++;
+    pthread_mutex_unlock(&__device_table_lock);
+
+    return 0;
+}
+
+void
+USBDisableHotplug(void) {
+    REPLAY_DISPATCH_VOID(USBDisableHotplug())
+
+    int i;
+
+    pthread_mutex_lock(&__device_table_lock);
+    for(i = 0; i < __hotplug_handle_count; i++) {
+        libusb_hotplug_deregister_callback(__libusb_ctx, __hotplug_handles[i]);
+    }
+    __hotplug_handle_count = 0;
+    pthread_mutex_unlock(&__device_table_lock);
+
+    /* Drop anything that was not collected */
+    pthread_mutex_lock(&__hotplug_lock);
+    for(; __hotplug_event_count > 0; __hotplug_event_count--) {
+        libusb_unref_device(__hotplug_events[__hotplug_event_head].device);
+        __hotplug_event_head = (__hotplug_event_head + 1) % MAX_PENDING_HOTPLUG_EVENTS;
+    }
+    pthread_mutex_unlock(&__hotplug_lock);
+}
+
+int
+USBPollHotplugEvents(struct USBHotplugEvent *events, int max_events) {
+    REPLAY_DISPATCH(USBPollHotplugEvents(events, max_events))
+
+    struct libusb_device_descriptor desc;
+    struct timeval zero = { 0, 0 };
+    __hotplug_event_t pending;
+    __device_instance_t *instance;
+    int reported = 0;
+
+    if(NULL == __libusb_ctx || NULL == events) {
+        return -1;
+    }
+
+    /* Let libusb deliver anything that has happened without blocking */
+    libusb_handle_events_timeout_completed(__libusb_ctx, &zero, NULL);
+
+    pthread_mutex_lock(&__device_table_lock);
+    while(reported < max_events) {
+        pthread_mutex_lock(&__hotplug_lock);
+        if(0 == __hotplug_event_count) {
+            pthread_mutex_unlock(&__hotplug_lock);
+            break;
+        }
+        pending = __hotplug_events[__hotplug_event_head];
+        __hotplug_event_head = (__hotplug_event_head + 1) % MAX_PENDING_HOTPLUG_EVENTS;
+        __hotplug_event_count--;
+        pthread_mutex_unlock(&__hotplug_lock);
+
+        if(USB_DEVICE_ARRIVED == pending.event) {
+            instance = __lookup_device_instance_by_device(pending.device);
+            if(NULL == instance
+                    && 0 == libusb_get_device_descriptor(pending.device, &desc)) {
+                instance = __add_device_instance(pending.device, desc.idVendor, desc.idProduct);
+                if(NULL != instance) {
+                    events[reported].deviceID = instance->deviceID;
+                    events[reported].vendorID = instance->vendorID;
+                    events[reported].productID = instance->productID;
+                    events[reported].event = USB_DEVICE_ARRIVED;
+                    reported++;
+                }
+            }
+            /* Devices that were already known (e.g. probed meanwhile) are
+             * not reported again.
+             */
+        } else {
+            instance = __lookup_device_instance_by_device(pending.device);
+            if(NULL != instance) {
+                events[reported].deviceID = instance->deviceID;
+                events[reported].vendorID = instance->vendorID;
+                events[reported].productID = instance->productID;
+                events[reported].event = USB_DEVICE_LEFT;
+                reported++;
+                __remove_device_instance(instance);
+            }
+        }
+        libusb_unref_device(pending.device);
+    }
+    pthread_mutex_unlock(&__device_table_lock);
+
+    return reported;
+}
+
+int
+USBBeginProbe(void) {
+    REPLAY_DISPATCH(USBBeginProbe())
+
+    int retval;
+
+    pthread_mutex_lock(&__device_table_lock);
+    retval = __begin_probe();
+    pthread_mutex_unlock(&__device_table_lock);
+    return retval;
+}
+
+void
+USBEndProbe(void) {
+    REPLAY_DISPATCH_VOID(USBEndProbe())
+
+    pthread_mutex_lock(&__device_table_lock);
+    __end_probe();
+    pthread_mutex_unlock(&__device_table_lock);
+}
+
+int
+USBProbeDevices(int vendorID, int productID, unsigned long *output, int max_devices) {
+    REPLAY_DISPATCH(USBProbeDevices(vendorID, productID, output, max_devices))
+
+    int retval;
+
+    pthread_mutex_lock(&__device_table_lock);
+    retval = __probe_matching_devices(vendorID, productID, output, max_devices);
+    pthread_mutex_unlock(&__device_table_lock);
+    return retval;
+}
+
+/* These do the work of the functions above with the table lock held.  A
+ * snapshot taken by one thread is shared by any probe made on another
+ * thread before it ends, which is harmless as the lock is held throughout
+ * each use.
+ */
+static int __begin_probe(void) {
+    struct libusb_device_descriptor desc;
+    int num_dev;
+    int i;
+
+    if(__probe_depth > 0) {
+        /* Already inside a probe; keep using the same snapshot */
+        __probe_depth++;
+        return 0;
+    }
+
+    if(__init_libusb_context() < 0) {
+        return -1;
+    }
+
+    /* Get device list */
+    num_dev = libusb_get_device_list(__libusb_ctx, &__probe_device_list);
+    if(num_dev < 0) {
+        fprintf(stderr, "libusb_get_device_list() failed (Error: %s)", libusb_strerror(num_dev));
+        __probe_device_list = NULL;
+        return -1;
+    }
+
+    __probe_index = (__probe_entry_t *)calloc(num_dev + 1, sizeof(__probe_entry_t));
+    if(NULL == __probe_index) {
+        libusb_free_device_list(__probe_device_list, 1);
+        __probe_device_list = NULL;
+        return -1;
+    }
+
+    /* Read each device descriptor exactly once for the whole probe */
+    for(i = 0, __probe_index_count = 0; i < num_dev; i++) {
+        memset(&desc, 0, sizeof(desc));
+        if(libusb_get_device_descriptor(__probe_device_list[i], &desc) < 0) {
+            /* Error. Skip device */
+            continue;
+        }
+        __probe_index[__probe_index_count].vendorID = desc.idVendor;
+        __probe_index[__probe_index_count].productID = desc.idProduct;
+        __probe_index[__probe_index_count].device = __probe_device_list[i];
+        __probe_index_count++;
+    }
 
+    qsort(__probe_index, __probe_index_count, sizeof(__probe_entry_t),
+            __compare_probe_entries);
 
-/* This will attempt to free up all resources associated with an open
- * USB descriptor.  This also deallocates the provided pointer.
- */
-static void __close_and_dealloc_usb_interface(__usb_interface_t *usb) {
-    if(NULL == usb) {
+    __probe_depth = 1;
+    return 0;
+}
+
+static void __end_probe(void) {
+    if(__probe_depth <= 0 || --__probe_depth > 0) {
         return;
     }
 
-    if(NULL != usb->dev) {
-        /* MZ: This call to usb_reset() resolves a reported issue in which Linux apps 
-         * would run correctly once, then require spectrometer to be un/replugged to 
-         * run a second time.
-         */
-        libusb_reset_device(usb->dev);
-        /* Release interface */
-        libusb_release_interface(usb->dev, usb->interface);
-        /* Close device */
-        libusb_close(usb->dev);
-    }
+    free(__probe_index);
+    __probe_index = NULL;
+    __probe_index_count = 0;
 
-    free(usb);
+    /* free the list, unref the devices in it */
+    libusb_free_device_list(__probe_device_list, 1);
+    __probe_device_list = NULL;
 }
 
-
-int
-USBProbeDevices(int vendorID, int productID, unsigned long *output, int max_devices) {
-
+static int __probe_matching_devices(int vendorID, int productID,
+        unsigned long *output, int max_devices) {
     /* Local variables */
-    libusb_device **dev_list;
-    struct libusb_device_descriptor desc;
+    __probe_entry_t *entry;
     __device_instance_t *instance;
     int i;
     int matched = 0;
     int valid = 0;
-    int r = 0;
-    int num_dev = 0;
 
-    /* Check if libusb_init() has been called since it must be called before
-     * anything else happens.  This will be checked here, but not in any of
-     * the other functions because it only needs to happen once and this function
-     * is the entry point into the API.
+    /* Outside of USBBeginProbe()/USBEndProbe() this takes a snapshot of its
+     * own, which is equivalent to enumerating the bus for this call alone.
      */
-    if(NULL == __libusb_ctx) {
-        r = libusb_init(&__libusb_ctx);
-        if(r < 0) { // Init failed
-            fprintf(stderr, "libusb_init() failed (Error: %s)", libusb_strerror(r));
-            return -1;
-        }
-    }
-
-    /* Get device list */
-    num_dev = libusb_get_device_list(__libusb_ctx, &dev_list);
-    if(num_dev < 0) {
-        fprintf(stderr, "libusb_get_device_list() failed (Error: %s)", libusb_strerror(num_dev));
+    if(__begin_probe() < 0) {
         return -1;
     }
 
-    /* Traverse the tree and update the local cached device table as needed. */
-    for(i = 0; i < num_dev; i++) {
-
-        // Clear struct
-        memset(&desc, 0, sizeof(desc));
+    /* Walk the matching range of the snapshot and update the local cached
+     * device table as needed.
+     */
+    for(i = __probe_index_lower_bound(vendorID, productID); i < __probe_index_count; i++) {
+        entry = &(__probe_index[i]);
+        if(entry->vendorID != vendorID || entry->productID != productID) {
+            break;
+        }
 
-        // Get device descriptor
-        r = libusb_get_device_descriptor(dev_list[i], &desc);
-        if(r < 0) {
-            /* Error. Skip device */
+        /* Got a matching device node.  Determine if this is
+         * already in the cache.
+         */
+        instance = __lookup_device_instance_by_location(entry->device);
+        if(NULL != instance) {
+            /* Device is already known, so mark it and keep going */
+            instance->mark = 1;
             continue;
         }
 
-        if(desc.idVendor == vendorID && desc.idProduct == productID) {
-            /* Got a matching device node.  Determine if this is
-             * already in the cache.
-             */
-            instance = __lookup_device_instance_by_location(dev_list[i]);
-            if(NULL != instance) {
-                /* Device is already known, so mark it and keep going */
-                instance->mark = 1;
-                continue;
-            }
-
-            /* At this point, we must be dealing with a newly discovered USB
-             * device that matches the given VID and PID.  It must now be
-             * cached for use with the open function.  Note that instance was
-             * checked above so it must be NULL here.
-             */
-            libusb_ref_device(dev_list[i]);
-            instance = __add_device_instance(dev_list[i], vendorID, productID);
-            if(NULL == instance) {
-                /* Could not add the device -- this should not be possible, so bail out. */
-                return -1;
-            }
-            instance->mark = 1;     /* Preserve this since it was just seen */
+        /* At this point, we must be dealing with a newly discovered USB
+         * device that matches the given VID and PID.  It must now be
+         * cached for use with the open function.  Note that instance was
+         * checked above so it must be NULL here.
+         */
+        instance = __add_device_instance(entry->device, vendorID, productID);
+        if(NULL == instance) {
+            /* Could not add the device -- this should not be possible, so bail out. */
+            __end_probe();
+            return -1;
         }
+        instance->mark = 1;     /* Preserve this since it was just seen */
     }
-    /* free the list, unref the devices in it */
-    libusb_free_device_list(dev_list, 1);
+
+    __end_probe();
 
     /* Purge any devices that are cached but that no longer exist. */
     __purge_unmarked_device_instances(vendorID, productID);
@@ -314,6 +1145,7 @@ USBProbeDevices(int vendorID, int productID, unsigned long *output, int max_devi
                 && __enumerated_devices[i].vendorID == vendorID
                 && __enumerated_devices[i].productID == productID) {
             output[valid] = __enumerated_devices[i].deviceID;
+            USBCaptureDevice(output[valid], vendorID, productID);
             valid++;
         }
     }
@@ -323,6 +1155,18 @@ USBProbeDevices(int vendorID, int productID, unsigned long *output, int max_devi
 
 void *
 USBOpen(unsigned long deviceID, int *errorCode) {
+    REPLAY_DISPATCH(USBOpen(deviceID, errorCode))
+
+    void *retval;
+
+    /* Holding the table lock also stops two threads opening one device */
+    pthread_mutex_lock(&__device_table_lock);
+    retval = __open_device(deviceID, errorCode);
+    pthread_mutex_unlock(&__device_table_lock);
+    return retval;
+}
+
+static void *__open_device(unsigned long deviceID, int *errorCode) {
     // Local variables
     struct libusb_device_descriptor desc;
     struct libusb_config_descriptor *config = NULL;
@@ -404,6 +1248,7 @@ USBOpen(unsigned long deviceID, int *errorCode) {
         SET_ERROR_CODE(CLAIM_INTERFACE_FAILED);
         return 0;
     }
+    pthread_mutex_init(&(retval->lock), NULL);
     retval->interface = interface;
     retval->dev = deviceHandle;
     retval->deviceID = instance->deviceID;
@@ -415,6 +1260,8 @@ USBOpen(unsigned long deviceID, int *errorCode) {
 
 int
 USBWrite_timeout(void *deviceHandle, unsigned char endpoint, char *data, int numberOfBytes, unsigned int timeout) {
+    REPLAY_DISPATCH(USBWrite_timeout(deviceHandle, endpoint, data, numberOfBytes, timeout))
+
     /* Local variables */
     int retval;
     int bytesWritten;
@@ -430,11 +1277,14 @@ USBWrite_timeout(void *deviceHandle, unsigned char endpoint, char *data, int num
      * Perform the write.  This is effectively blocking (the timeout is large)
      */
     retval = libusb_bulk_transfer(usb->dev, endpoint, data, numberOfBytes, &bytesWritten, timeout);
-    if(retval < 0 || (0 == bytesWritten && 0 != numberOfBytes)) {
+    if(LIBUSB_ERROR_TIMEOUT == retval && 0 == bytesWritten) {
+        retval = WRITE_TIMED_OUT;
+    } else if(retval < 0 || (0 == bytesWritten && 0 != numberOfBytes)) {
         /* Transfer error */
         retval = WRITE_FAILED;
     } else {
         retval = bytesWritten;
+        USBCaptureWrite(usb->deviceID, endpoint, data, retval);
     }
     return retval;
 }
@@ -446,10 +1296,13 @@ USBWrite(void *deviceHandle, unsigned char endpoint, char *data, int numberOfByt
 
 int
 USBRead_timeout(void *deviceHandle, unsigned char endpoint, char * data, int numberOfBytes, unsigned int timeout) {
+    REPLAY_DISPATCH(USBRead_timeout(deviceHandle, endpoint, data, numberOfBytes, timeout))
+
     /* Local variables */
     int retval;
     int bytesRead;
     __usb_interface_t *usb;
+    __read_queue_t *queue;
 
     if(0 == deviceHandle) {
         return READ_FAILED;
@@ -457,16 +1310,37 @@ USBRead_timeout(void *deviceHandle, unsigned char endpoint, char * data, int num
 
     usb = (__usb_interface_t *)deviceHandle;
 
+    /* If transfers are being kept queued on this endpoint then every read
+     * has to be served from that queue to preserve the ordering of data.
+     */
+    pthread_mutex_lock(&(usb->lock));
+    queue = usb->readQueues[endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK];
+    if(NULL != queue && 0 != (endpoint & LIBUSB_ENDPOINT_IN)) {
+        if(0 == __read_queue_enter(usb, queue)) {
+            retval = __read_queue_read(usb, queue, data, numberOfBytes, timeout);
+        } else {
+            retval = READ_FAILED;
+        }
+        __read_queue_leave(usb, queue);
+        pthread_mutex_unlock(&(usb->lock));
+        USBCaptureRead(usb->deviceID, endpoint, data, retval);
+        return retval;
+    }
+    pthread_mutex_unlock(&(usb->lock));
+
     /*
      * Perform the read.  This is effectively blocking (the timeout is large)
      */
     retval = libusb_bulk_transfer(usb->dev, endpoint, data, numberOfBytes, &bytesRead, timeout);
 
-    if(retval < 0 || (0 == bytesRead && 0 != numberOfBytes)) {
+    if(LIBUSB_ERROR_TIMEOUT == retval && 0 == bytesRead) {
+        retval = READ_TIMED_OUT;
+    } else if(retval < 0 || (0 == bytesRead && 0 != numberOfBytes)) {
         retval = READ_FAILED;
     } else {
         retval = bytesRead;
     }
+    USBCaptureRead(usb->deviceID, endpoint, data, retval);
     return retval;
 }
 
@@ -475,8 +1349,369 @@ USBRead(void *deviceHandle, unsigned char endpoint, char * data, int numberOfByt
     return USBRead_timeout(deviceHandle, endpoint, data, numberOfBytes, DEFAULT_TIMEOUT);
 }
 
+int
+USBSetReadQueue(void *deviceHandle, unsigned char endpoint, int depth, int flags) {
+    REPLAY_DISPATCH(USBSetReadQueue(deviceHandle, endpoint, depth, flags))
+
+    __usb_interface_t *usb;
+    int retval;
+
+    if(0 == deviceHandle || 0 == (endpoint & LIBUSB_ENDPOINT_IN)) {
+        return -1;
+    }
+
+    usb = (__usb_interface_t *)deviceHandle;
+    pthread_mutex_lock(&(usb->lock));
+    retval = __set_read_queue(usb, endpoint, depth, flags);
+    pthread_mutex_unlock(&(usb->lock));
+    return retval;
+}
+
+/* Does the work of USBSetReadQueue() with the handle's lock held */
+static int __set_read_queue(__usb_interface_t *usb, unsigned char endpoint,
+        int depth, int flags) {
+    __read_queue_t *queue;
+    int index = endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK;
+
+    /* Tear down any existing queue first; its unread data is discarded.
+     * One that a reader is still in is freed when the last reader leaves.
+     */
+    if(NULL != usb->readQueues[index]) {
+        queue = usb->readQueues[index];
+        usb->readQueues[index] = NULL;
+        if(queue->users > 0) {
+            __read_queue_retire(queue);
+        } else {
+            __read_queue_destroy(usb, queue);
+        }
+    }
+
+    if(depth <= 0) {
+        /* Back to plain blocking reads */
+        return 0;
+    }
+
+    if(depth > MAX_QUEUED_TRANSFERS) {
+        depth = MAX_QUEUED_TRANSFERS;
+    }
+
+    queue = (__read_queue_t *)calloc(sizeof(__read_queue_t), 1);
+    if(NULL == queue) {
+        return -1;
+    }
+    queue->endpoint = endpoint;
+    queue->depth = depth;
+    queue->flags = flags;
+    pthread_mutex_init(&(queue->readLock), NULL);
+    usb->readQueues[index] = queue;
+
+    return 0;
+}
+
+static void LIBUSB_CALL __concurrent_read_callback(struct libusb_transfer *transfer) {
+    __concurrent_read_t *state = (__concurrent_read_t *)transfer->user_data;
+
+    state->outstanding--;
+    if(0 == state->outstanding) {
+        state->completed = 1;
+    }
+}
+
+int
+USBReadConcurrent(void *deviceHandle, struct USBReadRequest *requests, int count,
+        unsigned int timeout) {
+    REPLAY_DISPATCH(USBReadConcurrent(deviceHandle, requests, count, timeout))
+
+    /* Local variables */
+    struct libusb_transfer *transfers[MAX_ENDPOINTS];
+    __concurrent_read_t state;
+    __usb_interface_t *usb;
+    int retval = 0;
+    int total = 0;
+    int cancelled;
+    int flag;
+    int i;
+
+    if(0 == deviceHandle || count <= 0 || count > MAX_ENDPOINTS) {
+        return READ_FAILED;
+    }
+
+    usb = (__usb_interface_t *)deviceHandle;
+    if(0 == timeout) {
+        timeout = DEFAULT_TIMEOUT;
+    }
+
+    /* Anything with a read queue already has transfers in flight and has
+     * to be read through the queue to keep its data in order.
+     */
+    pthread_mutex_lock(&(usb->lock));
+    for(i = 0; i < count; i++) {
+        if(NULL != usb->readQueues[requests[i].endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK]) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&(usb->lock));
+    if(i < count) {
+        for(i = 0; i < count; i++) {
+            requests[i].bytesRead = USBRead_timeout(deviceHandle, requests[i].endpoint,
+                    requests[i].data, requests[i].numberOfBytes, timeout);
+            if(requests[i].bytesRead < 0) {
+                retval = READ_FAILED;
+            } else {
+                total += requests[i].bytesRead;
+            }
+        }
+        return (retval < 0) ? retval : total;
+    }
+
+    /* Each transfer points straight at its part of the caller's buffer */
+    state.outstanding = 0;
+    state.completed = 0;
+    for(i = 0; i < count; i++) {
+        requests[i].bytesRead = READ_FAILED;
+        transfers[i] = libusb_alloc_transfer(0);
+        if(NULL == transfers[i]) {
+            retval = READ_FAILED;
+            break;
+        }
+        libusb_fill_bulk_transfer(transfers[i], usb->dev, requests[i].endpoint,
+                (unsigned char *)requests[i].data, requests[i].numberOfBytes,
+                __concurrent_read_callback, &state, timeout);
+        if(libusb_submit_transfer(transfers[i]) < 0) {
+            libusb_free_transfer(transfers[i]);
+            retval = READ_FAILED;
+            break;
+        }
+        state.outstanding++;
+    }
+    count = i;
+
+    cancelled = 0;
+    if(retval < 0) {
+        /* Take back whatever did get submitted */
+        for(i = 0; i < count; i++) {
+            libusb_cancel_transfer(transfers[i]);
+        }
+        cancelled = 1;
+    }
+
+    /* Every transfer has a timeout, so this always comes to an end */
+    while(state.outstanding > 0) {
+        flag = libusb_handle_events_completed(__libusb_ctx, &(state.completed));
+        if(flag < 0 && LIBUSB_ERROR_INTERRUPTED != flag && 0 == cancelled) {
+            for(i = 0; i < count; i++) {
+                libusb_cancel_transfer(transfers[i]);
+            }
+            cancelled = 1;
+        }
+    }
+
+    for(i = 0; i < count; i++) {
+        if(LIBUSB_TRANSFER_COMPLETED == transfers[i]->status
+                && (transfers[i]->actual_length > 0 || 0 == requests[i].numberOfBytes)) {
+            requests[i].bytesRead = transfers[i]->actual_length;
+            total += transfers[i]->actual_length;
+        } else {
+            if(LIBUSB_TRANSFER_TIMED_OUT == transfers[i]->status) {
+                requests[i].bytesRead = READ_TIMED_OUT;
+            }
+            retval = READ_FAILED;
+        }
+        USBCaptureRead(usb->deviceID, requests[i].endpoint, requests[i].data,
+                requests[i].bytesRead);
+        libusb_free_transfer(transfers[i]);
+    }
+
+    return (retval < 0) ? retval : total;
+}
+
+int
+USBSetReadQueueDepth(void *deviceHandle, unsigned char endpoint, int depth) {
+    return USBSetReadQueue(deviceHandle, endpoint, depth, 0);
+}
+
+int
+USBReadQueueAcquire(void *deviceHandle, unsigned char endpoint,
+        int numberOfBytes, unsigned char **data, unsigned int timeout) {
+    REPLAY_DISPATCH(USBReadQueueAcquire(deviceHandle, endpoint, numberOfBytes, data, timeout))
+
+    __usb_interface_t *usb;
+    __read_queue_t *queue;
+    int retval;
+
+    if(0 == deviceHandle || NULL == data) {
+        return READ_FAILED;
+    }
+
+    usb = (__usb_interface_t *)deviceHandle;
+    pthread_mutex_lock(&(usb->lock));
+    __free_orphaned_buffer(usb, endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK);
+    queue = usb->readQueues[endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK];
+    if(NULL == queue || 0 == (queue->flags & USB_READ_QUEUE_ZERO_COPY)) {
+        pthread_mutex_unlock(&(usb->lock));
+        return READ_FAILED;
+    }
+
+    if(0 == __read_queue_enter(usb, queue)) {
+        retval = __read_queue_acquire(usb, queue, numberOfBytes, data,
+                (0 == timeout) ? DEFAULT_TIMEOUT : timeout);
+    } else {
+        retval = READ_FAILED;
+    }
+    __read_queue_leave(usb, queue);
+    pthread_mutex_unlock(&(usb->lock));
+    USBCaptureRead(usb->deviceID, endpoint, (retval > 0) ? (const char *)*data : NULL, retval);
+    return retval;
+}
+
+int
+USBReadQueueRelease(void *deviceHandle, unsigned char endpoint) {
+    REPLAY_DISPATCH(USBReadQueueRelease(deviceHandle, endpoint))
+
+    __usb_interface_t *usb;
+    __read_queue_t *queue;
+
+    if(0 == deviceHandle) {
+        return -1;
+    }
+
+    usb = (__usb_interface_t *)deviceHandle;
+    pthread_mutex_lock(&(usb->lock));
+    queue = usb->readQueues[endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK];
+    if(NULL != usb->orphaned[endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK].buffer) {
+        /* Borrowed from a queue that has since been replaced */
+        __free_orphaned_buffer(usb, endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK);
+        pthread_mutex_unlock(&(usb->lock));
+        return 0;
+    }
+    if(NULL == queue || NULL == queue->borrowed) {
+        pthread_mutex_unlock(&(usb->lock));
+        return -1;
+    }
+
+    queue->spare = queue->borrowed;
+    queue->borrowed = NULL;
+    pthread_mutex_unlock(&(usb->lock));
+    return 0;
+}
+
+int
+USBReadQueueSubmit(void *deviceHandle, unsigned char endpoint, int numberOfBytes) {
+    REPLAY_DISPATCH(USBReadQueueSubmit(deviceHandle, endpoint, numberOfBytes))
+
+    __usb_interface_t *usb;
+    __read_queue_t *queue;
+    int index;
+    int retval = -1;
+
+    if(0 == deviceHandle || 0 == (endpoint & LIBUSB_ENDPOINT_IN)) {
+        return -1;
+    }
+
+    usb = (__usb_interface_t *)deviceHandle;
+    index = endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK;
+
+    pthread_mutex_lock(&(usb->lock));
+    /* Completion can only be watched for on queued transfers */
+    if(NULL != usb->readQueues[index] || __set_read_queue(usb, endpoint, 1, 0) >= 0) {
+        queue = usb->readQueues[index];
+        if(0 == queue->transferSize) {
+            if(__read_queue_arm(usb, queue, numberOfBytes) >= 0) {
+                retval = 0;
+            }
+        } else {
+            __read_queue_refill(queue);
+            retval = 0;
+        }
+        if(0 == retval && 0 == queue->transfers[queue->head].submitted) {
+            retval = -1;
+        }
+    }
+    pthread_mutex_unlock(&(usb->lock));
+
+    return retval;
+}
+
+int
+USBReadQueueReady(void *deviceHandle, unsigned char endpoint) {
+    REPLAY_DISPATCH(USBReadQueueReady(deviceHandle, endpoint))
+
+    __usb_interface_t *usb;
+    __read_queue_t *queue;
+    __queued_transfer_t *queued;
+    int retval = -1;
+
+    if(0 == deviceHandle) {
+        return -1;
+    }
+
+    usb = (__usb_interface_t *)deviceHandle;
+    pthread_mutex_lock(&(usb->lock));
+    queue = usb->readQueues[endpoint & LIBUSB_ENDPOINT_ADDRESS_MASK];
+    if(NULL != queue && 0 != queue->transferSize) {
+        /* Reads are served from the head, so that is the one that matters.
+         * Its completion flag is only updated while events are being handled.
+         */
+        queued = &(queue->transfers[queue->head]);
+        if(0 != queued->submitted) {
+            retval = (0 != queued->completed) ? 1 : 0;
+        }
+    }
+    pthread_mutex_unlock(&(usb->lock));
+
+    return retval;
+}
+
+int
+USBGetPollDescriptors(struct USBPollDescriptor *descriptors, int max_descriptors) {
+    REPLAY_DISPATCH(USBGetPollDescriptors(descriptors, max_descriptors))
+
+    const struct libusb_pollfd **pollfds;
+    int count;
+
+    pthread_mutex_lock(&__device_table_lock);
+    count = __init_libusb_context();
+    pthread_mutex_unlock(&__device_table_lock);
+    if(count < 0) {
+        return -1;
+    }
+
+    pollfds = libusb_get_pollfds(__libusb_ctx);
+    if(NULL == pollfds) {
+        return -1;
+    }
+
+    for(count = 0; NULL != pollfds[count]; count++) {
+        if(NULL != descriptors && count < max_descriptors) {
+            descriptors[count].fd = pollfds[count]->fd;
+            descriptors[count].events = pollfds[count]->events;
+        }
+    }
+    libusb_free_pollfds(pollfds);
+
+    return count;
+}
+
+int
+USBHandleEvents(void) {
+    REPLAY_DISPATCH(USBHandleEvents())
+
+    struct timeval zero = { 0, 0 };
+
+    if(NULL == __libusb_ctx) {
+        return -1;
+    }
+
+    if(libusb_handle_events_timeout_completed(__libusb_ctx, &zero, NULL) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
 int
 USBClose(void *deviceHandle) {
+    REPLAY_DISPATCH(USBClose(deviceHandle))
+
     /* Local variables */
     __usb_interface_t *usb;
     __device_instance_t *device;
@@ -487,17 +1722,21 @@ USBClose(void *deviceHandle) {
 
     usb = (__usb_interface_t *)deviceHandle;
 
+    pthread_mutex_lock(&__device_table_lock);
     device = __lookup_device_instance_by_ID(usb->deviceID);
     if(NULL != device) {
         /* This had an extra reference to the handle so free it up */
         device->handle = NULL;
     }
+    pthread_mutex_unlock(&__device_table_lock);
 
     __close_and_dealloc_usb_interface(usb);
     return CLOSE_OK;
 }
 
 void USBClearStall(void *deviceHandle, unsigned char endpoint) {
+    REPLAY_DISPATCH_VOID(USBClearStall(deviceHandle, endpoint))
+
     __usb_interface_t *usb;
 
     if(0 == deviceHandle) {
@@ -511,9 +1750,11 @@ void USBClearStall(void *deviceHandle, unsigned char endpoint) {
 
 int
 USBGetDeviceDescriptor(void *deviceHandle, struct USBDeviceDescriptor *desc) {
+    REPLAY_DISPATCH(USBGetDeviceDescriptor(deviceHandle, desc))
+
     struct libusb_device_descriptor dd;
     __usb_interface_t *usb;
-    __device_instance_t *device;
+    libusb_device *device;
     int r = 0;
 
     if(0 == desc) {
@@ -525,13 +1766,13 @@ USBGetDeviceDescriptor(void *deviceHandle, struct USBDeviceDescriptor *desc) {
     }
 
     usb = (__usb_interface_t *)deviceHandle;
-    device = __lookup_device_instance_by_ID(usb->deviceID);
-    if(0 == device) {
-        return -2;
-    }
+    /* Taken from the handle rather than from the device table, which
+     * may be changing under a probe on another thread.
+     */
+    device = libusb_get_device(usb->dev);
 
     /* Get device descriptor */
-    r = libusb_get_device_descriptor(device->device, &dd);
+    r = libusb_get_device_descriptor(device, &dd);
     if(r < 0) {
         fprintf(stderr, "libusb_get_device_descriptor() failed (Error: %s)", libusb_strerror(r));
         return -3;
@@ -552,16 +1793,19 @@ USBGetDeviceDescriptor(void *deviceHandle, struct USBDeviceDescriptor *desc) {
     desc->iSerialNumber = dd.iSerialNumber;
     desc->bNumConfigurations = dd.bNumConfigurations;
 
+    USBCaptureDeviceDescriptor(usb->deviceID, desc);
     return 0;
 }
 
 int
 USBGetInterfaceDescriptor(void *deviceHandle, struct USBInterfaceDescriptor *desc) {
+    REPLAY_DISPATCH(USBGetInterfaceDescriptor(deviceHandle, desc))
+
     struct libusb_device_descriptor dd;
     struct libusb_config_descriptor *config = NULL;
     const struct libusb_interface_descriptor *id = NULL;
     __usb_interface_t *usb;
-    __device_instance_t *device;
+    libusb_device *device;
     int r = 0;
 
     if(0 == desc) {
@@ -573,13 +1817,10 @@ USBGetInterfaceDescriptor(void *deviceHandle, struct USBInterfaceDescriptor *des
     }
 
     usb = (__usb_interface_t *)deviceHandle;
-    device = __lookup_device_instance_by_ID(usb->deviceID);
-    if(0 == device) {
-        return -2;
-    }
+    device = libusb_get_device(usb->dev);
 
     /* Get device descriptor */
-    r = libusb_get_device_descriptor(device->device, &dd);
+    r = libusb_get_device_descriptor(device, &dd);
     if(r < 0) {
         fprintf(stderr, "libusb_get_device_descriptor() failed (Error: %s)", libusb_strerror(r));
         return -3;
@@ -593,7 +1834,7 @@ USBGetInterfaceDescriptor(void *deviceHandle, struct USBInterfaceDescriptor *des
     if(dd.bNumConfigurations > 1) {
         fprintf(stderr, "Warning: USB device has more than one configuration available. Get descriptor of the first one.");
     }
-    r = libusb_get_config_descriptor(device->device, 0, &config);
+    r = libusb_get_config_descriptor(device, 0, &config);
     if(r < 0) {
         fprintf(stderr, "libusb_get_config_descriptor() failed (Error: %s)", libusb_strerror(r));
         return -3;
@@ -618,6 +1859,7 @@ USBGetInterfaceDescriptor(void *deviceHandle, struct USBInterfaceDescriptor *des
 
     libusb_free_config_descriptor(config);
 
+    USBCaptureInterfaceDescriptor(usb->deviceID, desc);
     return 0;
 }
 
@@ -625,11 +1867,13 @@ USBGetInterfaceDescriptor(void *deviceHandle, struct USBInterfaceDescriptor *des
 int
 USBGetEndpointDescriptor(void *deviceHandle, int endpoint_index,
         struct USBEndpointDescriptor *desc) {
+    REPLAY_DISPATCH(USBGetEndpointDescriptor(deviceHandle, endpoint_index, desc))
+
     struct libusb_device_descriptor dd;
     struct libusb_config_descriptor *config = NULL;
     const struct libusb_endpoint_descriptor* ed = NULL;
     __usb_interface_t *usb;
-    __device_instance_t *device;
+    libusb_device *device;
     int r = 0;
 
     if(0 == desc) {
@@ -641,13 +1885,10 @@ USBGetEndpointDescriptor(void *deviceHandle, int endpoint_index,
     }
 
     usb = (__usb_interface_t *)deviceHandle;
-    device = __lookup_device_instance_by_ID(usb->deviceID);
-    if(0 == device) {
-        return -2;
-    }
+    device = libusb_get_device(usb->dev);
 
     /* Get device descriptor */
-    r = libusb_get_device_descriptor(device->device, &dd);
+    r = libusb_get_device_descriptor(device, &dd);
     if(r < 0) {
         fprintf(stderr, "libusb_get_device_descriptor() failed (Error: %s)", libusb_strerror(r));
         return -3;
@@ -661,7 +1902,7 @@ USBGetEndpointDescriptor(void *deviceHandle, int endpoint_index,
     if(dd.bNumConfigurations > 1) {
         fprintf(stderr, "Warning: USB device has more than one configuration available. Get descriptor of the first one.");
     }
-    r = libusb_get_config_descriptor(device->device, 0, &config);
+    r = libusb_get_config_descriptor(device, 0, &config);
     if(r < 0) {
         fprintf(stderr, "libusb_get_config_descriptor() failed (Error: %s)", libusb_strerror(r));
         return -3;
@@ -684,6 +1925,7 @@ USBGetEndpointDescriptor(void *deviceHandle, int endpoint_index,
 
     libusb_free_config_descriptor(config);
 
+    USBCaptureEndpointDescriptor(usb->deviceID, endpoint_index, desc);
     return 0;
 }
 
@@ -691,6 +1933,8 @@ USBGetEndpointDescriptor(void *deviceHandle, int endpoint_index,
 int
 USBGetStringDescriptor(void *deviceHandle, unsigned int string_index,
         char *buffer, int maxLength) {
+    REPLAY_DISPATCH(USBGetStringDescriptor(deviceHandle, string_index, buffer, maxLength))
+
     /* Local variables */
     int length = 0;
     __usb_interface_t *usb;
@@ -706,6 +1950,8 @@ USBGetStringDescriptor(void *deviceHandle, unsigned int string_index,
     length = libusb_get_string_descriptor_ascii(usb->dev, string_index, buffer, maxLength);
     if(length <= 0) {
         buffer[0] = '\0';
+    } else {
+        USBCaptureStringDescriptor(usb->deviceID, string_index, buffer, length);
     }
 
     return length;
@@ -327,6 +327,35 @@ void __close_and_dealloc_usb_interface(__usb_interface_t *usb) {
     free(usb);
 }
 
+/* Hotplug notification is only implemented for libusb; callers fall back
+ * to probing.
+ */
+int
+USBEnableHotplug(int vendorID, int productID) {
+    return -1;
+}
+
+void
+USBDisableHotplug(void) {
+}
+
+int
+USBPollHotplugEvents(struct USBHotplugEvent *events, int max_events) {
+    return -1;
+}
+
+/* This platform enumerates the bus on every USBProbeDevices() call, so
+ * there is no snapshot to share between device types.
+ */
+int
+USBBeginProbe(void) {
+    return 0;
+}
+
+void
+USBEndProbe(void) {
+}
+
 int
 USBProbeDevices(int vendorID, int productID, unsigned long *output,
                 int max_devices) {
@@ -934,6 +963,87 @@ USBRead(void *deviceHandle, unsigned char endpoint, char *data, int numberOfByte
 }
 
 
+int
+USBReadConcurrent(void *deviceHandle, struct USBReadRequest *requests, int count,
+        unsigned int timeout) {
+    /* Only libusb can have reads outstanding on several endpoints at once,
+     * so these are simply made one after the other.
+     */
+    int total = 0;
+    int retval = 0;
+    int i;
+
+    for(i = 0; i < count; i++) {
+        requests[i].bytesRead = USBRead_timeout(deviceHandle, requests[i].endpoint,
+                requests[i].data, requests[i].numberOfBytes, timeout);
+        if(requests[i].bytesRead < 0) {
+            retval = READ_FAILED;
+        } else {
+            total += requests[i].bytesRead;
+        }
+    }
+
+    return (retval < 0) ? retval : total;
+}
+
+int
+USBSetReadQueueDepth(void *deviceHandle, unsigned char endpoint, int depth) {
+    /* Queued reads are only implemented for libusb.  Asking for plain
+     * blocking reads is trivially satisfied.
+     */
+    if(NULL == deviceHandle) {
+        return -1;
+    }
+    return (depth <= 0) ? 0 : -1;
+}
+
+int
+USBSetReadQueue(void *deviceHandle, unsigned char endpoint, int depth, int flags) {
+    /* Zero-copy buffers are only implemented for libusb */
+    if(0 != flags) {
+        return -1;
+    }
+    return USBSetReadQueueDepth(deviceHandle, endpoint, depth);
+}
+
+int
+USBReadQueueAcquire(void *deviceHandle, unsigned char endpoint, int numberOfBytes,
+        unsigned char **data, unsigned int timeout) {
+    /* Only implemented for libusb */
+    return READ_FAILED;
+}
+
+int
+USBReadQueueRelease(void *deviceHandle, unsigned char endpoint) {
+    /* Only implemented for libusb */
+    return -1;
+}
+
+int
+USBReadQueueSubmit(void *deviceHandle, unsigned char endpoint, int numberOfBytes) {
+    /* Only implemented for libusb */
+    return -1;
+}
+
+int
+USBReadQueueReady(void *deviceHandle, unsigned char endpoint) {
+    /* Only implemented for libusb */
+    return -1;
+}
+
+int
+USBGetPollDescriptors(struct USBPollDescriptor *descriptors, int max_descriptors) {
+    /* Only implemented for libusb */
+    return -1;
+}
+
+int
+USBHandleEvents(void) {
+    /* Only implemented for libusb */
+    return -1;
+}
+
+
 void
 USBClearStall(void *deviceHandle, unsigned char endpoint) {
     __usb_interface_t *usb;
@@ -0,0 +1,964 @@
+/***************************************************//**
+ * @file    NativeUSBReplay.c
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * This is an implementation of the USB interface that plays
+ * back recorded traffic from a trace file instead of talking
+ * to hardware, along with the capture hooks that a real
+ * backend uses to record such traces.  See NativeUSBReplay.h
+ * for the trace format and how the backend is selected.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#include "common/globals.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "native/usb/NativeUSB.h"
+#include "native/usb/replay/NativeUSBReplay.h"
+
+/* Definitions and macros */
+#define MAX_REPLAY_DEVICES          32
+#define MAX_ENDPOINTS               16 /* Endpoint numbers are 4 bits wide */
+#define MAX_ENDPOINT_DESCRIPTORS    32
+#define MAX_STRING_DESCRIPTORS      16
+#define MAX_RECORD_FIELDS           20
+
+/* Either implement NativeUSB.h directly or provide the prefixed entry
+ * points that a native backend hands over to.
+ */
+#ifdef USB_REPLAY_BACKEND
+#define REPLAY_API(name) name
+#else
+#define REPLAY_API(name) Replay ## name
+#endif
+
+/* struct definitions */
+typedef struct {
+    int length;                   /* READ_FAILED for a failed read */
+    unsigned char *data;
+    int next;                     /* Next read on the same endpoint, or -1 */
+} __replay_read_t;
+
+typedef struct {
+    unsigned long deviceID;
+    unsigned short vendorID;
+    unsigned short productID;
+    int haveDeviceDescriptor;
+    struct USBDeviceDescriptor deviceDescriptor;
+    int haveInterfaceDescriptor;
+    struct USBInterfaceDescriptor interfaceDescriptor;
+    int haveEndpointDescriptor[MAX_ENDPOINT_DESCRIPTORS];
+    struct USBEndpointDescriptor endpointDescriptors[MAX_ENDPOINT_DESCRIPTORS];
+    char *strings[MAX_STRING_DESCRIPTORS];
+    int first[MAX_ENDPOINTS];     /* First read on each endpoint, or -1 */
+    int last[MAX_ENDPOINTS];      /* Last read on each endpoint while loading */
+    int loop[MAX_ENDPOINTS];      /* First read after the loop record, or -1 */
+    int cursor[MAX_ENDPOINTS];    /* Next read to hand out, or -1 */
+    int borrowed[MAX_ENDPOINTS];
+} __replay_device_t;
+
+/* Global variables (static) */
+static __replay_device_t __replay_devices[MAX_REPLAY_DEVICES];
+static int __replay_device_count = 0;
+static __replay_read_t *__replay_reads = NULL;
+static int __replay_read_count = 0;
+static int __replay_read_capacity = 0;
+static int __replay_loaded = 0;
+static int __replay_active = -1;
+
+static FILE *__capture_file = NULL;
+static int __capture_checked = 0;
+static pthread_mutex_t __capture_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char __hex_digits[] = "0123456789abcdef";
+
+/* Function prototypes */
+static void __replay_load(void);
+static char *__replay_read_line(FILE *file);
+static const char *__replay_payload(const char *field);
+static int __replay_decode_hex(const char *hex, unsigned char **data);
+static int __replay_parse_numbers(char **fields, int count, unsigned long *values);
+static __replay_device_t *__replay_lookup_device(unsigned long deviceID);
+static __replay_device_t *__replay_add_device(unsigned long deviceID);
+static int __replay_add_read(__replay_device_t *device, int endpoint,
+        int length, unsigned char *data, int looping);
+static int __replay_next_read(__replay_device_t *device, unsigned char endpoint);
+static FILE *__capture_open(void);
+static void __capture_line(FILE *file, const char *line, size_t length);
+static void __capture_payload(const char *prefix, const unsigned char *data, int length);
+
+
+/* Trace loading.  The whole trace is read into memory the first time the
+ * backend is used, so that replay itself never touches the file system and
+ * measures only the cost of the driver stack above it.
+ */
+static void __replay_load(void) {
+    char *fields[MAX_RECORD_FIELDS];
+    unsigned long values[MAX_RECORD_FIELDS];
+    __replay_device_t *device;
+    unsigned char *data;
+    const char *path;
+    char *line;
+    char *token;
+    FILE *file;
+    int looping = 0;
+    int lineNumber = 0;
+    int count;
+    int length;
+
+    if(0 != __replay_loaded) {
+        return;
+    }
+    __replay_loaded = 1;
+
+    path = getenv(USB_REPLAY_ENV);
+    if(NULL == path || '\0' == path[0]) {
+        return;
+    }
+
+    file = fopen(path, "r");
+    if(NULL == file) {
+        fprintf(stderr, "Could not open USB trace %s\n", path);
+        return;
+    }
+
+    while(NULL != (line = __replay_read_line(file))) {
+        lineNumber++;
+
+        count = 0;
+        token = strtok(line, " \t");
+        while(NULL != token && count < MAX_RECORD_FIELDS) {
+            fields[count++] = token;
+            token = strtok(NULL, " \t");
+        }
+        if(0 == count || '#' == fields[0][0]) {
+            free(line);
+            continue;
+        }
+
+        if(0 == strcmp(fields[0], "loop")) {
+            looping = 1;
+        } else if(0 == strcmp(fields[0], "device") && 4 == count
+                && 0 == __replay_parse_numbers(&fields[1], 3, values)) {
+            device = __replay_add_device(values[0]);
+            if(NULL != device) {
+                device->vendorID = (unsigned short)values[1];
+                device->productID = (unsigned short)values[2];
+            }
+        } else if(0 == strcmp(fields[0], "devdesc") && 16 == count
+                && 0 == __replay_parse_numbers(&fields[1], 15, values)
+                && NULL != (device = __replay_add_device(values[0]))) {
+            device->deviceDescriptor.bLength = (unsigned char)values[1];
+            device->deviceDescriptor.bDescriptorType = (unsigned char)values[2];
+            device->deviceDescriptor.bcdUSB = (unsigned short)values[3];
+            device->deviceDescriptor.bDeviceClass = (unsigned char)values[4];
+            device->deviceDescriptor.bDeviceSubClass = (unsigned char)values[5];
+            device->deviceDescriptor.bDeviceProtocol = (unsigned char)values[6];
+            device->deviceDescriptor.bMaxPacketSize0 = (unsigned char)values[7];
+            device->deviceDescriptor.idVendor = (unsigned short)values[8];
+            device->deviceDescriptor.idProduct = (unsigned short)values[9];
+            device->deviceDescriptor.bcdDevice = (unsigned short)values[10];
+            device->deviceDescriptor.iManufacturer = (unsigned char)values[11];
+            device->deviceDescriptor.iProduct = (unsigned char)values[12];
+            device->deviceDescriptor.iSerialNumber = (unsigned char)values[13];
+            device->deviceDescriptor.bNumConfigurations = (unsigned char)values[14];
+            device->haveDeviceDescriptor = 1;
+        } else if(0 == strcmp(fields[0], "ifdesc") && 11 == count
+                && 0 == __replay_parse_numbers(&fields[1], 10, values)
+                && NULL != (device = __replay_add_device(values[0]))) {
+            device->interfaceDescriptor.bLength = (unsigned char)values[1];
+            device->interfaceDescriptor.bDescriptorType = (unsigned char)values[2];
+            device->interfaceDescriptor.bInterfaceNumber = (unsigned char)values[3];
+            device->interfaceDescriptor.bAlternateSetting = (unsigned char)values[4];
+            device->interfaceDescriptor.bNumEndpoints = (unsigned char)values[5];
+            device->interfaceDescriptor.bInterfaceClass = (unsigned char)values[6];
+            device->interfaceDescriptor.bInterfaceSubClass = (unsigned char)values[7];
+            device->interfaceDescriptor.bInterfaceProtocol = (unsigned char)values[8];
+            device->interfaceDescriptor.iInterface = (unsigned char)values[9];
+            device->haveInterfaceDescriptor = 1;
+        } else if(0 == strcmp(fields[0], "epdesc") && 9 == count
+                && 0 == __replay_parse_numbers(&fields[1], 8, values)
+                && values[1] < MAX_ENDPOINT_DESCRIPTORS
+                && NULL != (device = __replay_add_device(values[0]))) {
+            device->endpointDescriptors[values[1]].bLength = (unsigned char)values[2];
+            device->endpointDescriptors[values[1]].bDescriptorType = (unsigned char)values[3];
+            device->endpointDescriptors[values[1]].bEndpointAddress = (unsigned char)values[4];
+            device->endpointDescriptors[values[1]].bmAttributes = (unsigned char)values[5];
+            device->endpointDescriptors[values[1]].wMaxPacketSize = (unsigned short)values[6];
+            device->endpointDescriptors[values[1]].bInterval = (unsigned char)values[7];
+            device->haveEndpointDescriptor[values[1]] = 1;
+        } else if(0 == strcmp(fields[0], "string") && 4 == count
+                && 0 == __replay_parse_numbers(&fields[1], 2, values)
+                && values[1] < MAX_STRING_DESCRIPTORS
+                && NULL != (device = __replay_add_device(values[0]))
+                && (length = __replay_decode_hex(__replay_payload(fields[3]), &data)) >= 0) {
+            /* Keep it terminated so it can be handed out as a string */
+            free(device->strings[values[1]]);
+            device->strings[values[1]] = (char *)realloc(data, length + 1);
+            if(NULL == device->strings[values[1]]) {
+                free(data);
+            } else {
+                device->strings[values[1]][length] = '\0';
+            }
+        } else if(0 == strcmp(fields[0], "write") && 4 == count) {
+            /* Writes are not checked on replay */
+        } else if(0 == strcmp(fields[0], "read") && 4 == count
+                && 0 == __replay_parse_numbers(&fields[1], 2, values)
+                && NULL != (device = __replay_add_device(values[0]))) {
+            if(0 == strcmp(fields[3], "-")) {
+                __replay_add_read(device, (int)values[1], READ_FAILED, NULL, looping);
+            } else if((length = __replay_decode_hex(__replay_payload(fields[3]), &data)) >= 0) {
+                if(__replay_add_read(device, (int)values[1], length, data, looping) < 0) {
+                    free(data);
+                }
+            }
+        } else {
+            fprintf(stderr, "Ignoring bad record on line %d of USB trace %s\n",
+                    lineNumber, path);
+        }
+
+        free(line);
+    }
+
+    fclose(file);
+}
+
+/* Reads one line of any length, without its line ending.  Payloads are
+ * often several kilobytes long, so the buffer grows as needed.
+ */
+static char *__replay_read_line(FILE *file) {
+    size_t capacity = 256;
+    size_t length = 0;
+    char *line;
+    char *grown;
+
+    line = (char *)malloc(capacity);
+    if(NULL == line) {
+        return NULL;
+    }
+
+    while(NULL != fgets(line + length, (int)(capacity - length), file)) {
+        length += strlen(line + length);
+        if(length > 0 && '\n' == line[length - 1]) {
+            line[--length] = '\0';
+            if(length > 0 && '\r' == line[length - 1]) {
+                line[--length] = '\0';
+            }
+            return line;
+        }
+        if(length + 1 >= capacity) {
+            capacity *= 2;
+            grown = (char *)realloc(line, capacity);
+            if(NULL == grown) {
+                free(line);
+                return NULL;
+            }
+            line = grown;
+        }
+    }
+
+    if(0 == length) {
+        /* End of file */
+        free(line);
+        return NULL;
+    }
+    return line;
+}
+
+static int __replay_hex_value(char c) {
+    if(c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if(c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/* Empty payloads are written as '.' so that the record keeps its field */
+static const char *__replay_payload(const char *field) {
+    return (0 == strcmp(field, ".")) ? "" : field;
+}
+
+static int __replay_decode_hex(const char *hex, unsigned char **data) {
+    size_t digits;
+    int length;
+    int high;
+    int low;
+    int i;
+
+    digits = strlen(hex);
+    if(0 != (digits % 2)) {
+        return -1;
+    }
+    length = (int)(digits / 2);
+
+    /* Always allocate something so that an empty payload is not NULL */
+    *data = (unsigned char *)malloc(length > 0 ? length : 1);
+    if(NULL == *data) {
+        return -1;
+    }
+
+    for(i = 0; i < length; i++) {
+        high = __replay_hex_value(hex[2 * i]);
+        low = __replay_hex_value(hex[2 * i + 1]);
+        if(high < 0 || low < 0) {
+            free(*data);
+            *data = NULL;
+            return -1;
+        }
+        (*data)[i] = (unsigned char)((high << 4) | low);
+    }
+
+    return length;
+}
+
+static int __replay_parse_numbers(char **fields, int count, unsigned long *values) {
+    char *end;
+    int i;
+
+    for(i = 0; i < count; i++) {
+        values[i] = strtoul(fields[i], &end, 0);
+        if(end == fields[i] || '\0' != *end) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static __replay_device_t *__replay_lookup_device(unsigned long deviceID) {
+    int i;
+
+    for(i = 0; i < __replay_device_count; i++) {
+        if(__replay_devices[i].deviceID == deviceID) {
+            return &__replay_devices[i];
+        }
+    }
+    return NULL;
+}
+
+/* Returns the device with the given ID, creating it on first mention */
+static __replay_device_t *__replay_add_device(unsigned long deviceID) {
+    __replay_device_t *device;
+    int i;
+
+    device = __replay_lookup_device(deviceID);
+    if(NULL != device) {
+        return device;
+    }
+    if(__replay_device_count >= MAX_REPLAY_DEVICES) {
+        return NULL;
+    }
+
+    device = &__replay_devices[__replay_device_count++];
+    memset(device, 0, sizeof(__replay_device_t));
+    device->deviceID = deviceID;
+    for(i = 0; i < MAX_ENDPOINTS; i++) {
+        device->first[i] = -1;
+        device->last[i] = -1;
+        device->loop[i] = -1;
+        device->cursor[i] = -1;
+    }
+    return device;
+}
+
+static int __replay_add_read(__replay_device_t *device, int endpoint,
+        int length, unsigned char *data, int looping) {
+    __replay_read_t *grown;
+    int capacity;
+    int index;
+
+    if(__replay_read_count >= __replay_read_capacity) {
+        capacity = (0 == __replay_read_capacity) ? 64 : 2 * __replay_read_capacity;
+        grown = (__replay_read_t *)realloc(__replay_reads,
+                capacity * sizeof(__replay_read_t));
+        if(NULL == grown) {
+            return -1;
+        }
+        __replay_reads = grown;
+        __replay_read_capacity = capacity;
+    }
+
+    __replay_reads[__replay_read_count].length = length;
+    __replay_reads[__replay_read_count].data = data;
+    __replay_reads[__replay_read_count].next = -1;
+
+    /* Chain it onto the reads already seen on this endpoint */
+    endpoint &= (MAX_ENDPOINTS - 1);
+    if(device->last[endpoint] < 0) {
+        device->first[endpoint] = __replay_read_count;
+        device->cursor[endpoint] = __replay_read_count;
+    } else {
+        __replay_reads[device->last[endpoint]].next = __replay_read_count;
+    }
+    device->last[endpoint] = __replay_read_count;
+    if(0 != looping && device->loop[endpoint] < 0) {
+        device->loop[endpoint] = __replay_read_count;
+    }
+
+    index = __replay_read_count++;
+    return index;
+}
+
+/* Hands out the next recorded read on an endpoint, wrapping around to the
+ * loop point once the recording runs out.
+ */
+static int __replay_next_read(__replay_device_t *device, unsigned char endpoint) {
+    int index = endpoint & (MAX_ENDPOINTS - 1);
+    int read;
+
+    read = device->cursor[index];
+    if(read < 0) {
+        return -1;
+    }
+
+    device->cursor[index] = __replay_reads[read].next;
+    if(device->cursor[index] < 0) {
+        device->cursor[index] = device->loop[index];
+    }
+    return read;
+}
+
+
+/* Replay interface */
+int
+USBReplayActive(void) {
+    const char *path;
+
+    if(__replay_active < 0) {
+        path = getenv(USB_REPLAY_ENV);
+        __replay_active = (NULL != path && '\0' != path[0]) ? 1 : 0;
+    }
+    return __replay_active;
+}
+
+int
+REPLAY_API(USBProbeDevices)(int vendorID, int productID, unsigned long *output,
+        int max_devices) {
+    int found = 0;
+    int i;
+
+    __replay_load();
+
+    for(i = 0; i < __replay_device_count && found < max_devices; i++) {
+        if(__replay_devices[i].vendorID == vendorID
+                && __replay_devices[i].productID == productID) {
+            output[found++] = __replay_devices[i].deviceID;
+        }
+    }
+    return found;
+}
+
+int
+REPLAY_API(USBBeginProbe)(void) {
+    __replay_load();
+    return 0;
+}
+
+void
+REPLAY_API(USBEndProbe)(void) {
+    /* Nothing to release; the trace stays loaded */
+}
+
+int
+REPLAY_API(USBEnableHotplug)(int vendorID, int productID) {
+    /* Devices in a trace never come or go */
+    return -1;
+}
+
+void
+REPLAY_API(USBDisableHotplug)(void) {
+
+}
+
+int
+REPLAY_API(USBPollHotplugEvents)(struct USBHotplugEvent *events, int max_events) {
+    return -1;
+}
+
+void *
+REPLAY_API(USBOpen)(unsigned long deviceID, int *errorCode) {
+    __replay_device_t *device;
+
+    __replay_load();
+
+    device = __replay_lookup_device(deviceID);
+    if(NULL == device) {
+        if(NULL != errorCode) {
+            *errorCode = NO_DEVICE_FOUND;
+        }
+        return NULL;
+    }
+
+    if(NULL != errorCode) {
+        *errorCode = OPEN_OK;
+    }
+    return device;
+}
+
+int
+REPLAY_API(USBClose)(void *deviceHandle) {
+    if(NULL == deviceHandle) {
+        return CLOSE_ERROR;
+    }
+    return CLOSE_OK;
+}
+
+int
+REPLAY_API(USBWrite_timeout)(void *deviceHandle, unsigned char endpoint,
+        char *data, int numberOfBytes, unsigned int timeout) {
+    if(NULL == deviceHandle) {
+        return WRITE_FAILED;
+    }
+    return numberOfBytes;
+}
+
+int
+REPLAY_API(USBWrite)(void *deviceHandle, unsigned char endpoint, char *data,
+        int numberOfBytes) {
+    return REPLAY_API(USBWrite_timeout)(deviceHandle, endpoint, data, numberOfBytes, 0);
+}
+
+int
+REPLAY_API(USBRead_timeout)(void *deviceHandle, unsigned char endpoint,
+        char *data, int numberOfBytes, unsigned int timeout) {
+    __replay_device_t *device;
+    __replay_read_t *read;
+    int index;
+    int count;
+
+    if(NULL == deviceHandle) {
+        return READ_FAILED;
+    }
+
+    device = (__replay_device_t *)deviceHandle;
+    index = __replay_next_read(device, endpoint);
+    if(index < 0) {
+        /* The trace has run out */
+        return READ_FAILED;
+    }
+
+    read = &__replay_reads[index];
+    if(read->length < 0 || (0 == read->length && 0 != numberOfBytes)) {
+        return READ_FAILED;
+    }
+
+    count = (read->length < numberOfBytes) ? read->length : numberOfBytes;
+    memcpy(data, read->data, count);
+    return count;
+}
+
+int
+REPLAY_API(USBRead)(void *deviceHandle, unsigned char endpoint, char *data,
+        int numberOfBytes) {
+    return REPLAY_API(USBRead_timeout)(deviceHandle, endpoint, data, numberOfBytes, 0);
+}
+
+int
+REPLAY_API(USBReadConcurrent)(void *deviceHandle, struct USBReadRequest *requests,
+        int count, unsigned int timeout) {
+    int total = 0;
+    int retval = 0;
+    int i;
+
+    /* Reads are recorded per endpoint, so their order does not matter */
+    for(i = 0; i < count; i++) {
+        requests[i].bytesRead = REPLAY_API(USBRead_timeout)(deviceHandle,
+                requests[i].endpoint, requests[i].data, requests[i].numberOfBytes,
+                timeout);
+        if(requests[i].bytesRead < 0) {
+            retval = READ_FAILED;
+        } else {
+            total += requests[i].bytesRead;
+        }
+    }
+
+    return (retval < 0) ? retval : total;
+}
+
+int
+REPLAY_API(USBSetReadQueue)(void *deviceHandle, unsigned char endpoint, int depth,
+        int flags) {
+    /* Every read is already served from memory */
+    if(NULL == deviceHandle) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+REPLAY_API(USBSetReadQueueDepth)(void *deviceHandle, unsigned char endpoint, int depth) {
+    return REPLAY_API(USBSetReadQueue)(deviceHandle, endpoint, depth, 0);
+}
+
+int
+REPLAY_API(USBReadQueueAcquire)(void *deviceHandle, unsigned char endpoint,
+        int numberOfBytes, unsigned char **data, unsigned int timeout) {
+    __replay_device_t *device;
+    __replay_read_t *read;
+    int index;
+
+    if(NULL == deviceHandle || NULL == data) {
+        return READ_FAILED;
+    }
+
+    device = (__replay_device_t *)deviceHandle;
+    index = __replay_next_read(device, endpoint);
+    if(index < 0) {
+        return READ_FAILED;
+    }
+
+    read = &__replay_reads[index];
+    if(read->length <= 0) {
+        return READ_FAILED;
+    }
+
+    /* Lend out the recorded payload itself */
+    *data = read->data;
+    device->borrowed[endpoint & (MAX_ENDPOINTS - 1)] = 1;
+    return read->length;
+}
+
+int
+REPLAY_API(USBReadQueueRelease)(void *deviceHandle, unsigned char endpoint) {
+    __replay_device_t *device;
+    int index = endpoint & (MAX_ENDPOINTS - 1);
+
+    if(NULL == deviceHandle) {
+        return -1;
+    }
+
+    device = (__replay_device_t *)deviceHandle;
+    if(0 == device->borrowed[index]) {
+        return -1;
+    }
+    device->borrowed[index] = 0;
+    return 0;
+}
+
+int
+REPLAY_API(USBReadQueueSubmit)(void *deviceHandle, unsigned char endpoint,
+        int numberOfBytes) {
+    if(NULL == deviceHandle) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+REPLAY_API(USBReadQueueReady)(void *deviceHandle, unsigned char endpoint) {
+    /* Recorded data never has to be waited for */
+    if(NULL == deviceHandle) {
+        return -1;
+    }
+    return 1;
+}
+
+int
+REPLAY_API(USBGetPollDescriptors)(struct USBPollDescriptor *descriptors,
+        int max_descriptors) {
+    return 0;
+}
+
+int
+REPLAY_API(USBHandleEvents)(void) {
+    return 0;
+}
+
+void
+REPLAY_API(USBClearStall)(void *deviceHandle, unsigned char endpoint) {
+
+}
+
+int
+REPLAY_API(USBGetDeviceDescriptor)(void *deviceHandle, struct USBDeviceDescriptor *desc) {
+    __replay_device_t *device;
+
+    if(NULL == deviceHandle || NULL == desc) {
+        return -1;
+    }
+
+    device = (__replay_device_t *)deviceHandle;
+    if(0 != device->haveDeviceDescriptor) {
+        memcpy(desc, &device->deviceDescriptor, sizeof(struct USBDeviceDescriptor));
+    } else {
+        /* Enough for the device to be recognized */
+        memset(desc, 0, sizeof(struct USBDeviceDescriptor));
+        desc->bLength = 18;
+        desc->bDescriptorType = 1;
+        desc->idVendor = device->vendorID;
+        desc->idProduct = device->productID;
+        desc->bNumConfigurations = 1;
+    }
+    return 0;
+}
+
+int
+REPLAY_API(USBGetInterfaceDescriptor)(void *deviceHandle, struct USBInterfaceDescriptor *desc) {
+    __replay_device_t *device;
+
+    if(NULL == deviceHandle || NULL == desc) {
+        return -1;
+    }
+
+    device = (__replay_device_t *)deviceHandle;
+    if(0 == device->haveInterfaceDescriptor) {
+        return -1;
+    }
+    memcpy(desc, &device->interfaceDescriptor, sizeof(struct USBInterfaceDescriptor));
+    return 0;
+}
+
+int
+REPLAY_API(USBGetEndpointDescriptor)(void *deviceHandle, int endpoint_index,
+        struct USBEndpointDescriptor *desc) {
+    __replay_device_t *device;
+
+    if(NULL == deviceHandle || NULL == desc || endpoint_index < 0
+            || endpoint_index >= MAX_ENDPOINT_DESCRIPTORS) {
+        return -1;
+    }
+
+    device = (__replay_device_t *)deviceHandle;
+    if(0 == device->haveEndpointDescriptor[endpoint_index]) {
+        return -1;
+    }
+    memcpy(desc, &device->endpointDescriptors[endpoint_index],
+            sizeof(struct USBEndpointDescriptor));
+    return 0;
+}
+
+int
+REPLAY_API(USBGetStringDescriptor)(void *deviceHandle, unsigned int string_index,
+        char *buffer, int maxLength) {
+    __replay_device_t *device;
+    int length;
+
+    if(NULL == deviceHandle || NULL == buffer || maxLength <= 0) {
+        return 0;
+    }
+
+    device = (__replay_device_t *)deviceHandle;
+    if(string_index >= MAX_STRING_DESCRIPTORS || NULL == device->strings[string_index]) {
+        buffer[0] = '\0';
+        return 0;
+    }
+
+    length = (int)strlen(device->strings[string_index]);
+    if(length > maxLength) {
+        length = maxLength;
+    }
+    memcpy(buffer, device->strings[string_index], length);
+    if(length < maxLength) {
+        buffer[length] = '\0';
+    }
+    return length;
+}
+
+
+/* Capture interface.  Records are flushed as they are written so that a
+ * trace is usable even if the process recording it does not exit cleanly.
+ * Each record is formatted first and then written out in one go under
+ * __capture_lock, so devices captured from different threads cannot
+ * interleave their records.
+ */
+static FILE *__capture_open(void) {
+    const char *path;
+
+    pthread_mutex_lock(&__capture_lock);
+    if(0 == __capture_checked) {
+        __capture_checked = 1;
+        path = getenv(USB_CAPTURE_ENV);
+        if(NULL != path && '\0' != path[0]) {
+            __capture_file = fopen(path, "w");
+            if(NULL == __capture_file) {
+                fprintf(stderr, "Could not create USB trace %s\n", path);
+            } else {
+                fprintf(__capture_file, "# SeaBreeze USB trace\n");
+            }
+        }
+    }
+    pthread_mutex_unlock(&__capture_lock);
+    return __capture_file;
+}
+
+static void __capture_line(FILE *file, const char *line, size_t length) {
+    pthread_mutex_lock(&__capture_lock);
+    fwrite(line, 1, length, file);
+    fflush(file);
+    pthread_mutex_unlock(&__capture_lock);
+}
+
+/* Writes prefix followed by the payload in hex, '-' if length is negative
+ * to mark a failed transfer, or '.' if there is no data.
+ */
+static void __capture_payload(const char *prefix, const unsigned char *data, int length) {
+    FILE *file = __capture_open();
+    size_t prefixLength;
+    char *line;
+    char *p;
+    int i;
+
+    if(NULL == file) {
+        return;
+    }
+
+    prefixLength = strlen(prefix);
+    line = (char *)malloc(prefixLength + ((length > 0) ? 2 * (size_t)length : 1) + 1);
+    if(NULL == line) {
+        return;
+    }
+    memcpy(line, prefix, prefixLength);
+    p = line + prefixLength;
+    if(length < 0) {
+        *p++ = '-';
+    } else if(0 == length) {
+        *p++ = '.';
+    } else {
+        for(i = 0; i < length; i++) {
+            *p++ = __hex_digits[data[i] >> 4];
+            *p++ = __hex_digits[data[i] & 0x0F];
+        }
+    }
+    *p++ = '\n';
+
+    __capture_line(file, line, p - line);
+    free(line);
+}
+
+int
+USBCaptureActive(void) {
+    return (NULL != __capture_open()) ? 1 : 0;
+}
+
+void
+USBCaptureDevice(unsigned long deviceID, unsigned short vendorID,
+        unsigned short productID) {
+    FILE *file = __capture_open();
+    char line[128];
+    int length;
+
+    if(NULL == file) {
+        return;
+    }
+    length = snprintf(line, sizeof(line), "device %lu 0x%04x 0x%04x\n",
+            deviceID, vendorID, productID);
+    __capture_line(file, line, length);
+}
+
+void
+USBCaptureDeviceDescriptor(unsigned long deviceID,
+        const struct USBDeviceDescriptor *desc) {
+    FILE *file = __capture_open();
+    char line[256];
+    int length;
+
+    if(NULL == file) {
+        return;
+    }
+    length = snprintf(line, sizeof(line),
+            "devdesc %lu %u %u 0x%04x %u %u %u %u 0x%04x 0x%04x 0x%04x %u %u %u %u\n",
+            deviceID, desc->bLength, desc->bDescriptorType, desc->bcdUSB,
+            desc->bDeviceClass, desc->bDeviceSubClass, desc->bDeviceProtocol,
+            desc->bMaxPacketSize0, desc->idVendor, desc->idProduct,
+            desc->bcdDevice, desc->iManufacturer, desc->iProduct,
+            desc->iSerialNumber, desc->bNumConfigurations);
+    __capture_line(file, line, length);
+}
+
+void
+USBCaptureInterfaceDescriptor(unsigned long deviceID,
+        const struct USBInterfaceDescriptor *desc) {
+    FILE *file = __capture_open();
+    char line[256];
+    int length;
+
+    if(NULL == file) {
+        return;
+    }
+    length = snprintf(line, sizeof(line), "ifdesc %lu %u %u %u %u %u %u %u %u %u\n",
+            deviceID, desc->bLength, desc->bDescriptorType,
+            desc->bInterfaceNumber, desc->bAlternateSetting,
+            desc->bNumEndpoints, desc->bInterfaceClass,
+            desc->bInterfaceSubClass, desc->bInterfaceProtocol,
+            desc->iInterface);
+    __capture_line(file, line, length);
+}
+
+void
+USBCaptureEndpointDescriptor(unsigned long deviceID, int endpoint_index,
+        const struct USBEndpointDescriptor *desc) {
+    FILE *file = __capture_open();
+    char line[256];
+    int length;
+
+    if(NULL == file) {
+        return;
+    }
+    length = snprintf(line, sizeof(line), "epdesc %lu %d %u %u 0x%02x %u %u %u\n",
+            deviceID, endpoint_index, desc->bLength, desc->bDescriptorType,
+            desc->bEndpointAddress, desc->bmAttributes, desc->wMaxPacketSize,
+            desc->bInterval);
+    __capture_line(file, line, length);
+}
+
+void
+USBCaptureStringDescriptor(unsigned long deviceID, unsigned int string_index,
+        const char *buffer, int length) {
+    char prefix[64];
+
+    if(length < 0) {
+        return;
+    }
+    snprintf(prefix, sizeof(prefix), "string %lu %u ", deviceID, string_index);
+    __capture_payload(prefix, (const unsigned char *)buffer, length);
+}
+
+void
+USBCaptureWrite(unsigned long deviceID, unsigned char endpoint,
+        const char *data, int length) {
+    char prefix[64];
+
+    if(length < 0) {
+        return;
+    }
+    snprintf(prefix, sizeof(prefix), "write %lu 0x%02x ", deviceID, endpoint);
+    __capture_payload(prefix, (const unsigned char *)data, length);
+}
+
+void
+USBCaptureRead(unsigned long deviceID, unsigned char endpoint,
+        const char *data, int length) {
+    char prefix[64];
+
+    snprintf(prefix, sizeof(prefix), "read %lu 0x%02x ", deviceID, endpoint);
+    __capture_payload(prefix, (const unsigned char *)data, length);
+}
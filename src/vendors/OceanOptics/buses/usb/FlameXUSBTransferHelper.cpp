@@ -29,7 +29,7 @@
 
 #include "common/globals.h"
 #include "vendors/OceanOptics/buses/usb/FlameXUSBTransferHelper.h"
-#include <string.h> /* for memcpy() */
+#include <string.h> /* for memcpy() and memset() */
 
 using namespace seabreeze;
 using namespace std;
@@ -48,26 +48,31 @@ FlameXUSBTransferHelper::~FlameXUSBTransferHelper() {
 
 int FlameXUSBTransferHelper::receive(vector<byte> &buffer,
         unsigned int length) throw (BusTransferException) {
+    return receiveAt(buffer, 0, length);
+}
+
+int FlameXUSBTransferHelper::receiveAt(vector<byte> &buffer,
+        unsigned int offset, unsigned int length) throw (BusTransferException) {
     if(0 != (length % WORD_SIZE_BYTES)) {
-        vector<byte> *inBuffer;
-        int paddedLength;
+        unsigned int paddedLength;
+        unsigned int scratchOffset;
         
+        /* Read the padded message into scratch and copy out what was asked for */
         paddedLength = length + (WORD_SIZE_BYTES - (length % WORD_SIZE_BYTES));
-        inBuffer = new vector<byte>(paddedLength);
+        scratchOffset = scratchAt(this->receiveScratch, paddedLength);
         
-        int result = USBTransferHelper::receive(*inBuffer, paddedLength);
-        if(result != paddedLength) {
+        int result = USBTransferHelper::receiveAt(this->receiveScratch, scratchOffset, paddedLength);
+        if(result != (int)paddedLength) {
             string error("Failed to read padded message length: ");
             error += (char)result;
             error += " != ";
             error += (char)paddedLength;
             throw BusTransferException(error);
         }
-        memcpy(&buffer[0], &inBuffer[0], length);
-        delete inBuffer;
+        memcpy(&buffer[offset], &(this->receiveScratch[scratchOffset]), length);
         return length;
     } else {
-        return USBTransferHelper::receive(buffer, length);
+        return USBTransferHelper::receiveAt(buffer, offset, length);
     }
 }
 
@@ -76,12 +81,11 @@ int FlameXUSBTransferHelper::send(const std::vector<byte> &buffer,
     
     if(0 != (length % WORD_SIZE_BYTES)) {
         /* Pad up to a multiple of the word size */
-        int paddedLength = length + (WORD_SIZE_BYTES - (length % WORD_SIZE_BYTES));
-        vector<byte> *outBuffer = new vector<byte>(paddedLength);
-        memcpy(&outBuffer[0], &buffer[0], length);
-        int result = USBTransferHelper::send(*outBuffer, paddedLength);
-        delete outBuffer;
-        return result;
+        unsigned int paddedLength = length + (WORD_SIZE_BYTES - (length % WORD_SIZE_BYTES));
+        unsigned int scratchOffset = scratchAt(this->sendScratch, paddedLength);
+        memcpy(&(this->sendScratch[scratchOffset]), &buffer[0], length);
+        memset(&(this->sendScratch[scratchOffset + length]), 0, paddedLength - length);
+        return USBTransferHelper::sendAt(this->sendScratch, scratchOffset, paddedLength);
     } else {
         return USBTransferHelper::send(buffer, length);
     }
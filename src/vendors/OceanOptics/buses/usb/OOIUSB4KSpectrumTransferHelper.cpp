@@ -29,7 +29,6 @@
 
 #include "common/globals.h"
 #include "vendors/OceanOptics/buses/usb/OOIUSB4KSpectrumTransferHelper.h"
-#include <string.h> /* for memcpy() */
 
 /* Note that in this mode, the primary high speed endpoint will
  * generally read 5633 bytes, and the secondary will read
@@ -48,8 +47,7 @@ OOIUSB4KSpectrumTransferHelper::OOIUSB4KSpectrumTransferHelper(USB *usb,
     this->sendEndpoint = map.getLowSpeedOutEP();
     this->receiveEndpoint = map.getHighSpeedInEP();
     this->secondaryHighSpeedEP = map.getHighSpeedIn2EP();
-    this->secondaryReadBuffer.resize(SECONDARY_READ_LENGTH);
-    this->primaryReadBuffer.resize(0);
+    this->primarySubmitted = false;
 }
 
 OOIUSB4KSpectrumTransferHelper::~OOIUSB4KSpectrumTransferHelper() {
@@ -58,67 +56,125 @@ OOIUSB4KSpectrumTransferHelper::~OOIUSB4KSpectrumTransferHelper() {
 
 int OOIUSB4KSpectrumTransferHelper::receive(vector<byte> &buffer,
         unsigned int length) throw (BusTransferException) {
-    size_t bytesRead = 0;
-    size_t bytesToCopy;
+    return receiveAt(buffer, 0, length);
+}
+
+int OOIUSB4KSpectrumTransferHelper::receiveAt(vector<byte> &buffer,
+        unsigned int offset, unsigned int length) throw (BusTransferException) {
+    struct USBReadRequest requests[2];
+    unsigned int secondaryReadLength;
+    unsigned int primaryReadLength;
+    int count = 1;
     int flag;
-    int retval;
-    int primaryReadLength;
 
-    primaryReadLength = length - SECONDARY_READ_LENGTH;
-    if(primaryReadLength < 0) {
-        primaryReadLength = 0;
+    /* Never read past the end of the caller's buffer */
+    if(offset + length > buffer.size()) {
+        length = (offset < buffer.size()) ? (unsigned int) buffer.size() - offset : 0;
     }
-    if(((size_t)primaryReadLength) > this->primaryReadBuffer.size()) {
-        this->primaryReadBuffer.resize(primaryReadLength);
+
+    secondaryReadLength = (length < SECONDARY_READ_LENGTH) ? length : SECONDARY_READ_LENGTH;
+    primaryReadLength = length - secondaryReadLength;
+
+    /* The first 2048 bytes come from the secondary high speed endpoint and
+     * the remainder from the primary one.  Both reads are issued together
+     * and land directly at their final place in the caller's buffer.
+     */
+    requests[0].endpoint = (unsigned char) this->secondaryHighSpeedEP;
+    requests[0].data = (char *) &(buffer[offset]);
+    requests[0].numberOfBytes = (int) secondaryReadLength;
+    requests[0].bytesRead = 0;
+    if(primaryReadLength > 0) {
+        requests[1].endpoint = (unsigned char) this->receiveEndpoint;
+        requests[1].data = (char *) &(buffer[offset + secondaryReadLength]);
+        requests[1].numberOfBytes = (int) primaryReadLength;
+        requests[1].bytesRead = 0;
+        count = 2;
     }
 
-    /* Read the first 2048 bytes from the secondary high speed endpoint. */
-    /* This may throw a BusTransferException. */
-    flag = this->usb->read(this->secondaryHighSpeedEP, &(this->secondaryReadBuffer[0]), SECONDARY_READ_LENGTH, this->timeout);
-    if(flag <= 0) {
+    flag = this->usb->readConcurrent(requests, count, this->timeout);
+    if(requests[0].bytesRead <= 0) {
         string error("Failed to read any data from USB.");
         throw BusTransferException(error);
     }
-    if(flag >= 0) {
-        bytesRead = flag;
-    }
-    /* Read the remainder from the primary high speed endpoint. */
-    /* This may throw a BusTransferException. */
-    flag = this->usb->read(this->receiveEndpoint, &(primaryReadBuffer[0]), primaryReadLength, this->timeout);
-    if(flag <= 0) {
+    if(flag <= 0 || (count > 1 && requests[1].bytesRead <= 0)) {
         string error("Failed to read part of the data from USB.");
         throw BusTransferException(error);
     }
-    if(flag >= 0) {
-        bytesRead += flag;
-    }
 
-    /* Compute the number of bytes to copy as the minimum
-     * of the bytes read, the specified read length, and the
-     * size of the destination buffer.  This will let us keep
-     * track of how much data has been copied from each buffer
-     * and hopefully prevent overruns.
-     */
-    bytesToCopy = (bytesRead < length) ? bytesRead : length;
-    bytesToCopy = (length < buffer.size()) ? length : buffer.size();
+    return (flag < (int) length) ? flag : (int) length;
+}
 
-    retval = (int) bytesToCopy; /* Hold a copy for later */
+unsigned int OOIUSB4KSpectrumTransferHelper::getSingleReadLength() {
+    /* Reads are split across two endpoints, so none ends early */
+    return 0;
+}
+
+void OOIUSB4KSpectrumTransferHelper::setReadQueueDepth(unsigned int depth,
+        bool zeroCopy) throw (BusTransferException) {
 
-    /* Copy the data from the secondary endpoint into the
-     * caller's buffer.
+    /* Both halves of the spectrum need the same treatment, otherwise the
+     * secondary endpoint would still stall the primary one.
      */
-    memcpy(&(buffer[0]), &(this->secondaryReadBuffer[0]),
-            (this->secondaryReadBuffer.size() <= bytesToCopy) ? this->secondaryReadBuffer.size() : bytesToCopy);
-    bytesToCopy -= this->secondaryReadBuffer.size();
+    USBTransferHelper::setReadQueueDepth(depth, zeroCopy);
+
+    if(this->usb->setReadQueueDepth(this->secondaryHighSpeedEP, (int)depth, zeroCopy) < 0) {
+        string error("Failed to set up queued reads on USB endpoint.");
+        throw BusTransferException(error);
+    }
+}
 
-    // if(bytesToCopy < 0) { // size_t doesn't need this
-    //    bytesToCopy = 0;
-    // }
+int OOIUSB4KSpectrumTransferHelper::receiveBorrowed(const byte **data,
+        unsigned int length) throw (BusTransferException) {
 
-    /* Copy the remaining data from the primary buffer */
-    memcpy(&(buffer[this->secondaryReadBuffer.size() * sizeof (byte)]),
-            &(this->primaryReadBuffer[0]),
-            (this->primaryReadBuffer.size() < bytesToCopy) ? this->primaryReadBuffer.size() : bytesToCopy);
+    unsigned int scratchOffset;
+    int retval;
+
+    /* The spectrum is split across two endpoints, so it has to be put
+     * back together in one buffer rather than lent out in place.  That
+     * buffer is the helper's aligned scratch space.
+     */
+    scratchOffset = scratchAt(this->receiveScratch, length);
+    retval = receiveAt(this->receiveScratch, scratchOffset, length);
+    *data = &(this->receiveScratch[scratchOffset]);
 
     return retval;
 }
+
+void OOIUSB4KSpectrumTransferHelper::releaseBorrowed() {
+    /* Nothing to do; scratch is reused on the next receive */
+}
+
+void OOIUSB4KSpectrumTransferHelper::submitReceive(unsigned int length)
+        throw (BusTransferException) {
+    unsigned int secondaryReadLength;
+
+    /* Split the same way as receive() does */
+    secondaryReadLength = (length < SECONDARY_READ_LENGTH) ? length : SECONDARY_READ_LENGTH;
+
+    if(this->usb->submitQueuedRead(this->secondaryHighSpeedEP, secondaryReadLength) < 0) {
+        string error("Failed to queue a read on USB endpoint.");
+        throw BusTransferException(error);
+    }
+
+    this->primarySubmitted = false;
+    if(length > secondaryReadLength) {
+        USBTransferHelper::submitReceive(length - secondaryReadLength);
+        this->primarySubmitted = true;
+    }
+}
+
+bool OOIUSB4KSpectrumTransferHelper::isReceiveReady() throw (BusTransferException) {
+    int retval;
+
+    retval = this->usb->isReadReady(this->secondaryHighSpeedEP);
+    if(retval < 0) {
+        string error("No read has been queued on USB endpoint.");
+        throw BusTransferException(error);
+    }
+
+    if(0 == retval) {
+        return false;
+    }
+
+    return (true == this->primarySubmitted) ? USBTransferHelper::isReceiveReady() : true;
+}
@@ -28,6 +28,7 @@
  *******************************************************/
 
 #include "common/globals.h"
+#include <string.h>
 #include "vendors/OceanOptics/protocols/interfaces/SpectrometerProtocolInterface.h"
 #include "vendors/OceanOptics/features/eeprom_slots/WavelengthEEPROMSlotFeature.h"
 #include "common/exceptions/FeatureProtocolNotFoundException.h"
@@ -35,9 +36,13 @@
 #include "common/buses/usb/USBTransferHelper.h"
 #include "vendors/OceanOptics/protocols/ooi/impls/OOISpectrometerProtocol.h"
 #include "vendors/OceanOptics/protocols/ooi/hints/SpectrumHint.h"
+#include "vendors/OceanOptics/protocols/obp/hints/OBPSpectrumHint.h"
 #include "common/buses/BusFamilies.h"
 #include "api/seabreezeapi/FeatureFamilies.h"
 #include "common/Log.h"
+#include "common/UShortVector.h"
+#include "common/U32Vector.h"
+#include "common/PixelUnpack.h"
 #include "vendors/OceanOptics/features/spectrometer/OOISpectrometerFeature.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPIntegrationTimeExchange.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPReadSpectrumWithGainExchange.h"
@@ -109,6 +114,253 @@ ByteVector *OOISpectrometerFeature::getUnformattedSpectrum(
     return readUnformattedSpectrum(protocol, bus);
 }
 
+SpectrometerAcquisition *OOISpectrometerFeature::resolveAcquisition(
+        const Protocol &protocol, const Bus &bus) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    SpectrometerAcquisition *retval = new SpectrometerAcquisition();
+
+    try {
+        resolveAcquisition(protocol, bus, retval);
+    } catch (FeatureException &fe) {
+        delete retval;
+        throw;
+    }
+
+    return retval;
+}
+
+void OOISpectrometerFeature::resolveAcquisition(const Protocol &protocol,
+        const Bus &bus, SpectrometerAcquisition *acquisition) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    ProtocolHelper *proto;
+    SpectrometerProtocolInterface *spec;
+
+    try {
+        proto = lookupProtocolImpl(protocol);
+        spec = static_cast<SpectrometerProtocolInterface *>(proto);
+    } catch (FeatureProtocolNotFoundException &e) {
+        string error("Could not find matching protocol implementation to resolve an acquisition.");
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureProtocolNotFoundException(error);
+    }
+
+    try {
+        spec->resolveAcquisition(bus, acquisition);
+    } catch (ProtocolException &pe) {
+        string error("Caught protocol exception: ");
+        error += pe.what();
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureControlException(error);
+    }
+}
+
+DoubleVector *OOISpectrometerFeature::getFormattedSpectrum(
+        const SpectrometerAcquisition &acquisition) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    DoubleVector *retval = NULL;
+
+    try {
+        acquisition.protocol->requestFormattedSpectrum(acquisition.requestFormattedHelper);
+        retval = acquisition.protocol->readFormattedSpectrum(acquisition.readFormattedHelper);
+    } catch (ProtocolException &pe) {
+        string error("Caught protocol exception: ");
+        error += pe.what();
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureControlException(error);
+    }
+
+    return retval;
+}
+
+DoubleVector *OOISpectrometerFeature::getFormattedSpectrum(const Protocol &protocol,
+        const Bus &bus, SpectrumStatistics *statistics) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    /* The helpers are only needed for this one acquisition, so they are
+     * kept here rather than in a SpectrometerAcquisition on the heap.
+     */
+    SpectrometerAcquisition acquisition;
+    resolveAcquisition(protocol, bus, &acquisition);
+
+    return getFormattedSpectrum(acquisition, statistics);
+}
+
+DoubleVector *OOISpectrometerFeature::getFormattedSpectrum(
+        const SpectrometerAcquisition &acquisition,
+        SpectrumStatistics *statistics) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    DoubleVector *retval = NULL;
+
+    try {
+        acquisition.protocol->requestFormattedSpectrum(acquisition.requestFormattedHelper);
+        retval = acquisition.protocol->readFormattedSpectrum(acquisition.readFormattedHelper,
+            (double)getMaximumIntensity(), statistics);
+    } catch (ProtocolException &pe) {
+        string error("Caught protocol exception: ");
+        error += pe.what();
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureControlException(error);
+    }
+
+    return retval;
+}
+
+unsigned int OOISpectrometerFeature::getFormattedSpectrum(const Protocol &protocol,
+        const Bus &bus, double *buffer, unsigned int bufferLength)
+        throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    SpectrometerAcquisition acquisition;
+    resolveAcquisition(protocol, bus, &acquisition);
+
+    return getFormattedSpectrum(acquisition, buffer, bufferLength);
+}
+
+unsigned int OOISpectrometerFeature::getFormattedSpectrum(
+        const SpectrometerAcquisition &acquisition, double *buffer,
+        unsigned int bufferLength) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    unsigned int retval = 0;
+
+    try {
+        acquisition.protocol->requestFormattedSpectrum(acquisition.requestFormattedHelper);
+        retval = acquisition.protocol->readFormattedSpectrum(acquisition.readFormattedHelper,
+            buffer, bufferLength);
+    } catch (ProtocolException &pe) {
+        string error("Caught protocol exception: ");
+        error += pe.what();
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureControlException(error);
+    }
+
+    return retval;
+}
+
+unsigned int OOISpectrometerFeature::getFormattedSpectrumAs(const Protocol &protocol,
+        const Bus &bus, PixelFormat format, void *buffer,
+        unsigned int bufferLength) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    SpectrometerAcquisition acquisition;
+    resolveAcquisition(protocol, bus, &acquisition);
+
+    return getFormattedSpectrumAs(acquisition, format, buffer, bufferLength);
+}
+
+unsigned int OOISpectrometerFeature::getFormattedSpectrumAs(
+        const SpectrometerAcquisition &acquisition, PixelFormat format,
+        void *buffer, unsigned int bufferLength) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    Data *result = NULL;
+    unsigned int count = 0;
+
+    try {
+        acquisition.protocol->requestFormattedSpectrum(acquisition.requestFormattedHelper);
+        result = acquisition.protocol->readNativeSpectrum(acquisition.readFormattedHelper);
+    } catch (ProtocolException &pe) {
+        string error("Caught protocol exception: ");
+        error += pe.what();
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureControlException(error);
+    }
+
+    /* Each pixel is converted once, from the type the exchange decoded it
+     * as straight into the caller's buffer.
+     */
+    UShortVector *usv = dynamic_cast<UShortVector *>(result);
+    U32Vector *u32v = dynamic_cast<U32Vector *>(result);
+    DoubleVector *dv = dynamic_cast<DoubleVector *>(result);
+    if(NULL != usv) {
+        vector<unsigned short> &spectrum = usv->getUShortVector();
+        count = ((unsigned int)spectrum.size() < bufferLength) ? (unsigned int)spectrum.size() : bufferLength;
+        if(count > 0) {
+            switch(format) {
+            case PIXEL_UINT16:
+                memcpy(buffer, &(spectrum[0]), count * sizeof(unsigned short));
+                break;
+            case PIXEL_UINT32:
+                PixelUnpack::widenToU32(&(spectrum[0]), (unsigned int *)buffer, count);
+                break;
+            case PIXEL_FLOAT32:
+                PixelUnpack::widenToFloat(&(spectrum[0]), (float *)buffer, count);
+                break;
+            }
+        }
+    } else if(NULL != u32v) {
+        vector<unsigned int> &spectrum = u32v->getU32Vector();
+        count = ((unsigned int)spectrum.size() < bufferLength) ? (unsigned int)spectrum.size() : bufferLength;
+        if(count > 0) {
+            switch(format) {
+            case PIXEL_UINT16:
+                PixelUnpack::convert(&(spectrum[0]), (unsigned short *)buffer, count);
+                break;
+            case PIXEL_UINT32:
+                memcpy(buffer, &(spectrum[0]), count * sizeof(unsigned int));
+                break;
+            case PIXEL_FLOAT32:
+                PixelUnpack::convert(&(spectrum[0]), (float *)buffer, count);
+                break;
+            }
+        }
+    } else if(NULL != dv) {
+        vector<double> &spectrum = dv->getDoubleVector();
+        count = ((unsigned int)spectrum.size() < bufferLength) ? (unsigned int)spectrum.size() : bufferLength;
+        if(count > 0) {
+            switch(format) {
+            case PIXEL_UINT16:
+                PixelUnpack::convert(&(spectrum[0]), (unsigned short *)buffer, count);
+                break;
+            case PIXEL_UINT32:
+                PixelUnpack::convert(&(spectrum[0]), (unsigned int *)buffer, count);
+                break;
+            case PIXEL_FLOAT32:
+                PixelUnpack::convert(&(spectrum[0]), (float *)buffer, count);
+                break;
+            }
+        }
+    } else {
+        delete result;
+        string error("Got unexpected vector type.");
+        logger.error(error.c_str());
+        throw FeatureControlException(error);
+    }
+
+    delete result;
+    return count;
+}
+
+ByteVector *OOISpectrometerFeature::getUnformattedSpectrum(
+        const SpectrometerAcquisition &acquisition) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    ByteVector *retval = NULL;
+
+    try {
+        acquisition.protocol->requestUnformattedSpectrum(acquisition.requestUnformattedHelper);
+        retval = acquisition.protocol->readUnformattedSpectrum(acquisition.readUnformattedHelper);
+    } catch (ProtocolException &pe) {
+        string error("Caught protocol exception: ");
+        error += pe.what();
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureControlException(error);
+    }
+
+    return retval;
+}
+
 ByteVector *OOISpectrometerFeature::getFastBufferSpectrum(
     const Protocol &protocol, const Bus &bus, unsigned int numberOfSamplesToRetrieve) throw (FeatureException)
 {
@@ -264,6 +516,124 @@ ByteVector *OOISpectrometerFeature::readUnformattedSpectrum(const Protocol &prot
     return retval;
 }
 
+int OOISpectrometerFeature::borrowUnformattedSpectrum(const Protocol &protocol,
+        const Bus &bus, const byte **data) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    ProtocolHelper *proto;
+    SpectrometerProtocolInterface *spec;
+
+    try {
+        proto = lookupProtocolImpl(protocol);
+        spec = static_cast<SpectrometerProtocolInterface *>(proto);
+    } catch (FeatureProtocolNotFoundException &e) {
+        string error("Could not find matching protocol implementation to get an unformatted spectrum.");
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureProtocolNotFoundException(error);
+    }
+
+    writeRequestUnformattedSpectrum(protocol, bus);
+
+    int retval;
+
+    try {
+        retval = spec->borrowUnformattedSpectrum(bus, data);
+    } catch (ProtocolException &pe) {
+        string error("Caught protocol exception: ");
+        error += pe.what();
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureControlException(error);
+    }
+
+    return retval;
+}
+
+void OOISpectrometerFeature::releaseUnformattedSpectrum(const Protocol &protocol,
+        const Bus &bus) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    ProtocolHelper *proto;
+    SpectrometerProtocolInterface *spec;
+
+    try {
+        proto = lookupProtocolImpl(protocol);
+        spec = static_cast<SpectrometerProtocolInterface *>(proto);
+    } catch (FeatureProtocolNotFoundException &e) {
+        string error("Could not find matching protocol implementation to release an unformatted spectrum.");
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureProtocolNotFoundException(error);
+    }
+
+    try {
+        spec->releaseUnformattedSpectrum(bus);
+    } catch (ProtocolException &pe) {
+        string error("Caught protocol exception: ");
+        error += pe.what();
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureControlException(error);
+    }
+}
+
+void OOISpectrometerFeature::submitUnformattedSpectrum(const Protocol &protocol,
+        const Bus &bus) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    ProtocolHelper *proto;
+    SpectrometerProtocolInterface *spec;
+
+    try {
+        proto = lookupProtocolImpl(protocol);
+        spec = static_cast<SpectrometerProtocolInterface *>(proto);
+    } catch (FeatureProtocolNotFoundException &e) {
+        string error("Could not find matching protocol implementation to submit an unformatted spectrum request.");
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureProtocolNotFoundException(error);
+    }
+
+    try {
+        spec->submitUnformattedSpectrum(bus);
+    } catch (ProtocolException &pe) {
+        string error("Caught protocol exception: ");
+        error += pe.what();
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureControlException(error);
+    }
+}
+
+bool OOISpectrometerFeature::isUnformattedSpectrumReady(const Protocol &protocol,
+        const Bus &bus) throw (FeatureException) {
+    LOG(__FUNCTION__);
+
+    ProtocolHelper *proto;
+    SpectrometerProtocolInterface *spec;
+
+    try {
+        proto = lookupProtocolImpl(protocol);
+        spec = static_cast<SpectrometerProtocolInterface *>(proto);
+    } catch (FeatureProtocolNotFoundException &e) {
+        string error("Could not find matching protocol implementation to check for an unformatted spectrum.");
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureProtocolNotFoundException(error);
+    }
+
+    try {
+        return spec->isUnformattedSpectrumReady(bus);
+    } catch (ProtocolException &pe) {
+        string error("Caught protocol exception: ");
+        error += pe.what();
+        logger.error(error.c_str());
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw FeatureControlException(error);
+    }
+}
+
 ByteVector *OOISpectrometerFeature::readFastBufferSpectrum(const Protocol &protocol,
     const Bus &bus, unsigned int numberOfSamplesToRetrieve) throw (FeatureException) {
     LOG(__FUNCTION__);
@@ -425,23 +795,44 @@ int OOISpectrometerFeature::getMaximumIntensity() const {
 }
 
 void OOISpectrometerFeature::setTimeout(const Bus &bus, unsigned int timeout) throw (FeatureException) {
+    // Set timeout on helper
+    getSpectrumUSBHelper(bus)->setTimeout(timeout);
+}
+
+void OOISpectrometerFeature::setReadQueueDepth(const Bus &bus, unsigned int depth,
+        bool zeroCopy) throw (FeatureException) {
+    USBTransferHelper *usb_helper = getSpectrumUSBHelper(bus);
+
+    try {
+        usb_helper->setReadQueueDepth(depth, zeroCopy);
+    } catch (BusTransferException &bte) {
+        throw FeatureException("Failed to set read queue depth on spectrum endpoint");
+    }
+}
+
+USBTransferHelper *OOISpectrometerFeature::getSpectrumUSBHelper(const Bus &bus) throw (FeatureException) {
 //     BusFamily bf = bus.getBusFamily();
 //     BusFamilies families;
 //     if(!bf.equals(families.USB))
 //         throw FeatureException("");
 
-    // Create a hints vector
+    // OOI devices read spectra through the SpectrumHint helper, OBP devices
+    // through the OBPSpectrumHint one.
     vector<ProtocolHint *> hints;
-    hints.push_back(new SpectrumHint());
-
-    // Get transfer helper for spectra (SpectrumHint)
     TransferHelper* helper;
-    helper = bus.getHelper(hints);
 
-    // Cleanup hints
+    hints.push_back(new SpectrumHint());
+    helper = bus.getHelper(hints);
     delete hints[0];
     hints.clear();
 
+    if(NULL == helper) {
+        hints.push_back(new oceanBinaryProtocol::OBPSpectrumHint());
+        helper = bus.getHelper(hints);
+        delete hints[0];
+        hints.clear();
+    }
+
     if(NULL == helper) {
         throw FeatureException("Failed to get spectrum transfer helper");
     }
@@ -452,8 +843,7 @@ void OOISpectrometerFeature::setTimeout(const Bus &bus, unsigned int timeout) th
         throw FeatureException("This is supported only on USB spectrometers");
     }
 
-    // Set timeout on helper
-    usb_helper->setTimeout(timeout);
+    return usb_helper;
 }
 
 FeatureFamily OOISpectrometerFeature::getFeatureFamily() {
@@ -45,3 +45,9 @@ bool OBPCommand::sendCommandToDevice(TransferHelper *helper) throw (ProtocolExce
     return OBPTransaction::sendCommandToDevice(helper, this->messageType,
                     this->payload);
 }
+
+unsigned int OBPCommand::submitCommand(OBPPipeline &pipeline)
+        throw (ProtocolException) {
+    return pipeline.submit(this->messageType, OBP_MESSAGE_FLAGS_ACK_REQUESTED,
+                    this->payload);
+}
@@ -0,0 +1,96 @@
+/***************************************************//**
+ * @file    OBPFastBufferSpectra.cpp
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#include "common/globals.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPFastBufferSpectra.h"
+#include <stddef.h>
+
+using namespace seabreeze;
+using namespace seabreeze::oceanBinaryProtocol;
+
+static inline unsigned int __read_le32(const byte *p) {
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8)
+            | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+OBPFastBufferSpectra::OBPFastBufferSpectra(const byte *payload,
+        unsigned int length, unsigned int numberOfPixels,
+        unsigned int bytesPerPixel) {
+    this->payload = payload;
+    this->numberOfPixels = numberOfPixels;
+    this->bytesPerPixel = bytesPerPixel;
+    this->recordLength = getRecordLength(numberOfPixels, bytesPerPixel);
+    this->count = (NULL == payload) ? 0 : length / this->recordLength;
+}
+
+OBPFastBufferSpectra::~OBPFastBufferSpectra() {
+
+}
+
+unsigned int OBPFastBufferSpectra::getRecordLength(unsigned int numberOfPixels,
+        unsigned int bytesPerPixel) {
+    return OBP_FAST_BUFFER_METADATA_LENGTH + (numberOfPixels * bytesPerPixel)
+            + OBP_FAST_BUFFER_CHECKSUM_LENGTH;
+}
+
+unsigned int OBPFastBufferSpectra::size() const {
+    return this->count;
+}
+
+unsigned int OBPFastBufferSpectra::getNumberOfPixels() const {
+    return this->numberOfPixels;
+}
+
+unsigned int OBPFastBufferSpectra::getBytesPerPixel() const {
+    return this->bytesPerPixel;
+}
+
+void OBPFastBufferSpectra::getSpectrum(unsigned int index,
+        OBPFastBufferSpectrum *spectrum) const {
+    const byte *record = this->payload + (index * this->recordLength);
+    const byte *tick = record + OBP_FAST_BUFFER_TICK_COUNT_OFFSET;
+
+    spectrum->metadata = record;
+    spectrum->spectrumCount = __read_le32(record + OBP_FAST_BUFFER_SPECTRUM_COUNT_OFFSET);
+    spectrum->tickCount = (unsigned long long)__read_le32(tick)
+            | ((unsigned long long)__read_le32(tick + 4) << 32);
+    spectrum->integrationTimeMicros = __read_le32(record + OBP_FAST_BUFFER_INTEGRATION_TIME_OFFSET);
+    spectrum->triggerMode = record[OBP_FAST_BUFFER_TRIGGER_MODE_OFFSET];
+    spectrum->pixels = record + OBP_FAST_BUFFER_METADATA_LENGTH;
+    spectrum->checksum = __read_le32(spectrum->pixels
+            + (this->numberOfPixels * this->bytesPerPixel));
+}
+
+OBPFastBufferSpectra::const_iterator OBPFastBufferSpectra::begin() const {
+    return const_iterator(this, 0);
+}
+
+OBPFastBufferSpectra::const_iterator OBPFastBufferSpectra::end() const {
+    return const_iterator(this, this->count);
+}
@@ -51,17 +51,16 @@ unsigned int OBPGetConsecutiveSampleCountExchange::queryConsecutiveSampleCount(
         TransferHelper *helper) throw (ProtocolException) {
 
     unsigned int consecutiveSampleCount;
-    vector<byte> *result;
+    const byte *result = NULL;
+    int resultLength;
 
-    result = this->queryDevice(helper);
-    if(NULL == result || result->size() < sizeof(unsigned int)) {
+    resultLength = this->queryDeviceInPlace(helper, &result);
+    if(resultLength < (int)sizeof(unsigned int)) {
         throw ProtocolException("Got a short read when querying consecutive sample count.");
     }
 
     // cast of a byte pointer(data) to an unsigned integer pointer which is dereferenced
-    consecutiveSampleCount = *(unsigned int *)((*result).data()); 
-
-    delete result;
+    consecutiveSampleCount = *(unsigned int *)result; 
 
     return consecutiveSampleCount;
 }
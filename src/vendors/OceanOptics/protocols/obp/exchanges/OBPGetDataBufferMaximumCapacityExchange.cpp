@@ -51,19 +51,18 @@ unsigned long OBPGetDataBufferMaximumCapacityExchange::queryBufferMaximumCapacit
         TransferHelper *helper) throw (ProtocolException) {
 
     unsigned long maxCapacity;
-    vector<byte> *result;
+    const byte *result = NULL;
+    int resultLength;
 
-    result = this->queryDevice(helper);
-    if(NULL == result || result->size() < 4) {
+    resultLength = this->queryDeviceInPlace(helper, &result);
+    if(resultLength < 4) {
         throw ProtocolException("Got a short read when querying maxCapacity.");
     }
 
-    maxCapacity = (    ((*result)[0] & 0x00FF)
-                    | (((*result)[1] & 0x00FF) << 8)
-                    | (((*result)[2] & 0x00FF) << 16)
-                    | (((*result)[3] & 0x00FF) << 24));
-
-    delete result;
+    maxCapacity = (    (result[0] & 0x00FF)
+                    | ((result[1] & 0x00FF) << 8)
+                    | ((result[2] & 0x00FF) << 16)
+                    | ((result[3] & 0x00FF) << 24));
 
     return maxCapacity;
 }
@@ -51,16 +51,15 @@ unsigned char OBPGetFastBufferingEnableExchange::queryBufferingEnable(
         TransferHelper *helper) throw (ProtocolException) {
 
     unsigned char isEnabled;
-    vector<byte> *result;
+    const byte *result = NULL;
+    int resultLength;
 
-    result = this->queryDevice(helper);
-    if(NULL == result || result->size() < 1) {
+    resultLength = this->queryDeviceInPlace(helper, &result);
+    if(resultLength < 1) {
         throw ProtocolException("Got a short read when querying buffering data enable.");
     }
 
-    isEnabled = ((*result)[0] & 0x00FF);
-
-    delete result;
+    isEnabled = (result[0] & 0x00FF);
 
     return isEnabled;
 }
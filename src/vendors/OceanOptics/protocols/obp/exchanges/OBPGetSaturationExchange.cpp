@@ -53,22 +53,18 @@ unsigned int OBPGetSaturationExchange::querySaturationLevel(
         TransferHelper *helper) throw (ProtocolException) {
 
     unsigned int saturation;
-    vector<byte> *result;
+    const byte *result = NULL;
+    int resultLength;
 
-    result = this->queryDevice(helper);
-    if(NULL == result || result->size() < 4) {
-        if(NULL != result) {
-            delete result;
-        }
+    resultLength = this->queryDeviceInPlace(helper, &result);
+    if(resultLength < 4) {
         throw ProtocolException("Got a short read when querying saturation level.");
     }
 
-    saturation = (     ((*result)[0] & 0x00FF)
-                    | (((*result)[1] & 0x00FF) << 8)
-                    | (((*result)[2] & 0x00FF) << 16)
-                    | (((*result)[3] & 0x00FF) << 24));
-
-    delete result;
+    saturation = (     (result[0] & 0x00FF)
+                    | ((result[1] & 0x00FF) << 8)
+                    | ((result[2] & 0x00FF) << 16)
+                    | ((result[3] & 0x00FF) << 24));
 
     return saturation;
 }
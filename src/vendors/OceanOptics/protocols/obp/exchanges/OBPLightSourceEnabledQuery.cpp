@@ -57,19 +57,18 @@ bool OBPLightSourceEnabledQuery::queryEnable(TransferHelper *helper)
             throw (ProtocolException) {
 
     bool retval;
-    vector<byte> *result;
+    const byte *result = NULL;
+    int resultLength;
 
     this->payload[0] = (byte)this->moduleIndex;
     this->payload[1] = (byte)this->lightSourceIndex;
 
-    result = this->queryDevice(helper);
-    if(NULL == result || result->size() < 1) {
+    resultLength = this->queryDeviceInPlace(helper, &result);
+    if(resultLength < 1) {
         throw ProtocolException("Got back no data when trying to get enable status");
     }
 
-    retval = (*result)[0] == 0 ? false : true;
-
-    delete result;
+    retval = result[0] == 0 ? false : true;
 
     return retval;
 }
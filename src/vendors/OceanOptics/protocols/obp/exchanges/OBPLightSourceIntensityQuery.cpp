@@ -57,29 +57,26 @@ OBPLightSourceIntensityQuery::~OBPLightSourceIntensityQuery() {
 float OBPLightSourceIntensityQuery::queryIntensity(TransferHelper *helper)
         throw (ProtocolException) {
 
-    vector<byte>::iterator iter;
     float retval = 0;
     unsigned int i;
     byte *cptr = NULL;
-    vector<byte> *result;
+    const byte *result = NULL;
+    int resultLength;
 
     this->payload[0] = (byte)this->moduleIndex;
     this->payload[1] = (byte)this->lightSourceIndex;
 
-    result = this->queryDevice(helper);
-    if(NULL == result || result->size() < sizeof(float)) {
+    resultLength = this->queryDeviceInPlace(helper, &result);
+    if(resultLength < (int)sizeof(float)) {
         throw ProtocolException("Got back no data when trying to get enable status");
     }
 
     cptr = (byte *)&retval;
 
-    for(iter = result->begin(), i = 0;
-                iter != result->end() && i < sizeof(float); iter++, i++) {
+    for(i = 0; i < sizeof(float); i++) {
         /* FIXME: this assumes the host is little-endian.  Is this safe? */
-        cptr[i] = *iter;
+        cptr[i] = result[i];
     }
 
-    delete result;
-
     return retval;
 }
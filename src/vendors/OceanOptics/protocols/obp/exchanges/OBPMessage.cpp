@@ -39,14 +39,11 @@
 #include "common/globals.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPMessage.h"
 
+#include <string.h>
+
 #define OBP_MESSAGE_IMMEDIATE_PAYLOAD_LENGTH 16
 #define OBP_MESSAGE_CHECKSUM_LENGTH 16
-
-#define OBP_MESSAGE_FLAGS_RESPONSE      (1 << 0)
-#define OBP_MESSAGE_FLAGS_ACK           (1 << 1)
-#define OBP_MESSAGE_FLAGS_ACK_REQUESTED (1 << 2)
-#define OBP_MESSAGE_FLAGS_NACK          (1 << 3)
-#define OBP_MESSAGE_FLAGS_EXCEPTION     (1 << 4)
+#define OBP_MESSAGE_PROTOCOL_VERSION 0x1100
 
 using namespace seabreeze;
 using namespace oceanBinaryProtocol;
@@ -294,6 +291,154 @@ vector<byte> *OBPMessage::toByteStream()
     return retval;
 }
 
+unsigned int OBPMessage::writeByteStream(vector<byte> &stream,
+        unsigned int messageType, unsigned short flags,
+        unsigned int regarding, const byte *data, unsigned int dataLength)
+{
+    static const byte footer[4] = { 0xC5, 0xC4, 0xC3, 0xC2 };
+    unsigned int length = OBP_MESSAGE_OVERHEAD_LENGTH;
+    unsigned int payloadLength = 0;
+    unsigned int bytesRemaining;
+    byte *out;
+
+    /* As with setData(), short data goes in the immediate field */
+    if(dataLength > OBP_MESSAGE_IMMEDIATE_PAYLOAD_LENGTH)
+    {
+        payloadLength = dataLength;
+        length += payloadLength;
+    }
+    bytesRemaining = payloadLength + OBP_MESSAGE_TRAILER_LENGTH;
+
+    if(stream.size() < length)
+    {
+        stream.resize(length);
+    }
+    out = &(stream[0]);
+    memset(out, 0, OBP_MESSAGE_HEADER_LENGTH);
+
+    out[0] = 0xC1;
+    out[1] = 0xC0;
+    out[2] = OBP_MESSAGE_PROTOCOL_VERSION & 0x00FF;
+    out[3] = (OBP_MESSAGE_PROTOCOL_VERSION >> 8) & 0x00FF;
+    out[4] = flags & 0x00FF;
+    out[5] = (flags >> 8) & 0x00FF;
+    out[8] = messageType & 0x00FF;
+    out[9] = (messageType >> 8) & 0x00FF;
+    out[10] = (messageType >> 16) & 0x00FF;
+    out[11] = (messageType >> 24) & 0x00FF;
+    out[12] = regarding & 0x00FF;
+    out[13] = (regarding >> 8) & 0x00FF;
+    out[14] = (regarding >> 16) & 0x00FF;
+    out[15] = (regarding >> 24) & 0x00FF;
+    if(0 == payloadLength && dataLength > 0)
+    {
+        out[23] = (byte)dataLength;
+        memcpy(out + 24, data, dataLength);
+    }
+    out[40] = bytesRemaining & 0x00FF;
+    out[41] = (bytesRemaining >> 8) & 0x00FF;
+    out[42] = (bytesRemaining >> 16) & 0x00FF;
+    out[43] = (bytesRemaining >> 24) & 0x00FF;
+
+    if(payloadLength > 0)
+    {
+        memcpy(out + OBP_MESSAGE_HEADER_LENGTH, data, payloadLength);
+    }
+    /* Checksum (zero for now) and footer */
+    memset(out + OBP_MESSAGE_HEADER_LENGTH + payloadLength, 0,
+        OBP_MESSAGE_CHECKSUM_LENGTH);
+    memcpy(out + length - sizeof(footer), footer, sizeof(footer));
+
+    return length;
+}
+
+void OBPMessage::patchData(byte *stream, const byte *data,
+        unsigned int dataLength)
+{
+    if(dataLength > OBP_MESSAGE_IMMEDIATE_PAYLOAD_LENGTH)
+    {
+        memcpy(stream + OBP_MESSAGE_HEADER_LENGTH, data, dataLength);
+    }
+    else if(dataLength > 0)
+    {
+        memcpy(stream + 24, data, dataLength);
+    }
+}
+
+void OBPMessage::parseHeader(const byte *message, OBPHeader *header)
+        throw (IllegalArgumentException)
+{
+    if(0xC1 != message[0] || 0xC0 != message[1])
+    {
+        string errorMessage("Could not find message header");
+        throw IllegalArgumentException(errorMessage);
+    }
+
+    header->protocolVersion = (message[2] & 0x00FF)
+                           | ((message[3] & 0x00FF) << 8);
+    header->flags = (message[4] & 0x00FF)
+                 | ((message[5] & 0x00FF) << 8);
+    header->errorNumber = (message[6] & 0x00FF)
+                       | ((message[7] & 0x00FF) << 8);
+    header->messageType = (message[8] & 0x00FF)
+                       | ((message[9] & 0x00FF) << 8)
+                       | ((message[10] & 0x00FF) << 16)
+                       | ((message[11] & 0x00FF) << 24);
+    header->regarding = (message[12] & 0x00FF)
+                     | ((message[13] & 0x00FF) << 8)
+                     | ((message[14] & 0x00FF) << 16)
+                     | ((message[15] & 0x00FF) << 24);
+    header->checksumType = message[22];
+    header->immediateDataLength = message[23];
+    header->bytesRemaining = (message[40] & 0x00FF)
+                          | ((message[41] & 0x00FF) << 8)
+                          | ((message[42] & 0x00FF) << 16)
+                          | ((message[43] & 0x00FF) << 24);
+    if(header->bytesRemaining < OBP_MESSAGE_TRAILER_LENGTH)
+    {
+        string errorMessage("Invalid bytes remaining field");
+        throw IllegalArgumentException(errorMessage);
+    }
+}
+
+unsigned int OBPMessage::findData(const byte *message, unsigned int length,
+        const OBPHeader &header, const byte **data)
+        throw (IllegalArgumentException)
+{
+    unsigned int payloadLength = header.bytesRemaining - OBP_MESSAGE_TRAILER_LENGTH;
+
+    if(length < OBP_MESSAGE_HEADER_LENGTH + header.bytesRemaining)
+    {
+        string errorMessage("OBP Message Error: Could not parse message. Bytes remaining did not match message size.");
+        throw IllegalArgumentException(errorMessage);
+    }
+
+    checkTrailer(message + OBP_MESSAGE_HEADER_LENGTH + payloadLength);
+
+    /* Same precedence as getData() */
+    if(header.immediateDataLength > 0)
+    {
+        *data = message + 24;
+        return (header.immediateDataLength < OBP_MESSAGE_IMMEDIATE_PAYLOAD_LENGTH)
+            ? header.immediateDataLength : OBP_MESSAGE_IMMEDIATE_PAYLOAD_LENGTH;
+    }
+    *data = message + OBP_MESSAGE_HEADER_LENGTH;
+    return payloadLength;
+}
+
+void OBPMessage::checkTrailer(const byte *trailer)
+        throw (IllegalArgumentException)
+{
+    /* As when parsing a whole message, the checksum is not verified */
+    const byte *footer = trailer + OBP_MESSAGE_TRAILER_LENGTH - 4;
+
+    if(0xC5 != footer[0] || 0xC4 != footer[1] || 0xC3 != footer[2] || 0xC2 != footer[3])
+    {
+        string errorMessage("Could not find message footer");
+        throw IllegalArgumentException(errorMessage);
+    }
+}
+
 vector<byte> *OBPMessage::getData() 
 {
     if(0 != this->immediateData && 0 != this->immediateDataLength) 
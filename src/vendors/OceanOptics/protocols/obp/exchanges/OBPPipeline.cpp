@@ -0,0 +1,291 @@
+/***************************************************//**
+ * @file    OBPPipeline.cpp
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * An OBPPipeline lets one caller have several OBP requests
+ * outstanding on a device at once, matching replies to
+ * requests by the "regarding" token.  Only batches use it.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#include "common/globals.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPPipeline.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPTransaction.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPTransport.h"
+
+#ifdef _WINDOWS
+#pragma warning (disable: 4101) // unreferenced local variable
+#endif
+
+using namespace seabreeze;
+using namespace seabreeze::oceanBinaryProtocol;
+using namespace std;
+
+OBPPipeline::OBPPipeline(TransferHelper *helper, unsigned int maximumInFlight) {
+    unsigned int i;
+
+    this->helper = helper;
+    this->nextToken = 1;
+    this->nextOrder = 0;
+    this->inFlight = 0;
+
+    /* The requests are allocated once so that replies can be pointed into
+     * them without being moved by later growth.
+     */
+    this->requests.resize((0 == maximumInFlight) ? 1 : maximumInFlight);
+    for(i = 0; i < this->requests.size(); i++) {
+        this->requests[i].token = 0;
+        this->requests[i].inFlight = false;
+        this->requests[i].arrived = false;
+    }
+}
+
+OBPPipeline::~OBPPipeline() {
+
+}
+
+unsigned int OBPPipeline::submit(unsigned int messageType, unsigned short flags,
+        const vector<byte> &data) throw (ProtocolException) {
+    Request *request = NULL;
+    unsigned int length;
+    unsigned int i;
+    int flag = 0;
+
+    /* A request whose reply has been collected (or never will be) is free */
+    for(i = 0; i < this->requests.size(); i++) {
+        if(false == this->requests[i].inFlight) {
+            request = &(this->requests[i]);
+            break;
+        }
+    }
+    if(NULL == request) {
+        string error("Too many OBP requests in flight; collect some replies first.");
+        throw ProtocolException(error);
+    }
+
+    request->token = this->nextToken++;
+    if(0 == this->nextToken) {
+        this->nextToken = 1;   /* Zero means the device did not echo a token */
+    }
+    request->messageType = messageType;
+    request->order = this->nextOrder++;
+    request->arrived = false;
+    request->refused = false;
+    request->dataOffset = 0;
+    request->dataLength = 0;
+
+    if(true == OBPTransaction::invalidatesCache(messageType)) {
+        OBPTransport::getTransport(this->helper)->getReplyCache().clear();
+    }
+
+    length = OBPMessage::writeByteStream(this->frame, messageType, flags,
+        request->token, (true == data.empty()) ? NULL : &(data[0]),
+        (unsigned) data.size());
+
+    try {
+        flag = this->helper->send(this->frame, length);
+        if(((unsigned int)flag) != length) {
+            /* FIXME: retry, throw exception, something here */
+        }
+    } catch (BusException &be) {
+        string error("Failed to write to bus.");
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw ProtocolException(error);
+    }
+
+    request->inFlight = true;
+    this->inFlight++;
+
+    return request->token;
+}
+
+int OBPPipeline::collect(unsigned int token, const byte **reply)
+        throw (ProtocolException) {
+    Request *request = findRequest(token);
+
+    if(NULL == request) {
+        string error("No OBP request in flight with the given token.");
+        throw ProtocolException(error);
+    }
+
+    while(false == request->arrived) {
+        receiveReply();
+    }
+
+    request->inFlight = false;
+    this->inFlight--;
+
+    if(true == request->refused) {
+        return -1;
+    }
+    *reply = &(request->message[request->dataOffset]);
+    return (int)request->dataLength;
+}
+
+unsigned int OBPPipeline::getNumberInFlight() const {
+    return this->inFlight;
+}
+
+unsigned int OBPPipeline::drain(unsigned int timeoutMillis) throw() {
+    unsigned int previousTimeout = 0;
+    unsigned int waiting = 0;
+    unsigned int drained = 0;
+    unsigned int i;
+
+    for(i = 0; i < this->requests.size(); i++) {
+        if(true == this->requests[i].inFlight && false == this->requests[i].arrived) {
+            waiting++;
+        }
+    }
+
+    if(waiting > 0 && true == this->helper->setReceiveTimeout(timeoutMillis,
+            &previousTimeout)) {
+        try {
+            while(drained < waiting) {
+                receiveReply();
+                drained++;
+            }
+        } catch (ProtocolException &pe) {
+            /* Nothing more arrived in time, or it could not be matched */
+        }
+        this->helper->setReceiveTimeout(previousTimeout, &previousTimeout);
+    }
+
+    for(i = 0; i < this->requests.size(); i++) {
+        this->requests[i].inFlight = false;
+        this->requests[i].arrived = false;
+    }
+    this->inFlight = 0;
+
+    return drained;
+}
+
+void OBPPipeline::receiveReply() throw (ProtocolException) {
+    OBPHeader header;
+    Request *request;
+    unsigned int length;
+    unsigned int readLength;
+    unsigned int received;
+    const byte *data = NULL;
+    int flag = 0;
+
+    /* Every reply starts with a 64-byte block holding its header.  Where the
+     * bus allows, the first read takes in as much as it can without waiting,
+     * which is all of most replies.
+     */
+    readLength = OBPTransport::getTransport(this->helper)->getHeaderReadLength();
+    if(this->scratch.size() < readLength) {
+        this->scratch.resize(readLength);
+    }
+
+    try {
+        flag = this->helper->receive(this->scratch, readLength);
+        if(flag < OBP_MESSAGE_OVERHEAD_LENGTH) {
+            /* FIXME: retry, throw exception, something here */
+        }
+        received = (flag > 0) ? (unsigned int)flag : 0;
+        try {
+            OBPMessage::parseHeader(&(this->scratch[0]), &header);
+        } catch (IllegalArgumentException &iae) {
+            string error("Lost synchronization with OBP replies.");
+            throw ProtocolException(error);
+        }
+
+        request = matchReply(header);
+        if(NULL == request) {
+            string error("Got an OBP reply that no request in flight was waiting for.");
+            throw ProtocolException(error);
+        }
+
+        /* The reply becomes the request's message by trading buffers, and
+         * anything still to come is read in after what has arrived.
+         */
+        length = OBP_MESSAGE_OVERHEAD_LENGTH + header.bytesRemaining
+            - OBP_MESSAGE_TRAILER_LENGTH;
+        request->message.swap(this->scratch);
+        if(received < length) {
+            if(request->message.size() < length) {
+                request->message.resize(length);
+            }
+            flag = this->helper->receiveAt(request->message, received,
+                length - received);
+            if(((unsigned int)flag) != length - received) {
+                /* FIXME: retry, throw exception, something here */
+            }
+        }
+    } catch (BusException &be) {
+        string error("Failed to read from bus.");
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw ProtocolException(error);
+    }
+
+    request->arrived = true;
+    if(0 != (header.flags & OBP_MESSAGE_FLAGS_NACK)) {
+        request->refused = true;
+        return;
+    }
+
+    try {
+        request->dataLength = OBPMessage::findData(&(request->message[0]),
+            length, header, &data);
+        request->dataOffset = (unsigned int)(data - &(request->message[0]));
+    } catch (IllegalArgumentException &iae) {
+        string error("Failed to parse extended message");
+        throw ProtocolException(error);
+    }
+}
+
+OBPPipeline::Request *OBPPipeline::findRequest(unsigned int token) {
+    unsigned int i;
+
+    for(i = 0; i < this->requests.size(); i++) {
+        if(true == this->requests[i].inFlight && token == this->requests[i].token) {
+            return &(this->requests[i]);
+        }
+    }
+    return NULL;
+}
+
+OBPPipeline::Request *OBPPipeline::matchReply(const OBPHeader &header) {
+    Request *oldest = NULL;
+    unsigned int i;
+
+    for(i = 0; i < this->requests.size(); i++) {
+        Request *r = &(this->requests[i]);
+        if(false == r->inFlight || true == r->arrived
+                || r->messageType != header.messageType) {
+            continue;
+        }
+        if(0 != header.regarding) {
+            if(header.regarding == r->token) {
+                return r;
+            }
+        } else if(NULL == oldest || r->order < oldest->order) {
+            oldest = r;
+        }
+    }
+    return oldest;
+}
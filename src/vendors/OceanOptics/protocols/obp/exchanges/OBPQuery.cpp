@@ -45,3 +45,14 @@ vector<byte> *OBPQuery::queryDevice(TransferHelper *helper) throw (ProtocolExcep
     return OBPTransaction::queryDevice(helper, this->messageType,
                     this->payload);
 }
+
+int OBPQuery::queryDeviceInPlace(TransferHelper *helper, const byte **reply)
+        throw (ProtocolException) {
+    return OBPTransaction::queryDeviceInPlace(helper, this->messageType,
+                    this->payload, reply);
+}
+
+unsigned int OBPQuery::submitQuery(OBPPipeline &pipeline)
+        throw (ProtocolException) {
+    return pipeline.submit(this->messageType, 0, this->payload);
+}
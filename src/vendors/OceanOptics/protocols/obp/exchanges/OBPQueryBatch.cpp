@@ -0,0 +1,169 @@
+/***************************************************//**
+ * @file    OBPQueryBatch.cpp
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * An OBPQueryBatch runs a list of OBP queries against one
+ * device through an OBPPipeline, writing the requests
+ * back-to-back and draining the replies in order.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#include "common/globals.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPQueryBatch.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPTransport.h"
+#include "vendors/OceanOptics/protocols/obp/hints/OBPControlHint.h"
+
+using namespace seabreeze;
+using namespace seabreeze::oceanBinaryProtocol;
+using namespace std;
+
+OBPQueryBatch::OBPQueryBatch(unsigned int maximumInFlight) {
+    this->numberOfEntries = 0;
+    this->maximumInFlight = (0 == maximumInFlight) ? 1 : maximumInFlight;
+    this->pipeline = NULL;
+    this->pipelineHelper = NULL;
+
+    this->hints->push_back(new OBPControlHint());
+}
+
+OBPQueryBatch::~OBPQueryBatch() {
+    delete this->pipeline;
+}
+
+unsigned int OBPQueryBatch::add(const OBPQuery &query) {
+    return add(query.messageType, query.payload);
+}
+
+unsigned int OBPQueryBatch::add(unsigned int messageType,
+        const vector<byte> &payload) {
+    /* Entries past numberOfEntries are left over from before the last
+     * clear(), and are reused so that their reply buffers are kept.
+     */
+    if(this->numberOfEntries == this->entries.size()) {
+        this->entries.resize(this->numberOfEntries + 1);
+    }
+
+    Entry &entry = this->entries[this->numberOfEntries];
+    entry.messageType = messageType;
+    entry.payload = payload;
+    entry.token = 0;
+    entry.refused = false;
+    entry.reply.clear();
+
+    return this->numberOfEntries++;
+}
+
+void OBPQueryBatch::clear() {
+    this->numberOfEntries = 0;
+}
+
+unsigned int OBPQueryBatch::getNumberOfQueries() const {
+    return this->numberOfEntries;
+}
+
+void OBPQueryBatch::run(TransferHelper *helper) throw (ProtocolException) {
+    ReplyCache &cache = OBPTransport::getTransport(helper)->getReplyCache();
+    const byte *reply = NULL;
+    unsigned int submitted = 0;
+    unsigned int inFlight = 0;
+    unsigned int i;
+    int length;
+
+    if(NULL == this->pipeline || helper != this->pipelineHelper) {
+        delete this->pipeline;
+        this->pipeline = new OBPPipeline(helper, this->maximumInFlight);
+        this->pipelineHelper = helper;
+    }
+
+    /* Anything already in the cache is answered from there and marked
+     * with a zero token so that it is not sent.
+     */
+    for(i = 0; i < this->numberOfEntries; i++) {
+        Entry &entry = this->entries[i];
+        entry.token = 1;
+        if(true == OBPTransaction::isCacheable(entry.messageType)) {
+            length = cache.lookup(entry.messageType, entry.payload, &reply);
+            if(length >= 0) {
+                entry.token = 0;
+                entry.refused = false;
+                entry.reply.assign(reply, reply + length);
+            }
+        }
+    }
+
+    try {
+        for(i = 0; i < this->numberOfEntries; i++) {
+            /* Keep the pipeline full, so the device always has the next
+             * request in hand by the time it has answered one.
+             */
+            while(submitted < this->numberOfEntries
+                    && inFlight < this->maximumInFlight) {
+                Entry &next = this->entries[submitted++];
+                if(0 != next.token) {
+                    next.token = this->pipeline->submit(next.messageType, 0,
+                        next.payload);
+                    inFlight++;
+                }
+            }
+
+            Entry &entry = this->entries[i];
+            if(0 == entry.token) {
+                continue;
+            }
+
+            /* The reply only stays put until the next submit, so it is
+             * copied out first.
+             */
+            length = this->pipeline->collect(entry.token, &reply);
+            inFlight--;
+            if(length < 0) {
+                entry.refused = true;
+                entry.reply.clear();
+            } else {
+                entry.refused = false;
+                entry.reply.assign(reply, reply + length);
+                if(true == OBPTransaction::isCacheable(entry.messageType)) {
+                    cache.store(entry.messageType, entry.payload, reply, length);
+                }
+            }
+        }
+    } catch (ProtocolException &pe) {
+        /* Up to inFlight replies may still be coming.  Left unread, the
+         * next exchange on this helper would take the first of them for
+         * its own reply.
+         */
+        this->pipeline->drain(OBP_PIPELINE_DRAIN_TIMEOUT_MILLIS);
+        throw;
+    }
+}
+
+const vector<byte> &OBPQueryBatch::getReply(unsigned int index) const {
+    return this->entries[index].reply;
+}
+
+bool OBPQueryBatch::wasRefused(unsigned int index) const {
+    return this->entries[index].refused;
+}
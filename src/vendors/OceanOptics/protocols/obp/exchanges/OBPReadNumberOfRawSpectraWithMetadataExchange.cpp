@@ -33,6 +33,7 @@
 #include "vendors/OceanOptics/protocols/obp/hints/OBPSpectrumHint.h"
 #include "vendors/OceanOptics/protocols/obp/constants/OBPMessageTypes.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPMessage.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPFastBufferSpectra.h"
 #include "common/ByteVector.h"
 
 using namespace seabreeze;
@@ -44,7 +45,6 @@ using std::vector;
 #pragma warning (disable: 4101) // unreferenced local variable
 #endif
 
-#define METADATA_LENGTH         64
 #define OBP_MESSAGE_OVERHEAD    64
 
 OBPReadNumberOfRawSpectraWithMetadataExchange::OBPReadNumberOfRawSpectraWithMetadataExchange(unsigned int pixels, unsigned int numberOfBytesPerPixel) 
@@ -56,8 +56,8 @@ OBPReadNumberOfRawSpectraWithMetadataExchange::OBPReadNumberOfRawSpectraWithMeta
     this->hints->push_back(new OBPSpectrumHint());
     this->direction = Transfer::FROM_DEVICE;
 
-    this->metadataLength = METADATA_LENGTH;
-    this->checkSumLength = sizeof(unsigned int);
+    this->metadataLength = OBP_FAST_BUFFER_METADATA_LENGTH;
+    this->checkSumLength = OBP_FAST_BUFFER_CHECKSUM_LENGTH;
     setNumberOfPixels(pixels);
     setNumberOfBytesPerPixel(numberOfBytesPerPixel);
 
@@ -93,22 +93,24 @@ unsigned int OBPReadNumberOfRawSpectraWithMetadataExchange::isLegalMessageType(u
     return 0;
 }
 
-#define OBP_PAYLOAD_START 44
-
 Data *OBPReadNumberOfRawSpectraWithMetadataExchange::transfer(TransferHelper *helper)
         throw (ProtocolException) 
 {
-    Data *xfer;
-    OBPMessage *message = NULL;
-    vector<byte> *bytes;
-    vector<byte> obpHeader(OBP_PAYLOAD_START, 0);
+    OBPHeader header;
+    ByteVector *retval;
+    unsigned int payloadLength;
     int flag = 0;
 
+    if(this->buffer->size() < OBP_MESSAGE_HEADER_LENGTH)
+    {
+        this->buffer->resize(OBP_MESSAGE_HEADER_LENGTH);
+    }
+
     // this particular call can return less than the number of bytes requested and still be valid.
     //  read the OBP header first, then request the remaining bytes.
     try {
-        flag = helper->receive(obpHeader, OBP_PAYLOAD_START);
-        if(((unsigned int)flag) != OBP_PAYLOAD_START) {
+        flag = helper->receive(*(this->buffer), OBP_MESSAGE_HEADER_LENGTH);
+        if(((unsigned int)flag) != OBP_MESSAGE_HEADER_LENGTH) {
             /* FIXME: retry, throw exception, something here */
         }
     } catch (BusException &be) {
@@ -118,61 +120,61 @@ Data *OBPReadNumberOfRawSpectraWithMetadataExchange::transfer(TransferHelper *he
         throw ProtocolException(error);
     }
 
-    this->length = *reinterpret_cast<const uint32_t*>(&obpHeader[OBP_PAYLOAD_START-sizeof(uint32_t)]);
-
-    // the original vector does not need to be resized because it will be the same size, or larger than the
-    //  data sent back by the spectrometer, since this->length was the maximum number of spectra to be returned
-    // the next transfer will retrieve the number of remaining bytes.
+    try 
+    {
+        OBPMessage::parseHeader(&((*this->buffer)[0]), &header);
+    } 
+    catch (IllegalArgumentException &iae) 
+    {
+        string error("Failed to parse message transferred from device");
+        throw ProtocolException(error);
+    }
 
-    /* This will use the superclass to transfer data from the device
-     */
-    xfer = Transfer::transfer(helper);
-    if(NULL == xfer) 
+    if(0 == isLegalMessageType(header.messageType)) 
     {
-        string error("Expected Transfer::transfer to produce a non-null result "
-                        "containing raw spectral data.  Without this data, it is not "
-                        "possible to generate a valid formatted spectrum.");
+        string error("Did not get expected message type, got ");
+        error += (char)(header.messageType);
         throw ProtocolException(error);
     }
-    /* xfer is a copy of what is already stored in this->buffer so delete it.
-     */
-    delete xfer;
 
-    /* Try to parse the buffer into an OBPMessage.  This may throw an exception
-     * if the message is badly formed.
+    /* The payload and trailer are read straight into the vector that is
+     * handed back, which is then cut down to the payload.  Nothing has to
+     * be moved to make room for the header or to take it off again.
      */
+    retval = new ByteVector();
+    vector<byte> &bytes = retval->getByteVector();
+    bytes.resize(header.bytesRemaining);
+    try {
+        flag = helper->receive(bytes, header.bytesRemaining);
+        if(((unsigned int)flag) != header.bytesRemaining) {
+            /* FIXME: retry, throw exception, something here */
+        }
+    } catch (BusException &be) {
+        delete retval;
+        string error("Failed to read from bus.");
+        /* FIXME: previous exception should probably be bundled up into the new exception */
+        throw ProtocolException(error);
+    }
+
+    payloadLength = header.bytesRemaining - OBP_MESSAGE_TRAILER_LENGTH;
     try 
     {
-
-        // the current buffer does not include the header. For the parse to work, those
-        //  44 bytes must be inserted at the front of this->buffer
-        this->buffer->insert(this->buffer->begin(), obpHeader.begin(), obpHeader.end());
-
-        message = OBPMessage::parseByteStream(this->buffer);
+        OBPMessage::checkTrailer(&(bytes[payloadLength]));
     } 
     catch (IllegalArgumentException &iae) 
     {
+        delete retval;
         string error("Failed to parse message transferred from device");
         throw ProtocolException(error);
     }
+    bytes.resize(payloadLength);
 
-    if(0 == isLegalMessageType(message->getMessageType())) 
-    {
-        string error("Did not get expected message type, got ");
-        error += (char)(message->getMessageType());
-        throw ProtocolException(error);
-    }
-
-    bytes = message->getData();
-    if((bytes->size() % ((numberOfPixels * numberOfBytesPerPixel)+metadataLength+checkSumLength)) != 0) // the number of bytes should be an integral of the spectrum size
+    if((payloadLength % ((numberOfPixels * numberOfBytesPerPixel)+metadataLength+checkSumLength)) != 0) // the number of bytes should be an integral of the spectrum size
     {
         string error("Spectrum response does not have enough data.");
-        delete message;
+        delete retval;
         throw ProtocolException(error);
     }
-    /* This incurs a copy of the buffer so it is safe to delete the message. */
-    ByteVector *retval = new ByteVector(*bytes);
-    delete message;
 
     return retval;
 }
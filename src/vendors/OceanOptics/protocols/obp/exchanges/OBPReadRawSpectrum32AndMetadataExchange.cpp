@@ -85,22 +85,13 @@ unsigned int OBPReadRawSpectrum32AndMetadataExchange::isLegalMessageType(unsigne
 
 Data *OBPReadRawSpectrum32AndMetadataExchange::transfer(TransferHelper *helper)
         throw (ProtocolException) {
-    Data *xfer;
     OBPMessage *message = NULL;
     vector<byte> *bytes;
 
-    /* This will use the superclass to transfer data from the device
+    /* This will use the superclass to transfer data from the device into
+     * this->buffer, which is parsed in place below.
      */
-    xfer = Transfer::transfer(helper);
-    if(NULL == xfer) {
-        string error("Expected Transfer::transfer to produce a non-null result "
-                        "containing raw spectral data.  Without this data, it is not "
-                        "possible to generate a valid formatted spectrum.");
-        throw ProtocolException(error);
-    }
-    /* xfer is a copy of what is already stored in this->buffer so delete it.
-     */
-    delete xfer;
+    Transfer::transferInPlace(helper);
 
     /* Try to parse the buffer into an OBPMessage.  This may throw an exception
      * if the message is badly formed.
@@ -128,8 +119,11 @@ Data *OBPReadRawSpectrum32AndMetadataExchange::transfer(TransferHelper *helper)
         delete message;
         throw ProtocolException(error);
     }
-    /* This incurs a copy of the buffer so it is safe to delete the message. */
-    ByteVector *retval = new ByteVector(*bytes);
+    /* Take the payload over from the message rather than copying it; the
+     * message is left with an empty vector and can be deleted as usual.
+     */
+    ByteVector *retval = new ByteVector();
+    retval->getByteVector().swap(*bytes);
     delete message;
 
     return retval;
@@ -33,6 +33,7 @@
 #include "vendors/OceanOptics/protocols/obp/constants/OBPMessageTypes.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPMessage.h"
 #include "common/UShortVector.h"
+#include "common/PixelUnpack.h"
 #include "common/ByteVector.h"
 
 using namespace seabreeze;
@@ -52,8 +53,6 @@ OBPReadSpectrumExchange::~OBPReadSpectrumExchange() {
 Data *OBPReadSpectrumExchange::transfer(TransferHelper *helper)
         throw (ProtocolException) {
     Data *xfer;
-    byte lsb;
-    byte msb;
 
     /* This will use the superclass to transfer data from the device, and will
      * then strip off the message header and footer so that only the
@@ -70,17 +69,49 @@ Data *OBPReadSpectrumExchange::transfer(TransferHelper *helper)
 
     /* Extract the pixel data from the byte vector */
     ByteVector *bv = static_cast<ByteVector *>(xfer);
-    vector<byte> bytes = bv->getByteVector();
+    vector<byte> &bytes = bv->getByteVector();
 
-    vector<unsigned short> formatted(this->numberOfPixels);
-    for(unsigned int i = 0; i < this->numberOfPixels; i++) {
-        lsb = bytes[i * 2];
-        msb = bytes[(i * 2) + 1];
-        formatted[i] = ((msb & 0x00FF) << 8) | (lsb & 0x00FF);
-    }
+    UShortVector *retval = new UShortVector(this->numberOfPixels);
+    PixelUnpack::unpackLE16(&(bytes[0]), &(retval->getUShortVector()[0]),
+        this->numberOfPixels);
     delete xfer;  /* Equivalent to deleting bv and bytes */
 
-    UShortVector *retval = new UShortVector(formatted);
-
     return retval;
 }
+
+int OBPReadSpectrumExchange::transferSpectrum(TransferHelper *helper,
+        double *spectrum, unsigned int length) throw (ProtocolException) {
+    OBPHeader header;
+    const byte *data;
+    unsigned int dataLength;
+    unsigned int count = (length < this->numberOfPixels) ? length : this->numberOfPixels;
+
+    /* The message is left where it was received and its pixels decoded
+     * from there, rather than being parsed into an OBPMessage.
+     */
+    Transfer::transferInPlace(helper);
+
+    try {
+        OBPMessage::parseHeader(&((*(this->buffer))[0]), &header);
+        dataLength = OBPMessage::findData(&((*(this->buffer))[0]), this->length,
+            header, &data);
+    } catch (IllegalArgumentException &iae) {
+        string error("Failed to parse message transferred from device");
+        throw ProtocolException(error);
+    }
+
+    if(0 == isLegalMessageType(header.messageType)) {
+        string error("Did not get expected message type, got ");
+        error += (char)(header.messageType);
+        throw ProtocolException(error);
+    }
+
+    if(dataLength < 2*this->numberOfPixels) {
+        string error("Spectrum response does not have enough data.");
+        throw ProtocolException(error);
+    }
+
+    PixelUnpack::unpackLE16ToDouble(data, spectrum, count);
+
+    return (int)count;
+}
@@ -34,6 +34,7 @@
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPMessage.h"
 #include "common/UShortVector.h"
 #include "common/DoubleVector.h"
+#include "common/PixelUnpack.h"
 
 using namespace seabreeze;
 using namespace seabreeze::oceanBinaryProtocol;
@@ -53,7 +54,6 @@ OBPReadSpectrumWithGainExchange::~OBPReadSpectrumWithGainExchange() {
 Data *OBPReadSpectrumWithGainExchange::transfer(TransferHelper *helper)
         throw (ProtocolException) {
     
-    unsigned int i;
     Data *xfer;
     double maxIntensity;
     double saturationLevel;
@@ -80,25 +80,40 @@ Data *OBPReadSpectrumWithGainExchange::transfer(TransferHelper *helper)
 
     /* Cast the formatted values so that we can get to the array of shorts */
     UShortVector *usv = static_cast<UShortVector *>(xfer);
-    vector<unsigned short> shortVec = usv->getUShortVector();
+    vector<unsigned short> &shortVec = usv->getUShortVector();
 
-    /* Create a buffer to store the gain-adjusted values.  This is local. */
-    vector<double> adjusted(this->numberOfPixels);
-
-    for(i = 0; i < this->numberOfPixels; i++) {
-        double temp = shortVec[i] * maxIntensity / saturationLevel;
-        if(temp > maxIntensity) {
-            temp = maxIntensity;
-        }
-        adjusted[i] = temp;
+    /* The gain-adjusted values go straight into the result */
+    DoubleVector *retval = new DoubleVector();
+    vector<double> &adjusted = retval->getDoubleVector();
+    adjusted.resize(this->numberOfPixels);
+    if(this->numberOfPixels > 0) {
+        PixelUnpack::applyGain(&shortVec[0], &adjusted[0], this->numberOfPixels,
+            maxIntensity, saturationLevel);
     }
 
-    /* It might speed things up to dynamically allocate the buffer and
-     * hand it off to retval rather than letting it make a copy.
-     */
-    DoubleVector *retval = new DoubleVector(adjusted);
-
     delete xfer;
 
     return retval;
 }
+
+int OBPReadSpectrumWithGainExchange::transferSpectrum(TransferHelper *helper, double *spectrum,
+        unsigned int length) throw (ProtocolException) {
+    int count;
+    double maxIntensity;
+    double saturationLevel;
+
+    count = OBPReadSpectrumExchange::transferSpectrum(helper, spectrum, length);
+
+    if(NULL == this->spectrometerFeature) {
+        return count;
+    }
+
+    maxIntensity = this->spectrometerFeature->getMaximumIntensity();
+    saturationLevel = this->spectrometerFeature->getSaturationLevel();
+
+    /* Scale in place, without the local buffer transfer() needs */
+    PixelUnpack::applyGain(spectrum, (unsigned int)count, maxIntensity,
+        saturationLevel);
+
+    return count;
+}
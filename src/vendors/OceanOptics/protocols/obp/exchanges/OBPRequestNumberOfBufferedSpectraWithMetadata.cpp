@@ -55,10 +55,8 @@ OBPRequestNumberOfBufferedSpectraWithMetadataExchange::~OBPRequestNumberOfBuffer
 
 void OBPRequestNumberOfBufferedSpectraWithMetadataExchange::setNumberOfSamplesToRequest(void *myClass, unsigned int numberOfSamples)
 {
-    OBPMessage message;
-    vector<byte> *stream;
-    unsigned int i;
     unsigned int adjustedNumberOfSamples = numberOfSamples;
+    byte sampleCount[sizeof(unsigned int)];
 
     OBPRequestNumberOfBufferedSpectraWithMetadataExchange *parentClass = (OBPRequestNumberOfBufferedSpectraWithMetadataExchange *)myClass;
 
@@ -67,24 +65,21 @@ void OBPRequestNumberOfBufferedSpectraWithMetadataExchange::setNumberOfSamplesTo
     if(adjustedNumberOfSamples < 1)
         adjustedNumberOfSamples = 1;
 
-    std::vector<unsigned char> *numberOfSamplesToRetrieve = new vector<unsigned char>(sizeof(unsigned int));
-    // no c++11 yet
-    //memcpy(numberOfSamplesToRetrieve.data(), &numberOfSamples, sizeof(unsigned int)); 
-    memcpy(&((*numberOfSamplesToRetrieve)[0]), &adjustedNumberOfSamples, sizeof(unsigned int));
+    memcpy(sampleCount, &adjustedNumberOfSamples, sizeof(unsigned int));
 
-
-
-    message.setMessageType(OBPMessageTypes::OBP_GET_N_BUF_RAW_SPECTRA_META);
-    message.setImmediateData(numberOfSamplesToRetrieve); // sets length automatically ~obpMessage destroys the vector
-    stream = message.toByteStream();
-
-    parentClass->length = (unsigned)stream->size();
-    parentClass->buffer->resize(stream->size());
-
-    for (i = 0; i < stream->size(); i++) {
-        (*(parentClass->buffer))[i] = (*stream)[i];
+    // the request is formatted once; after that only the sample count in its
+    //  immediate data needs to be rewritten
+    if(0 == parentClass->length)
+    {
+        parentClass->length = OBPMessage::writeByteStream(*(parentClass->buffer),
+            OBPMessageTypes::OBP_GET_N_BUF_RAW_SPECTRA_META, 0, 0,
+            sampleCount, sizeof(sampleCount));
+    }
+    else
+    {
+        OBPMessage::patchData(&((*(parentClass->buffer))[0]), sampleCount,
+            sizeof(sampleCount));
     }
-    delete stream;
 
     parentClass->checkBufferSize();
 }
@@ -38,24 +38,13 @@ using namespace seabreeze::oceanBinaryProtocol;
 using namespace std;
 
 OBPRequestSpectrumExchange::OBPRequestSpectrumExchange() {
-    OBPMessage message;
-    vector<byte> *stream;
-    unsigned int i;
-
     this->hints->push_back(new OBPSpectrumHint());
 
     this->direction = Transfer::TO_DEVICE;
 
-    message.setMessageType(OBPMessageTypes::OBP_GET_CORRECTED_SPECTRUM_NOW);
-    stream = message.toByteStream();
-
-    this->length = (unsigned) stream->size();
-    this->buffer->resize(stream->size());
-
-    for(i = 0; i < stream->size(); i++) {
-        (*(this->buffer))[i] = (*stream)[i];
-    }
-    delete stream;
+    /* The request never changes, so it is formatted once and kept */
+    this->length = OBPMessage::writeByteStream(*(this->buffer),
+        OBPMessageTypes::OBP_GET_CORRECTED_SPECTRUM_NOW, 0, 0, NULL, 0);
 
     checkBufferSize();
 }
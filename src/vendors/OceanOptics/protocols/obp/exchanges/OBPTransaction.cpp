@@ -39,6 +39,8 @@
 
 #include "common/globals.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPTransaction.h"
+#include "vendors/OceanOptics/protocols/obp/constants/OBPMessageTypes.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPTransport.h"
 
 using namespace seabreeze;
 using namespace seabreeze::oceanBinaryProtocol;
@@ -68,140 +70,171 @@ const vector<ProtocolHint *> &OBPTransaction::getHints() {
     return *(this->hints);
 }
 
+bool OBPTransaction::isCacheable(unsigned int messageType) {
+    switch(messageType) {
+        case OBPMessageTypes::OBP_GET_HARDWARE_REVISION:
+        case OBPMessageTypes::OBP_GET_FIRMWARE_REVISION:
+        case OBPMessageTypes::OBP_GET_FIRMWARE_2_REVISION:
+        case OBPMessageTypes::OBP_GET_SERIAL_NUMBER:
+        case OBPMessageTypes::OBP_GET_SERIAL_NUMBER_LENGTH:
+        case OBPMessageTypes::OBP_GET_BUFFER_SIZE_MAX:
+        case OBPMessageTypes::OBP_GET_MAXIMUM_ADC_COUNTS:
+        case OBPMessageTypes::OBP_GET_MINIMUM_INTEGRATION_TIME_US:
+        case OBPMessageTypes::OBP_GET_MAXIMUM_INTEGRATION_TIME_US:
+        case OBPMessageTypes::OBP_GET_INTEGRATION_TIME_STEP_SIZE_US:
+        case OBPMessageTypes::OBP_GET_NUMBER_OF_PIXELS:
+        case OBPMessageTypes::OBP_GET_ACTIVE_PIXEL_RANGES:
+        case OBPMessageTypes::OBP_GET_OPTICAL_DARK_PIXEL_RANGES:
+        case OBPMessageTypes::OBP_GET_ELECTRIC_DARK_PIXEL_RANGES:
+        case OBPMessageTypes::OBP_GET_MAX_BINNING_FACTOR:
+        case OBPMessageTypes::OBP_GET_DEFAULT_BINNING_FACTOR:
+        case OBPMessageTypes::OBP_GET_MINIMUM_ACQUISITION_DELAY:
+        case OBPMessageTypes::OBP_GET_MAXIMUM_ACQUISITION_DELAY:
+        case OBPMessageTypes::OBP_GET_ACQUISITION_DELAY_STEP:
+        case OBPMessageTypes::OBP_GET_WL_COEFF_COUNT:
+        case OBPMessageTypes::OBP_GET_WL_COEFF:
+        case OBPMessageTypes::OBP_GET_NL_COEFF_COUNT:
+        case OBPMessageTypes::OBP_GET_NL_COEFF:
+        case OBPMessageTypes::OBP_GET_IRRAD_CAL_ALL:
+        case OBPMessageTypes::OBP_GET_IRRAD_CAL_COUNT:
+        case OBPMessageTypes::OBP_GET_IRRAD_CAL_COLL_AREA:
+        case OBPMessageTypes::OBP_GET_STRAY_COEFF_COUNT:
+        case OBPMessageTypes::OBP_GET_STRAY_COEFF:
+        case OBPMessageTypes::OBP_GET_BENCH_ID:
+        case OBPMessageTypes::OBP_GET_BENCH_SERIAL_NUMBER:
+        case OBPMessageTypes::OBP_GET_BENCH_SLIT_WIDTH_MICRONS:
+        case OBPMessageTypes::OBP_GET_BENCH_FIBER_DIAM_MICRONS:
+        case OBPMessageTypes::OBP_GET_BENCH_GRATING:
+        case OBPMessageTypes::OBP_GET_BENCH_FILTER:
+        case OBPMessageTypes::OBP_GET_BENCH_COATING:
+        case OBPMessageTypes::OBP_GET_GPIO_NUMBER_OF_PINS:
+        case OBPMessageTypes::OBP_GET_EGPIO_NUMBER_OF_PINS:
+        case OBPMessageTypes::OBP_GET_EGPIO_AVAILABLE_MODES:
+        case OBPMessageTypes::OBP_GET_TEMPERATURE_COUNT:
+        case OBPMessageTypes::OBP_GET_I2C_MASTER_BUS_COUNT:
+        case OBPMessageTypes::OBP_GET_NETWORK_INTERFACE_COUNT:
+            return true;
+    }
+    return false;
+}
+
+bool OBPTransaction::invalidatesCache(unsigned int messageType) {
+    /* Binning changes the pixel count and ranges as well as the factors,
+     * and a reset may bring back different values for any of them.
+     */
+    switch(messageType) {
+        case OBPMessageTypes::OBP_RESET:
+        case OBPMessageTypes::OBP_RESET_DEFAULTS:
+        case OBPMessageTypes::OBP_SET_PIXEL_BINNING_FACTOR:
+        case OBPMessageTypes::OBP_SET_DEFAULT_BINNING_FACTOR:
+        case OBPMessageTypes::OBP_SET_WL_COEFF:
+        case OBPMessageTypes::OBP_SET_NL_COEFF:
+        case OBPMessageTypes::OBP_SET_IRRADIANCE_CAL_AT_PIXEL:
+        case OBPMessageTypes::OBP_SET_IRRAD_CAL_ALL:
+        case OBPMessageTypes::OBP_SET_IRRAD_CAL_COLL_AREA:
+        case OBPMessageTypes::OBP_SET_STRAY_COEFF:
+        case OBPMessageTypes::OBP_SET_BENCH_SLIT_WIDTH_MICRONS:
+        case OBPMessageTypes::OBP_SET_BENCH_GRATING:
+        case OBPMessageTypes::OBP_SET_BENCH_FILTER:
+            return true;
+    }
+    return false;
+}
+
 vector<byte> *OBPTransaction::queryDevice(TransferHelper *helper,
                     unsigned int messageType,
                     vector<byte> &data) throw (ProtocolException) 
 {
-    int flag = 0;
-    vector<byte> *bytes = NULL;
-    vector<byte> *fullVector = NULL;
-    OBPMessage *message = new OBPMessage();
-    OBPMessage *response = NULL;
+    const byte *reply = NULL;
+    int length;
 
-    message->setMessageType(messageType);
+    length = queryDeviceInPlace(helper, messageType, data, &reply);
+    if(length < 0) 
+    {
+        /* There may be a legitimate reason to not return a message
+         * (e.g. tried to read an unprogrammed value).  Just return
+         * NULL here instead of throwing an exception and let the
+         * caller figure it out.
+         */
+        return NULL;
+    }
 
-    /* Need a copy of the input data that can be given to the message. */
-    /* Note: copy will be deleted by message when appropriate. */
-    message->setData(new vector<byte>(data));
+    /* Copy the reply out of the transport's buffer so the caller can keep it */
+    return new vector<byte>(reply, reply + length);
+}
 
-    try 
-    {
-        bytes = message->toByteStream();
-        flag = helper->send(*bytes, (unsigned) bytes->size());
-        if(((unsigned int)flag) != bytes->size()) 
-        {
-            /* FIXME: retry, throw exception, something here */
-        }
-    } 
-    catch (BusException &be) 
-    {
-        if(NULL != bytes) 
-        {
-            delete bytes;
+int OBPTransaction::queryDeviceInPlace(TransferHelper *helper,
+                    unsigned int messageType,
+                    const vector<byte> &data,
+                    const byte **reply) throw (ProtocolException) 
+{
+    OBPTransport *transport = OBPTransport::getTransport(helper);
+    OBPHeader header;
+    unsigned int length;
+    unsigned int received;
+    int dataLength;
+    bool cacheable = isCacheable(messageType);
+
+    if(true == cacheable) {
+        dataLength = transport->getReplyCache().lookup(messageType, data, reply);
+        if(dataLength >= 0) {
+            return dataLength;
         }
-        delete message;
-        string error("Failed to write to bus.");
-        /* FIXME: previous exception should probably be bundled up into the new exception */
-        /* FIXME: there is probably a more descriptive type for this than ProtocolException */
-        throw ProtocolException(error);
     }
 
-    delete message;
-    delete bytes;
-    bytes = NULL;
+    sendRequest(helper, messageType, 0, data);
 
     try {
         /* Read the 64-byte OBP header.  This may indicate that more data
          * must be absorbed afterwards.
          */
-        bytes = new vector<byte>(64);
-        flag = helper->receive(*bytes, (unsigned) bytes->size());
-        if(((unsigned int)flag) != bytes->size()) 
-        {
-            /* FIXME: retry, throw exception, something here */
-        }
-
-        /* Parse out the header and see if there is an extended payload. */
-        try 
-        {
-            response = OBPMessage::parseHeaderFromByteStream(bytes);
-        } 
-        catch (IllegalArgumentException &iae) 
+        if(false == receiveReplyHeader(helper, &header, &received)) 
         {
-            response = NULL;
+            return -1;
         }
-        if(NULL == response || true == response->isNackFlagSet() || response->getMessageType() != messageType) 
+        if(0 != (header.flags & OBP_MESSAGE_FLAGS_NACK) || header.messageType != messageType) 
         {
-            if(NULL != bytes) 
+            char message[64];
+            if (header.messageType == messageType)
             {
-                delete bytes;
+                snprintf(message, sizeof(message), "OBP Flags indicated an error: %x", header.flags);
             }
-
-            if(NULL != response) 
+            else
             {
-                char message[64];
-                if (response->getMessageType() == messageType)
-                {
-                    unsigned short flags = (*response).getFlags();
-                    snprintf(message, sizeof(message), "OBP Flags indicated an error: %x", flags);
-                }
-                else
-                {
-                    snprintf(message, sizeof(message), "Expected message type 0x%x, but got %x", messageType, response->getMessageType());
-                }
-                throw(ProtocolException(message));
-                delete response;
+                snprintf(message, sizeof(message), "Expected message type 0x%x, but got %x", messageType, header.messageType);
             }
-            /* There may be a legitimate reason to not return a message
-             * (e.g. tried to read an unprogrammed value).  Just return
-             * NULL here instead of throwing an exception and let the
-             * caller figure it out.
-             */
-            return NULL;
+            throw(ProtocolException(message));
         }
-        unsigned int bytesToRead = response->getBytesRemaining() - 20; /* omit footer and checksum */
-        if(bytesToRead > 0) {
-            fullVector = new vector<byte>(bytesToRead + bytes->size());
-            /* Safely stl::copy() the header into a full-sized block and
-             * delete the existing buffer
+
+        unsigned int bytesToRead = header.bytesRemaining - 20; /* omit footer and checksum */
+        length = MINIMUM_TRANSFER_SIZE + bytesToRead;
+        if(received < length) 
+        {
+            vector<byte> &replyBuffer = transport->getReplyBuffer();
+            /* Whatever did not come with the header is read in right
+             * behind it, so the whole reply can be parsed where it lies.
              */
-            vector<byte>::iterator iter = copy(bytes->begin(), bytes->end(), fullVector->begin());
-            delete bytes;
-            bytes = NULL;
-            /* TransferHelper expects a vector, so create a new one for it */
-            vector<byte> *remainder = new vector<byte>(bytesToRead);
-            flag = helper->receive(*remainder, (unsigned) remainder->size());
-            if(((unsigned int)flag) != bytesToRead) {
+            if(replyBuffer.size() < length) 
+            {
+                replyBuffer.resize(length);
+            }
+            int flag = helper->receiveAt(replyBuffer, received, length - received);
+            if(((unsigned int)flag) != length - received) 
+            {
                 /* FIXME: retry, throw exception, something here */
             }
-            copy(remainder->begin(), remainder->end(), iter);
-            delete remainder;
-        } else {
-            fullVector = bytes;
-            bytes = NULL;  /* To prevent double deletion */
         }
-        /* Delete and recreate response using the full message */
-        delete response;
-        try {
-            response = OBPMessage::parseByteStream(fullVector);
-        } catch (IllegalArgumentException &iae) {
-            response = NULL;
-        }
-        delete fullVector;
-        fullVector = NULL;
     } catch (BusException &be) {
-        if(NULL != bytes) {
-            delete bytes;
-        }
-        if(NULL != fullVector) {
-            delete fullVector;
-        }
         string error("Failed to read from bus.");
         /* FIXME: previous exception should probably be bundled up into the new exception */
         /* FIXME: there is probably a more descriptive type for this than ProtocolException */
         throw ProtocolException(error);
     }
-    if(NULL == response) {
+
+    try {
+        dataLength = (int)OBPMessage::findData(&(transport->getReplyBuffer()[0]),
+            length, header, reply);
+    } catch (IllegalArgumentException &iae) {
         /* This could happen if the footer or checksum failed for
          * some reason, but that would be very unusual.  This can only happen
          * if the header was already verified, but there was some error in the
@@ -211,88 +244,107 @@ vector<byte> *OBPTransaction::queryDevice(TransferHelper *helper,
         throw ProtocolException(error);
     }
 
-    /* Make a copy of the response buffer so response can be deleted */
-    bytes = new vector<byte>(*response->getData());
-    
-    delete response;
-    return bytes;
+    if(true == cacheable) {
+        transport->getReplyCache().store(messageType, data, *reply, dataLength);
+    }
+    return dataLength;
 }
 
-
 bool OBPTransaction::sendCommandToDevice(TransferHelper *helper,
                     unsigned int messageType,
                     vector<byte> &data) throw (ProtocolException) {
 
-    bool retval = false;
-    int flag = 0;
-    vector<byte> *bytes = NULL;
-    OBPMessage *message = new OBPMessage();
-    OBPMessage *response = NULL;
+    OBPHeader header;
+    unsigned int received;
 
-    message->setMessageType(messageType);
-    message->setAckRequestedFlag();
+    if(true == invalidatesCache(messageType)) {
+        OBPTransport::getTransport(helper)->getReplyCache().clear();
+    }
 
-    /* Need a copy of the input data that can be given to the message. */
-    /* Note: copy will be deleted by message when appropriate. */
-    message->setData(new vector<byte>(data));
+    sendRequest(helper, messageType, OBP_MESSAGE_FLAGS_ACK_REQUESTED, data);
 
     try {
-        bytes = message->toByteStream();
-        flag = helper->send(*bytes, (unsigned) bytes->size());
-        if(((unsigned int)flag) != bytes->size()) {
-            /* FIXME: retry, throw exception, something here */
+        /* Read the 64-byte OBP header. */
+        if(false == receiveReplyHeader(helper, &header, &received)) {
+            return false;
         }
     } catch (BusException &be) {
-        if(NULL != bytes) {
-            delete bytes;
-        }
-        delete message;
-        string error("Failed to write to bus.");
+        string error("Failed to read from bus.");
         /* FIXME: previous exception should probably be bundled up into the new exception */
         /* FIXME: there is probably a more descriptive type for this than ProtocolException */
         throw ProtocolException(error);
     }
 
-    delete message;
-    delete bytes;
-    bytes = NULL;
+    if(0 != (header.flags & OBP_MESSAGE_FLAGS_NACK)
+            || header.messageType != messageType) {
+        return false;
+    } else if(0 != (header.flags & OBP_MESSAGE_FLAGS_ACK)) {
+        return true;
+    }
+
+    string error("Illegal device response");
+    throw ProtocolException(error);
+}
+
+void OBPTransaction::sendRequest(TransferHelper *helper,
+                    unsigned int messageType, unsigned short flags,
+                    const vector<byte> &data) throw (ProtocolException) {
+    int flag = 0;
+    const byte *dataBytes = (true == data.empty()) ? NULL : &(data[0]);
+    unsigned int dataLength = (unsigned) data.size();
+    OBPTransport *transport = OBPTransport::getTransport(helper);
+    vector<byte> &request = transport->getRequestBuffer();
+    RequestFrame &frame = transport->getRequestFrame();
+
+    /* Most queries are repeated with at most a few bytes of data changed,
+     * so when the request buffer still holds a message of the
+     * right shape only the data is rewritten.  The buffer outlives the
+     * exchange objects, which are often made afresh for every call.
+     */
+    if(0 != frame.length && messageType == frame.messageType
+            && flags == frame.flags && dataLength == frame.dataLength) {
+        OBPMessage::patchData(&(request[0]), dataBytes, dataLength);
+    } else {
+        frame.length = OBPMessage::writeByteStream(request,
+            messageType, flags, 0, dataBytes, dataLength);
+        frame.messageType = messageType;
+        frame.flags = flags;
+        frame.dataLength = dataLength;
+    }
 
     try {
-        /* Read the 64-byte OBP header. */
-        bytes = new vector<byte>(64);
-        flag = helper->receive(*bytes, (unsigned) bytes->size());
-        if(((unsigned int)flag) != bytes->size()) {
+        flag = helper->send(request, frame.length);
+        if(((unsigned int)flag) != frame.length) {
             /* FIXME: retry, throw exception, something here */
         }
-
-        /* Parse out the header. */
-        try {
-            response = OBPMessage::parseHeaderFromByteStream(bytes);
-        } catch (IllegalArgumentException &iae) {
-            response = NULL;
-        }
     } catch (BusException &be) {
-        if(NULL != bytes) {
-            delete bytes;
-        }
-        string error("Failed to read from bus.");
+        string error("Failed to write to bus.");
         /* FIXME: previous exception should probably be bundled up into the new exception */
         /* FIXME: there is probably a more descriptive type for this than ProtocolException */
         throw ProtocolException(error);
     }
+}
 
-    delete bytes;
+bool OBPTransaction::receiveReplyHeader(TransferHelper *helper,
+                    OBPHeader *header, unsigned int *received) throw (BusException) {
+    OBPTransport *transport = OBPTransport::getTransport(helper);
+    int flag = 0;
+    unsigned int readLength = transport->getHeaderReadLength();
+    vector<byte> &reply = transport->getReplyBuffer();
 
-    if(NULL == response || true == response->isNackFlagSet()
-            || response->getMessageType() != messageType) {
-        retval = false;
-    } else if(true == response->isAckFlagSet()) {
-        retval = true;
-    } else {
-        delete response;
-        string error("Illegal device response");
-        throw ProtocolException(error);
+    if(reply.size() < readLength) {
+        reply.resize(readLength);
+    }
+    flag = helper->receive(reply, readLength);
+    if(flag < MINIMUM_TRANSFER_SIZE) {
+        /* FIXME: retry, throw exception, something here */
+    }
+    *received = (flag > 0) ? (unsigned int)flag : 0;
+
+    try {
+        OBPMessage::parseHeader(&(reply[0]), header);
+    } catch (IllegalArgumentException &iae) {
+        return false;
     }
-    delete response;
-    return retval;
+    return true;
 }
@@ -0,0 +1,89 @@
+/***************************************************//**
+ * @file    OBPTransport.cpp
+ * @date    October 2026
+ * @author  Ocean Optics, Inc.
+ *
+ * The OBP state that is kept with each TransferHelper.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#include "common/globals.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPTransport.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPMessage.h"
+#include <string.h>
+
+using namespace seabreeze;
+using namespace seabreeze::oceanBinaryProtocol;
+using namespace std;
+
+OBPTransport::OBPTransport(TransferHelper *helper) {
+    this->helper = helper;
+    memset(&(this->requestFrame), 0, sizeof(this->requestFrame));
+    this->headerReadLength = 0;
+}
+
+OBPTransport::~OBPTransport() {
+
+}
+
+OBPTransport *OBPTransport::getTransport(TransferHelper *helper) {
+    OBPTransport *transport;
+
+    transport = dynamic_cast<OBPTransport *>(helper->getProtocolState());
+    if(NULL == transport) {
+        transport = new OBPTransport(helper);
+        helper->setProtocolState(transport);
+    }
+
+    return transport;
+}
+
+vector<byte> &OBPTransport::getRequestBuffer() {
+    return this->requestBuffer;
+}
+
+vector<byte> &OBPTransport::getReplyBuffer() {
+    return this->replyBuffer;
+}
+
+RequestFrame &OBPTransport::getRequestFrame() {
+    return this->requestFrame;
+}
+
+ReplyCache &OBPTransport::getReplyCache() {
+    return this->replyCache;
+}
+
+unsigned int OBPTransport::getHeaderReadLength() {
+    if(0 == this->headerReadLength) {
+        /* Fixed for as long as the helper exists */
+        this->headerReadLength = this->helper->getSingleReadLength();
+        if(this->headerReadLength < OBP_MESSAGE_OVERHEAD_LENGTH) {
+            this->headerReadLength = OBP_MESSAGE_OVERHEAD_LENGTH;
+        }
+    }
+
+    return this->headerReadLength;
+}
@@ -48,11 +48,15 @@ using namespace std;
 
 OBPDataBufferProtocol::OBPDataBufferProtocol()
         : DataBufferProtocolInterface(new OceanBinaryProtocol()) {
-
+    this->getDataBufferElementCountExchange = new OBPGetDataBufferElementCountExchange();
+    this->getDataBufferCapacityExchange = new OBPGetDataBufferCapacityExchange();
+    this->getDataBufferMaximumCapacityExchange = new OBPGetDataBufferMaximumCapacityExchange();
 }
 
 OBPDataBufferProtocol::~OBPDataBufferProtocol() {
-
+    delete this->getDataBufferElementCountExchange;
+    delete this->getDataBufferCapacityExchange;
+    delete this->getDataBufferMaximumCapacityExchange;
 }
 
 void OBPDataBufferProtocol::clearBuffer(const Bus &bus,
@@ -117,7 +121,7 @@ unsigned long OBPDataBufferProtocol::getNumberOfElements(const Bus &bus,
         unsigned char bufferIndex) throw (ProtocolException) {
 
     unsigned long elementCount;
-    OBPGetDataBufferElementCountExchange exchange;
+    OBPGetDataBufferElementCountExchange &exchange = *(this->getDataBufferElementCountExchange);
 
     if(0 != bufferIndex) {
         /* At present, this protocol only knows how to deal with one buffer
@@ -143,7 +147,7 @@ unsigned long OBPDataBufferProtocol::getBufferCapacity(const Bus &bus,
         unsigned char bufferIndex) throw (ProtocolException) {
 
     unsigned long capacity;
-    OBPGetDataBufferCapacityExchange exchange;
+    OBPGetDataBufferCapacityExchange &exchange = *(this->getDataBufferCapacityExchange);
 
     if(0 != bufferIndex) {
         /* At present, this protocol only knows how to deal with one buffer
@@ -191,7 +195,7 @@ unsigned long OBPDataBufferProtocol::getBufferCapacityMaximum(const Bus &bus,
         unsigned char bufferIndex) throw (ProtocolException) {
 
     unsigned long maximumCapacity;
-    OBPGetDataBufferMaximumCapacityExchange exchange;
+    OBPGetDataBufferMaximumCapacityExchange &exchange = *(this->getDataBufferMaximumCapacityExchange);
 
     if(0 != bufferIndex) {
         /* At present, this protocol only knows how to deal with one buffer
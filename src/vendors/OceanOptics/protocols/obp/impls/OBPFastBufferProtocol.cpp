@@ -42,18 +42,20 @@ using namespace std;
 
 OBPFastBufferProtocol::OBPFastBufferProtocol()
         : FastBufferProtocolInterface(new OceanBinaryProtocol()) {
-
+    this->getFastBufferingEnableExchange = new OBPGetFastBufferingEnableExchange();
+    this->getConsecutiveSampleCountExchange = new OBPGetConsecutiveSampleCountExchange();
 }
 
 OBPFastBufferProtocol::~OBPFastBufferProtocol() {
-
+    delete this->getFastBufferingEnableExchange;
+    delete this->getConsecutiveSampleCountExchange;
 }
 
 unsigned char OBPFastBufferProtocol::getBufferingEnable(const Bus &bus,
         unsigned char bufferIndex) throw (ProtocolException) {
 
     unsigned char isEnabled;
-    OBPGetFastBufferingEnableExchange exchange;
+    OBPGetFastBufferingEnableExchange &exchange = *(this->getFastBufferingEnableExchange);
 
     if(0 != bufferIndex) {
         /* At present, this protocol only knows how to deal with one buffer
@@ -105,7 +107,7 @@ unsigned int OBPFastBufferProtocol::getConsecutiveSampleCount(const Bus &bus,
     unsigned char bufferIndex) throw (ProtocolException) {
 
     unsigned int consecutiveSampleCount;
-    OBPGetConsecutiveSampleCountExchange exchange;
+    OBPGetConsecutiveSampleCountExchange &exchange = *(this->getConsecutiveSampleCountExchange);
 
     if (0 != bufferIndex) {
         /* At present, this protocol only knows how to deal with one buffer
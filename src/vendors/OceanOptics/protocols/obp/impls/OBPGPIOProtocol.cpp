@@ -55,12 +55,36 @@ using namespace std;
 OBPGPIOProtocol::OBPGPIOProtocol()
         : GPIOProtocolInterface(new OceanBinaryProtocol()) 
 {
-
+    this->getGPIONumberOfPinsExchange = new OBPGetGPIONumberOfPinsExchange();
+    this->getGPIOOutputEnableVectorExchange = new OBPGetGPIOOutputEnableVectorExchange();
+    this->setGPIOOutputEnableVectorExchange = new OBPSetGPIOOutputEnableVectorExchange();
+    this->getGPIOValueVectorExchange = new OBPGetGPIOValueVectorExchange();
+    this->setGPIOValueVectorExchange = new OBPSetGPIOValueVectorExchange();
+    this->getGPIOExtensionNumberOfPinsExchange = new OBPGetGPIOExtensionNumberOfPinsExchange();
+    this->getGPIOExtensionAvailableModesExchange = new OBPGetGPIOExtensionAvailableModesExchange();
+    this->getGPIOExtensionCurrentModeExchange = new OBPGetGPIOExtensionCurrentModeExchange();
+    this->setGPIOExtensionModeExchange = new OBPSetGPIOExtensionModeExchange();
+    this->getGPIOExtensionOutputVectorExchange = new OBPGetGPIOExtensionOutputVectorExchange();
+    this->setGPIOExtensionOutputVectorExchange = new OBPSetGPIOExtensionOutputVectorExchange();
+    this->getGPIOExtensionValueExchange = new OBPGetGPIOExtensionValueExchange();
+    this->setGPIOExtensionValueExchange = new OBPSetGPIOExtensionValueExchange();
 }
 
 OBPGPIOProtocol::~OBPGPIOProtocol()
 {
-
+    delete this->getGPIONumberOfPinsExchange;
+    delete this->getGPIOOutputEnableVectorExchange;
+    delete this->setGPIOOutputEnableVectorExchange;
+    delete this->getGPIOValueVectorExchange;
+    delete this->setGPIOValueVectorExchange;
+    delete this->getGPIOExtensionNumberOfPinsExchange;
+    delete this->getGPIOExtensionAvailableModesExchange;
+    delete this->getGPIOExtensionCurrentModeExchange;
+    delete this->setGPIOExtensionModeExchange;
+    delete this->getGPIOExtensionOutputVectorExchange;
+    delete this->setGPIOExtensionOutputVectorExchange;
+    delete this->getGPIOExtensionValueExchange;
+    delete this->setGPIOExtensionValueExchange;
 }
 
 #ifdef _WINDOWS
@@ -70,7 +94,7 @@ OBPGPIOProtocol::~OBPGPIOProtocol()
 unsigned char OBPGPIOProtocol::getGPIO_NumberOfPins(const Bus &bus) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPGetGPIONumberOfPinsExchange request;
+    OBPGetGPIONumberOfPinsExchange &request = *(this->getGPIONumberOfPinsExchange);
 
     helper = bus.getHelper(request.getHints());
     if (NULL == helper) {
@@ -79,22 +103,20 @@ unsigned char OBPGPIOProtocol::getGPIO_NumberOfPins(const Bus &bus) throw (Proto
     }
 
     /* This transfer() may cause a ProtocolException to be thrown. */
-    vector<byte> *raw = request.queryDevice(helper);
-    if (NULL == raw) {
+    const byte *raw = NULL;
+    int rawLength = request.queryDeviceInPlace(helper, &raw);
+    if (rawLength < 0) {
         string error("Expected queryDevice to produce a non-null result.  Without this data, it is not possible to continue.");
         throw ProtocolException(error);
     }
 
-    if(raw->size() < sizeof(byte)) {
+    if(rawLength < (int)sizeof(byte)) {
         string error("Failed to get back expected number of bytes that should"
             " have held collection area.");
-        delete raw;
         throw ProtocolException(error);
     }
 
-    unsigned char retval = (*raw)[0];
-
-    delete raw;
+    unsigned char retval = raw[0];
 
     return retval;
 }
@@ -102,7 +124,7 @@ unsigned char OBPGPIOProtocol::getGPIO_NumberOfPins(const Bus &bus) throw (Proto
 unsigned int OBPGPIOProtocol::getGPIO_OutputEnableVector(const Bus &bus) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPGetGPIOOutputEnableVectorExchange request;
+    OBPGetGPIOOutputEnableVectorExchange &request = *(this->getGPIOOutputEnableVectorExchange);
 
     helper = bus.getHelper(request.getHints());
     if (NULL == helper) {
@@ -111,22 +133,20 @@ unsigned int OBPGPIOProtocol::getGPIO_OutputEnableVector(const Bus &bus) throw (
     }
 
     /* This transfer() may cause a ProtocolException to be thrown. */
-    vector<byte> *raw = request.queryDevice(helper);
-    if (NULL == raw) {
+    const byte *raw = NULL;
+    int rawLength = request.queryDeviceInPlace(helper, &raw);
+    if (rawLength < 0) {
         string error("Expected queryDevice to produce a non-null result.  Without this data, it is not possible to continue.");
         throw ProtocolException(error);
     }
 
-    if (raw->size() < sizeof(byte)) {
+    if (rawLength < (int)sizeof(byte)) {
         string error("Failed to get back expected number of bytes that should"
             " have held collection area.");
-        delete raw;
         throw ProtocolException(error);
     }
 
-    unsigned int retval = (*raw)[0];
-
-    delete raw;
+    unsigned int retval = raw[0];
 
     return retval;
 }
@@ -134,7 +154,7 @@ unsigned int OBPGPIOProtocol::getGPIO_OutputEnableVector(const Bus &bus) throw (
 void OBPGPIOProtocol::setGPIO_OutputEnableVector(const Bus &bus, unsigned int outputEnableVector, unsigned int bitMask) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPSetGPIOOutputEnableVectorExchange command;
+    OBPSetGPIOOutputEnableVectorExchange &command = *(this->setGPIOOutputEnableVectorExchange);
 
     helper = bus.getHelper(command.getHints());
     if (NULL == helper) {
@@ -154,7 +174,7 @@ void OBPGPIOProtocol::setGPIO_OutputEnableVector(const Bus &bus, unsigned int ou
 unsigned int OBPGPIOProtocol::getGPIO_ValueVector(const Bus &bus) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPGetGPIOValueVectorExchange request;
+    OBPGetGPIOValueVectorExchange &request = *(this->getGPIOValueVectorExchange);
 
     helper = bus.getHelper(request.getHints());
     if (NULL == helper) {
@@ -163,22 +183,20 @@ unsigned int OBPGPIOProtocol::getGPIO_ValueVector(const Bus &bus) throw (Protoco
     }
 
     /* This transfer() may cause a ProtocolException to be thrown. */
-    vector<byte> *raw = request.queryDevice(helper);
-    if (NULL == raw) {
+    const byte *raw = NULL;
+    int rawLength = request.queryDeviceInPlace(helper, &raw);
+    if (rawLength < 0) {
         string error("Expected queryDevice to produce a non-null result.  Without this data, it is not possible to continue.");
         throw ProtocolException(error);
     }
 
-    if (raw->size() < sizeof(byte)) {
+    if (rawLength < (int)sizeof(byte)) {
         string error("Failed to get back expected number of bytes that should"
             " have held collection area.");
-        delete raw;
         throw ProtocolException(error);
     }
 
-    unsigned int retval = (*raw)[0];
-
-    delete raw;
+    unsigned int retval = raw[0];
 
     return retval;
 }
@@ -186,7 +204,7 @@ unsigned int OBPGPIOProtocol::getGPIO_ValueVector(const Bus &bus) throw (Protoco
 void OBPGPIOProtocol::setGPIO_ValueVector(const Bus &bus, unsigned int valueVector, unsigned int bitMask) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPSetGPIOValueVectorExchange command;
+    OBPSetGPIOValueVectorExchange &command = *(this->setGPIOValueVectorExchange);
 
     helper = bus.getHelper(command.getHints());
     if (NULL == helper) {
@@ -206,7 +224,7 @@ void OBPGPIOProtocol::setGPIO_ValueVector(const Bus &bus, unsigned int valueVect
 unsigned char OBPGPIOProtocol::getEGPIO_NumberOfPins(const Bus &bus) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPGetGPIOExtensionNumberOfPinsExchange request;
+    OBPGetGPIOExtensionNumberOfPinsExchange &request = *(this->getGPIOExtensionNumberOfPinsExchange);
 
     helper = bus.getHelper(request.getHints());
     if (NULL == helper) {
@@ -215,22 +233,20 @@ unsigned char OBPGPIOProtocol::getEGPIO_NumberOfPins(const Bus &bus) throw (Prot
     }
 
     /* This transfer() may cause a ProtocolException to be thrown. */
-    vector<byte> *raw = request.queryDevice(helper);
-    if (NULL == raw) {
+    const byte *raw = NULL;
+    int rawLength = request.queryDeviceInPlace(helper, &raw);
+    if (rawLength < 0) {
         string error("Expected queryDevice to produce a non-null result.  Without this data, it is not possible to continue.");
         throw ProtocolException(error);
     }
 
-    if (raw->size() < sizeof(byte)) {
+    if (rawLength < (int)sizeof(byte)) {
         string error("Failed to get back expected number of bytes that should"
             " have held collection area.");
-        delete raw;
         throw ProtocolException(error);
     }
 
-    unsigned char retval = (*raw)[0];
-
-    delete raw;
+    unsigned char retval = raw[0];
 
     return retval;
 }
@@ -238,7 +254,7 @@ unsigned char OBPGPIOProtocol::getEGPIO_NumberOfPins(const Bus &bus) throw (Prot
 std::vector<unsigned char> OBPGPIOProtocol::getEGPIO_AvailableModes(const Bus &bus, unsigned char pinNumber) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPGetGPIOExtensionAvailableModesExchange request;
+    OBPGetGPIOExtensionAvailableModesExchange &request = *(this->getGPIOExtensionAvailableModesExchange);
 
     helper = bus.getHelper(request.getHints());
     if (NULL == helper) {
@@ -249,17 +265,16 @@ std::vector<unsigned char> OBPGPIOProtocol::getEGPIO_AvailableModes(const Bus &b
     request.setPinNumber(pinNumber);
 
     /* This transfer() may cause a ProtocolException to be thrown. */
-    vector<byte> *raw = request.queryDevice(helper);
-    if (NULL == raw) {
+    const byte *raw = NULL;
+    int rawLength = request.queryDeviceInPlace(helper, &raw);
+    if (rawLength < 0) {
         string error("Expected queryDevice to produce a non-null result "
             "containing calibration data.  Without this data, it is not possible to "
             "generate a calibration array.");
         throw ProtocolException(error);
     }
 
-    vector<unsigned char> result = *raw;
-
-    delete raw;
+    vector<unsigned char> result(raw, raw + rawLength);
 
     return result;
 }
@@ -267,7 +282,7 @@ std::vector<unsigned char> OBPGPIOProtocol::getEGPIO_AvailableModes(const Bus &b
 unsigned char OBPGPIOProtocol::getEGPIO_CurrentMode(const Bus &bus, unsigned char pinNumber ) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPGetGPIOExtensionCurrentModeExchange request;
+    OBPGetGPIOExtensionCurrentModeExchange &request = *(this->getGPIOExtensionCurrentModeExchange);
 
     request.setPinNumber(pinNumber);
 
@@ -278,22 +293,20 @@ unsigned char OBPGPIOProtocol::getEGPIO_CurrentMode(const Bus &bus, unsigned cha
     }
 
     /* This transfer() may cause a ProtocolException to be thrown. */
-    vector<byte> *raw = request.queryDevice(helper);
-    if (NULL == raw) {
+    const byte *raw = NULL;
+    int rawLength = request.queryDeviceInPlace(helper, &raw);
+    if (rawLength < 0) {
         string error("Expected queryDevice to produce a non-null result.  Without this data, it is not possible to continue.");
         throw ProtocolException(error);
     }
 
-    if (raw->size() < sizeof(byte)) {
+    if (rawLength < (int)sizeof(byte)) {
         string error("Failed to get back expected number of bytes that should"
             " have held collection area.");
-        delete raw;
         throw ProtocolException(error);
     }
 
-    unsigned char retval = (*raw)[0];
-
-    delete raw;
+    unsigned char retval = raw[0];
 
     return retval;
 }
@@ -301,7 +314,7 @@ unsigned char OBPGPIOProtocol::getEGPIO_CurrentMode(const Bus &bus, unsigned cha
 void OBPGPIOProtocol::setEGPIO_Mode(const Bus &bus, unsigned char pinNumber, unsigned char mode, float value) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPSetGPIOExtensionModeExchange command;
+    OBPSetGPIOExtensionModeExchange &command = *(this->setGPIOExtensionModeExchange);
 
     helper = bus.getHelper(command.getHints());
     if (NULL == helper) {
@@ -321,7 +334,7 @@ void OBPGPIOProtocol::setEGPIO_Mode(const Bus &bus, unsigned char pinNumber, uns
 unsigned int OBPGPIOProtocol::getEGPIO_OutputVector(const Bus &bus) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPGetGPIOExtensionOutputVectorExchange request;
+    OBPGetGPIOExtensionOutputVectorExchange &request = *(this->getGPIOExtensionOutputVectorExchange);
 
     helper = bus.getHelper(request.getHints());
     if (NULL == helper) {
@@ -330,22 +343,20 @@ unsigned int OBPGPIOProtocol::getEGPIO_OutputVector(const Bus &bus) throw (Proto
     }
 
     /* This transfer() may cause a ProtocolException to be thrown. */
-    vector<byte> *raw = request.queryDevice(helper);
-    if (NULL == raw) {
+    const byte *raw = NULL;
+    int rawLength = request.queryDeviceInPlace(helper, &raw);
+    if (rawLength < 0) {
         string error("Expected queryDevice to produce a non-null result.  Without this data, it is not possible to continue.");
         throw ProtocolException(error);
     }
 
-    if (raw->size() < sizeof(byte)) {
+    if (rawLength < (int)sizeof(byte)) {
         string error("Failed to get back expected number of bytes that should"
             " have held collection area.");
-        delete raw;
         throw ProtocolException(error);
     }
 
-    unsigned int retval = (*raw)[0];
-
-    delete raw;
+    unsigned int retval = raw[0];
 
     return retval;
 }
@@ -353,7 +364,7 @@ unsigned int OBPGPIOProtocol::getEGPIO_OutputVector(const Bus &bus) throw (Proto
 void OBPGPIOProtocol::setEGPIO_OutputVector(const Bus &bus, unsigned int outputVector, unsigned int bitMask) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPSetGPIOExtensionOutputVectorExchange command;
+    OBPSetGPIOExtensionOutputVectorExchange &command = *(this->setGPIOExtensionOutputVectorExchange);
 
     helper = bus.getHelper(command.getHints());
     if (NULL == helper) {
@@ -374,7 +385,7 @@ void OBPGPIOProtocol::setEGPIO_OutputVector(const Bus &bus, unsigned int outputV
 float OBPGPIOProtocol::getEGPIO_Value(const Bus &bus, unsigned char pinNumber) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPGetGPIOExtensionValueExchange request;
+    OBPGetGPIOExtensionValueExchange &request = *(this->getGPIOExtensionValueExchange);
 
     request.setPinNumber(pinNumber);
 
@@ -385,22 +396,20 @@ float OBPGPIOProtocol::getEGPIO_Value(const Bus &bus, unsigned char pinNumber) t
     }
 
     /* This transfer() may cause a ProtocolException to be thrown. */
-    vector<byte> *raw = request.queryDevice(helper);
-    if (NULL == raw) {
+    const byte *raw = NULL;
+    int rawLength = request.queryDeviceInPlace(helper, &raw);
+    if (rawLength < 0) {
         string error("Expected queryDevice to produce a non-null result.  Without this data, it is not possible to continue.");
         throw ProtocolException(error);
     }
 
-    if (raw->size() < sizeof(byte)) {
+    if (rawLength < (int)sizeof(byte)) {
         string error("Failed to get back expected number of bytes that should"
             " have held collection area.");
-        delete raw;
         throw ProtocolException(error);
     }
 
-    float retval = (*raw)[0];
-
-    delete raw;
+    float retval = raw[0];
 
     return retval;
 }
@@ -408,7 +417,7 @@ float OBPGPIOProtocol::getEGPIO_Value(const Bus &bus, unsigned char pinNumber) t
 void OBPGPIOProtocol::setEGPIO_Value(const Bus &bus, unsigned char pinNumber, float value) throw (ProtocolException)
 {
     TransferHelper *helper;
-    OBPSetGPIOExtensionValueExchange command;
+    OBPSetGPIOExtensionValueExchange &command = *(this->setGPIOExtensionValueExchange);
 
     helper = bus.getHelper(command.getHints());
     if (NULL == helper) {
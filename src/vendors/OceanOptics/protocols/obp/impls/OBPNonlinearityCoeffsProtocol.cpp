@@ -30,6 +30,7 @@
 #include "common/globals.h"
 #include "vendors/OceanOptics/protocols/obp/impls/OBPNonlinearityCoeffsProtocol.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPGetNonlinearityCoeffExchange.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPQueryBatch.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPGetNonlinearityCoeffsCountExchange.h"
 #include "vendors/OceanOptics/protocols/obp/impls/OceanBinaryProtocol.h"
 #include "common/exceptions/ProtocolBusMismatchException.h"
@@ -49,11 +50,11 @@ OBPNonlinearityCoeffsProtocol::~OBPNonlinearityCoeffsProtocol() {
 
 vector<double> *OBPNonlinearityCoeffsProtocol::readNonlinearityCoeffs(const Bus &bus)
                 throw (ProtocolException) {
-    vector<byte> *result = NULL;
     unsigned int i;
     vector<double> *retval;
     float coeff;
     byte *bptr;
+    OBPQueryBatch batch;
     int count = 0;
     vector<byte> *countResult;
 
@@ -76,10 +77,24 @@ vector<double> *OBPNonlinearityCoeffsProtocol::readNonlinearityCoeffs(const Bus
     delete countResult;
 
     retval = new vector<double>(count);
+
+    /* All of the coefficients are asked for before any reply is read, so
+     * the whole set costs about one round trip.
+     */
     for(i = 0; i < retval->size(); i++) {
         xchange.setCoefficientIndex(i);
-        result = xchange.queryDevice(helper);
-        if(NULL == result) {
+        batch.add(xchange);
+    }
+    try {
+        batch.run(helper);
+    } catch (ProtocolException &pe) {
+        delete retval;
+        throw;
+    }
+
+    for(i = 0; i < retval->size(); i++) {
+        const vector<byte> &result = batch.getReply(i);
+        if(true == batch.wasRefused(i) || result.size() < sizeof(float)) {
             string error("Expected Transfer::transfer to produce a non-null result "
                 "containing linearity coefficient.  Without this data, it is not possible to "
                 "continue.");
@@ -89,12 +104,10 @@ vector<double> *OBPNonlinearityCoeffsProtocol::readNonlinearityCoeffs(const Bus
 
         bptr = (byte *)&coeff;
         for(unsigned int j = 0; j < sizeof(float); j++) {
-            bptr[j] = (*result)[j];
+            bptr[j] = result[j];
         }
 
         (*retval)[i] = coeff;  /* Only one is returned per request */
-
-        delete result;
     }
 
     return retval;
@@ -39,18 +39,18 @@ using namespace std;
 
 OBPProgrammableSaturationProtocol::OBPProgrammableSaturationProtocol()
     : ProgrammableSaturationProtocolInterface(new OceanBinaryProtocol()) {
-    
+    this->getSaturationExchange = new OBPGetSaturationExchange();
 }
 
 OBPProgrammableSaturationProtocol::~OBPProgrammableSaturationProtocol() {
-    
+    delete this->getSaturationExchange;
 }
 
 unsigned int OBPProgrammableSaturationProtocol::getSaturation(const Bus &bus)
         throw (ProtocolException) {
     
     TransferHelper *helper;
-    OBPGetSaturationExchange exchange;
+    OBPGetSaturationExchange &exchange = *(this->getSaturationExchange);
 
     helper = bus.getHelper(exchange.getHints());
     if (NULL == helper) {
@@ -28,6 +28,7 @@
  *******************************************************/
 
 #include "common/globals.h"
+#include <string.h>
 #include "vendors/OceanOptics/protocols/obp/impls/OBPSpectrometerProtocol.h"
 #include "vendors/OceanOptics/protocols/obp/impls/OceanBinaryProtocol.h"
 #include "common/ByteVector.h"
@@ -35,6 +36,7 @@
 #include "common/UShortVector.h"
 #include "common/U32Vector.h"
 #include "common/DoubleVector.h"
+#include "common/PixelUnpack.h"
 #include "common/exceptions/ProtocolBusMismatchException.h"
 
 using namespace seabreeze;
@@ -59,9 +61,11 @@ OBPSpectrometerProtocol::OBPSpectrometerProtocol(
     this->requestFastBufferSpectrumExchange = requestFastBufferSpectrum;
     this->readFastBufferSpectrumExchange = readFastBufferSpectrum;
     this->triggerModeExchange = triggerMode;
+    this->borrowedSpectrum = NULL;
 }
 
 OBPSpectrometerProtocol::~OBPSpectrometerProtocol() {
+    delete this->borrowedSpectrum;
     delete this->integrationTimeExchange;
     delete this->requestFormattedSpectrumExchange;
     delete this->readFormattedSpectrumExchange;
@@ -140,10 +144,60 @@ void OBPSpectrometerProtocol::Initialize(
 
 }
 
+void OBPSpectrometerProtocol::submitUnformattedSpectrum(const Bus &bus)
+        throw (ProtocolException)
+{
+    TransferHelper *helper;
+
+    helper = bus.getHelper(this->readUnformattedSpectrumExchange->getHints());
+    if (NULL == helper)
+    {
+        string error("Failed to find a helper to bridge given protocol and bus.");
+        throw ProtocolBusMismatchException(error);
+    }
+
+    /* Have the read waiting before the spectrum is asked for */
+    try
+    {
+        helper->submitReceive(this->readUnformattedSpectrumExchange->getLength());
+    }
+    catch (BusException &be)
+    {
+        string error("Failed to queue a read on the bus: ");
+        error += be.what();
+        throw ProtocolException(error);
+    }
+
+    requestUnformattedSpectrum(bus);
+}
+
+bool OBPSpectrometerProtocol::isUnformattedSpectrumReady(const Bus &bus)
+        throw (ProtocolException)
+{
+    TransferHelper *helper;
+
+    helper = bus.getHelper(this->readUnformattedSpectrumExchange->getHints());
+    if (NULL == helper)
+    {
+        string error("Failed to find a helper to bridge given protocol and bus.");
+        throw ProtocolBusMismatchException(error);
+    }
+
+    try
+    {
+        return helper->isReceiveReady();
+    }
+    catch (BusException &be)
+    {
+        string error("Failed to check for a queued read: ");
+        error += be.what();
+        throw ProtocolException(error);
+    }
+}
+
 ByteVector *OBPSpectrometerProtocol::readUnformattedSpectrum(const Bus &bus)
         throw (ProtocolException) 
 {
-    Data *result;
     TransferHelper *helper;
 
     helper = bus.getHelper(this->readUnformattedSpectrumExchange->getHints());
@@ -153,6 +207,14 @@ ByteVector *OBPSpectrometerProtocol::readUnformattedSpectrum(const Bus &bus)
         throw ProtocolBusMismatchException(error);
     }
 
+    return readUnformattedSpectrum(helper);
+}
+
+ByteVector *OBPSpectrometerProtocol::readUnformattedSpectrum(TransferHelper *helper)
+        throw (ProtocolException) 
+{
+    Data *result;
+
     /* This transfer() may cause a ProtocolException to be thrown. */
     result = this->readUnformattedSpectrumExchange->transfer(helper);
 
@@ -173,6 +235,26 @@ ByteVector *OBPSpectrometerProtocol::readUnformattedSpectrum(const Bus &bus)
     return retval;
 }
 
+int OBPSpectrometerProtocol::borrowUnformattedSpectrum(const Bus &bus,
+        const byte **data) throw (ProtocolException)
+{
+    /* Only one spectrum can be out at a time */
+    releaseUnformattedSpectrum(bus);
+
+    this->borrowedSpectrum = readUnformattedSpectrum(bus);
+    vector<byte> &spectrum = this->borrowedSpectrum->getByteVector();
+    *data = spectrum.empty() ? NULL : &(spectrum[0]);
+
+    return (int)spectrum.size();
+}
+
+void OBPSpectrometerProtocol::releaseUnformattedSpectrum(const Bus &bus)
+        throw (ProtocolException)
+{
+    delete this->borrowedSpectrum;
+    this->borrowedSpectrum = NULL;
+}
+
 ByteVector *OBPSpectrometerProtocol::readFastBufferSpectrum(const Bus &bus, unsigned int numberOfSamplesToRetrieve)
 throw (ProtocolException) 
 {
@@ -212,8 +294,6 @@ throw (ProtocolException)
 DoubleVector *OBPSpectrometerProtocol::readFormattedSpectrum(const Bus &bus)
         throw (ProtocolException) {
     TransferHelper *helper;
-    Data *result;
-    unsigned int i;
 
     helper = bus.getHelper(this->readFormattedSpectrumExchange->getHints());
     if (NULL == helper) {
@@ -221,6 +301,13 @@ DoubleVector *OBPSpectrometerProtocol::readFormattedSpectrum(const Bus &bus)
         throw ProtocolBusMismatchException(error);
     }
 
+    return readFormattedSpectrum(helper);
+}
+
+Data *OBPSpectrometerProtocol::readNativeSpectrum(TransferHelper *helper)
+        throw (ProtocolException) {
+    Data *result;
+
     /* This transfer() may cause a ProtocolException to be thrown. */
     result = this->readFormattedSpectrumExchange->transfer(helper);
 
@@ -229,6 +316,41 @@ DoubleVector *OBPSpectrometerProtocol::readFormattedSpectrum(const Bus &bus)
         throw ProtocolException(error);
     }
 
+    return result;
+}
+
+DoubleVector *OBPSpectrometerProtocol::readFormattedSpectrum(TransferHelper *helper)
+        throw (ProtocolException) {
+    return readFormattedSpectrum(helper, 0.0, NULL);
+}
+
+unsigned int OBPSpectrometerProtocol::readFormattedSpectrum(TransferHelper *helper,
+        double *spectrum, unsigned int length) throw (ProtocolException) {
+    int count;
+
+    count = this->readFormattedSpectrumExchange->transferSpectrum(helper,
+        spectrum, length);
+    if(count >= 0) {
+        return (unsigned int)count;
+    }
+
+    DoubleVector *formatted = readFormattedSpectrum(helper);
+    vector<double> &pixels = formatted->getDoubleVector();
+    count = ((unsigned int)pixels.size() < length) ? (int)pixels.size() : (int)length;
+    if(count > 0) {
+        memcpy(spectrum, &(pixels[0]), count * sizeof(double));
+    }
+    delete formatted;
+
+    return (unsigned int)count;
+}
+
+DoubleVector *OBPSpectrometerProtocol::readFormattedSpectrum(TransferHelper *helper,
+        double saturationLevel, SpectrumStatistics *statistics)
+        throw (ProtocolException) {
+    Data *result = readNativeSpectrum(helper);
+    unsigned int i;
+
     /* FIXME: not knowing whether doubles or shorts will be returned
      * requires an RTTI lookup with dynamic_cast.  It might be better
      * to have the conversion to doubles done at a lower level (if that
@@ -248,9 +370,16 @@ DoubleVector *OBPSpectrometerProtocol::readFormattedSpectrum(const Bus &bus)
         if(NULL != usv) {
             // Short vector
             vector<unsigned short>& spectrum = usv->getUShortVector();
-            out.reserve(spectrum.size());
-            for (i = 0; i < spectrum.size(); i++) {
-                out.push_back((double)spectrum[i]);
+            out.resize(spectrum.size());
+            if(NULL != statistics) {
+                PixelUnpack::widenToDoubleWithStatistics(
+                    (true == spectrum.empty()) ? NULL : &(spectrum[0]),
+                    (true == out.empty()) ? NULL : &(out[0]),
+                    (unsigned int)spectrum.size(), saturationLevel, statistics);
+                statistics = NULL;
+            } else if(false == spectrum.empty()) {
+                PixelUnpack::widenToDouble(&(spectrum[0]), &(out[0]),
+                    (unsigned int)spectrum.size());
             }
 
         } else {
@@ -272,6 +401,13 @@ DoubleVector *OBPSpectrometerProtocol::readFormattedSpectrum(const Bus &bus)
         delete result;
     }
 
+    /* 32-bit and already scaled spectra get a separate pass */
+    if(NULL != statistics) {
+        vector<double>& out = retval->getDoubleVector();
+        PixelUnpack::computeStatistics((true == out.empty()) ? NULL : &(out[0]),
+            (unsigned int)out.size(), saturationLevel, statistics);
+    }
+
     return retval;
 }
 
@@ -286,6 +422,11 @@ void OBPSpectrometerProtocol::requestFormattedSpectrum(const Bus &bus)
         throw ProtocolBusMismatchException(error);
     }
 
+    requestFormattedSpectrum(helper);
+}
+
+void OBPSpectrometerProtocol::requestFormattedSpectrum(TransferHelper *helper)
+        throw (ProtocolException) {
     /* This transfer() may cause a ProtocolException to be thrown. */
     this->requestFormattedSpectrumExchange->transfer(helper);
 }
@@ -301,6 +442,11 @@ throw (ProtocolException) {
         throw ProtocolBusMismatchException(error);
     }
 
+    requestUnformattedSpectrum(helper);
+}
+
+void OBPSpectrometerProtocol::requestUnformattedSpectrum(TransferHelper *helper)
+throw (ProtocolException) {
     /* This transfer() may cause a ProtocolException to be thrown. */
     this->requestUnformattedSpectrumExchange->transfer(helper);
 }
@@ -355,3 +501,18 @@ void OBPSpectrometerProtocol::setTriggerMode(const Bus &bus,
     /* This may cause a ProtocolException to be thrown. */
     this->triggerModeExchange->sendCommandToDevice(helper);
 }
+
+void OBPSpectrometerProtocol::resolveAcquisition(const Bus &bus,
+            SpectrometerAcquisition *acquisition) throw (ProtocolException) {
+    acquisition->protocol = this;
+    acquisition->requestFormattedHelper = bus.getHelper(this->requestFormattedSpectrumExchange->getHints());
+    acquisition->readFormattedHelper = bus.getHelper(this->readFormattedSpectrumExchange->getHints());
+    acquisition->requestUnformattedHelper = bus.getHelper(this->requestUnformattedSpectrumExchange->getHints());
+    acquisition->readUnformattedHelper = bus.getHelper(this->readUnformattedSpectrumExchange->getHints());
+
+    if (NULL == acquisition->requestFormattedHelper || NULL == acquisition->readFormattedHelper
+            || NULL == acquisition->requestUnformattedHelper || NULL == acquisition->readUnformattedHelper) {
+        string error("Failed to find a helper to bridge given protocol and bus.");
+        throw ProtocolBusMismatchException(error);
+    }
+}
@@ -30,6 +30,7 @@
 #include "common/globals.h"
 #include "vendors/OceanOptics/protocols/obp/impls/OBPStrayLightCoeffsProtocol.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPGetStrayLightCoeffExchange.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPQueryBatch.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPGetStrayLightCoeffsCountExchange.h"
 #include "vendors/OceanOptics/protocols/obp/impls/OceanBinaryProtocol.h"
 #include "common/exceptions/ProtocolBusMismatchException.h"
@@ -49,11 +50,11 @@ OBPStrayLightCoeffsProtocol::~OBPStrayLightCoeffsProtocol() {
 
 vector<double> *OBPStrayLightCoeffsProtocol::readStrayLightCoeffs(const Bus &bus)
                 throw (ProtocolException) {
-    vector<byte> *result = NULL;
     unsigned int i;
     vector<double> *retval;
     float coeff;
     byte *bptr;
+    OBPQueryBatch batch;
     int count = 0;
     vector<byte> *countResult;
 
@@ -76,10 +77,22 @@ vector<double> *OBPStrayLightCoeffsProtocol::readStrayLightCoeffs(const Bus &bus
     delete countResult;
 
     retval = new vector<double>(count);
+
+    /* Request every coefficient before reading any of the replies */
     for(i = 0; i < retval->size(); i++) {
         xchange.setCoefficientIndex(i);
-        result = xchange.queryDevice(helper);
-        if(NULL == result) {
+        batch.add(xchange);
+    }
+    try {
+        batch.run(helper);
+    } catch (ProtocolException &pe) {
+        delete retval;
+        throw;
+    }
+
+    for(i = 0; i < retval->size(); i++) {
+        const vector<byte> &result = batch.getReply(i);
+        if(true == batch.wasRefused(i) || result.size() < sizeof(float)) {
             string error("Expected Transfer::transfer to produce a non-null result "
                 "containing stray light coefficient.  Without this data, it is not possible to "
                 "continue.");
@@ -89,12 +102,10 @@ vector<double> *OBPStrayLightCoeffsProtocol::readStrayLightCoeffs(const Bus &bus
 
         bptr = (byte *)&coeff;
         for(unsigned int j = 0; j < sizeof(float); j++) {
-            bptr[j] = (*result)[j];
+            bptr[j] = result[j];
         }
 
         (*retval)[i] = coeff;  /* Only one is returned per request */
-
-        delete result;
     }
 
     return retval;
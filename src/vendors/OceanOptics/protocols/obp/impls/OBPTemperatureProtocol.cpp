@@ -42,10 +42,15 @@ using namespace std;
 OBPTemperatureProtocol::OBPTemperatureProtocol()
         : TemperatureProtocolInterface(new OceanBinaryProtocol()) {
 
+    this->temperatureExchange = new OBPGetTemperatureExchange();
+    this->allTemperaturesExchange = new OBPGetAllTemperaturesExchange();
+    this->temperatureCountExchange = new OBPGetTemperatureCountExchange();
 }
 
 OBPTemperatureProtocol::~OBPTemperatureProtocol() {
-
+    delete this->temperatureExchange;
+    delete this->allTemperaturesExchange;
+    delete this->temperatureCountExchange;
 }
 
 
@@ -53,9 +58,9 @@ unsigned char OBPTemperatureProtocol::readTemperatureCount(const Bus &bus)
                 throw (ProtocolException) 
 {
     int count = 0;
-    vector<byte> *countResult;
+    const byte *countResult = NULL;
 
-    OBPGetTemperatureCountExchange countExchange;
+    OBPGetTemperatureCountExchange &countExchange = *(this->temperatureCountExchange);
     
     TransferHelper *helper = bus.getHelper(countExchange.getHints());
     if(NULL == helper) 
@@ -64,10 +69,13 @@ unsigned char OBPTemperatureProtocol::readTemperatureCount(const Bus &bus)
         throw ProtocolBusMismatchException(error);
     }
     
-    countResult = countExchange.queryDevice(helper);
+    if(countExchange.queryDeviceInPlace(helper, &countResult) < 1)
+    {
+        /* Device is incapable of providing temperature */
+        return 0;
+    }
 
-    count = (*countResult)[0];
-    delete countResult;
+    count = countResult[0];
 
     return count;
 }
@@ -75,14 +83,14 @@ unsigned char OBPTemperatureProtocol::readTemperatureCount(const Bus &bus)
 double OBPTemperatureProtocol::readTemperature(const Bus &bus, int index)
                 throw (ProtocolException) 
 {
-    vector<byte> *result = NULL;
+    const byte *result = NULL;
     float temperature;
     byte *bptr;
     int count = 0;
-    vector<byte> *countResult;
+    const byte *countResult = NULL;
     
-    OBPGetTemperatureExchange xchange;
-    OBPGetTemperatureCountExchange countExchange;
+    OBPGetTemperatureExchange &xchange = *(this->temperatureExchange);
+    OBPGetTemperatureCountExchange &countExchange = *(this->temperatureCountExchange);
     
     TransferHelper *helper = bus.getHelper(xchange.getHints());
     if(NULL == helper) 
@@ -93,20 +101,17 @@ double OBPTemperatureProtocol::readTemperature(const Bus &bus, int index)
     
     // although the number of temperatures is not needed for the query, it is nice to
     //  confirm that the index is in bounds
-    countResult = countExchange.queryDevice(helper);
-    if(NULL == countResult || (*countResult)[0] > 16) 
+    if(countExchange.queryDeviceInPlace(helper, &countResult) < 1 || countResult[0] > 16) 
     {
         /* Device is incapable of providing temperature */
         return 0;
     }
 
-    count = (*countResult)[0];
-    delete countResult;
+    count = countResult[0];
 
     if ((index>=0) && (index<count)) {
         xchange.setTemperatureIndex(index);
-        result = xchange.queryDevice(helper);
-        if(NULL == result) {
+        if(xchange.queryDeviceInPlace(helper, &result) < (int)sizeof(float)) {
             string error("Expected Transfer::transfer to produce a non-null result "
                 "containing temperature.  Without this data, it is not possible to "
                 "continue.");
@@ -117,9 +122,8 @@ double OBPTemperatureProtocol::readTemperature(const Bus &bus, int index)
         bptr = (byte *)&temperature;
         for(unsigned int j = 0; j < sizeof(float); j++) { // four bytes returned
             //printf("byte %d=%x\n", j, (*result)[j]);
-            bptr[j] = (*result)[j];  // get a little endian float
+            bptr[j] = result[j];  // get a little endian float
         }
-        delete result;
     }
     else {
         string error("Bad Argument::The temperature index was out of bounds.");
@@ -133,16 +137,17 @@ double OBPTemperatureProtocol::readTemperature(const Bus &bus, int index)
 vector<double> *OBPTemperatureProtocol::readAllTemperatures(const Bus &bus) 
         throw (ProtocolException) {
     
-    vector<byte> *result = NULL;
+    const byte *result = NULL;
+    int resultLength;
     unsigned int i;
     vector<double> *retval; // temperatures
     byte *bptr;
     float temperatureBuffer;
     int count = 0;
-    vector<byte> *countResult;
+    const byte *countResult = NULL;
 
-    OBPGetAllTemperaturesExchange xchange;
-    OBPGetTemperatureCountExchange countExchange;
+    OBPGetAllTemperaturesExchange &xchange = *(this->allTemperaturesExchange);
+    OBPGetTemperatureCountExchange &countExchange = *(this->temperatureCountExchange);
 
     TransferHelper *helper = bus.getHelper(xchange.getHints());
     if(NULL == helper) {
@@ -150,20 +155,18 @@ vector<double> *OBPTemperatureProtocol::readAllTemperatures(const Bus &bus)
         throw ProtocolBusMismatchException(error);
     }
 
-    countResult = countExchange.queryDevice(helper);
-    if(NULL == countResult || (*countResult)[0] > 16) {
+    if(countExchange.queryDeviceInPlace(helper, &countResult) < 1 || countResult[0] > 16) {
         /* Device is incapable of providing temperature */
         return NULL;
     }
 
-    count = (*countResult)[0];
-    delete countResult;
+    count = countResult[0];
 
     retval = new vector<double>(count); // temperature array to be returned
     // query device returns a generic byte array, 
     // not temperature floats as defined by the actual command 
-    result = xchange.queryDevice(helper); 
-    if(NULL == result) {
+    resultLength = xchange.queryDeviceInPlace(helper, &result); 
+    if(resultLength < (int)(count * sizeof(float))) {
         string error("Expected Transfer::transfer to produce a non-null result "
             "containing temperature.  Without this data, it is not possible to "
             "continue.");
@@ -177,14 +180,13 @@ vector<double> *OBPTemperatureProtocol::readAllTemperatures(const Bus &bus)
             
             bptr = (byte *)&temperatureBuffer;
             for(unsigned int j = 0; j < sizeof(float); j++) {
-                bptr[j] = (*result)[j+(i*sizeof(float))];
+                bptr[j] = result[j+(i*sizeof(float))];
             }
 
             // fill the return array with the temperatures
             (*retval)[i] = (double)temperatureBuffer;  
         }
     }
-    delete result;
     return retval;
 }
 
@@ -30,6 +30,7 @@
 #include "common/globals.h"
 #include "vendors/OceanOptics/protocols/obp/impls/OBPWaveCalProtocol.h"
 #include "vendors/OceanOptics/protocols/obp/exchanges/OBPGetWaveCalExchange.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPQueryBatch.h"
 #include "vendors/OceanOptics/protocols/obp/impls/OceanBinaryProtocol.h"
 #include "common/exceptions/ProtocolBusMismatchException.h"
 
@@ -47,11 +48,11 @@ OBPWaveCalProtocol::~OBPWaveCalProtocol() {
 
 vector<double> *OBPWaveCalProtocol::readWavelengthCoeffs(const Bus &bus)
                 throw (ProtocolException) {
-    vector<byte> *result = NULL;
     unsigned int i;
     vector<double> *retval;
     float coeff;
     byte *bptr;
+    OBPQueryBatch batch;
 
     OBPGetWaveCalExchange xchange;
 
@@ -62,10 +63,22 @@ vector<double> *OBPWaveCalProtocol::readWavelengthCoeffs(const Bus &bus)
     }
 
     retval = new vector<double>(4);
+
+    /* The four coefficients go out in one burst */
     for(i = 0; i < retval->size(); i++) {
         xchange.setCoefficientIndex(i);
-        result = xchange.queryDevice(helper);
-        if(NULL == result) {
+        batch.add(xchange);
+    }
+    try {
+        batch.run(helper);
+    } catch (ProtocolException &pe) {
+        delete retval;
+        throw;
+    }
+
+    for(i = 0; i < retval->size(); i++) {
+        const vector<byte> &result = batch.getReply(i);
+        if(true == batch.wasRefused(i) || result.size() < sizeof(float)) {
             string error("Expected Transfer::transfer to produce a non-null result "
                 "containing wavelength coefficient.  Without this data, it is not possible to "
                 "continue.");
@@ -75,12 +88,10 @@ vector<double> *OBPWaveCalProtocol::readWavelengthCoeffs(const Bus &bus)
 
         bptr = (byte *)&coeff;
         for(unsigned int j = 0; j < sizeof(float); j++) {
-            bptr[j] = (*result)[j];
+            bptr[j] = result[j];
         }
 
         (*retval)[i] = coeff;  /* Only one is returned per request */
-
-        delete result;
     }
 
     return retval;
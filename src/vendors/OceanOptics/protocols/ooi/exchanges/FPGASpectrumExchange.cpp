@@ -32,6 +32,7 @@
 #include <vector>
 #include "vendors/OceanOptics/protocols/ooi/exchanges/FPGASpectrumExchange.h"
 #include "common/UShortVector.h"
+#include "common/PixelUnpack.h"
 #include "common/exceptions/ProtocolFormatException.h"
 
 using namespace seabreeze;
@@ -48,29 +49,14 @@ FPGASpectrumExchange::~FPGASpectrumExchange() {
 
 }
 
-Data *FPGASpectrumExchange::transfer(TransferHelper *helper)
+void FPGASpectrumExchange::receiveSpectrum(TransferHelper *helper)
         throw (ProtocolException) {
     LOG(__FUNCTION__);
 
-    unsigned int i;
-    Data *xfer;
-    byte lsb;
-    byte msb;
-
-    /* Use the superclass to move the data into a local buffer. */
-    xfer = Transfer::transfer(helper);
-    if(NULL == xfer) {
-        string error("FPGASpectrumExchange::transfer: " 
-                "Expected Transfer::transfer to produce a non-null result "
-                "containing raw spectral data.  Without this data, it is not possible to "
-                "generate a valid formatted spectrum.");
-        logger.error(error.c_str());
-        throw ProtocolException(error);
-    }
-
-
-    /* xfer is just a copy of what is already stored in this, so delete it. */
-    delete xfer;
+    /* Use the superclass to move the data into this->buffer, where the
+     * caller decodes it.  This may throw a ProtocolException.
+     */
+    Transfer::transferInPlace(helper);
     /* At this point, this->buffer should have the raw spectrum data. */
 
     /* In this style of transfer, the last byte should be 0x69.  If it is not, then
@@ -85,19 +71,32 @@ Data *FPGASpectrumExchange::transfer(TransferHelper *helper)
         logger.error(synchError.c_str());
         throw ProtocolFormatException(synchError);
     }
+}
+
+Data *FPGASpectrumExchange::transfer(TransferHelper *helper)
+        throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    receiveSpectrum(helper);
     
-    /* Allocate output vector */
-    UShortVector *retval = new UShortVector();
-    /* Get local reference */
+    /* Decode straight into the vector that will be handed back */
+    UShortVector *retval = new UShortVector(this->numberOfPixels);
     vector<unsigned short>& formatted = retval->getUShortVector();
-    /* Pre-allocate */
-    formatted.reserve(this->numberOfPixels);
-    /* Store spectrum */
-    for(i = 0; i < this->numberOfPixels; i++) {
-        lsb = (*(this->buffer))[i * 2];
-        msb = ((*(this->buffer))[(i * 2) + 1]);
-        formatted.push_back(((msb << 8) & 0x00FF00) | (lsb & 0x00FF));
-    }
+    PixelUnpack::unpackLE16(&((*(this->buffer))[0]), &(formatted[0]),
+        this->numberOfPixels);
 
     return retval;
 }
+
+int FPGASpectrumExchange::transferSpectrum(TransferHelper *helper, double *spectrum,
+        unsigned int length) throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    unsigned int count = (length < this->numberOfPixels) ? length : this->numberOfPixels;
+
+    receiveSpectrum(helper);
+
+    PixelUnpack::unpackLE16ToDouble(&((*(this->buffer))[0]), spectrum, count);
+
+    return (int)count;
+}
@@ -31,8 +31,10 @@
 
 #include "common/globals.h"
 #include "common/Log.h"
+#include "common/ByteVector.h"
 #include "common/UShortVector.h"
 #include "common/DoubleVector.h"
+#include "common/PixelUnpack.h"
 #include "common/exceptions/ProtocolFormatException.h"
 
 #include "vendors/OceanOptics/protocols/ooi/exchanges/FlameNIRSpectrumExchange.h"
@@ -56,68 +58,42 @@ Data *FlameNIRSpectrumExchange::transfer(TransferHelper *helper)
     LOG(__FUNCTION__);
 
     unsigned int i;
-    Data *xfer;
     double maxIntensity;
     double saturationLevel;
-    byte lsb;
-    byte msb;
-
-    // Use the superclass to move the data into a local buffer. 
-    // This transfer() may cause a ProtocolException to be thrown. 
-    xfer = Transfer::transfer(helper);
-    if(NULL == xfer) {
-        string error("FlameNIRSpectrumExchange::transfer: "
-            "Expected Transfer::transfer to produce a non-null result "
-            "containing raw spectral data.  Without this data, it is not possible to "
-            "generate a valid formatted spectrum.");
-        logger.error(error.c_str());
-        throw ProtocolException(error);
-    }
+
+    // Use the superclass to move the data into this->buffer, which is
+    // decoded in place below.  This may throw a ProtocolException.
+    Transfer::transferInPlace(helper);
 
     // At this point, this->buffer should have the raw spectrum data. 
 
     // We would normally check for synchronization byte here, but Flame-NIR 
     // does not send one.
 
-    // Get a local variable by reference to point to that buffer 
-    logger.debug("demarshalling");
-    vector<unsigned short> formatted(this->numberOfPixels);
-    for(i = 0; i < this->numberOfPixels; i++) {
-        lsb = (*(this->buffer))[i * 2];
-        msb = ((*(this->buffer))[(i * 2) + 1]);
-        formatted[i] = ((msb << 8) & 0x00ff00) | (lsb & 0x00ff);
-    }
-
     // confirm we can gain-adjust
     if(NULL == this->spectrometerFeature) {
         // FIXME: should this throw an illegal state exception instead? 
-        return xfer;
+        return new ByteVector(*(this->buffer));
     }
 
-    // xfer is just a copy of what is already stored in this, so delete it. 
-    delete xfer;
-
     maxIntensity = this->spectrometerFeature->getMaximumIntensity();
     saturationLevel = this->spectrometerFeature->getSaturationLevel();
 
-    // Cast the formatted values so that we can get to the array of shorts 
-    UShortVector *usv = new UShortVector(formatted);
-    vector<unsigned short> shortVec = usv->getUShortVector();
-
-    // Create a local buffer to store the gain-adjusted values  
-    vector<double> adjusted(this->numberOfPixels);
+    // Unpack straight into the returned vector and gain-adjust in place
+    logger.debug("demarshalling");
+    DoubleVector *retval = new DoubleVector();
+    vector<double> &adjusted = retval->getDoubleVector();
+    adjusted.resize(this->numberOfPixels);
+    PixelUnpack::unpackLE16ToDouble(&((*(this->buffer))[0]), &(adjusted[0]),
+        this->numberOfPixels);
 
     for(i = 0; i < this->numberOfPixels; i++) {
-        double temp = shortVec[i] * maxIntensity / saturationLevel;
+        double temp = adjusted[i] * maxIntensity / saturationLevel;
         if(temp > maxIntensity) {
             temp = maxIntensity;
         }
         adjusted[i] = temp;
     }
 
-    // It might speed things up to dynamically allocate the buffer and
-    // hand it off to retval rather than letting it make a copy.
-    DoubleVector *retval = new DoubleVector(adjusted);
-
     return retval;
 }
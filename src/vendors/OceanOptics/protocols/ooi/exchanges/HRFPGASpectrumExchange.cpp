@@ -31,6 +31,7 @@
 #include <vector>
 #include "vendors/OceanOptics/protocols/ooi/exchanges/HRFPGASpectrumExchange.h"
 #include "common/UShortVector.h"
+#include "common/PixelUnpack.h"
 #include "common/exceptions/ProtocolFormatException.h"
 
 using namespace seabreeze;
@@ -47,26 +48,12 @@ HRFPGASpectrumExchange::~HRFPGASpectrumExchange() {
 
 }
 
-Data *HRFPGASpectrumExchange::transfer(TransferHelper *helper)
+void HRFPGASpectrumExchange::receiveSpectrum(TransferHelper *helper)
         throw (ProtocolException) {
-    unsigned int i;
-    Data *xfer;
-    byte lsb;
-    byte msb;
-
-    /* Use the superclass to move the data into a local buffer. */
-    xfer = Transfer::transfer(helper);
-    if(NULL == xfer) {
-        string error("HRFPGASpectrumExchange::transfer: "
-                "Expected Transfer::transfer to produce a non-null result "
-                "containing raw spectral data.  Without this data, it is not possible to "
-                "generate a valid formatted spectrum.");
-        throw ProtocolException(error);
-    }
-
-
-    /* xfer is just a copy of what is already stored in this, so delete it. */
-    delete xfer;
+    /* Use the superclass to move the data into this->buffer, where the
+     * caller decodes it.  This may throw a ProtocolException.
+     */
+    Transfer::transferInPlace(helper);
     /* At this point, this->buffer should have the raw spectrum data. */
 
     /* In this style of transfer, the last byte should be 0x69.  If it is not, then
@@ -80,18 +67,33 @@ Data *HRFPGASpectrumExchange::transfer(TransferHelper *helper)
                 "issues.");
         throw ProtocolFormatException(synchError);
     }
+}
 
-    /* Get a local variable by reference to point to that buffer */
-    vector<unsigned short> formatted(this->numberOfPixels);
+Data *HRFPGASpectrumExchange::transfer(TransferHelper *helper)
+        throw (ProtocolException) {
+    receiveSpectrum(helper);
 
-    for(i = 0; i < this->numberOfPixels; i++) {
-        lsb = (*(this->buffer))[i * 2];
-        /* Flip bit 13 as it is copied out.
-         */
-        msb = ((*(this->buffer))[(i * 2) + 1]) ^ 0x20;
-        formatted[i] = ((msb << 8) & 0x00FF00) | (lsb & 0x00FF);
-    }
-    UShortVector *retval = new UShortVector(formatted);
+    /* Decode straight into the vector that will be handed back */
+    UShortVector *retval = new UShortVector();
+    vector<unsigned short> &formatted = retval->getUShortVector();
+    formatted.resize(this->numberOfPixels);
+
+    /* Flip bit 13 as it is copied out. */
+    PixelUnpack::unpackLE16Flip(&((*(this->buffer))[0]), &(formatted[0]),
+        this->numberOfPixels, 0x2000);
 
     return retval;
 }
+
+int HRFPGASpectrumExchange::transferSpectrum(TransferHelper *helper, double *spectrum,
+        unsigned int length) throw (ProtocolException) {
+    unsigned int count = (length < this->numberOfPixels) ? length : this->numberOfPixels;
+
+    receiveSpectrum(helper);
+
+    /* Flip bit 13 as it is decoded. */
+    PixelUnpack::unpackLE16FlipToDouble(&((*(this->buffer))[0]), spectrum,
+        count, 0x2000);
+
+    return (int)count;
+}
@@ -77,7 +77,7 @@ Data *JazSpectrumExchange::transfer(TransferHelper *helper)
 
     /* Cast the formatted values so that we can get to the array of shorts */
     UShortVector *usv = static_cast<UShortVector *>(xfer);
-    vector<unsigned short> shortVec = usv->getUShortVector();
+    vector<unsigned short> &shortVec = usv->getUShortVector();
 
     /* Create a buffer to store the gain-adjusted values.  This is local. */
     vector<double> adjusted(this->numberOfPixels);
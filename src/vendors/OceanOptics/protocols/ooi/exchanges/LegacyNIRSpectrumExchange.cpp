@@ -53,24 +53,13 @@ Data *LegacyNIRSpectrumExchange::transfer(TransferHelper *helper)
     LOG(__FUNCTION__);
 
     unsigned int i;
-    Data *xfer;
     byte lsb;
     byte msb;
 
-    /* Use the superclass to move the data into a local buffer. */
-    xfer = Transfer::transfer(helper);
-    if(NULL == xfer) {
-        string error("LegacyNIRSpectrumExchange::transfer: " 
-                "Expected Transfer::transfer to produce a non-null result "
-                "containing raw spectral data.  Without this data, it is not possible to "
-                "generate a valid formatted spectrum.");
-        logger.error(error.c_str());
-        throw ProtocolException(error);
-    }
-
-
-    /* xfer is just a copy of what is already stored in this, so delete it. */
-    delete xfer;
+    /* Use the superclass to move the data into this->buffer, which is
+     * decoded in place below.  This may throw a ProtocolException.
+     */
+    Transfer::transferInPlace(helper);
     /* At this point, this->buffer should have the raw spectrum data. */
 
     /* In this style of transfer, the last byte should be 0x69.  If it is not, then
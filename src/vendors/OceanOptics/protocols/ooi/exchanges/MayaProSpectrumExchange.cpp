@@ -30,7 +30,9 @@
 #include "common/globals.h"
 #include <vector>
 #include "vendors/OceanOptics/protocols/ooi/exchanges/MayaProSpectrumExchange.h"
+#include "common/ByteVector.h"
 #include "common/DoubleVector.h"
+#include "common/PixelUnpack.h"
 #include "common/exceptions/ProtocolFormatException.h"
 #include "common/Log.h"
 
@@ -54,28 +56,19 @@ Data *MayaProSpectrumExchange::transfer(TransferHelper *helper)
     LOG(__FUNCTION__);
 
     unsigned int i;
-    Data *xfer;
-    byte lsb;
-    byte msb;
     double maxIntensity;
     double saturationLevel;
     double scalingFactor;
 
-    /* Use the superclass to move the data into a local buffer. */
-    xfer = Transfer::transfer(helper);
-    if(NULL == xfer) {
-        string error("MayaProSpectrumExchange::transfer: "
-                "Expected Transfer::transfer to produce a non-null result "
-                "containing raw spectral data.  Without this data, it is not possible to "
-                "generate a valid formatted spectrum.");
-        logger.error(error.c_str());
-        throw ProtocolException(error);
-    }
+    /* Use the superclass to move the data into this->buffer, which is
+     * decoded in place below.  This may throw a ProtocolException.
+     */
+    Transfer::transferInPlace(helper);
 
     if(NULL == this->spectrometerFeature) {
         /* FIXME: should this throw an illegal state exception instead? */
         logger.error("no spectrometerFeature");
-        return xfer;
+        return new ByteVector(*(this->buffer));
     }
 
     maxIntensity = this->spectrometerFeature->getMaximumIntensity();
@@ -83,8 +76,6 @@ Data *MayaProSpectrumExchange::transfer(TransferHelper *helper)
 
     scalingFactor = maxIntensity/(double)saturationLevel;
 
-    /* xfer is just a copy of what is already stored in this, so delete it. */
-    delete xfer;
     /* At this point, this->buffer should have the raw spectrum data. */
 
     /* In this style of transfer, the last byte should be 0x69.  If it is not, then
@@ -100,17 +91,18 @@ Data *MayaProSpectrumExchange::transfer(TransferHelper *helper)
         throw ProtocolFormatException(synchError);
     }
 
-    /* Get a local variable by reference to point to that buffer */
-    vector<double> formatted(this->numberOfPixels);
+    /* Decode straight into the vector that will be handed back */
+    DoubleVector *retval = new DoubleVector();
+    vector<double> &formatted = retval->getDoubleVector();
+    formatted.resize(this->numberOfPixels);
+
+    /* Unpack all of the pixels first, then adjust them where they lie */
+    PixelUnpack::unpackLE16ToDouble(&((*(this->buffer))[0]), &(formatted[0]),
+        this->numberOfPixels);
 
     for(i = 0; i < this->numberOfPixels; i++) {
-        unsigned int pixel;
+        double pixel = formatted[i];
         double processedPixel;
-        lsb = (*(this->buffer))[i * 2];
-        msb = ((*(this->buffer))[(i * 2) + 1]);
-        /* Assemble the MSB and LSB into a single 16-bit integer */
-        pixel = ((msb << 8) & 0x00FF00) | (lsb & 0x00FF);
-        /* Cleanly convert to a double */
         processedPixel = pixel;
         if(processedPixel >= saturationLevel) {
             /* If we had a saturation indicator, it would be set here */
@@ -125,7 +117,6 @@ Data *MayaProSpectrumExchange::transfer(TransferHelper *helper)
         formatted[i] = processedPixel;
         // logger.debug("MayaProSpectrumExchange::transfer: autonulling changed pixel %4u from %8u to %8.2lf (%5.2lf%%)", i, pixel, formatted[i], 100.0 * formatted[i] / pixel);
     }
-    DoubleVector *retval = new DoubleVector(formatted);
 
     return retval;
 }
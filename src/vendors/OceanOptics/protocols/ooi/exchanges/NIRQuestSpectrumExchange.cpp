@@ -33,6 +33,7 @@
 #include "vendors/OceanOptics/protocols/ooi/exchanges/NIRQuestSpectrumExchange.h"
 #include "common/UShortVector.h"
 #include "common/DoubleVector.h"
+#include "common/PixelUnpack.h"
 #include "common/exceptions/ProtocolFormatException.h"
 
 using namespace seabreeze;
@@ -55,7 +56,6 @@ Data *NIRQuestSpectrumExchange::transfer(TransferHelper *helper)
 
     LOG(__FUNCTION__);
 
-    unsigned int i;
     Data *xfer;
     double maxIntensity;
     double saturationLevel;
@@ -81,25 +81,42 @@ Data *NIRQuestSpectrumExchange::transfer(TransferHelper *helper)
 
     /* Cast the formatted values so that we can get to the array of shorts */
     UShortVector *usv = static_cast<UShortVector *>(xfer);
-    vector<unsigned short> shortVec = usv->getUShortVector();
+    vector<unsigned short> &shortVec = usv->getUShortVector();
+
+    /* The gain-adjusted values go straight into the result */
+    DoubleVector *retval = new DoubleVector();
+    vector<double> &adjusted = retval->getDoubleVector();
+    adjusted.resize(this->numberOfPixels);
+    if(this->numberOfPixels > 0) {
+        PixelUnpack::applyGain(&shortVec[0], &adjusted[0], this->numberOfPixels,
+            maxIntensity, saturationLevel);
+    }
+
+    delete xfer;
+
+    return retval;
+}
+
+int NIRQuestSpectrumExchange::transferSpectrum(TransferHelper *helper, double *spectrum,
+        unsigned int length) throw (ProtocolException) {
+    LOG(__FUNCTION__);
 
-    /* Create a buffer to store the gain-adjusted values.  This is local. */
-    vector<double> adjusted(this->numberOfPixels);
+    int count;
+    double maxIntensity;
+    double saturationLevel;
 
-    for(i = 0; i < this->numberOfPixels; i++) {
-        double temp = shortVec[i] * maxIntensity / saturationLevel;
-        if(temp > maxIntensity) {
-            temp = maxIntensity;
-        }
-        adjusted[i] = temp;
+    count = QESpectrumExchange::transferSpectrum(helper, spectrum, length);
+
+    if(NULL == this->spectrometerFeature) {
+        return count;
     }
 
-    /* It might speed things up to dynamically allocate the buffer and
-     * hand it off to retval rather than letting it make a copy.
-     */
-    DoubleVector *retval = new DoubleVector(adjusted);
+    maxIntensity = this->spectrometerFeature->getMaximumIntensity();
+    saturationLevel = this->spectrometerFeature->getSaturationLevel();
 
-    delete xfer;
+    /* Adjust the counts for gain in the caller's array */
+    PixelUnpack::applyGain(spectrum, (unsigned int)count, maxIntensity,
+        saturationLevel);
 
-    return retval;
+    return count;
 }
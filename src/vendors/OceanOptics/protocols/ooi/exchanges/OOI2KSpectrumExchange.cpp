@@ -50,24 +50,15 @@ OOI2KSpectrumExchange::~OOI2KSpectrumExchange() {
 Data *OOI2KSpectrumExchange::transfer(TransferHelper *helper)
         throw (ProtocolException) {
     unsigned int i;
-    Data *xfer;
     int lsbPacket;
     int msbPacket;
     byte lsb;
     byte msb;
 
-    /* Use the superclass to move the data into a local buffer. */
-    xfer = Transfer::transfer(helper);
-    if(NULL == xfer) {
-        string error("OOI2KSpectrumExchange::transfer: "
-                "Expected Transfer::transfer to produce a non-null result "
-                "containing raw spectral data.  Without this data, it is not possible to "
-                "generate a valid formatted spectrum.");
-        throw ProtocolException(error);
-    }
-
-    /* xfer is just a copy of what is already stored in this, so delete it. */
-    delete xfer;
+    /* Use the superclass to move the data into this->buffer, which is
+     * decoded in place below.  This may throw a ProtocolException.
+     */
+    Transfer::transferInPlace(helper);
     /* At this point, this->buffer should have the raw spectrum data. */
 
     /* In this style of transfer, the last byte should be 0x69.  If it is not, then
@@ -82,8 +73,10 @@ Data *OOI2KSpectrumExchange::transfer(TransferHelper *helper)
         throw ProtocolFormatException(synchError);
     }
 
-    /* Get a local variable by reference to point to that buffer */
-    vector<unsigned short> formatted(this->numberOfPixels);
+    /* Decode straight into the vector that will be handed back */
+    UShortVector *retval = new UShortVector();
+    vector<unsigned short> &formatted = retval->getUShortVector();
+    formatted.resize(this->numberOfPixels);
 
     for(i = 0; i < this->numberOfPixels; i++) {
         lsbPacket = i >> 6;
@@ -96,7 +89,5 @@ Data *OOI2KSpectrumExchange::transfer(TransferHelper *helper)
         formatted[i] = (msb << 8) | (lsb & 0x00FF);
     }
 
-    UShortVector *retval = new UShortVector(formatted);
-
     return retval;
 }
@@ -31,6 +31,7 @@
 #include <vector>
 #include "vendors/OceanOptics/protocols/ooi/exchanges/QESpectrumExchange.h"
 #include "common/UShortVector.h"
+#include "common/PixelUnpack.h"
 #include "common/exceptions/ProtocolFormatException.h"
 #include "common/Log.h"
 
@@ -48,30 +49,14 @@ QESpectrumExchange::~QESpectrumExchange() {
 
 }
 
-Data *QESpectrumExchange::transfer(TransferHelper *helper)
+void QESpectrumExchange::receiveSpectrum(TransferHelper *helper)
         throw (ProtocolException) {
-
     LOG(__FUNCTION__);
 
-    unsigned int i;
-    Data *xfer;
-    byte lsb;
-    byte msb;
-
-    /* Use the superclass to move the data into a local buffer. */
-    /* This transfer() may cause a ProtocolException to be thrown. */
-    xfer = Transfer::transfer(helper);
-    if(NULL == xfer) {
-        string error("QESpectrumExchange::transfer: "
-            "Expected Transfer::transfer to produce a non-null result "
-            "containing raw spectral data.  Without this data, it is not possible to "
-            "generate a valid formatted spectrum.");
-        logger.error(error.c_str());
-        throw ProtocolException(error);
-    }
-
-    /* xfer is just a copy of what is already stored in this, so delete it. */
-    delete xfer;
+    /* Use the superclass to move the data into this->buffer, where the
+     * caller decodes it.  This may throw a ProtocolException.
+     */
+    Transfer::transferInPlace(helper);
     /* At this point, this->buffer should have the raw spectrum data. */
 
     /* In this style of transfer, the last byte should be 0x69.  If it is not, then
@@ -86,19 +71,38 @@ Data *QESpectrumExchange::transfer(TransferHelper *helper)
         logger.error(synchError.c_str());
         throw ProtocolFormatException(synchError);
     }
+}
 
-    /* Get a local variable by reference to point to that buffer */
-    logger.debug("demarshalling");
-    vector<unsigned short> formatted(this->numberOfPixels);
-    for(i = 0; i < this->numberOfPixels; i++) {
-        lsb = (*(this->buffer))[i * 2];
-        /* Flip bit 15 as it is copied out.
-         */
-        msb = ((*(this->buffer))[(i * 2) + 1]) ^ 0x80;
-        formatted[i] = ((msb << 8) & 0x00FF00) | (lsb & 0x00FF);
-    }
+Data *QESpectrumExchange::transfer(TransferHelper *helper)
+        throw (ProtocolException) {
 
-    UShortVector *retval = new UShortVector(formatted);
+    LOG(__FUNCTION__);
+
+    receiveSpectrum(helper);
+
+    /* Decode straight into the vector that will be handed back */
+    logger.debug("demarshalling");
+    UShortVector *retval = new UShortVector();
+    vector<unsigned short> &formatted = retval->getUShortVector();
+    formatted.resize(this->numberOfPixels);
+    /* Flip bit 15 as it is copied out. */
+    PixelUnpack::unpackLE16Flip(&((*(this->buffer))[0]), &(formatted[0]),
+        this->numberOfPixels, 0x8000);
 
     return retval;
 }
+
+int QESpectrumExchange::transferSpectrum(TransferHelper *helper, double *spectrum,
+        unsigned int length) throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    unsigned int count = (length < this->numberOfPixels) ? length : this->numberOfPixels;
+
+    receiveSpectrum(helper);
+
+    /* Flip bit 15 as it is decoded. */
+    PixelUnpack::unpackLE16FlipToDouble(&((*(this->buffer))[0]), spectrum,
+        count, 0x8000);
+
+    return (int)count;
+}
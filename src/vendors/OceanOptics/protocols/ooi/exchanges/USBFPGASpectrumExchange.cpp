@@ -35,6 +35,7 @@
 #include "vendors/OceanOptics/protocols/ooi/exchanges/USBFPGASpectrumExchange.h"
 #include "common/UShortVector.h"
 #include "common/DoubleVector.h"
+#include "common/PixelUnpack.h"
 #include "common/exceptions/ProtocolFormatException.h"
 #include "common/Log.h"
 
@@ -58,7 +59,6 @@ Data *USBFPGASpectrumExchange::transfer(TransferHelper *helper)
 
     LOG(__FUNCTION__);
 
-    unsigned int i;
     Data *xfer;
     double maxIntensity;
     double saturationLevel;
@@ -83,23 +83,42 @@ Data *USBFPGASpectrumExchange::transfer(TransferHelper *helper)
 
     /* Cast the formatted values so that we can get to the array of shorts */
     UShortVector *usv = static_cast<UShortVector *>(xfer);
-    vector<unsigned short> shortVec = usv->getUShortVector();
+    vector<unsigned short> &shortVec = usv->getUShortVector();
 
     /* Create output buffer to store the gain-adjusted values. */
     DoubleVector *retval = new DoubleVector();
     /* Get local reference */
     vector<double>& adjusted = retval->getDoubleVector(); 
-    /* Pre-allocate */
-    adjusted.reserve(this->numberOfPixels);
-    /* Store data */
-    for(i = 0; i < this->numberOfPixels; i++) {
-        double temp = shortVec[i] * maxIntensity / saturationLevel;
-        if(temp > maxIntensity) {
-            temp = maxIntensity;
-        }
-        adjusted.push_back(temp);
+    adjusted.resize(this->numberOfPixels);
+    if(this->numberOfPixels > 0) {
+        PixelUnpack::applyGain(&shortVec[0], &adjusted[0], this->numberOfPixels,
+            maxIntensity, saturationLevel);
     }
     delete xfer;
 
     return retval;
 }
+
+int USBFPGASpectrumExchange::transferSpectrum(TransferHelper *helper, double *spectrum,
+        unsigned int length) throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    int count;
+    double maxIntensity;
+    double saturationLevel;
+
+    count = FPGASpectrumExchange::transferSpectrum(helper, spectrum, length);
+
+    if(NULL == this->spectrometerFeature) {
+        return count;
+    }
+
+    maxIntensity = this->spectrometerFeature->getMaximumIntensity();
+    saturationLevel = this->spectrometerFeature->getSaturationLevel();
+
+    /* The gain is applied where the caller wants the spectrum */
+    PixelUnpack::applyGain(spectrum, (unsigned int)count, maxIntensity,
+        saturationLevel);
+
+    return count;
+}
@@ -28,6 +28,7 @@
  *******************************************************/
 
 #include "common/globals.h"
+#include <string.h>
 #include <string>
 #include "vendors/OceanOptics/protocols/ooi/impls/OOISpectrometerProtocol.h"
 #include "vendors/OceanOptics/protocols/ooi/impls/OOIProtocol.h"
@@ -35,6 +36,7 @@
 #include "common/Data.h"
 #include "common/UShortVector.h"
 #include "common/DoubleVector.h"
+#include "common/PixelUnpack.h"
 #include "common/exceptions/ProtocolBusMismatchException.h"
 #include "common/Log.h"
 
@@ -60,6 +62,7 @@ OOISpectrometerProtocol::OOISpectrometerProtocol(
     this->requestFastBufferSpectrumExchange = requestFastBufferSpectrum;
     this->readFastBufferSpectrumExchange = readFastBufferSpectrum;
     this->triggerModeExchange = triggerMode;
+    this->borrowHelper = NULL;
     
 }
 
@@ -78,7 +81,6 @@ ByteVector *OOISpectrometerProtocol::readUnformattedSpectrum(const Bus &bus)
         throw (ProtocolException) {
     LOG(__FUNCTION__);
 
-    Data *result;
     TransferHelper *helper;
 
     helper = bus.getHelper(this->readUnformattedSpectrumExchange->getHints());
@@ -88,6 +90,15 @@ ByteVector *OOISpectrometerProtocol::readUnformattedSpectrum(const Bus &bus)
         throw ProtocolBusMismatchException(error);
     }
 
+    return readUnformattedSpectrum(helper);
+}
+
+ByteVector *OOISpectrometerProtocol::readUnformattedSpectrum(TransferHelper *helper)
+        throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    Data *result;
+
     /* This transfer() may cause a ProtocolException to be thrown. */
     result = this->readUnformattedSpectrumExchange->transfer(helper);
 
@@ -109,6 +120,90 @@ ByteVector *OOISpectrometerProtocol::readUnformattedSpectrum(const Bus &bus)
     return retval;
 }
 
+int OOISpectrometerProtocol::borrowUnformattedSpectrum(const Bus &bus,
+        const byte **data) throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    TransferHelper *helper;
+    int length;
+
+    helper = bus.getHelper(this->readUnformattedSpectrumExchange->getHints());
+    if (NULL == helper) {
+        string error("Failed to find a helper to bridge given protocol and bus.");
+        logger.error(error.c_str());
+        throw ProtocolBusMismatchException(error);
+    }
+
+    /* Only one spectrum can be out at a time */
+    releaseUnformattedSpectrum(bus);
+
+    /* The unformatted spectrum is exactly what arrives on the bus, so it
+     * can be handed out from wherever the helper received it.
+     */
+    length = this->readUnformattedSpectrumExchange->transferBorrowed(helper, data);
+    this->borrowHelper = helper;
+
+    return length;
+}
+
+void OOISpectrometerProtocol::releaseUnformattedSpectrum(const Bus &bus)
+        throw (ProtocolException) {
+
+    if (NULL != this->borrowHelper) {
+        this->borrowHelper->releaseBorrowed();
+        this->borrowHelper = NULL;
+    }
+}
+
+void OOISpectrometerProtocol::submitUnformattedSpectrum(const Bus &bus)
+        throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    TransferHelper *helper;
+
+    helper = bus.getHelper(this->readUnformattedSpectrumExchange->getHints());
+    if (NULL == helper) {
+        string error("Failed to find a helper to bridge given protocol and bus.");
+        logger.error(error.c_str());
+        throw ProtocolBusMismatchException(error);
+    }
+
+    /* Have the read waiting before the spectrum is asked for */
+    try {
+        helper->submitReceive(this->readUnformattedSpectrumExchange->getLength());
+    } catch (BusException &be) {
+        string error("Failed to queue a read on the bus: ");
+        error += be.what();
+        logger.error(error.c_str());
+        throw ProtocolException(error);
+    }
+
+    requestUnformattedSpectrum(bus);
+}
+
+bool OOISpectrometerProtocol::isUnformattedSpectrumReady(const Bus &bus)
+        throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    TransferHelper *helper;
+
+    helper = bus.getHelper(this->readUnformattedSpectrumExchange->getHints());
+    if (NULL == helper) {
+        string error("Failed to find a helper to bridge given protocol and bus.");
+        logger.error(error.c_str());
+        throw ProtocolBusMismatchException(error);
+    }
+
+    try {
+        return helper->isReceiveReady();
+    } catch (BusException &be) {
+        string error("Failed to check for a queued read: ");
+        error += be.what();
+        logger.error(error.c_str());
+        throw ProtocolException(error);
+    }
+}
+
 ByteVector *OOISpectrometerProtocol::readFastBufferSpectrum(const Bus &bus, unsigned int numberOfSamplesToRetrieve)
 throw (ProtocolException) {
     LOG(__FUNCTION__);
@@ -150,8 +245,6 @@ DoubleVector *OOISpectrometerProtocol::readFormattedSpectrum(const Bus &bus)
     LOG(__FUNCTION__);
 
     TransferHelper *helper;
-    Data *result;
-    unsigned int i;
 
     helper = bus.getHelper(this->readFormattedSpectrumExchange->getHints());
     if (NULL == helper) {
@@ -160,6 +253,15 @@ DoubleVector *OOISpectrometerProtocol::readFormattedSpectrum(const Bus &bus)
         throw ProtocolBusMismatchException(error);
     }
 
+    return readFormattedSpectrum(helper);
+}
+
+Data *OOISpectrometerProtocol::readNativeSpectrum(TransferHelper *helper)
+        throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    Data *result;
+
     /* This transfer() may cause a ProtocolException to be thrown. */
     result = this->readFormattedSpectrumExchange->transfer(helper);
 
@@ -169,6 +271,44 @@ DoubleVector *OOISpectrometerProtocol::readFormattedSpectrum(const Bus &bus)
         throw ProtocolException(error);
     }
 
+    return result;
+}
+
+DoubleVector *OOISpectrometerProtocol::readFormattedSpectrum(TransferHelper *helper)
+        throw (ProtocolException) {
+    return readFormattedSpectrum(helper, 0.0, NULL);
+}
+
+unsigned int OOISpectrometerProtocol::readFormattedSpectrum(TransferHelper *helper,
+        double *spectrum, unsigned int length) throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    int count;
+
+    count = this->readFormattedSpectrumExchange->transferSpectrum(helper,
+        spectrum, length);
+    if(count >= 0) {
+        return (unsigned int)count;
+    }
+
+    DoubleVector *formatted = readFormattedSpectrum(helper);
+    vector<double> &pixels = formatted->getDoubleVector();
+    count = ((unsigned int)pixels.size() < length) ? (int)pixels.size() : (int)length;
+    if(count > 0) {
+        memcpy(spectrum, &(pixels[0]), count * sizeof(double));
+    }
+    delete formatted;
+
+    return (unsigned int)count;
+}
+
+DoubleVector *OOISpectrometerProtocol::readFormattedSpectrum(TransferHelper *helper,
+        double saturationLevel, SpectrumStatistics *statistics)
+        throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    Data *result = readNativeSpectrum(helper);
+
     /* FIXME: not knowing whether doubles or shorts will be returned
      * requires an RTTI lookup with dynamic_cast.  It might be better
      * to have the conversion to doubles done at a lower level (if that
@@ -195,14 +335,24 @@ DoubleVector *OOISpectrometerProtocol::readFormattedSpectrum(const Bus &bus)
         retval = new DoubleVector();
         // Get local reference
         vector<double>& out = retval->getDoubleVector();
-        // Pre-allocate buffer
-        out.reserve(spectrum.size());
-        // Convert buffer
-        for (i = 0; i < spectrum.size(); i++) {
-            out.push_back((double)spectrum[i]);
+        // Allocate and convert buffer
+        out.resize(spectrum.size());
+        if(NULL != statistics) {
+            PixelUnpack::widenToDoubleWithStatistics(
+                (true == spectrum.empty()) ? NULL : &(spectrum[0]),
+                (true == out.empty()) ? NULL : &(out[0]),
+                (unsigned int)spectrum.size(), saturationLevel, statistics);
+        } else if(false == spectrum.empty()) {
+            PixelUnpack::widenToDouble(&(spectrum[0]), &(out[0]),
+                (unsigned int)spectrum.size());
         }
         // result is not needed anymore as we converted it to a new format
         delete result;
+    } else if(NULL != statistics) {
+        // Spectra already scaled by the exchange get a separate pass
+        vector<double>& out = retval->getDoubleVector();
+        PixelUnpack::computeStatistics((true == out.empty()) ? NULL : &(out[0]),
+            (unsigned int)out.size(), saturationLevel, statistics);
     }
     return retval;
 }
@@ -220,6 +370,13 @@ void OOISpectrometerProtocol::requestFormattedSpectrum(const Bus &bus)
         throw ProtocolBusMismatchException(error);
     }
 
+    requestFormattedSpectrum(helper);
+}
+
+void OOISpectrometerProtocol::requestFormattedSpectrum(TransferHelper *helper)
+        throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
     /* This transfer() may cause a ProtocolException to be thrown. */
     this->requestFormattedSpectrumExchange->transfer(helper);
 }
@@ -237,6 +394,13 @@ throw (ProtocolException) {
         throw ProtocolBusMismatchException(error);
     }
 
+    requestUnformattedSpectrum(helper);
+}
+
+void OOISpectrometerProtocol::requestUnformattedSpectrum(TransferHelper *helper)
+throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
     /* This transfer() may cause a ProtocolException to be thrown. */
     this->requestUnformattedSpectrumExchange->transfer(helper);
 }
@@ -296,3 +460,21 @@ void OOISpectrometerProtocol::setTriggerMode(const Bus &bus,
     /* This transfer() may cause a ProtocolException to be thrown. */
     this->triggerModeExchange->transfer(helper);
 }
+
+void OOISpectrometerProtocol::resolveAcquisition(const Bus &bus,
+            SpectrometerAcquisition *acquisition) throw (ProtocolException) {
+    LOG(__FUNCTION__);
+
+    acquisition->protocol = this;
+    acquisition->requestFormattedHelper = bus.getHelper(this->requestFormattedSpectrumExchange->getHints());
+    acquisition->readFormattedHelper = bus.getHelper(this->readFormattedSpectrumExchange->getHints());
+    acquisition->requestUnformattedHelper = bus.getHelper(this->requestUnformattedSpectrumExchange->getHints());
+    acquisition->readUnformattedHelper = bus.getHelper(this->readUnformattedSpectrumExchange->getHints());
+
+    if (NULL == acquisition->requestFormattedHelper || NULL == acquisition->readFormattedHelper
+            || NULL == acquisition->requestUnformattedHelper || NULL == acquisition->readUnformattedHelper) {
+        string error("Failed to find a helper to bridge given protocol and bus.");
+        logger.error(error.c_str());
+        throw ProtocolBusMismatchException(error);
+    }
+}
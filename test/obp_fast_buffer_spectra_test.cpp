@@ -0,0 +1,169 @@
+/*******************************************************
+ * File:    obp_fast_buffer_spectra_test.cpp
+ * Date:    October 2026
+ * Author:  Ocean Optics, Inc.
+ *
+ * Builds a fast buffer payload by hand, two whole spectra
+ * followed by part of a third, and checks that
+ * OBPFastBufferSpectra counts only the whole ones, reads
+ * each metadata field and the checksum from the right
+ * place, and that walking it with begin() and end() visits
+ * exactly those spectra.  No device is needed.  Exits
+ * nonzero if anything is wrong.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+/* Includes */
+#include <stdio.h>
+#include <string.h>
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPFastBufferSpectra.h"
+#include "test_check.h"
+
+using namespace seabreeze;
+using namespace seabreeze::oceanBinaryProtocol;
+
+#define PIXELS              10
+#define BYTES_PER_PIXEL      2
+#define RECORDS              2
+#define TRUNCATED_TAIL      30  /* Less than a whole record */
+#define RECORD_LENGTH       (OBP_FAST_BUFFER_METADATA_LENGTH + PIXELS * BYTES_PER_PIXEL \
+                                + OBP_FAST_BUFFER_CHECKSUM_LENGTH)
+#define PAYLOAD_LENGTH      (RECORD_LENGTH * RECORDS + TRUNCATED_TAIL)
+
+static void writeLE32(byte *p, unsigned int value) {
+    p[0] = (byte)(value & 0xFF);
+    p[1] = (byte)((value >> 8) & 0xFF);
+    p[2] = (byte)((value >> 16) & 0xFF);
+    p[3] = (byte)((value >> 24) & 0xFF);
+}
+
+/* Each record gets values derived from its index so that reading the
+ * wrong record, or a field at the wrong offset, shows up.
+ */
+static unsigned int expectedCount(unsigned int i)      { return 1000 + i; }
+static unsigned int expectedTicksLow(unsigned int i)   { return 0x89ABCDEF + i; }
+static unsigned int expectedTicksHigh(unsigned int i)  { return 0x01234567 + i; }
+static unsigned int expectedIntegration(unsigned int i) { return 100000 * (i + 1); }
+static byte expectedTrigger(unsigned int i)             { return (byte)(3 + i); }
+static unsigned int expectedChecksum(unsigned int i)    { return 0xC0FFEE00 + i; }
+
+static unsigned long long expectedTicks(unsigned int i) {
+    return ((unsigned long long)expectedTicksHigh(i) << 32) | expectedTicksLow(i);
+}
+
+static void buildPayload(byte *payload) {
+    unsigned int i;
+    unsigned int p;
+    byte *record;
+
+    memset(payload, 0xEE, PAYLOAD_LENGTH);
+    for(i = 0; i < RECORDS; i++) {
+        record = payload + i * RECORD_LENGTH;
+        memset(record, 0, OBP_FAST_BUFFER_METADATA_LENGTH);
+        writeLE32(record + OBP_FAST_BUFFER_SPECTRUM_COUNT_OFFSET, expectedCount(i));
+        writeLE32(record + OBP_FAST_BUFFER_TICK_COUNT_OFFSET, expectedTicksLow(i));
+        writeLE32(record + OBP_FAST_BUFFER_TICK_COUNT_OFFSET + 4, expectedTicksHigh(i));
+        writeLE32(record + OBP_FAST_BUFFER_INTEGRATION_TIME_OFFSET, expectedIntegration(i));
+        record[OBP_FAST_BUFFER_TRIGGER_MODE_OFFSET] = expectedTrigger(i);
+        for(p = 0; p < PIXELS * BYTES_PER_PIXEL; p++) {
+            record[OBP_FAST_BUFFER_METADATA_LENGTH + p] = (byte)(i * 64 + p);
+        }
+        writeLE32(record + OBP_FAST_BUFFER_METADATA_LENGTH + PIXELS * BYTES_PER_PIXEL,
+                expectedChecksum(i));
+    }
+}
+
+static void checkSpectrum(const OBPFastBufferSpectrum &spectrum, const byte *payload,
+        unsigned int i) {
+    CHECK(spectrum.spectrumCount == expectedCount(i));
+    CHECK(spectrum.tickCount == expectedTicks(i));
+    CHECK(spectrum.integrationTimeMicros == expectedIntegration(i));
+    CHECK(spectrum.triggerMode == expectedTrigger(i));
+    CHECK(spectrum.checksum == expectedChecksum(i));
+    CHECK(spectrum.metadata == payload + i * RECORD_LENGTH);
+    CHECK(spectrum.pixels == payload + i * RECORD_LENGTH + OBP_FAST_BUFFER_METADATA_LENGTH);
+    CHECK(spectrum.pixels[0] == (byte)(i * 64));
+    CHECK(spectrum.pixels[PIXELS * BYTES_PER_PIXEL - 1]
+            == (byte)(i * 64 + PIXELS * BYTES_PER_PIXEL - 1));
+}
+
+static void testWholeAndTruncated() {
+    byte payload[PAYLOAD_LENGTH];
+    OBPFastBufferSpectrum spectrum;
+    OBPFastBufferSpectra::const_iterator it;
+    unsigned int i;
+
+    buildPayload(payload);
+    OBPFastBufferSpectra view(payload, PAYLOAD_LENGTH, PIXELS, BYTES_PER_PIXEL);
+
+    CHECK(OBPFastBufferSpectra::getRecordLength(PIXELS, BYTES_PER_PIXEL) == RECORD_LENGTH);
+    CHECK(view.size() == RECORDS);
+    CHECK(view.getNumberOfPixels() == PIXELS);
+    CHECK(view.getBytesPerPixel() == BYTES_PER_PIXEL);
+
+    for(i = 0; i < view.size(); i++) {
+        view.getSpectrum(i, &spectrum);
+        checkSpectrum(spectrum, payload, i);
+    }
+
+    /* The iterator must visit the same spectra, in order, and stop
+     * before the partial one.
+     */
+    CHECK(view.begin() != view.end());
+    i = 0;
+    for(it = view.begin(); it != view.end(); ++it) {
+        if(i < RECORDS) {
+            checkSpectrum(*it, payload, i);
+            CHECK(it->spectrumCount == expectedCount(i));
+        }
+        i++;
+    }
+    CHECK(i == RECORDS);
+
+    it = view.begin();
+    CHECK((it++) == view.begin());
+    it++;
+    CHECK(it == view.end());
+}
+
+static void testNothingWhole() {
+    byte payload[TRUNCATED_TAIL];
+
+    memset(payload, 0xEE, sizeof(payload));
+    OBPFastBufferSpectra shortView(payload, sizeof(payload), PIXELS, BYTES_PER_PIXEL);
+    CHECK(shortView.size() == 0);
+    CHECK(shortView.begin() == shortView.end());
+
+    OBPFastBufferSpectra emptyView(NULL, 1000, PIXELS, BYTES_PER_PIXEL);
+    CHECK(emptyView.size() == 0);
+    CHECK(emptyView.begin() == emptyView.end());
+}
+
+int main() {
+    testWholeAndTruncated();
+    testNothingWhole();
+
+    return checkSummary();
+}
@@ -0,0 +1,270 @@
+/*******************************************************
+ * File:    obp_pipeline_test.cpp
+ * Date:    October 2026
+ * Author:  Ocean Optics, Inc.
+ *
+ * Plays OBP replies back to an OBPPipeline through the USB
+ * replay backend and checks that each one reaches the
+ * request it answers: by the echoed token when replies come
+ * back out of order, by age among requests of the same type
+ * when the device echoes no token, as a refusal when it is
+ * a NACK, and as an error when nothing in flight asked for
+ * it.  No device is needed.  Exits nonzero on any mismatch.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+/* Includes */
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "common/buses/usb/USBTransferHelper.h"
+#include "common/exceptions/ProtocolException.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPPipeline.h"
+#include "usb_replay_trace.h"
+#include "test_check.h"
+
+using namespace seabreeze;
+using namespace seabreeze::oceanBinaryProtocol;
+
+/* Each scenario has a device of its own, so that its replies are kept apart */
+#define TOKEN_DEVICE        1
+#define TOKEN_PID           0xF141
+#define OLDEST_DEVICE       2
+#define OLDEST_PID          0xF142
+#define NACK_DEVICE         3
+#define NACK_PID            0xF143
+#define UNMATCHED_DEVICE    4
+#define UNMATCHED_PID       0xF144
+
+/* Message types only need to differ; the pipeline does not look inside */
+#define TYPE_A              0x00100100
+#define TYPE_B              0x00110220
+
+static const byte replyOne[] = { 'o', 'n', 'e' };
+static const byte replyTwo[] = { 't', 'w', 'o' };
+static const byte replyThree[] = { 't', 'h', 'r', 'e', 'e' };
+
+static bool replyIs(int length, const byte *reply, const byte *expected,
+        unsigned int expectedLength) {
+    return length == (int)expectedLength
+        && 0 == memcmp(reply, expected, expectedLength);
+}
+
+static void writeTrace(FILE *trace) {
+    /* Three requests answered in the order third, first, second, each
+     * naming its request by token.
+     */
+    replayTraceAddDevice(trace, TOKEN_DEVICE, TOKEN_PID);
+    replayTraceAddReply(trace, TOKEN_DEVICE, TYPE_A, OBP_MESSAGE_FLAGS_RESPONSE,
+        3, replyThree, sizeof(replyThree));
+    replayTraceAddReply(trace, TOKEN_DEVICE, TYPE_A, OBP_MESSAGE_FLAGS_RESPONSE,
+        1, replyOne, sizeof(replyOne));
+    replayTraceAddReply(trace, TOKEN_DEVICE, TYPE_B, OBP_MESSAGE_FLAGS_RESPONSE,
+        2, replyTwo, sizeof(replyTwo));
+
+    /* No tokens echoed: the reply of the other type first, then the two
+     * of the same type, which belong to those requests oldest first.
+     */
+    replayTraceAddDevice(trace, OLDEST_DEVICE, OLDEST_PID);
+    replayTraceAddReply(trace, OLDEST_DEVICE, TYPE_B, OBP_MESSAGE_FLAGS_RESPONSE,
+        0, replyThree, sizeof(replyThree));
+    replayTraceAddReply(trace, OLDEST_DEVICE, TYPE_A, OBP_MESSAGE_FLAGS_RESPONSE,
+        0, replyOne, sizeof(replyOne));
+    replayTraceAddReply(trace, OLDEST_DEVICE, TYPE_A, OBP_MESSAGE_FLAGS_RESPONSE,
+        0, replyTwo, sizeof(replyTwo));
+
+    /* A refusal, then an ordinary reply to show the pipeline carries on */
+    replayTraceAddDevice(trace, NACK_DEVICE, NACK_PID);
+    replayTraceAddReply(trace, NACK_DEVICE, TYPE_A,
+        OBP_MESSAGE_FLAGS_RESPONSE | OBP_MESSAGE_FLAGS_NACK, 1, NULL, 0);
+    replayTraceAddReply(trace, NACK_DEVICE, TYPE_B, OBP_MESSAGE_FLAGS_RESPONSE,
+        2, replyTwo, sizeof(replyTwo));
+
+    /* A reply naming a token that was never handed out */
+    replayTraceAddDevice(trace, UNMATCHED_DEVICE, UNMATCHED_PID);
+    replayTraceAddReply(trace, UNMATCHED_DEVICE, TYPE_A, OBP_MESSAGE_FLAGS_RESPONSE,
+        99, replyOne, sizeof(replyOne));
+}
+
+static void testTokenEcho() {
+    std::vector<byte> none;
+    const byte *reply = NULL;
+    unsigned int first;
+    unsigned int second;
+    unsigned int third;
+    int length;
+
+    USB *usb = replayTraceOpenDevice(TOKEN_PID);
+    CHECK(NULL != usb);
+    if(NULL == usb) {
+        return;
+    }
+    USBTransferHelper helper(usb, REPLAY_TEST_SEND_ENDPOINT, REPLAY_TEST_RECEIVE_ENDPOINT);
+    OBPPipeline pipeline(&helper);
+
+    first = pipeline.submit(TYPE_A, 0, none);
+    second = pipeline.submit(TYPE_B, 0, none);
+    third = pipeline.submit(TYPE_A, 0, none);
+    CHECK(1 == first && 2 == second && 3 == third);
+    CHECK(3 == pipeline.getNumberInFlight());
+    CHECK(3 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+
+    /* The third reply arrives first and must be held for its caller */
+    length = pipeline.collect(first, &reply);
+    CHECK(replyIs(length, reply, replyOne, sizeof(replyOne)));
+    CHECK(2 == replayTraceTransfers(usb, REPLAY_TEST_RECEIVE_ENDPOINT));
+
+    length = pipeline.collect(third, &reply);
+    CHECK(replyIs(length, reply, replyThree, sizeof(replyThree)));
+    CHECK(2 == replayTraceTransfers(usb, REPLAY_TEST_RECEIVE_ENDPOINT));
+
+    length = pipeline.collect(second, &reply);
+    CHECK(replyIs(length, reply, replyTwo, sizeof(replyTwo)));
+    CHECK(3 == replayTraceTransfers(usb, REPLAY_TEST_RECEIVE_ENDPOINT));
+    CHECK(0 == pipeline.getNumberInFlight());
+
+    usb->close();
+    delete usb;
+}
+
+static void testOldestOfType() {
+    std::vector<byte> none;
+    const byte *reply = NULL;
+    unsigned int older;
+    unsigned int other;
+    unsigned int newer;
+    int length;
+
+    USB *usb = replayTraceOpenDevice(OLDEST_PID);
+    CHECK(NULL != usb);
+    if(NULL == usb) {
+        return;
+    }
+    USBTransferHelper helper(usb, REPLAY_TEST_SEND_ENDPOINT, REPLAY_TEST_RECEIVE_ENDPOINT);
+    OBPPipeline pipeline(&helper);
+
+    older = pipeline.submit(TYPE_A, 0, none);
+    other = pipeline.submit(TYPE_B, 0, none);
+    newer = pipeline.submit(TYPE_A, 0, none);
+
+    /* Asking for the newer one first takes in all three replies */
+    length = pipeline.collect(newer, &reply);
+    CHECK(replyIs(length, reply, replyTwo, sizeof(replyTwo)));
+    length = pipeline.collect(older, &reply);
+    CHECK(replyIs(length, reply, replyOne, sizeof(replyOne)));
+    length = pipeline.collect(other, &reply);
+    CHECK(replyIs(length, reply, replyThree, sizeof(replyThree)));
+    CHECK(0 == pipeline.getNumberInFlight());
+
+    usb->close();
+    delete usb;
+}
+
+static void testNack() {
+    std::vector<byte> none;
+    const byte *reply = NULL;
+    unsigned int refused;
+    unsigned int answered;
+    int length;
+
+    USB *usb = replayTraceOpenDevice(NACK_PID);
+    CHECK(NULL != usb);
+    if(NULL == usb) {
+        return;
+    }
+    USBTransferHelper helper(usb, REPLAY_TEST_SEND_ENDPOINT, REPLAY_TEST_RECEIVE_ENDPOINT);
+    OBPPipeline pipeline(&helper);
+
+    refused = pipeline.submit(TYPE_A, 0, none);
+    answered = pipeline.submit(TYPE_B, 0, none);
+
+    CHECK(-1 == pipeline.collect(refused, &reply));
+    length = pipeline.collect(answered, &reply);
+    CHECK(replyIs(length, reply, replyTwo, sizeof(replyTwo)));
+    CHECK(0 == pipeline.getNumberInFlight());
+
+    usb->close();
+    delete usb;
+}
+
+static void testUnmatched() {
+    std::vector<byte> none;
+    const byte *reply = NULL;
+    unsigned int token;
+    bool threw = false;
+
+    USB *usb = replayTraceOpenDevice(UNMATCHED_PID);
+    CHECK(NULL != usb);
+    if(NULL == usb) {
+        return;
+    }
+    USBTransferHelper helper(usb, REPLAY_TEST_SEND_ENDPOINT, REPLAY_TEST_RECEIVE_ENDPOINT);
+    OBPPipeline pipeline(&helper);
+
+    token = pipeline.submit(TYPE_A, 0, none);
+    try {
+        pipeline.collect(token, &reply);
+    } catch (ProtocolException &pe) {
+        threw = true;
+    }
+    CHECK(true == threw);
+
+    /* Giving up must leave nothing in flight, even with the trace used up */
+    pipeline.drain(OBP_PIPELINE_DRAIN_TIMEOUT_MILLIS);
+    CHECK(0 == pipeline.getNumberInFlight());
+
+    threw = false;
+    try {
+        pipeline.collect(token, &reply);
+    } catch (ProtocolException &pe) {
+        threw = true;
+    }
+    CHECK(true == threw);
+
+    usb->close();
+    delete usb;
+}
+
+int main() {
+    char path[64];
+    FILE *trace;
+
+    trace = replayTraceCreate(path, sizeof(path));
+    if(NULL == trace) {
+        fprintf(stderr, "Could not create a USB trace\n");
+        return 1;
+    }
+    writeTrace(trace);
+    fclose(trace);
+
+    testTokenEcho();
+    testOldestOfType();
+    testNack();
+    testUnmatched();
+
+    remove(path);
+
+    return checkSummary();
+}
@@ -0,0 +1,228 @@
+/*******************************************************
+ * File:    obp_reply_cache_test.cpp
+ * Date:    October 2026
+ * Author:  Ocean Optics, Inc.
+ *
+ * Checks the OBP reply cache by counting what is written to
+ * a replayed USB device.  A query whose answer is fixed
+ * while the device is open should only go out once, until a
+ * command that can change that answer, here setting the
+ * pixel binning factor, is sent either directly or through
+ * an OBPPipeline.  After that the next query must go to the
+ * device again and return its new answer.  No device is
+ * needed.  Exits nonzero on any mismatch.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+/* Includes */
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "common/buses/usb/USBTransferHelper.h"
+#include "common/exceptions/ProtocolException.h"
+#include "vendors/OceanOptics/protocols/obp/constants/OBPMessageTypes.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPPipeline.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPTransaction.h"
+#include "usb_replay_trace.h"
+#include "test_check.h"
+
+using namespace seabreeze;
+using namespace seabreeze::oceanBinaryProtocol;
+
+#define COMMAND_DEVICE      1
+#define COMMAND_PID         0xF201
+#define PIPELINE_DEVICE     2
+#define PIPELINE_PID        0xF202
+
+static const byte serialBefore[] = { 'S', 'N', '0', '0', '0', '1' };
+static const byte serialAfter[] = { 'S', 'N', '0', '0', '0', '2' };
+static const byte scansOne[] = { 0x01, 0x00 };
+static const byte scansTwo[] = { 0x02, 0x00 };
+
+/* Opens up the protected exchanges that every OBP transaction is built on */
+class CacheTestTransaction : public OBPTransaction {
+public:
+    int query(TransferHelper *helper, unsigned int messageType,
+            const byte **reply) {
+        std::vector<byte> none;
+        return queryDeviceInPlace(helper, messageType, none, reply);
+    }
+
+    bool command(TransferHelper *helper, unsigned int messageType, byte value) {
+        std::vector<byte> data(1, value);
+        return sendCommandToDevice(helper, messageType, data);
+    }
+};
+
+static bool replyIs(int length, const byte *reply, const byte *expected,
+        unsigned int expectedLength) {
+    return length == (int)expectedLength
+        && 0 == memcmp(reply, expected, expectedLength);
+}
+
+static void addAck(FILE *trace, unsigned long deviceID, unsigned int messageType,
+        unsigned int regarding) {
+    replayTraceAddReply(trace, deviceID, messageType,
+        OBP_MESSAGE_FLAGS_RESPONSE | OBP_MESSAGE_FLAGS_ACK, regarding, NULL, 0);
+}
+
+/* Only the replies the device should really be asked for are in the trace,
+ * so one that was wrongly sent again would take the next reply instead.
+ */
+static void writeTrace(FILE *trace) {
+    replayTraceAddDevice(trace, COMMAND_DEVICE, COMMAND_PID);
+    replayTraceAddReply(trace, COMMAND_DEVICE, OBPMessageTypes::OBP_GET_SERIAL_NUMBER,
+        OBP_MESSAGE_FLAGS_RESPONSE, 0, serialBefore, sizeof(serialBefore));
+    addAck(trace, COMMAND_DEVICE, OBPMessageTypes::OBP_SET_ITIME_USEC, 0);
+    addAck(trace, COMMAND_DEVICE, OBPMessageTypes::OBP_SET_PIXEL_BINNING_FACTOR, 0);
+    replayTraceAddReply(trace, COMMAND_DEVICE, OBPMessageTypes::OBP_GET_SERIAL_NUMBER,
+        OBP_MESSAGE_FLAGS_RESPONSE, 0, serialAfter, sizeof(serialAfter));
+    replayTraceAddReply(trace, COMMAND_DEVICE, OBPMessageTypes::OBP_GET_SCANS_TO_AVERAGE,
+        OBP_MESSAGE_FLAGS_RESPONSE, 0, scansOne, sizeof(scansOne));
+    replayTraceAddReply(trace, COMMAND_DEVICE, OBPMessageTypes::OBP_GET_SCANS_TO_AVERAGE,
+        OBP_MESSAGE_FLAGS_RESPONSE, 0, scansTwo, sizeof(scansTwo));
+
+    /* The pipeline hands out token 1 to its first request */
+    replayTraceAddDevice(trace, PIPELINE_DEVICE, PIPELINE_PID);
+    replayTraceAddReply(trace, PIPELINE_DEVICE, OBPMessageTypes::OBP_GET_SERIAL_NUMBER,
+        OBP_MESSAGE_FLAGS_RESPONSE, 0, serialBefore, sizeof(serialBefore));
+    addAck(trace, PIPELINE_DEVICE, OBPMessageTypes::OBP_SET_PIXEL_BINNING_FACTOR, 1);
+    replayTraceAddReply(trace, PIPELINE_DEVICE, OBPMessageTypes::OBP_GET_SERIAL_NUMBER,
+        OBP_MESSAGE_FLAGS_RESPONSE, 0, serialAfter, sizeof(serialAfter));
+}
+
+static void testCommands() {
+    CacheTestTransaction transaction;
+    const byte *reply = NULL;
+    int length;
+
+    USB *usb = replayTraceOpenDevice(COMMAND_PID);
+    CHECK(NULL != usb);
+    if(NULL == usb) {
+        return;
+    }
+    USBTransferHelper helper(usb, REPLAY_TEST_SEND_ENDPOINT, REPLAY_TEST_RECEIVE_ENDPOINT);
+
+    /* The first query goes to the device, the second is answered here */
+    length = transaction.query(&helper, OBPMessageTypes::OBP_GET_SERIAL_NUMBER, &reply);
+    CHECK(replyIs(length, reply, serialBefore, sizeof(serialBefore)));
+    CHECK(1 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+    length = transaction.query(&helper, OBPMessageTypes::OBP_GET_SERIAL_NUMBER, &reply);
+    CHECK(replyIs(length, reply, serialBefore, sizeof(serialBefore)));
+    CHECK(1 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+    CHECK(1 == replayTraceTransfers(usb, REPLAY_TEST_RECEIVE_ENDPOINT));
+
+    /* A command that changes nothing cached leaves the cache alone */
+    CHECK(true == transaction.command(&helper, OBPMessageTypes::OBP_SET_ITIME_USEC, 10));
+    CHECK(2 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+    length = transaction.query(&helper, OBPMessageTypes::OBP_GET_SERIAL_NUMBER, &reply);
+    CHECK(replyIs(length, reply, serialBefore, sizeof(serialBefore)));
+    CHECK(2 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+
+    /* Binning clears it, so the query goes out again */
+    CHECK(true == transaction.command(&helper,
+        OBPMessageTypes::OBP_SET_PIXEL_BINNING_FACTOR, 2));
+    CHECK(3 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+    length = transaction.query(&helper, OBPMessageTypes::OBP_GET_SERIAL_NUMBER, &reply);
+    CHECK(replyIs(length, reply, serialAfter, sizeof(serialAfter)));
+    CHECK(4 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+    length = transaction.query(&helper, OBPMessageTypes::OBP_GET_SERIAL_NUMBER, &reply);
+    CHECK(replyIs(length, reply, serialAfter, sizeof(serialAfter)));
+    CHECK(4 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+
+    /* Queries whose answers may change are never cached */
+    length = transaction.query(&helper, OBPMessageTypes::OBP_GET_SCANS_TO_AVERAGE, &reply);
+    CHECK(replyIs(length, reply, scansOne, sizeof(scansOne)));
+    length = transaction.query(&helper, OBPMessageTypes::OBP_GET_SCANS_TO_AVERAGE, &reply);
+    CHECK(replyIs(length, reply, scansTwo, sizeof(scansTwo)));
+    CHECK(6 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+    CHECK(6 == replayTraceTransfers(usb, REPLAY_TEST_RECEIVE_ENDPOINT));
+
+    usb->close();
+    delete usb;
+}
+
+static void testPipeline() {
+    CacheTestTransaction transaction;
+    std::vector<byte> factor(1, 2);
+    const byte *reply = NULL;
+    unsigned int token;
+    int length;
+
+    USB *usb = replayTraceOpenDevice(PIPELINE_PID);
+    CHECK(NULL != usb);
+    if(NULL == usb) {
+        return;
+    }
+    USBTransferHelper helper(usb, REPLAY_TEST_SEND_ENDPOINT, REPLAY_TEST_RECEIVE_ENDPOINT);
+    OBPPipeline pipeline(&helper);
+
+    length = transaction.query(&helper, OBPMessageTypes::OBP_GET_SERIAL_NUMBER, &reply);
+    CHECK(replyIs(length, reply, serialBefore, sizeof(serialBefore)));
+    length = transaction.query(&helper, OBPMessageTypes::OBP_GET_SERIAL_NUMBER, &reply);
+    CHECK(replyIs(length, reply, serialBefore, sizeof(serialBefore)));
+    CHECK(1 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+
+    /* Submitting the command clears the cache, before its reply is in */
+    token = pipeline.submit(OBPMessageTypes::OBP_SET_PIXEL_BINNING_FACTOR,
+        OBP_MESSAGE_FLAGS_ACK_REQUESTED, factor);
+    CHECK(2 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+    CHECK(0 == pipeline.collect(token, &reply));
+
+    length = transaction.query(&helper, OBPMessageTypes::OBP_GET_SERIAL_NUMBER, &reply);
+    CHECK(replyIs(length, reply, serialAfter, sizeof(serialAfter)));
+    CHECK(3 == replayTraceTransfers(usb, REPLAY_TEST_SEND_ENDPOINT));
+
+    usb->close();
+    delete usb;
+}
+
+int main() {
+    char path[64];
+    FILE *trace;
+
+    trace = replayTraceCreate(path, sizeof(path));
+    if(NULL == trace) {
+        fprintf(stderr, "Could not create a USB trace\n");
+        return 1;
+    }
+    writeTrace(trace);
+    fclose(trace);
+
+    try {
+        testCommands();
+        testPipeline();
+    } catch (ProtocolException &pe) {
+        /* A reply went to the wrong exchange, most likely because something
+         * cached was asked for again.
+         */
+        fprintf(stderr, "FAILED: unexpected protocol error\n");
+        failures++;
+    }
+
+    remove(path);
+
+    return checkSummary();
+}
@@ -0,0 +1,219 @@
+/*******************************************************
+ * File:    pixel_unpack_test.cpp
+ * Date:    October 2026
+ * Author:  Ocean Optics, Inc.
+ *
+ * Checks every PixelUnpack kernel this processor can run
+ * (SSE2, AVX2 or NEON) against the scalar kernel on random
+ * pixels.  Every result must match bit for bit, for lengths
+ * that do and do not fill whole vectors, for unaligned
+ * buffers, and for the flip masks and saturation levels at
+ * the edges of what the kernels handle.  No device is
+ * needed.  Exits nonzero if anything differs.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "common/PixelUnpack.h"
+#include "test_check.h"
+
+using namespace seabreeze;
+
+/* Long enough for the SSE2 statistics kernel to flush its lane sums */
+#define LONG_SPECTRUM   (16384 * 8 + 13)
+
+static const char *kernelNames[] = { "sse2", "avx2", "neon" };
+static const unsigned short flips[] = { 0x0000, 0x8000, 0x2000, 0xFFFF, 0x5A5A };
+static const double saturationLevels[] = { 0.0, 65535.0, 65536.0, 1.0, 32767.5, 4000.0 };
+
+static unsigned int randomState = 12345;
+
+static unsigned int nextRandom() {
+    randomState = randomState * 1103515245 + 12345;
+    return (randomState >> 8) & 0xFFFFFF;
+}
+
+/* Random pixels, with the extreme values turning up often enough that every
+ * comparison and saturation count sees them.
+ */
+static void fillPixels(std::vector<byte> &raw, unsigned int count, unsigned int offset) {
+    unsigned int i;
+    unsigned int pixel;
+
+    raw.assign(count * 2 + offset + 1, 0xCD);
+    for(i = 0; i < count; i++) {
+        switch(nextRandom() % 16) {
+        case 0:  pixel = 0x0000; break;
+        case 1:  pixel = 0xFFFF; break;
+        case 2:  pixel = 0x8000; break;
+        case 3:  pixel = 0x7FFF; break;
+        default: pixel = nextRandom() & 0xFFFF; break;
+        }
+        raw[offset + i * 2] = (byte)(pixel & 0xFF);
+        raw[offset + i * 2 + 1] = (byte)(pixel >> 8);
+    }
+}
+
+static void check(bool same, const char *kernel, const char *routine,
+        unsigned int count, unsigned int offset, double parameter) {
+    if(false == same) {
+        fprintf(stderr, "FAILED: %s %s differs from scalar (count %u, offset %u, parameter %g)\n",
+                kernel, routine, count, offset, parameter);
+        failures++;
+    }
+}
+
+template <class T>
+static bool sameBits(const std::vector<T> &a, const std::vector<T> &b) {
+    return a.size() == b.size()
+        && (a.empty() || 0 == memcmp(&a[0], &b[0], a.size() * sizeof(T)));
+}
+
+static bool sameStatistics(const SpectrumStatistics &a, const SpectrumStatistics &b) {
+    return 0 == memcmp(&a.minimum, &b.minimum, sizeof(double))
+        && 0 == memcmp(&a.maximum, &b.maximum, sizeof(double))
+        && 0 == memcmp(&a.sum, &b.sum, sizeof(double))
+        && a.maximumIndex == b.maximumIndex
+        && a.saturatedPixels == b.saturatedPixels;
+}
+
+/* Runs one kernel and the scalar kernel over the same pixels.  Output
+ * buffers have a guard element past the end, which must survive.
+ */
+static void compareKernel(const char *kernel, unsigned int count, unsigned int offset) {
+    std::vector<byte> raw;
+    std::vector<unsigned short> widened(count + 1);
+    std::vector<unsigned short> u16[2];
+    std::vector<unsigned int> u32[2];
+    std::vector<double> d[2];
+    std::vector<float> f[2];
+    SpectrumStatistics statistics[2];
+    const byte *src;
+    unsigned int i;
+    unsigned int k;
+    int pass;
+
+    fillPixels(raw, count, offset);
+    src = &raw[offset];
+    for(i = 0; i < count; i++) {
+        widened[i] = (unsigned short)(src[i * 2] | (src[i * 2 + 1] << 8));
+    }
+
+    for(k = 0; k < sizeof(flips) / sizeof(flips[0]); k++) {
+        for(pass = 0; pass < 2; pass++) {
+            PixelUnpack::selectKernel((0 == pass) ? "scalar" : kernel);
+            u16[pass].assign(count + 1, 0xBEEF);
+            d[pass].assign(count + 1, -7.0);
+            PixelUnpack::unpackLE16Flip(src, &u16[pass][0], count, flips[k]);
+            PixelUnpack::unpackLE16FlipToDouble(src, &d[pass][0], count, flips[k]);
+        }
+        check(sameBits(u16[0], u16[1]), kernel, "unpackLE16Flip", count, offset, flips[k]);
+        check(sameBits(d[0], d[1]), kernel, "unpackLE16FlipToDouble", count, offset, flips[k]);
+    }
+
+    for(pass = 0; pass < 2; pass++) {
+        PixelUnpack::selectKernel((0 == pass) ? "scalar" : kernel);
+        u32[pass].assign(count + 1, 0xDEADBEEF);
+        d[pass].assign(count + 1, -7.0);
+        f[pass].assign(count + 1, -7.0f);
+        PixelUnpack::unpackLE16ToU32(src, &u32[pass][0], count);
+        PixelUnpack::unpackLE16ToDouble(src, &d[pass][0], count);
+        PixelUnpack::unpackLE16ToFloat(src, &f[pass][0], count);
+    }
+    check(sameBits(u32[0], u32[1]), kernel, "unpackLE16ToU32", count, offset, 0);
+    check(sameBits(d[0], d[1]), kernel, "unpackLE16ToDouble", count, offset, 0);
+    check(sameBits(f[0], f[1]), kernel, "unpackLE16ToFloat", count, offset, 0);
+
+    for(pass = 0; pass < 2; pass++) {
+        PixelUnpack::selectKernel((0 == pass) ? "scalar" : kernel);
+        u32[pass].assign(count + 1, 0xDEADBEEF);
+        d[pass].assign(count + 1, -7.0);
+        f[pass].assign(count + 1, -7.0f);
+        PixelUnpack::widenToU32(&widened[0], &u32[pass][0], count);
+        PixelUnpack::widenToDouble(&widened[0], &d[pass][0], count);
+        PixelUnpack::widenToFloat(&widened[0], &f[pass][0], count);
+    }
+    check(sameBits(u32[0], u32[1]), kernel, "widenToU32", count, offset, 0);
+    check(sameBits(d[0], d[1]), kernel, "widenToDouble", count, offset, 0);
+    check(sameBits(f[0], f[1]), kernel, "widenToFloat", count, offset, 0);
+
+    for(k = 0; k < sizeof(saturationLevels) / sizeof(saturationLevels[0]); k++) {
+        for(pass = 0; pass < 2; pass++) {
+            PixelUnpack::selectKernel((0 == pass) ? "scalar" : kernel);
+            d[pass].assign(count + 1, -7.0);
+            memset(&statistics[pass], 0xA5, sizeof(SpectrumStatistics));
+            PixelUnpack::unpackLE16ToDoubleWithStatistics(src, &d[pass][0], count,
+                saturationLevels[k], &statistics[pass]);
+        }
+        check(sameBits(d[0], d[1]), kernel, "unpackLE16ToDoubleWithStatistics",
+            count, offset, saturationLevels[k]);
+        check(sameStatistics(statistics[0], statistics[1]), kernel,
+            "unpackLE16ToDoubleWithStatistics (statistics)", count, offset,
+            saturationLevels[k]);
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned int kernel;
+    unsigned int count;
+    unsigned int offset;
+    int tested = 0;
+
+    if(argc > 1) {
+        randomState = (unsigned int)strtoul(argv[1], NULL, 0);
+    }
+    printf("Random seed %u\n", randomState);
+
+    for(kernel = 0; kernel < sizeof(kernelNames) / sizeof(kernelNames[0]); kernel++) {
+        if(false == PixelUnpack::selectKernel(kernelNames[kernel])) {
+            printf("Skipping %s: not available here\n", kernelNames[kernel]);
+            continue;
+        }
+        printf("Checking %s against scalar\n", kernelNames[kernel]);
+        tested++;
+
+        /* Every length up to a few vectors, so that each tail is covered */
+        for(count = 0; count <= 70; count++) {
+            for(offset = 0; offset < 2; offset++) {
+                compareKernel(kernelNames[kernel], count, offset);
+            }
+        }
+        compareKernel(kernelNames[kernel], 1023, 1);
+        compareKernel(kernelNames[kernel], 2048, 0);
+        compareKernel(kernelNames[kernel], LONG_SPECTRUM, 1);
+    }
+
+    PixelUnpack::selectKernel(NULL);
+
+    if(0 == tested) {
+        printf("Only the scalar kernel is built for this processor\n");
+    }
+
+    return checkSummary();
+}
@@ -0,0 +1,61 @@
+/*******************************************************
+ * File:    test_check.h
+ * Date:    October 2026
+ * Author:  Ocean Optics, Inc.
+ *
+ * The bookkeeping shared by the self-checking tests: a
+ * count of failed checks, a CHECK macro that reports the
+ * line of each one, and the summary that main() returns.
+ * Each test is a single translation unit, so the counter
+ * can live here.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            fprintf(stderr, "FAILED at line %d: %s\n", __LINE__, #condition); \
+            failures++; \
+        } \
+    } while(0)
+
+/* Prints the outcome and gives the exit status for main() */
+static int checkSummary() {
+    if(failures > 0) {
+        printf("%d checks FAILED\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
+
+#endif /* TEST_CHECK_H */
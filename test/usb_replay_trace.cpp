@@ -0,0 +1,112 @@
+/*******************************************************
+ * File:    usb_replay_trace.cpp
+ * Date:    October 2026
+ * Author:  Ocean Optics, Inc.
+ *
+ * Writes USB replay traces for the OBP tests.  See
+ * usb_replay_trace.h.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+/* Includes */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "native/usb/USBDiscovery.h"
+#include "native/usb/replay/NativeUSBReplay.h"
+#include "vendors/OceanOptics/protocols/obp/exchanges/OBPMessage.h"
+#include "usb_replay_trace.h"
+
+using namespace seabreeze;
+using namespace seabreeze::oceanBinaryProtocol;
+
+FILE *replayTraceCreate(char *path, size_t pathLength) {
+    int fd;
+
+    snprintf(path, pathLength, "/tmp/seabreeze_replay_XXXXXX");
+    fd = mkstemp(path);
+    if(fd < 0) {
+        return NULL;
+    }
+    setenv(USB_REPLAY_ENV, path, 1);
+    return fdopen(fd, "w");
+}
+
+void replayTraceAddDevice(FILE *trace, unsigned long deviceID,
+        unsigned short productID) {
+    fprintf(trace, "device %lu 0x%04X 0x%04X\n", deviceID,
+            REPLAY_TEST_VENDOR_ID, productID);
+    fprintf(trace, "devdesc %lu 18 1 0x0200 0 0 0 64 0x%04X 0x%04X 0 0 0 0 1\n",
+            deviceID, REPLAY_TEST_VENDOR_ID, productID);
+    fprintf(trace, "ifdesc %lu 9 4 0 0 2 0xFF 0 0 0\n", deviceID);
+    fprintf(trace, "epdesc %lu 0 7 5 0x%02X 2 64 0\n", deviceID,
+            REPLAY_TEST_SEND_ENDPOINT);
+    fprintf(trace, "epdesc %lu 1 7 5 0x%02X 2 64 0\n", deviceID,
+            REPLAY_TEST_RECEIVE_ENDPOINT);
+}
+
+void replayTraceAddReply(FILE *trace, unsigned long deviceID,
+        unsigned int messageType, unsigned short flags, unsigned int regarding,
+        const byte *data, unsigned int length) {
+    std::vector<byte> message;
+    unsigned int messageLength;
+    unsigned int i;
+
+    messageLength = OBPMessage::writeByteStream(message, messageType, flags,
+        regarding, data, length);
+
+    fprintf(trace, "read %lu 0x%02X ", deviceID, REPLAY_TEST_RECEIVE_ENDPOINT);
+    for(i = 0; i < messageLength; i++) {
+        fprintf(trace, "%02X", message[i]);
+    }
+    fprintf(trace, "\n");
+}
+
+USB *replayTraceOpenDevice(unsigned short productID) {
+    USBDiscovery discovery;
+    std::vector<unsigned long> *ids;
+    USB *usb = NULL;
+
+    ids = discovery.probeDevices(REPLAY_TEST_VENDOR_ID, productID);
+    if(NULL != ids && false == ids->empty()) {
+        usb = discovery.createUSBInterface((*ids)[0]);
+        if(NULL != usb && false == usb->open()) {
+            delete usb;
+            usb = NULL;
+        }
+    }
+    delete ids;
+    return usb;
+}
+
+unsigned long long replayTraceTransfers(USB *usb, int endpoint) {
+    struct USBEndpointMetrics metrics;
+
+    if(usb->getEndpointMetrics(endpoint, &metrics) < 0) {
+        return 0;
+    }
+    return metrics.transfers;
+}
@@ -0,0 +1,74 @@
+/*******************************************************
+ * File:    usb_replay_trace.h
+ * Date:    October 2026
+ * Author:  Ocean Optics, Inc.
+ *
+ * Helpers for tests that drive the OBP layers through the
+ * USB replay backend instead of a spectrometer.  A test
+ * writes a trace holding the replies each pretend device
+ * will give, points SEABREEZE_USB_REPLAY at it, and then
+ * opens the devices through the ordinary USB classes.
+ * The trace is only read once per process, so every device
+ * a test needs must be written before the first is opened.
+ *
+ * LICENSE:
+ *
+ * SeaBreeze Copyright (C) 2014, Ocean Optics Inc
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *******************************************************/
+
+#ifndef USB_REPLAY_TRACE_H
+#define USB_REPLAY_TRACE_H
+
+#include <stdio.h>
+#include "common/SeaBreeze.h"
+#include "native/usb/USB.h"
+
+#define REPLAY_TEST_VENDOR_ID       0x2457
+#define REPLAY_TEST_SEND_ENDPOINT   0x01
+#define REPLAY_TEST_RECEIVE_ENDPOINT 0x81
+
+/* Creates an empty trace in a temporary file and points the replay
+ * backend at it.  Returns NULL if the file cannot be made.
+ */
+FILE *replayTraceCreate(char *path, size_t pathLength);
+
+/* Describes a device with one bulk endpoint each way, 64-byte packets */
+void replayTraceAddDevice(FILE *trace, unsigned long deviceID,
+        unsigned short productID);
+
+/* Queues an OBP reply to be read from the device's receive endpoint.
+ * The data must fit in the immediate field so that the reply is a
+ * single 64-byte read.
+ */
+void replayTraceAddReply(FILE *trace, unsigned long deviceID,
+        unsigned int messageType, unsigned short flags, unsigned int regarding,
+        const byte *data, unsigned int length);
+
+/* Finds the device with the given product ID in the trace and opens it.
+ * Returns NULL if it is not there.
+ */
+seabreeze::USB *replayTraceOpenDevice(unsigned short productID);
+
+/* Transfers so far on one endpoint of an open device */
+unsigned long long replayTraceTransfers(seabreeze::USB *usb, int endpoint);
+
+#endif /* USB_REPLAY_TRACE_H */